@@ -10,8 +10,12 @@
 # C++ compiler
 CXX=g++
 
-# Flags for the C++ compiler
-CFLAGS=-Wall -ansi -pedantic -O3
+# Flags for the C++ compiler. The -fopenmp flag enables multithreaded cell
+# computation, and can be removed to build a serial version of the library.
+# Adding -DVOROPP_FLOAT_PARTICLES=1 stores the particle positions in single
+# precision, and -DVOROPP_FLOAT_VERTICES=1 does the same for the cell vertices
+# stored by the tessellation class; see config.hh.
+CFLAGS=-Wall -ansi -pedantic -O3 -fopenmp
 
 # Relative include and library paths for compilation of the examples
 E_INC=-I../../src
@@ -0,0 +1,69 @@
+// Bidisperse radical tessellation timing example code
+//
+// Author   : Chris H. Rycroft (LBL / UC Berkeley)
+// Email    : chr@alum.mit.edu
+// Date     : August 30th 2011
+
+#include "voro++.cc"
+using namespace voro;
+
+// Set up constants for the container geometry
+const double x_min=0,x_max=1;
+const double y_min=0,y_max=1;
+const double z_min=0,z_max=1;
+
+// Set up the number of blocks that the container is divided into
+const int n_x=26,n_y=26,n_z=26;
+
+// Set the number of particles, and the number of them that are large
+const int particles=100000;
+const int large_particles=20;
+
+// Set the radii of the small and large particles, with a 10:1 size ratio
+const double small_radius=0.005;
+const double large_radius=0.05;
+
+// Set the number of times to repeat each computation
+const int repeats=5;
+
+// This function returns a random double between 0 and 1
+double rnd() {return double(rand())/RAND_MAX;}
+
+// This function times repeated serial computations of all the cells in a
+// container, returning the shortest time and storing the total volume
+double time_cells(container_poly &con,double &vol) {
+	voronoicell c(con);
+	c_loop_all vl(con);
+	double t,best=large_number;
+	for(int r=0;r<repeats;r++) {
+		t=voro_wtime();vol=0;
+		if(vl.start()) do if(con.compute_cell(c,vl)) vol+=c.volume();
+		while(vl.inc());
+		t=voro_wtime()-t;
+		if(t<best) best=t;
+	}
+	return best;
+}
+
+int main() {
+	int i;
+	double t_glo,t_loc,v_glo,v_loc;
+
+	// Create a container with a small number of large particles scattered
+	// among many small ones
+	container_poly con(x_min,x_max,y_min,y_max,z_min,z_max,n_x,n_y,n_z,
+			false,false,false,8);
+	for(i=0;i<particles;i++)
+		con.put(i,x_min+rnd()*(x_max-x_min),y_min+rnd()*(y_max-y_min),
+			z_min+rnd()*(z_max-z_min),i<large_particles?large_radius:small_radius);
+
+	// Time the computation with the search cut off using the maximum
+	// radius of the whole container, and then using the maximum radius
+	// near each block once the radius map has been built
+	t_glo=time_cells(con,v_glo);
+	con.build_radius_map();
+	t_loc=time_cells(con,v_loc);
+	printf("Global maximum radius   : %g s (total volume %g)\n",t_glo,v_glo);
+	printf("Per-block maximum radius: %g s (total volume %g)\n",t_loc,v_loc);
+	printf("Speedup                 : %.3f\n",t_glo/t_loc);
+}
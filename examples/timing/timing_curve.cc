@@ -0,0 +1,66 @@
+// Space-filling curve timing example code
+//
+// Author   : Chris H. Rycroft (LBL / UC Berkeley)
+// Email    : chr@alum.mit.edu
+// Date     : August 30th 2011
+
+#include "voro++.cc"
+using namespace voro;
+
+// Set up constants for the container geometry
+const double x_min=-1,x_max=1;
+const double y_min=-1,y_max=1;
+const double z_min=-1,z_max=1;
+
+// Set the number of particles that are going to be randomly introduced. If
+// the preprocessor variable PARTICLES hasn't been passed to the code, then
+// use one million particles. The 10M case can be run by compiling with
+// -DPARTICLES=10000000.
+#ifndef PARTICLES
+#define PARTICLES 1000000
+#endif
+const int particles=PARTICLES;
+
+// This function returns a random double between 0 and 1
+double rnd() {return double(rand())/RAND_MAX;}
+
+// This function times the computation of all the cells in a container, with
+// the blocks visited in the order of a given loop class
+template<class c_loop>
+double time_cells(container &con,c_loop &vl) {
+	block_scheduler bs(vl);
+	double t=voro_wtime();
+	con.compute_cells(bs);
+	return voro_wtime()-t;
+}
+
+int main() {
+	int i;double x,y,z;
+
+	// Choose the grid size so that there are roughly the optimal number of
+	// particles per block
+	int n=int(pow(particles/optimal_particles,1/3.0)+0.5);
+
+	// Create a periodic container, and randomly add particles into it
+	container con(x_min,x_max,y_min,y_max,z_min,z_max,n,n,n,
+			true,true,true,8);
+	for(i=0;i<particles;i++) {
+		x=x_min+rnd()*(x_max-x_min);
+		y=y_min+rnd()*(y_max-y_min);
+		z=z_min+rnd()*(z_max-z_min);
+		con.put(i,x,y,z);
+	}
+	printf("%d particles in a %d by %d by %d grid\n",particles,n,n,n);
+
+	// Time the computation with the blocks visited in raster order, and
+	// then along the Morton and Hilbert curves, with the particle storage
+	// compacted to follow each curve
+	c_loop_all vla(con);
+	printf("Raster order  : %g s\n",time_cells(con,vla));
+	con.compact(morton);
+	c_loop_curve vlm(con,morton);
+	printf("Morton curve  : %g s\n",time_cells(con,vlm));
+	con.compact(hilbert);
+	c_loop_curve vlh(con,hilbert);
+	printf("Hilbert curve : %g s\n",time_cells(con,vlh));
+}
@@ -0,0 +1,46 @@
+// Neighbor graph timing example code
+//
+// Author   : Chris H. Rycroft (LBL / UC Berkeley)
+// Email    : chr@alum.mit.edu
+// Date     : August 30th 2011
+
+#include "voro++.cc"
+using namespace voro;
+
+// Set up constants for the container geometry
+const double x_min=-1,x_max=1;
+const double y_min=-1,y_max=1;
+const double z_min=-1,z_max=1;
+
+// Set up the number of blocks that the container is divided into
+const int n_x=26,n_y=26,n_z=26;
+
+// Set the number of particles that are going to be randomly introduced
+const int particles=100000;
+
+// This function returns a random double between 0 and 1
+double rnd() {return double(rand())/RAND_MAX;}
+
+int main() {
+	double t;
+	container con(x_min,x_max,y_min,y_max,z_min,z_max,n_x,n_y,n_z,
+			true,true,true,8);
+	for(int i=0;i<particles;i++)
+		con.put(i,x_min+rnd()*(x_max-x_min),y_min+rnd()*(y_max-y_min),
+			z_min+rnd()*(z_max-z_min));
+
+	// Time the neighbor output through the custom output routine, which
+	// writes it as text
+	FILE *fp=safe_fopen("/dev/null","w");
+	t=voro_wtime();con.print_custom("%i %n",fp);t=voro_wtime()-t;
+	fclose(fp);
+	printf("Custom output of neighbors    : %g s\n",t);
+
+	// Time the construction of the neighbor graph, with and without the
+	// face areas
+	neighbor_graph ng,nga(true);
+	t=voro_wtime();con.compute_neighbor_graph(ng);t=voro_wtime()-t;
+	printf("Neighbor graph                : %g s (%d entries)\n",t,ng.entries());
+	t=voro_wtime();con.compute_neighbor_graph(nga);t=voro_wtime()-t;
+	printf("Neighbor graph with face areas: %g s (%d entries)\n",t,nga.entries());
+}
@@ -0,0 +1,54 @@
+// Finite volume Laplacian timing example code
+//
+// Author   : Chris H. Rycroft (LBL / UC Berkeley)
+// Email    : chr@alum.mit.edu
+// Date     : August 30th 2011
+
+#include "voro++.cc"
+using namespace voro;
+
+// Set up constants for the container geometry
+const double x_min=-1,x_max=1;
+const double y_min=-1,y_max=1;
+const double z_min=-1,z_max=1;
+
+// Set up the number of blocks that the container is divided into
+const int n_x=26,n_y=26,n_z=26;
+
+// Set the number of particles that are going to be randomly introduced
+const int particles=100000;
+
+// This function returns a random double between 0 and 1
+double rnd() {return double(rand())/RAND_MAX;}
+
+int main() {
+	int j;
+	double t;
+	container con(x_min,x_max,y_min,y_max,z_min,z_max,n_x,n_y,n_z,
+			true,true,true,8);
+	for(int i=0;i<particles;i++)
+		con.put(i,x_min+rnd()*(x_max-x_min),y_min+rnd()*(y_max-y_min),
+			z_min+rnd()*(z_max-z_min));
+
+	// Time the construction of the neighbor graph with face areas, which
+	// requires the same cell computations
+	neighbor_graph ng(true);
+	t=voro_wtime();con.compute_neighbor_graph(ng);t=voro_wtime()-t;
+	printf("Neighbor graph with areas: %g s (%d entries)\n",t,ng.entries());
+
+	// Time the construction of the finite volume Laplacian, with the cell
+	// volumes as the mass vector
+	fv_laplacian fl(true);
+	t=voro_wtime();con.compute_laplacian(fl);t=voro_wtime()-t;
+	printf("Laplacian with volumes   : %g s (%d entries)\n",t,fl.entries());
+
+	// Check that the Laplacian of a constant field vanishes, and that the
+	// volumes fill the container
+	double r,rmax=0,vol=0;
+	for(int i=0;i<fl.n;i++) {
+		for(r=0,j=fl.off[i];j<fl.off[i+1];j++) r+=fl.val[j];
+		if(fabs(r)>rmax) rmax=fabs(r);
+		vol+=fl.mass[i];
+	}
+	printf("Largest row sum          : %g\nTotal volume             : %g\n",rmax,vol);
+}
@@ -0,0 +1,73 @@
+// Particle move timing example code
+//
+// Author   : Chris H. Rycroft (LBL / UC Berkeley)
+// Email    : chr@alum.mit.edu
+// Date     : August 30th 2011
+
+#include "voro++.cc"
+using namespace voro;
+
+// Set up the number of particles, the number of blocks that the container is
+// divided into, the number of timesteps, and the maximum displacement of a
+// particle in each timestep
+const int particles=100000;
+const int n_x=26,n_y=26,n_z=26;
+const int steps=20;
+const double step_size=0.002;
+
+// Arrays holding the particle positions
+double px[particles],py[particles],pz[particles];
+
+// This function returns a random double between 0 and 1
+double rnd() {return double(rand())/RAND_MAX;}
+
+// This function displaces every particle whose ID is a multiple of a given
+// stride by a small random amount, wrapping the positions back into the unit
+// box
+void displace(int stride) {
+	for(int i=0;i<particles;i+=stride) {
+		px[i]+=step_size*(2*rnd()-1);px[i]-=floor(px[i]);
+		py[i]+=step_size*(2*rnd()-1);py[i]-=floor(py[i]);
+		pz[i]+=step_size*(2*rnd()-1);pz[i]-=floor(pz[i]);
+	}
+}
+
+// This function carries out a number of timesteps, updating the first
+// container by clearing it and putting all of the particles back in, and the
+// second by moving each displaced particle
+void run(container &con,container &con2,int stride) {
+	int i,s;
+	double t,tr=0,tm=0;
+	for(s=0;s<steps;s++) {
+		displace(stride);
+		t=voro_wtime();
+		con.clear();
+		for(i=0;i<particles;i++) con.put(i,px[i],py[i],pz[i]);
+		tr+=voro_wtime()-t;
+		t=voro_wtime();
+		for(i=0;i<particles;i+=stride) con2.move(i,px[i],py[i],pz[i]);
+		tm+=voro_wtime()-t;
+	}
+	printf("One in %d particles displaced per step:\n"
+	       "  Rebuild : %g s per step (total volume %g)\n"
+	       "  Move    : %g s per step (total volume %g)\n",
+	       stride,tr/steps,con.sum_cell_volumes(),tm/steps,con2.sum_cell_volumes());
+}
+
+int main() {
+
+	// Create two identical periodic containers with random particles
+	container con(0,1,0,1,0,1,n_x,n_y,n_z,true,true,true,8),
+		  con2(0,1,0,1,0,1,n_x,n_y,n_z,true,true,true,8);
+	srand(1);
+	for(int i=0;i<particles;i++) {
+		px[i]=rnd();py[i]=rnd();pz[i]=rnd();
+		con.put(i,px[i],py[i],pz[i]);
+		con2.put(i,px[i],py[i],pz[i]);
+	}
+
+	// Time the updates when all of the particles are displaced, and when
+	// only a small fraction of them are
+	run(con,con2,1);
+	run(con,con2,20);
+}
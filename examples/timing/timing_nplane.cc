@@ -0,0 +1,76 @@
+// Plane cutting timing example code
+//
+// Author   : Chris H. Rycroft (LBL / UC Berkeley)
+// Email    : chr@alum.mit.edu
+// Date     : August 30th 2011
+
+#include "voro++.cc"
+using namespace voro;
+
+// Set the number of cells to construct by cutting with random planes, and the
+// number of planes to apply to each one
+const int cells=2000;
+const int planes=250;
+
+// Set up the number of blocks and particles for the container computation
+const int n_x=26,n_y=26,n_z=26;
+const int particles=100000;
+
+// Set the number of times to repeat each computation
+const int repeats=5;
+
+// This function returns a random double between -1 and 1
+double rnd() {return 2*double(rand())/RAND_MAX-1;}
+
+// This function constructs many cells by starting from a cube and cutting by
+// planes at random orientations and distances, and returns the shortest time
+// out of several repeats. The same planes are used on every repeat.
+template<class v_cell>
+double time_planes(v_cell &c,double &vol) {
+	double t,best=large_number,x,y,z,rsq,r;
+	for(int k=0;k<repeats;k++) {
+		srand(1);vol=0;
+		t=voro_wtime();
+		for(int i=0;i<cells;i++) {
+			c.init(-1,1,-1,1,-1,1);
+			for(int j=0;j<planes;j++) {
+				x=rnd();y=rnd();z=rnd();
+				rsq=x*x+y*y+z*z;
+				if(rsq>0.01&&rsq<1) {
+					r=2/sqrt(rsq);
+					c.plane(x*r,y*r,z*r,4);
+				}
+			}
+			vol+=c.volume();
+		}
+		t=voro_wtime()-t;
+		if(t<best) best=t;
+	}
+	return best;
+}
+
+int main() {
+	voronoicell c;
+	voronoicell_neighbor cn;
+	double vol,voln;
+
+	// Time the plane cutting on its own, with and without neighbor
+	// tracking
+	double t_p=time_planes(c,vol),t_n=time_planes(cn,voln);
+	printf("Random planes            : %g s (total volume %g)\n",t_p,vol);
+	printf("Random planes, neighbors : %g s (total volume %g)\n",t_n,voln);
+
+	// Time the computation of all the cells in a periodic container of
+	// random particles
+	container con(-1,1,-1,1,-1,1,n_x,n_y,n_z,true,true,true,8);
+	srand(1);
+	for(int i=0;i<particles;i++) con.put(i,rnd(),rnd(),rnd());
+	double t,best=large_number;
+	for(int k=0;k<repeats;k++) {
+		t=voro_wtime();
+		con.compute_all_cells();
+		t=voro_wtime()-t;
+		if(t<best) best=t;
+	}
+	printf("Container cells          : %g s\n",best);
+}
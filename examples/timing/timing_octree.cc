@@ -0,0 +1,60 @@
+// Octree container timing example code
+//
+// Author   : Chris H. Rycroft (LBL / UC Berkeley)
+// Email    : chr@alum.mit.edu
+// Date     : August 30th 2011
+
+#include "voro++.cc"
+using namespace voro;
+
+// Set up the total number of particles, the fraction of them that are placed
+// in clusters, the number of clusters, and the width of each cluster
+const int particles=200000;
+const double cluster_fraction=0.8;
+const int clusters=50;
+const double cluster_width=0.02;
+
+// This function returns a random double between 0 and 1
+double rnd() {return double(rand())/RAND_MAX;}
+
+// This function puts particles into a container, with most of them in a
+// number of small dense clusters, and the rest spread uniformly through the
+// box as a dilute background
+template<class c_class>
+void put_clusters(c_class &con) {
+	int i,j,n=int(cluster_fraction*particles)/clusters;
+	double x,y,z;
+	srand(1);
+	for(i=0;i<clusters;i++) {
+		x=cluster_width+(1-2*cluster_width)*rnd();
+		y=cluster_width+(1-2*cluster_width)*rnd();
+		z=cluster_width+(1-2*cluster_width)*rnd();
+		for(j=0;j<n;j++)
+			con.put(i*n+j,x+cluster_width*(rnd()-0.5),
+				y+cluster_width*(rnd()-0.5),z+cluster_width*(rnd()-0.5));
+	}
+	for(i*=n;i<particles;i++) con.put(i,rnd(),rnd(),rnd());
+}
+
+int main() {
+	int nx,ny,nz;
+	double t,vol;
+
+	// Set up a regular container with the grid chosen in the usual way from
+	// the total number of particles, and time the cell computation
+	pre_container pcon(0,1,0,1,0,1,false,false,false);
+	put_clusters(pcon);
+	pcon.guess_optimal(nx,ny,nz);
+	container con(0,1,0,1,0,1,nx,ny,nz,false,false,false,8);
+	pcon.setup(con);
+	t=voro_wtime();vol=con.sum_cell_volumes();t=voro_wtime()-t;
+	printf("Container        : %d by %d by %d grid, %g s, %g cells/s (total volume %g)\n",
+	       nx,ny,nz,t,particles/t,vol);
+
+	// Time the cell computation with the octree container
+	container_octree oc(0,1,0,1,0,1,8);
+	put_clusters(oc);
+	t=voro_wtime();vol=oc.sum_cell_volumes();t=voro_wtime()-t;
+	printf("Octree container : %d leaves, %g s, %g cells/s (total volume %g)\n",
+	       oc.occupied_blocks(),t,particles/t,vol);
+}
@@ -0,0 +1,66 @@
+// Periodicity policy timing example code
+//
+// Author   : Chris H. Rycroft (LBL / UC Berkeley)
+// Email    : chr@alum.mit.edu
+// Date     : August 30th 2011
+
+#include "voro++.cc"
+using namespace voro;
+
+// Set up constants for the container geometry
+const double x_min=-1,x_max=1;
+const double y_min=-1,y_max=1;
+const double z_min=-1,z_max=1;
+
+// Set up the number of blocks that the container is divided into
+const int n_x=26,n_y=26,n_z=26;
+
+// Set the number of particles that are going to be randomly introduced
+const int particles=100000;
+
+// Set the number of times to repeat each computation
+const int repeats=5;
+
+// This function returns a random double between 0 and 1
+double rnd() {return double(rand())/RAND_MAX;}
+
+// This function times repeated serial computations of all the cells in a
+// container, using a voro_compute class with the given periodicity policy, and
+// returns the shortest time
+template<class p_class>
+double time_cells(container &con,bool per) {
+	int h=per?2*n_x+1:n_x;
+	voro_compute<container,p_class> vc(con,h,h,h);
+	voronoicell c(con);
+	c_loop_all vl(con);
+	double t,best=large_number;
+	for(int r=0;r<repeats;r++) {
+		t=voro_wtime();
+		if(vl.start()) do vc.compute_cell(c,vl.ijk,vl.q,vl.i,vl.j,vl.k);
+		while(vl.inc());
+		t=voro_wtime()-t;
+		if(t<best) best=t;
+	}
+	return best;
+}
+
+// This function fills a container with random particles, and compares the
+// time to compute all of the cells with the periodicity tested at run time,
+// and fixed at compile time
+template<class p_class>
+void compare(const char *name,bool per) {
+	container con(x_min,x_max,y_min,y_max,z_min,z_max,n_x,n_y,n_z,
+			per,per,per,8);
+	for(int i=0;i<particles;i++)
+		con.put(i,x_min+rnd()*(x_max-x_min),y_min+rnd()*(y_max-y_min),
+			z_min+rnd()*(z_max-z_min));
+	double t_run=time_cells<periodicity_runtime>(con,per),
+	       t_fix=time_cells<p_class>(con,per);
+	printf("%s : run time %g s, compile time %g s, speedup %.3f\n",
+	       name,t_run,t_fix,t_run/t_fix);
+}
+
+int main() {
+	compare<periodicity_none>("Non-periodic box",false);
+	compare<periodicity_all>("Periodic box    ",true);
+}
@@ -0,0 +1,60 @@
+// Block scheduler timing example code
+//
+// Author   : Chris H. Rycroft (LBL / UC Berkeley)
+// Email    : chr@alum.mit.edu
+// Date     : August 30th 2011
+
+#include "voro++.cc"
+using namespace voro;
+
+// Set up constants for the container geometry
+const double x_min=-1,x_max=1;
+const double y_min=-1,y_max=1;
+const double z_min=-1,z_max=1;
+
+// Set up the number of blocks that the container is divided into
+const int n_x=26,n_y=26,n_z=26;
+
+// Set the number of particles in the dense bed and in the dilute gas above it
+const int bed_particles=90000;
+const int gas_particles=10000;
+
+// Set the height of the top of the dense bed
+const double bed_top=-0.8;
+
+// This function returns a random double between 0 and 1
+double rnd() {return double(rand())/RAND_MAX;}
+
+int main() {
+	int i;double x,y,z;
+
+	// Create a non-periodic container with the geometry given above
+	container con(x_min,x_max,y_min,y_max,z_min,z_max,n_x,n_y,n_z,
+			false,false,false,8);
+
+	// Add a dense bed of particles at the bottom of the container, and a
+	// dilute gas of particles above it, so that the number of particles
+	// per block varies by roughly two orders of magnitude
+	for(i=0;i<bed_particles;i++) {
+		x=x_min+rnd()*(x_max-x_min);
+		y=y_min+rnd()*(y_max-y_min);
+		z=z_min+rnd()*(bed_top-z_min);
+		con.put(i,x,y,z);
+	}
+	for(;i<bed_particles+gas_particles;i++) {
+		x=x_min+rnd()*(x_max-x_min);
+		y=y_min+rnd()*(y_max-y_min);
+		z=bed_top+rnd()*(z_max-bed_top);
+		con.put(i,x,y,z);
+	}
+
+	// Share the particles among the threads using the block scheduler,
+	// and compute all of the cells
+	c_loop_all vl(con);
+	block_scheduler bs(vl);
+	con.compute_cells(bs);
+
+	// Print the work done and the busy and idle times for each thread
+	printf("%d particles in %d runs and %d chunks\n",bs.tp,bs.nr,bs.nc);
+	bs.print_timing();
+}
@@ -0,0 +1,54 @@
+// Sparse block storage timing example code
+//
+// Author   : Chris H. Rycroft (LBL / UC Berkeley)
+// Email    : chr@alum.mit.edu
+// Date     : August 30th 2011
+
+#include "voro++.cc"
+using namespace voro;
+
+// Set up the number of blocks that the container is divided into
+const int n_x=80,n_y=80,n_z=80;
+
+// Set up the number of clusters, the number of particles in each, and the
+// width of each cluster
+const int clusters=100;
+const int cluster_particles=500;
+const double cluster_width=0.04;
+
+// This function returns a random double between 0 and 1
+double rnd() {return double(rand())/RAND_MAX;}
+
+// This function puts particles into a container in a number of small
+// clusters, so that most of the blocks are empty
+template<class c_class>
+void put_clusters(c_class &con) {
+	double x,y,z;
+	srand(1);
+	for(int i=0;i<clusters;i++) {
+		x=rnd();y=rnd();z=rnd();
+		for(int j=0;j<cluster_particles;j++)
+			con.put(i*cluster_particles+j,x+cluster_width*(rnd()-0.5),
+				y+cluster_width*(rnd()-0.5),z+cluster_width*(rnd()-0.5));
+	}
+}
+
+int main() {
+	double t,vol;
+
+	// Compute the cells with the regular container, which allocates every
+	// block
+	container con(0,1,0,1,0,1,n_x,n_y,n_z,false,false,false,8);
+	put_clusters(con);
+	t=voro_wtime();vol=con.sum_cell_volumes();t=voro_wtime()-t;
+	printf("Container        : %d blocks stored, %g s (total volume %g)\n",
+	       con.nxyz,t,vol);
+
+	// Compute the cells with the sparse container, which only allocates
+	// the occupied blocks
+	container_sparse cons(0,1,0,1,0,1,n_x,n_y,n_z,8);
+	put_clusters(cons);
+	t=voro_wtime();vol=cons.sum_cell_volumes();t=voro_wtime()-t;
+	printf("Sparse container : %d blocks stored, %g s (total volume %g)\n",
+	       cons.nb-1,t,vol);
+}
@@ -0,0 +1,59 @@
+// Tessellation timing example code
+//
+// Author   : Chris H. Rycroft (LBL / UC Berkeley)
+// Email    : chr@alum.mit.edu
+// Date     : August 30th 2011
+
+#include "voro++.cc"
+using namespace voro;
+
+// Set up constants for the container geometry
+const double x_min=-1,x_max=1;
+const double y_min=-1,y_max=1;
+const double z_min=-1,z_max=1;
+
+// Set up the number of blocks that the container is divided into
+const int n_x=26,n_y=26,n_z=26;
+
+// Set the number of particles that are going to be randomly introduced
+const int particles=100000;
+
+// This function returns a random double between 0 and 1
+double rnd() {return double(rand())/RAND_MAX;}
+
+int main() {
+	int i;
+	double t,vol,mem;
+	container con(x_min,x_max,y_min,y_max,z_min,z_max,n_x,n_y,n_z,
+			true,true,true,8);
+	for(i=0;i<particles;i++)
+		con.put(i,x_min+rnd()*(x_max-x_min),y_min+rnd()*(y_max-y_min),
+			z_min+rnd()*(z_max-z_min));
+
+	// Time the computation of the cells, with and without storing them
+	t=voro_wtime();con.compute_all_cells();t=voro_wtime()-t;
+	printf("Compute all cells      : %g s\n",t);
+	tessellation ts;
+	t=voro_wtime();con.compute_tessellation(ts);t=voro_wtime()-t;
+	printf("Compute tessellation   : %g s\n",t);
+
+	// Time a second pass that finds the total volume, by recomputing the
+	// cells and from the stored cells
+	t=voro_wtime();vol=con.sum_cell_volumes();t=voro_wtime()-t;
+	printf("Recomputed volume      : %g s (%g)\n",t,vol);
+	t=voro_wtime();
+	for(vol=0,i=0;i<ts.n;i++) vol+=ts.volume(i);
+	t=voro_wtime()-t;
+	printf("Stored volume          : %g s (%g)\n",t,vol);
+
+	// Compare the memory used by the tessellation with a lower bound on
+	// the memory that the same cells would use as voronoicell_neighbor
+	// classes, counting the vertex positions, the edge and neighbor tables
+	// with their pointers, and the vertex orders, but none of the spare
+	// capacity that each class allocates
+	for(mem=0,i=0;i<ts.n;i++)
+		mem+=double(ts.number_of_vertices(i))*(4*sizeof(double)+2*sizeof(int*)+2*sizeof(int))
+		    +3*sizeof(int)*double(ts.fvo[ts.fo[i+1]]-ts.fvo[ts.fo[i]]);
+	printf("Tessellation memory    : %g bytes per cell\n",double(ts.memory_used())/ts.n);
+	printf("voronoicell_neighbor   : over %g bytes per cell\n",mem/ts.n);
+}
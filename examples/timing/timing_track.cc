@@ -0,0 +1,57 @@
+// Cell tracker timing example code
+//
+// Author   : Chris H. Rycroft (LBL / UC Berkeley)
+// Email    : chr@alum.mit.edu
+// Date     : August 30th 2011
+
+#include "voro++.cc"
+using namespace voro;
+
+// Set up the number of particles, the number of blocks that the container is
+// divided into, and the maximum displacement of a moving particle
+const int particles=100000;
+const int n_x=26,n_y=26,n_z=26;
+const double step_size=0.005;
+
+// Arrays holding the particle positions
+double px[particles],py[particles],pz[particles];
+
+// This function returns a random double between 0 and 1
+double rnd() {return double(rand())/RAND_MAX;}
+
+int main() {
+	int i,l,m;
+	double t,tu;
+	const int nf=4;
+	const double fractions[nf]={0.001,0.003,0.01,0.03};
+
+	// Create a periodic container with random particles
+	container con(0,1,0,1,0,1,n_x,n_y,n_z,true,true,true,8);
+	srand(1);
+	for(i=0;i<particles;i++) {
+		px[i]=rnd();py[i]=rnd();pz[i]=rnd();
+		con.put(i,px[i],py[i],pz[i]);
+	}
+
+	// Time the computation of all of the cells
+	cell_tracker<container> tr(con);
+	t=voro_wtime();tr.compute();t=voro_wtime()-t;
+	printf("Full computation : %g s for %d cells\n",t,tr.recomputed);
+
+	// For several fractions of moving particles, displace the particles
+	// by small random amounts, and time the moves and the update of the
+	// dirty cells
+	for(l=0;l<nf;l++) {
+		m=0;
+		tu=voro_wtime();
+		for(i=0;i<particles;i++) if(rnd()<fractions[l]) {
+			px[i]+=step_size*(2*rnd()-1);
+			py[i]+=step_size*(2*rnd()-1);
+			pz[i]+=step_size*(2*rnd()-1);
+			tr.move(i,px[i],py[i],pz[i]);m++;
+		}
+		tr.update();tu=voro_wtime()-tu;
+		printf("%5d particles moved : %g s for %d cells (%.1f%% of the full time)\n",
+		       m,tu,tr.recomputed,100*tu/t);
+	}
+}
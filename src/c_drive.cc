@@ -0,0 +1,84 @@
+// Voro++, a 3D cell-based Voronoi library
+//
+// Author   : Chris H. Rycroft (LBL / UC Berkeley)
+// Email    : chr@alum.mit.edu
+// Date     : August 30th 2011
+
+/** \file c_drive.cc
+ * \brief Function implementations for the cell actions carried out by the
+ * drive_cells routine. */
+
+#include "c_drive.hh"
+#include "common.hh"
+
+namespace voro {
+
+/** The class constructor allocates space for the sum of each chunk.
+ * \param[in] bs the scheduler that the cells will be computed with. */
+drive_volume::drive_volume(block_scheduler &bs) : nc(bs.nc), cv(new double[nc]) {}
+
+/** Adds the sums of the chunks in order.
+ * \return The sum of the volumes of all of the computed cells. */
+double drive_volume::sum() {
+	double vol=0;
+	for(int ch=0;ch<nc;ch++) vol+=cv[ch];
+	return vol;
+}
+
+/** The class constructor compiles the format string for each thread, and sets
+ * up the output buffer for each thread, writing to a temporary file if there
+ * is more than one thread.
+ * \param[in] bs the scheduler that the cells will be computed with.
+ * \param[in] format the custom output string to use.
+ * \param[in] fp_ a file handle to write to. */
+drive_custom::drive_custom(block_scheduler &bs,const char *format,FILE *fp_)
+	: nt(bs.nt), nc(bs.nc), fp(fp_), cth(new int[nc]), choff(new long[2*nc]),
+	tf(new FILE*[nt]), cf(new custom_format*[nt]), ob(new output_buffer*[nt]) {
+	for(int t=0;t<nt;t++) {
+		tf[t]=nt>1?voro_tmpfile():fp;
+		cf[t]=new custom_format(format);
+		ob[t]=new output_buffer(tf[t]);
+	}
+}
+
+/** The class destructor frees the dynamically allocated memory. */
+drive_custom::~drive_custom() {
+	for(int t=0;t<nt;t++) {delete ob[t];delete cf[t];}
+	delete [] ob;
+	delete [] cf;
+	delete [] tf;
+	delete [] choff;
+	delete [] cth;
+}
+
+/** Writes out the output buffers, and if there is more than one thread,
+ * copies the output of each chunk from the temporary files in order. */
+void drive_custom::finish() {
+	int ch;
+	for(ch=0;ch<nt;ch++) {delete ob[ch];ob[ch]=NULL;}
+	if(nt>1) {
+		for(ch=0;ch<nc;ch++) voro_copy_stream(tf[cth[ch]],choff[2*ch],choff[2*ch+1],fp);
+		for(ch=0;ch<nt;ch++) fclose(tf[ch]);
+	}
+}
+
+/** The class constructor sets up a custom_columns class for each thread.
+ * \param[in] bs the scheduler that the cells will be computed with.
+ * \param[in] format the custom output string to use.
+ * \param[in] fp_ a file handle to write to. */
+drive_columns::drive_columns(block_scheduler &bs,const char *format,FILE *fp_)
+	: nt(bs.nt), nc(bs.nc), fp(fp_), cth(new int[nc]), cc(new custom_columns*[nt]) {
+	for(int t=0;t<nt;t++) cc[t]=new custom_columns(format);
+	m=cc[0]->marks();
+	so=new long[2*m*nc];
+}
+
+/** The class destructor frees the dynamically allocated memory. */
+drive_columns::~drive_columns() {
+	for(int t=0;t<nt;t++) delete cc[t];
+	delete [] so;
+	delete [] cc;
+	delete [] cth;
+}
+
+}
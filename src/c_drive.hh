@@ -0,0 +1,364 @@
+// Voro++, a 3D cell-based Voronoi library
+//
+// Author   : Chris H. Rycroft (LBL / UC Berkeley)
+// Email    : chr@alum.mit.edu
+// Date     : August 30th 2011
+
+/** \file c_drive.hh
+ * \brief Header file for the drive_cells routine, which computes the Voronoi
+ * cells of the particles in a block_scheduler in parallel, and for the cell
+ * actions that it can carry out. */
+
+#ifndef VOROPP_C_DRIVE_HH
+#define VOROPP_C_DRIVE_HH
+
+#include <cstdio>
+
+#include "config.hh"
+#include "cell.hh"
+#include "c_sched.hh"
+#include "c_pool.hh"
+#include "v_compute.hh"
+#include "o_custom.hh"
+#include "o_columns.hh"
+#include "o_tess.hh"
+#include "o_laplace.hh"
+#include "o_mesh.hh"
+#include "o_graph.hh"
+
+namespace voro {
+
+/** \brief A base class for the actions carried out by drive_cells, which do
+ * nothing at the start and end of each chunk.
+ *
+ * An action class is passed to drive_cells, which calls its begin_chunk and
+ * end_chunk routines when a thread starts and finishes a chunk of the
+ * scheduler, and its cell routine for each Voronoi cell that is computed.
+ * Since the routines are called from several threads at once, each one should
+ * only modify data belonging to the thread or chunk that it is given. */
+class drive_action {
+	public:
+		/** Called when a thread starts a chunk.
+		 * \param[in] t the thread number.
+		 * \param[in] ch the chunk. */
+		inline void begin_chunk(int t,int ch) {}
+		/** Called when a thread finishes a chunk.
+		 * \param[in] t the thread number.
+		 * \param[in] ch the chunk. */
+		inline void end_chunk(int t,int ch) {}
+};
+
+/** \brief An action that does nothing with the computed cells. */
+class drive_none : public drive_action {
+	public:
+		/** Does nothing with a computed cell. */
+		inline void cell(int t,int ch,int i,particle_real *pp,double r,voronoicell_base &c) {}
+};
+
+/** \brief An action that sums the volumes of the computed cells.
+ *
+ * The volumes are summed for each chunk, and these are then added in order,
+ * so that the result does not depend on the number of threads. */
+class drive_volume : public drive_action {
+	public:
+		drive_volume(block_scheduler &bs);
+		/** The class destructor frees the dynamically allocated
+		 * memory. */
+		~drive_volume() {delete [] cv;}
+		/** Starts the sum for a chunk.
+		 * \param[in] t the thread number.
+		 * \param[in] ch the chunk. */
+		inline void begin_chunk(int t,int ch) {cv[ch]=0;}
+		/** Adds the volume of a computed cell to the sum for its
+		 * chunk.
+		 * \param[in] ch the chunk.
+		 * \param[in] c the computed cell. */
+		inline void cell(int t,int ch,int i,particle_real *pp,double r,voronoicell_base &c) {
+			cv[ch]+=c.volume();
+		}
+		double sum();
+	private:
+		/** The number of chunks. */
+		const int nc;
+		/** The volume summed for each chunk. */
+		double *cv;
+};
+
+/** \brief An action that saves customized information about the computed
+ * cells.
+ *
+ * The format string is compiled once for each thread, and the output is
+ * collected in a buffer for each thread. If there is more than one thread,
+ * each thread's buffer is written out to its own temporary file, and the
+ * output for each chunk is then copied in order by the finish routine, so
+ * that the output is identical to that of a serial computation. */
+class drive_custom : public drive_action {
+	public:
+		drive_custom(block_scheduler &bs,const char *format,FILE *fp_);
+		~drive_custom();
+		/** Records where the output for a chunk starts.
+		 * \param[in] t the thread number.
+		 * \param[in] ch the chunk. */
+		inline void begin_chunk(int t,int ch) {
+			if(nt>1) {cth[ch]=t;choff[2*ch]=ob[t]->tell();}
+		}
+		/** Records where the output for a chunk ends.
+		 * \param[in] t the thread number.
+		 * \param[in] ch the chunk. */
+		inline void end_chunk(int t,int ch) {
+			if(nt>1) choff[2*ch+1]=ob[t]->tell();
+		}
+		/** Saves the information about a computed cell.
+		 * \param[in] t the thread number.
+		 * \param[in] i the ID of the particle.
+		 * \param[in] pp a pointer to the particle position.
+		 * \param[in] r the radius of the particle.
+		 * \param[in] c the computed cell. */
+		inline void cell(int t,int ch,int i,particle_real *pp,double r,voronoicell_base &c) {
+			cf[t]->write(c,i,*pp,pp[1],pp[2],r,*ob[t]);
+		}
+		void finish();
+	private:
+		/** The number of threads. */
+		const int nt;
+		/** The number of chunks. */
+		const int nc;
+		/** The file handle to write the output to. */
+		FILE *fp;
+		/** The thread that computed each chunk. */
+		int *cth;
+		/** The start and end of the output of each chunk within the
+		 * output of its thread. */
+		long *choff;
+		/** The file that each thread writes its output to. */
+		FILE **tf;
+		/** The compiled format string of each thread. */
+		custom_format **cf;
+		/** The output buffer of each thread. */
+		output_buffer **ob;
+};
+
+/** \brief An action that saves customized information about the computed
+ * cells in the columnar binary format.
+ *
+ * Each thread has its own custom_columns class, and the positions in its
+ * columns at the start and end of each chunk are marked, so that the finish
+ * routine can combine the columns for each chunk in order. */
+class drive_columns : public drive_action {
+	public:
+		drive_columns(block_scheduler &bs,const char *format,FILE *fp_);
+		~drive_columns();
+		/** Marks where the columns for a chunk start.
+		 * \param[in] t the thread number.
+		 * \param[in] ch the chunk. */
+		inline void begin_chunk(int t,int ch) {
+			cth[ch]=t;cc[t]->mark(so+2*m*ch);
+		}
+		/** Marks where the columns for a chunk end.
+		 * \param[in] t the thread number.
+		 * \param[in] ch the chunk. */
+		inline void end_chunk(int t,int ch) {
+			cc[t]->mark(so+(2*ch+1)*m);
+		}
+		/** Saves the information about a computed cell.
+		 * \param[in] t the thread number.
+		 * \param[in] i the ID of the particle.
+		 * \param[in] pp a pointer to the particle position.
+		 * \param[in] r the radius of the particle.
+		 * \param[in] c the computed cell. */
+		inline void cell(int t,int ch,int i,particle_real *pp,double r,voronoicell_base &c) {
+			cc[t]->write(c,i,*pp,pp[1],pp[2],r);
+		}
+		/** Combines the columns for each chunk in order and writes
+		 * them to the file. */
+		inline void finish() {custom_columns::assemble(cc,nt,nc,cth,so,fp);}
+	private:
+		/** The number of threads. */
+		const int nt;
+		/** The number of chunks. */
+		const int nc;
+		/** The file handle to write the output to. */
+		FILE *fp;
+		/** The thread that computed each chunk. */
+		int *cth;
+		/** The custom_columns class of each thread. */
+		custom_columns **cc;
+		/** The number of marks recorded at the start or end of a
+		 * chunk. */
+		int m;
+		/** The marks recorded at the start and end of each chunk. */
+		long *so;
+};
+
+/** \brief An action that records the neighbors of the computed cells in a
+ * neighbor_graph.
+ *
+ * The setup routine of the graph is called when the action is constructed,
+ * and the assemble routine of the graph should be called once the cells have
+ * been computed. */
+class drive_graph : public drive_action {
+	public:
+		/** The class constructor prepares the graph to receive the
+		 * cells.
+		 * \param[in] bs the scheduler that the cells will be computed
+		 *               with.
+		 * \param[in] ng_ the neighbor graph to fill in. */
+		drive_graph(block_scheduler &bs,neighbor_graph &ng_) : ng(ng_) {
+			ng.setup(bs.nt,bs.nc);
+		}
+		/** Records the neighbors of a computed cell.
+		 * \param[in] t the thread number.
+		 * \param[in] ch the chunk.
+		 * \param[in] i the ID of the particle.
+		 * \param[in] c the computed cell. */
+		inline void cell(int t,int ch,int i,particle_real *pp,double r,voronoicell_neighbor &c) {
+			ng.add(t,ch,i,c);
+		}
+	private:
+		/** The neighbor graph to fill in. */
+		neighbor_graph &ng;
+};
+
+/** \brief An action that records the faces of the computed cells in a
+ * face_mesh.
+ *
+ * The setup routine of the mesh is called when the action is constructed,
+ * and the assemble routine of the mesh should be called once the cells have
+ * been computed. */
+class drive_mesh : public drive_action {
+	public:
+		/** The class constructor prepares the mesh to receive the
+		 * cells.
+		 * \param[in] bs the scheduler that the cells will be computed
+		 *               with.
+		 * \param[in] fm_ the mesh to fill in.
+		 * \param[in] tol the distance within which vertices are taken
+		 *                to be the same. */
+		drive_mesh(block_scheduler &bs,face_mesh &fm_,double tol) : fm(fm_) {
+			fm.setup(bs.nt,bs.nc,tol);
+		}
+		/** Records the faces of a computed cell.
+		 * \param[in] t the thread number.
+		 * \param[in] ch the chunk.
+		 * \param[in] i the ID of the particle.
+		 * \param[in] pp a pointer to the particle position.
+		 * \param[in] c the computed cell. */
+		inline void cell(int t,int ch,int i,particle_real *pp,double r,voronoicell_neighbor &c) {
+			fm.add(t,ch,i,*pp,pp[1],pp[2],c);
+		}
+	private:
+		/** The mesh to fill in. */
+		face_mesh &fm;
+};
+
+/** \brief An action that records the faces of the computed cells in an
+ * fv_laplacian.
+ *
+ * The setup routine of the matrix is called when the action is constructed,
+ * and the assemble routine of the matrix should be called once the cells have
+ * been computed. */
+class drive_laplacian : public drive_action {
+	public:
+		/** The class constructor prepares the matrix to receive the
+		 * cells.
+		 * \param[in] bs the scheduler that the cells will be computed
+		 *               with.
+		 * \param[in] fl_ the matrix to fill in. */
+		drive_laplacian(block_scheduler &bs,fv_laplacian &fl_) : fl(fl_) {
+			fl.setup(bs.nt,bs.nc);
+		}
+		/** Records the faces of a computed cell.
+		 * \param[in] t the thread number.
+		 * \param[in] ch the chunk.
+		 * \param[in] i the ID of the particle.
+		 * \param[in] c the computed cell. */
+		inline void cell(int t,int ch,int i,particle_real *pp,double r,voronoicell_neighbor &c) {
+			fl.add(t,ch,i,c);
+		}
+	private:
+		/** The matrix to fill in. */
+		fv_laplacian &fl;
+};
+
+/** \brief An action that records the computed cells in a tessellation.
+ *
+ * The setup routine of the tessellation is called when the action is
+ * constructed, and the assemble routine of the tessellation should be called
+ * once the cells have been computed. */
+class drive_tessellation : public drive_action {
+	public:
+		/** The class constructor prepares the tessellation to receive
+		 * the cells.
+		 * \param[in] bs the scheduler that the cells will be computed
+		 *               with.
+		 * \param[in] ts_ the tessellation to fill in. */
+		drive_tessellation(block_scheduler &bs,tessellation &ts_) : ts(ts_) {
+			ts.setup(bs.nt,bs.nc);
+		}
+		/** Records a computed cell.
+		 * \param[in] t the thread number.
+		 * \param[in] ch the chunk.
+		 * \param[in] i the ID of the particle.
+		 * \param[in] pp a pointer to the particle position.
+		 * \param[in] c the computed cell. */
+		inline void cell(int t,int ch,int i,particle_real *pp,double r,voronoicell_neighbor &c) {
+			ts.add(t,ch,i,*pp,pp[1],pp[2],c);
+		}
+	private:
+		/** The tessellation to fill in. */
+		tessellation &ts;
+};
+
+/** Computes the Voronoi cells for the particles in a scheduler and carries out
+ * an action on each of them. The chunks of the scheduler are shared among the
+ * threads, each of which uses its own cell computation class and Voronoi cell
+ * from the container's cell pool. The cell computation class is constructed
+ * from the container for each thread.
+ * \param[in] con the container.
+ * \param[in] bs the scheduler to use.
+ * \param[in] f the action to carry out. */
+template<class v_cell,class vc_class,class c_class,class f_class>
+void drive_cells(c_class &con,block_scheduler &bs,f_class &f) {
+	con.pool.setup(bs.nt);
+	bs.start();
+#ifdef _OPENMP
+#pragma omp parallel num_threads(bs.nt)
+#endif
+	{
+		int t=block_scheduler::thread_num(),ch,q,*rp,*re;
+		v_cell &c=con.pool.template fetch<v_cell>(t);
+		vc_class tvc(con);
+		particle_real *pp;
+		while(bs.next_chunk(t,ch)) {
+			f.begin_chunk(t,ch);
+			for(rp=bs.ru+6*bs.cs[ch],re=bs.ru+6*bs.cs[ch+1];rp<re;rp+=6)
+				for(q=rp[4];q<rp[5];q++) if(tvc.compute_cell(c,*rp,q,rp[1],rp[2],rp[3])) {
+					pp=con.p[*rp]+con.ps*q;
+					f.cell(t,ch,con.id[*rp][q],pp,con.ps==3?default_radius:pp[3],c);
+				}
+			f.end_chunk(t,ch);
+		}
+	}
+	bs.finish();
+}
+
+/** Computes the Voronoi cells for the particles in a scheduler and carries out
+ * an action on each of them, using the drive_cells routine. If the container
+ * is non-periodic or periodic in all three directions, then the cells are
+ * computed with a voro_compute class whose periodicity is fixed at compile
+ * time, and otherwise the periodicity is checked at run time.
+ * \param[in] con the container.
+ * \param[in] bs the scheduler to use.
+ * \param[in] f the action to carry out. */
+template<class v_cell,class c_class,class f_class>
+void drive_cells_periodicity(c_class &con,block_scheduler &bs,f_class &f) {
+	if(!(con.xperiodic||con.yperiodic||con.zperiodic))
+		drive_cells<v_cell,voro_compute<c_class,periodicity_none> >(con,bs,f);
+	else if(con.xperiodic&&con.yperiodic&&con.zperiodic)
+		drive_cells<v_cell,voro_compute<c_class,periodicity_all> >(con,bs,f);
+	else drive_cells<v_cell,voro_compute<c_class> >(con,bs,f);
+}
+
+}
+
+#endif
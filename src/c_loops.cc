@@ -7,7 +7,10 @@
 /** \file c_loops.cc
  * \brief Function implementations for the loop classes. */
 
+#include <algorithm>
+
 #include "c_loops.hh"
+#include "common.hh"
 
 namespace voro {
 
@@ -110,7 +113,7 @@ void c_loop_subset::setup_box(double xmin,double xmax,double ymin,double ymax,do
  * current loop setup.
  * \return True if the point is out of bounds, false otherwise. */
 bool c_loop_subset::out_of_bounds() {
-	double *pp=p[ijk]+ps*q;
+	particle_real *pp=p[ijk]+ps*q;
 	if(mode==sphere) {
 		double fx(*pp+px-v0),fy(pp[1]+py-v1),fz(pp[2]+pz-v2);
 		return fx*fx+fy*fy+fz*fz>v3;
@@ -122,19 +125,21 @@ bool c_loop_subset::out_of_bounds() {
 }
 
 /** Returns the next block to be tested in a loop, and updates the periodicity
- * vector if necessary. */
+ * vector if necessary. The ci, cj, and ck indices count through the subgrid
+ * range without being wrapped, while the i, j, and k indices hold the
+ * coordinates of the block within the container. */
 bool c_loop_subset::next_block() {
-	if(i<bi) {
-		i++;
-		if(ci<nx-1) {ci++;ijk++;} else {ci=0;ijk+=1-nx;px+=sx;}
+	if(ci<bi) {
+		ci++;
+		if(i<nx-1) {i++;ijk++;} else {i=0;ijk+=1-nx;px+=sx;}
 		return true;
-	} else if(j<bj) {
-		i=ai;ci=di;px=apx;j++;
-		if(cj<ny-1) {cj++;ijk+=inc1;} else {cj=0;ijk+=inc1-nxy;py+=sy;}
+	} else if(cj<bj) {
+		ci=ai;i=di;px=apx;cj++;
+		if(j<ny-1) {j++;ijk+=inc1;} else {j=0;ijk+=inc1-nxy;py+=sy;}
 		return true;
-	} else if(k<bk) {
-		i=ai;ci=di;j=aj;cj=dj;px=apx;py=apy;k++;
-		if(ck<nz-1) {ck++;ijk+=inc2;} else {ck=0;ijk+=inc2-nxyz;pz+=sz;}
+	} else if(ck<bk) {
+		ci=ai;i=di;cj=aj;j=dj;px=apx;py=apy;ck++;
+		if(k<nz-1) {k++;ijk+=inc2;} else {k=0;ijk+=inc2-nxyz;pz+=sz;}
 		return true;
 	} else return false;
 }
@@ -147,4 +152,79 @@ void particle_order::add_ordering_memory() {
 	size<<=1;o=no;op=nop;
 }
 
+/** \brief A comparison class for sorting blocks along a space-filling curve.
+ *
+ * Each block is given a triplet of integers whose Morton order is the order of
+ * the block along the curve. For the Morton curve these are the block
+ * coordinates themselves. For the Hilbert curve they are the transposed form
+ * of the Hilbert index, computed using the method of J. Skilling, AIP Conf.
+ * Proc. 707, 381 (2004), which avoids forming the index as a single integer
+ * that might overflow. */
+struct curve_block_order {
+	/** The curve keys of the blocks, three for each block. */
+	int *key;
+	curve_block_order(int *key_) : key(key_) {}
+	/** Compares two blocks along the curve.
+	 * \param[in] (a,b) the indices of the two blocks.
+	 * \return True if block a comes before block b. */
+	inline bool operator()(int a,int b) const {
+		int *ka=key+3*a,*kb=key+3*b;
+		return voro_morton_less(*ka,ka[1],ka[2],*kb,kb[1],kb[2]);
+	}
+};
+
+/** Converts a set of block coordinates into the transposed form of their
+ * Hilbert index.
+ * \param[in] m the highest bit used by the coordinates.
+ * \param[in,out] x the three coordinates, which are replaced by the transposed
+ *                  index, with the most significant bits in x[0]. */
+static void hilbert_transpose(unsigned int m,unsigned int *x) {
+	unsigned int p,q,t;
+	int l;
+
+	// Apply the inverse of the curve's rotations and reflections
+	for(q=m;q>1;q>>=1) {
+		p=q-1;
+		for(l=0;l<3;l++) {
+			if(x[l]&q) *x^=p;
+			else {t=(*x^x[l])&p;*x^=t;x[l]^=t;}
+		}
+	}
+
+	// Gray encode
+	x[1]^=*x;x[2]^=x[1];
+	for(t=0,q=m;q>1;q>>=1) if(x[2]&q) t^=q-1;
+	for(l=0;l<3;l++) x[l]^=t;
+}
+
+/** Computes the order in which to visit the blocks of a rectangular grid
+ * along a space-filling curve. Grids whose dimensions are not equal powers of
+ * two are handled by ordering the blocks along the curve for the smallest
+ * enclosing power-of-two cube, and skipping those that lie outside.
+ * \param[in] (nx,ny,nz) the number of blocks in each direction.
+ * \param[in] mode the space-filling curve to use.
+ * \param[out] bo an array of size nx*ny*nz in which to store the block
+ *                indices in order. */
+void curve_order(int nx,int ny,int nz,c_loop_curve_mode mode,int *bo) {
+	int i,j,k,ijk,nxyz=nx*ny*nz,*key=new int[3*nxyz],*kp=key;
+	unsigned int m=1,x[3],mx=nx>ny?nx:ny;
+	if(nz>(int) mx) mx=nz;
+	while(m<<1<mx) m<<=1;
+
+	// Compute the curve keys of the blocks. The Morton order compares
+	// the third entry as the most significant, whereas the most
+	// significant bits of the transposed Hilbert index are in x[0], so
+	// the entries are reversed.
+	for(ijk=k=0;k<nz;k++) for(j=0;j<ny;j++) for(i=0;i<nx;i++,ijk++,kp+=3) {
+		bo[ijk]=ijk;
+		if(mode==hilbert) {
+			*x=i;x[1]=j;x[2]=k;
+			hilbert_transpose(m,x);
+			*kp=x[2];kp[1]=x[1];kp[2]=*x;
+		} else {*kp=i;kp[1]=j;kp[2]=k;}
+	}
+	std::sort(bo,bo+nxyz,curve_block_order(key));
+	delete [] key;
+}
+
 }
@@ -22,6 +22,15 @@ enum c_loop_subset_mode {
 	no_check
 };
 
+/** A type associated with a c_loop_curve class, determining which
+ * space-filling curve is used to order the blocks. */
+enum c_loop_curve_mode {
+	morton,
+	hilbert
+};
+
+void curve_order(int nx,int ny,int nz,c_loop_curve_mode mode,int *bo);
+
 /** \brief A class for storing ordering information when particles are added to
  * a container.
  *
@@ -95,7 +104,7 @@ class c_loop_base {
 		const int ps;
 		/** A pointer to the particle position information in the
 		 * associated container data structure. */
-		double **p;
+		particle_real **p;
 		/** A pointer to the particle ID information in the associated
 		 * container data structure. */
 		int **id;
@@ -128,7 +137,7 @@ class c_loop_base {
 		 * considered by the loop.
 		 * \param[out] (x,y,z) the position vector of the particle. */
 		inline void pos(double &x,double &y,double &z) {
-			double *pp=p[ijk]+ps*q;
+			particle_real *pp=p[ijk]+ps*q;
 			x=*(pp++);y=*(pp++);z=*pp;
 		}
 		/** Returns the ID, position vector, and radius of the particle
@@ -140,7 +149,7 @@ class c_loop_base {
 		 * 		 value is returned. */
 		inline void pos(int &pid,double &x,double &y,double &z,double &r) {
 			pid=id[ijk][q];
-			double *pp=p[ijk]+ps*q;
+			particle_real *pp=p[ijk]+ps*q;
 			x=*(pp++);y=*(pp++);z=*pp;
 			r=ps==3?default_radius:*(++pp);
 		}
@@ -209,6 +218,76 @@ class c_loop_all : public c_loop_base {
 		}
 };
 
+/** \brief Class for looping over all of the particles in a container, visiting
+ * the blocks along a space-filling curve.
+ *
+ * This class visits the same particles as the c_loop_all class, but it orders
+ * the computational blocks along a Morton or Hilbert curve rather than
+ * scanning them row by row. Successive blocks are therefore close together in
+ * all three directions, so that successive Voronoi cell computations test many
+ * of the same neighboring blocks, which are then likely to be in the cache.
+ * The container's compact() routine can lay out the particle data in the same
+ * order. */
+class c_loop_curve : public c_loop_base {
+	public:
+		/** The constructor copies several necessary constants from the
+		 * base container class, and computes the order of the blocks.
+		 * \param[in] con the container class to use.
+		 * \param[in] mode the space-filling curve to use. */
+		template<class c_class>
+		c_loop_curve(c_class &con,c_loop_curve_mode mode=morton)
+			: c_loop_base(con), bo(new int[nxyz]), be(bo+nxyz) {
+			curve_order(nx,ny,nz,mode,bo);
+		}
+		/** The destructor frees the dynamically allocated memory. */
+		~c_loop_curve() {delete [] bo;}
+		/** Sets the class to consider the first particle.
+		 * \return True if there is any particle to consider, false
+		 * otherwise. */
+		inline bool start() {
+			bp=bo;q=0;decode();
+			while(co[ijk]==0) if(!next_block()) return false;
+			return true;
+		}
+		/** Finds the next particle to test.
+		 * \return True if there is another particle, false if no more
+		 * particles are available. */
+		inline bool inc() {
+			q++;
+			if(q>=co[ijk]) {
+				q=0;
+				do {
+					if(!next_block()) return false;
+				} while(co[ijk]==0);
+			}
+			return true;
+		}
+	private:
+		/** The order in which to visit the blocks. */
+		int *bo;
+		/** A pointer to the end of the block order. */
+		int *be;
+		/** A pointer to the current block in the block order. */
+		int *bp;
+		/** Sets the block index from the current position in the block
+		 * order, and computes indices in the x, y, and z directions. */
+		inline void decode() {
+			ijk=*bp;
+			k=ijk/nxy;
+			int ijkt=ijk-nxy*k;
+			j=ijkt/nx;
+			i=ijkt-j*nx;
+		}
+		/** Moves to the next block in the block order.
+		 * \return True if another block is found, false if there are
+		 * no more blocks. */
+		inline bool next_block() {
+			if(++bp==be) return false;
+			decode();
+			return true;
+		}
+};
+
 /** \brief Class for looping over a subset of particles in a container.
  *
  * This class can loop over a subset of particles in a certain geometrical
@@ -242,6 +321,15 @@ class c_loop_subset : public c_loop_base {
 			} while(mode!=no_check&&out_of_bounds());
 			return true;
 		}
+		/** Computes the position of the current particle, including
+		 * the periodic displacement of the block being considered,
+		 * so that it is the image of the particle within the region
+		 * being looped over.
+		 * \param[out] (x,y,z) the position. */
+		inline void image_pos(double &x,double &y,double &z) {
+			particle_real *pp=p[ijk]+ps*q;
+			x=*pp+px;y=pp[1]+py;z=pp[2]+pz;
+		}
 	private:
 		const double ax,ay,az,sx,sy,sz,xsp,ysp,zsp;
 		const bool xperiodic,yperiodic,zperiodic;
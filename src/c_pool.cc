@@ -0,0 +1,54 @@
+// Voro++, a 3D cell-based Voronoi library
+//
+// Author   : Chris H. Rycroft (LBL / UC Berkeley)
+// Email    : chr@alum.mit.edu
+// Date     : August 30th 2011
+
+/** \file c_pool.cc
+ * \brief Function implementations for the cell_pool class. */
+
+#include "c_pool.hh"
+
+namespace voro {
+
+/** The class constructor sets up an empty pool.
+ * \param[in] max_len_sq_ the maximum length squared used to construct the
+ *                        cells. */
+cell_pool::cell_pool(double max_len_sq_) : max_len_sq(max_len_sq_), nt(0),
+	pc(NULL), pn(NULL), proto(max_len_sq_) {}
+
+/** The class destructor frees the cells and the dynamically allocated
+ * memory. */
+cell_pool::~cell_pool() {
+	for(int t=0;t<nt;t++) {
+		if(pn[t]!=NULL) delete pn[t];
+		if(pc[t]!=NULL) delete pc[t];
+	}
+	delete [] pn;
+	delete [] pc;
+}
+
+/** Prepares the pool for use by a given number of threads. This extends the
+ * arrays of cells if necessary, and extends the memory allocations of the
+ * prototype cell to match all of the cells in the pool, so that any cells
+ * that are created by the threads start with the same allocations. The routine
+ * must be called outside of a parallel region.
+ * \param[in] nt_ the number of threads. */
+void cell_pool::setup(int nt_) {
+	int t;
+	for(t=0;t<nt;t++) {
+		if(pc[t]!=NULL) proto.match_memory(*pc[t]);
+		if(pn[t]!=NULL) proto.match_memory(*pn[t]);
+	}
+	if(nt_>nt) {
+		voronoicell **npc=new voronoicell*[nt_];
+		voronoicell_neighbor **npn=new voronoicell_neighbor*[nt_];
+		for(t=0;t<nt;t++) {npc[t]=pc[t];npn[t]=pn[t];}
+		for(;t<nt_;t++) {npc[t]=NULL;npn[t]=NULL;}
+		delete [] pn;pn=npn;
+		delete [] pc;pc=npc;
+		nt=nt_;
+	}
+}
+
+}
@@ -0,0 +1,83 @@
+// Voro++, a 3D cell-based Voronoi library
+//
+// Author   : Chris H. Rycroft (LBL / UC Berkeley)
+// Email    : chr@alum.mit.edu
+// Date     : August 30th 2011
+
+/** \file c_pool.hh
+ * \brief Header file for the cell_pool class. */
+
+#ifndef VOROPP_C_POOL_HH
+#define VOROPP_C_POOL_HH
+
+#include <cstdio>
+
+#include "config.hh"
+#include "cell.hh"
+
+namespace voro {
+
+/** \brief A class holding a persistent set of Voronoi cells for each thread.
+ *
+ * Constructing a Voronoi cell allocates its vertex and edge arrays, and during
+ * the computation of a complex cell these arrays may need to be extended
+ * several times. This class keeps one voronoicell and one voronoicell_neighbor
+ * for each thread, so that the routines of a container can reuse cells whose
+ * memory has already grown to a sufficient size, rather than constructing new
+ * ones on each call. The memory allocations of all of the cells are recorded
+ * in a prototype cell, and when a new cell is needed, for example when more
+ * threads are used than before, it is created with allocations that match
+ * the prototype. Since the cells are shared between calls, the routines of a
+ * container that use the pool should not be called concurrently. */
+class cell_pool {
+	public:
+		cell_pool(double max_len_sq_);
+		~cell_pool();
+		void setup(int nt_);
+		template<class v_cell>
+		v_cell& fetch(int t);
+	private:
+		/** The maximum length squared used to construct the cells. */
+		const double max_len_sq;
+		/** The number of threads that there is space for. */
+		int nt;
+		/** The cells without neighbor information for each thread. */
+		voronoicell **pc;
+		/** The cells with neighbor information for each thread. */
+		voronoicell_neighbor **pn;
+		/** A cell whose memory allocations are at least as large as
+		 * those of all of the cells in the pool. */
+		voronoicell proto;
+};
+
+/** Returns the cell without neighbor information for a thread, creating it if
+ * necessary. The setup routine must have been called with a number of threads
+ * larger than the thread number.
+ * \param[in] t the thread number.
+ * \return A reference to the cell. */
+template<>
+inline voronoicell& cell_pool::fetch<voronoicell>(int t) {
+	if(pc[t]==NULL) {
+		pc[t]=new voronoicell(max_len_sq);
+		pc[t]->match_memory(proto);
+	}
+	return *pc[t];
+}
+
+/** Returns the cell with neighbor information for a thread, creating it if
+ * necessary. The setup routine must have been called with a number of threads
+ * larger than the thread number.
+ * \param[in] t the thread number.
+ * \return A reference to the cell. */
+template<>
+inline voronoicell_neighbor& cell_pool::fetch<voronoicell_neighbor>(int t) {
+	if(pn[t]==NULL) {
+		pn[t]=new voronoicell_neighbor(max_len_sq);
+		pn[t]->match_memory(proto);
+	}
+	return *pn[t];
+}
+
+}
+
+#endif
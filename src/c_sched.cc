@@ -0,0 +1,184 @@
+// Voro++, a 3D cell-based Voronoi library
+//
+// Author   : Chris H. Rycroft (LBL / UC Berkeley)
+// Email    : chr@alum.mit.edu
+// Date     : August 30th 2011
+
+/** \file c_sched.cc
+ * \brief Function implementations for the block_scheduler class. */
+
+#include "c_sched.hh"
+#include "common.hh"
+
+namespace voro {
+
+/** The class destructor frees the dynamically allocated memory. */
+block_scheduler::~block_scheduler() {
+#ifdef _OPENMP
+	for(int t=0;t<nt;t++) omp_destroy_lock(lk+t);
+	delete [] lk;
+#endif
+	delete [] tlast;
+	delete [] cur;
+	delete [] hi;
+	delete [] lo;
+	delete [] steals;
+	delete [] cdone;
+	delete [] idle;
+	delete [] busy;
+	delete [] cw;
+	delete [] cs;
+	delete [] ru;
+}
+
+/** Doubles the memory allocation for the runs. */
+void block_scheduler::add_run_memory() {
+	int *nru,i;
+	rmem<<=1;
+	if(rmem>max_run_size)
+		voro_fatal_error("Run memory allocation exceeded absolute maximum",VOROPP_MEMORY_ERROR);
+	nru=new int[6*rmem];
+	for(i=0;i<6*nr;i++) nru[i]=ru[i];
+	delete [] ru;
+	ru=nru;
+}
+
+/** Groups the runs into chunks that each contain approximately the same
+ * number of particles, and allocates the per-thread arrays. Since the target
+ * chunk size depends only on the total number of particles, the chunks are the
+ * same regardless of the number of threads. */
+void block_scheduler::setup_chunks() {
+	int r,n,w=0,tot=0,tw=tp/sched_target_chunks;
+	if(tw<1) tw=1;
+
+	// Record the first run and the number of prior particles for each
+	// chunk
+	cs=new int[nr+1];cw=new int[nr+1];
+	for(nc=r=0;r<nr;r++) {
+		if(w==0) {cs[nc]=r;cw[nc++]=tot;}
+		n=ru[6*r+5]-ru[6*r+4];
+		w+=n;tot+=n;
+		if(w>=tw) w=0;
+	}
+	cs[nc]=nr;cw[nc]=tot;
+
+	// Allocate the per-thread information
+	busy=new double[nt];idle=new double[nt];tlast=new double[nt];
+	cdone=new int[nt];steals=new int[nt];
+	lo=new int[nt];hi=new int[nt];cur=new int[nt];
+#ifdef _OPENMP
+	lk=new omp_lock_t[nt];
+	for(int t=0;t<nt;t++) omp_init_lock(lk+t);
+#endif
+	start();
+}
+
+/** Resets the timing information and hands out the chunks to the threads, so
+ * that each thread receives a contiguous range of chunks containing roughly
+ * equal numbers of particles. This is called automatically on construction,
+ * and can be called again to reuse the class for another pass over the same
+ * particles. */
+void block_scheduler::start() {
+	int c=0,t;
+	for(t=0;t<nt;t++) {
+		lo[t]=c;
+		while(c<nc&&static_cast<double>(cw[c])*nt<static_cast<double>(t+1)*tp) c++;
+		hi[t]=c;
+		busy[t]=idle[t]=0;cdone[t]=steals[t]=0;cur[t]=-1;
+	}
+	t0=voro_wtime();
+}
+
+/** Marks the end of a pass over the particles, after all the threads have
+ * finished. The idle time of each thread is set to the time since the start
+ * routine was called, minus the time that the thread spent working. */
+void block_scheduler::finish() {
+	double el=voro_wtime()-t0;
+	for(int t=0;t<nt;t++) idle[t]=el-busy[t];
+}
+
+/** Finds the next chunk for a thread to work on. The thread first takes a
+ * chunk from the front of its own range, and if this is empty, it tries to
+ * steal from another thread. The time since the previous call is added to the
+ * thread's busy time.
+ * \param[in] t the number of the thread.
+ * \param[out] c the chunk to work on.
+ * \return True if a chunk was found, false if there are no chunks left. */
+bool block_scheduler::next_chunk(int t,int &c) {
+	if(cur[t]>=0) {busy[t]+=voro_wtime()-tlast[t];cdone[t]++;}
+#ifdef _OPENMP
+	omp_set_lock(lk+t);
+#endif
+	bool found=lo[t]<hi[t];
+	if(found) c=lo[t]++;
+#ifdef _OPENMP
+	omp_unset_lock(lk+t);
+#endif
+	if(found||steal(t,c)) {
+		cur[t]=c;tlast[t]=voro_wtime();
+		return true;
+	}
+	cur[t]=-1;
+	return false;
+}
+
+/** Steals the back half of the largest remaining range of chunks from another
+ * thread. The first stolen chunk is returned, and the rest become the thread's
+ * own range.
+ * \param[in] t the number of the thread that is stealing.
+ * \param[out] c the chunk to work on.
+ * \return True if a chunk was stolen, false if all ranges are empty. */
+bool block_scheduler::steal(int t,int &c) {
+	int u,v,n,bn;
+	while(true) {
+
+		// Find the thread with the most remaining chunks
+		for(bn=0,v=-1,u=0;u<nt;u++) if(u!=t) {
+#ifdef _OPENMP
+			omp_set_lock(lk+u);
+#endif
+			n=hi[u]-lo[u];
+#ifdef _OPENMP
+			omp_unset_lock(lk+u);
+#endif
+			if(n>bn) {bn=n;v=u;}
+		}
+		if(v==-1) return false;
+
+		// Take the back half of its range, checking that the range
+		// was not emptied in the meantime
+#ifdef _OPENMP
+		omp_set_lock(lk+v);
+#endif
+		n=hi[v]-lo[v];
+		if(n>0) {
+			n=(n+1)>>1;
+			hi[v]-=n;c=hi[v];
+		}
+#ifdef _OPENMP
+		omp_unset_lock(lk+v);
+#endif
+		if(n>0) {
+#ifdef _OPENMP
+			omp_set_lock(lk+t);
+#endif
+			lo[t]=c+1;hi[t]=c+n;
+#ifdef _OPENMP
+			omp_unset_lock(lk+t);
+#endif
+			steals[t]++;
+			return true;
+		}
+	}
+}
+
+/** Prints the number of chunks processed, the number of steals, and the busy
+ * and idle times for each thread.
+ * \param[in] fp the file handle to write to. */
+void block_scheduler::print_timing(FILE *fp) {
+	for(int t=0;t<nt;t++)
+		fprintf(fp,"Thread %d: %d chunks, %d steals, busy %g s, idle %g s\n",
+			t,cdone[t],steals[t],busy[t],idle[t]);
+}
+
+}
@@ -0,0 +1,139 @@
+// Voro++, a 3D cell-based Voronoi library
+//
+// Author   : Chris H. Rycroft (LBL / UC Berkeley)
+// Email    : chr@alum.mit.edu
+// Date     : August 30th 2011
+
+/** \file c_sched.hh
+ * \brief Header file for the block_scheduler class. */
+
+#ifndef VOROPP_C_SCHED_HH
+#define VOROPP_C_SCHED_HH
+
+#include <cstdio>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "config.hh"
+
+namespace voro {
+
+/** \brief Class for sharing the particles visited by a loop among several
+ * threads.
+ *
+ * The particles visited by any of the loop classes are recorded as a sequence
+ * of runs, where each run is a set of consecutive particles within a single
+ * block. The runs are grouped into chunks that contain roughly equal numbers
+ * of particles, and each thread is initially given a contiguous range of
+ * chunks with a similar total number of particles. A thread takes chunks from
+ * the front of its own range, and once its range is exhausted, it steals the
+ * back half of the largest remaining range of another thread. This keeps all
+ * threads busy when the number of particles per block varies widely. The class
+ * also records how long each thread spends working on chunks, and how long it
+ * spends idle. */
+class block_scheduler {
+	public:
+		/** The number of threads that the chunks are shared among. */
+		const int nt;
+		/** The number of runs. */
+		int nr;
+		/** The number of chunks. */
+		int nc;
+		/** The total number of particles in all of the runs. */
+		int tp;
+		/** An array holding the runs. Each run has six entries: the
+		 * block index, the x, y, and z indices of the block, and the
+		 * range of particle indices within the block, with the upper
+		 * index being exclusive. */
+		int *ru;
+		/** An array holding the index of the first run in each chunk.
+		 * It has an additional entry at the end holding the total
+		 * number of runs. */
+		int *cs;
+		/** An array holding the total number of particles in all of
+		 * the chunks prior to each chunk. It has an additional entry
+		 * at the end holding the total number of particles. */
+		int *cw;
+		/** The time that each thread has spent working on chunks. */
+		double *busy;
+		/** The time that each thread has spent idle. */
+		double *idle;
+		/** The number of chunks that each thread has processed. */
+		int *cdone;
+		/** The number of times that each thread has stolen work from
+		 * another thread. */
+		int *steals;
+		/** The class constructor records the particles visited by a
+		 * loop class, groups them into chunks, and allocates the
+		 * per-thread information.
+		 * \param[in] vl the loop class to use.
+		 * \param[in] nt_ the number of threads to share the chunks
+		 *                among. */
+		template<class c_loop>
+		block_scheduler(c_loop &vl,int nt_=default_threads()) : nt(nt_),
+			nr(0), tp(0), ru(new int[6*init_run_size]), rmem(init_run_size) {
+			int *rp=ru;
+			if(vl.start()) do {
+				if(nr>0&&rp[0]==vl.ijk&&rp[5]==vl.q) rp[5]++;
+				else {
+					if(nr==rmem) add_run_memory();
+					rp=ru+6*nr++;
+					*rp=vl.ijk;rp[1]=vl.i;rp[2]=vl.j;rp[3]=vl.k;
+					rp[4]=vl.q;rp[5]=vl.q+1;
+				}
+				tp++;
+			} while(vl.inc());
+			setup_chunks();
+		}
+		~block_scheduler();
+		void start();
+		void finish();
+		bool next_chunk(int t,int &c);
+		void print_timing(FILE *fp=stdout);
+		/** Returns the number of threads to use when none is
+		 * specified, which is the maximum number of OpenMP threads, or
+		 * one if the code is compiled without OpenMP. */
+		static inline int default_threads() {
+#ifdef _OPENMP
+			return omp_get_max_threads();
+#else
+			return 1;
+#endif
+		}
+		/** Returns the number of the calling thread within the
+		 * current parallel region. */
+		static inline int thread_num() {
+#ifdef _OPENMP
+			return omp_get_thread_num();
+#else
+			return 0;
+#endif
+		}
+	private:
+		/** The current memory allocation for runs. */
+		int rmem;
+		/** The first chunk in each thread's remaining range. */
+		int *lo;
+		/** The end of each thread's remaining range (exclusive). */
+		int *hi;
+		/** The chunk that each thread is currently working on, or -1
+		 * if it is not working on a chunk. */
+		int *cur;
+		/** The time at which each thread started its current chunk. */
+		double *tlast;
+		/** The time at which the start routine was called. */
+		double t0;
+#ifdef _OPENMP
+		/** Locks protecting each thread's range of chunks. */
+		omp_lock_t *lk;
+#endif
+		void add_run_memory();
+		void setup_chunks();
+		bool steal(int t,int &c);
+};
+
+}
+
+#endif
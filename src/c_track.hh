@@ -0,0 +1,279 @@
+// Voro++, a 3D cell-based Voronoi library
+//
+// Author   : Chris H. Rycroft (LBL / UC Berkeley)
+// Email    : chr@alum.mit.edu
+// Date     : August 30th 2011
+
+/** \file c_track.hh
+ * \brief Header file for the cell_tracker class. */
+
+#ifndef VOROPP_C_TRACK_HH
+#define VOROPP_C_TRACK_HH
+
+#include <vector>
+
+#include "config.hh"
+#include "cell.hh"
+#include "c_loops.hh"
+
+namespace voro {
+
+/** \brief A class that keeps the Voronoi cells of a container up to date as
+ * its particles move, recomputing only the cells that could have changed.
+ *
+ * This class stores the volume and the neighbors of the Voronoi cell of every
+ * particle in a container, along with the cell's security radius, which is the
+ * distance beyond which no particle could cut the cell. Particles are moved
+ * and removed through this class, which marks as dirty the cell of the
+ * particle itself, and the cells that could be affected. At the old position,
+ * these are the neighbors of the particle's cell if it is up to date. At the
+ * new position, and at the old position if the particle's cell is dirty,
+ * these are the cells whose security radius reaches the position, which are
+ * found with a c_loop_subset over a sphere whose radius is the largest
+ * security radius of any cell. Cells that are removed entirely by the planes
+ * of larger neighboring particles in the radical tessellation have no
+ * security radius, so they are recomputed on every update, while cells that are
+ * removed by the walls alone are never recomputed. The update() routine then
+ * recomputes only the dirty cells, so that the stored cells match a full
+ * computation. Since taking a particle out of a block changes the order of the
+ * remaining particles, and therefore the order in which the planes are cut, the
+ * stored volumes may differ from those of a full computation by rounding
+ * errors.
+ *
+ * The template parameter is the container class, which can be the container
+ * or container_poly class. The particle IDs should be non-negative, since they
+ * are used to index the stored cells. Particles that are put into the
+ * container directly, rather than being moved through this class, are not
+ * tracked until compute() is called again. */
+template<class c_class>
+class cell_tracker {
+	public:
+		/** A reference to the container class. */
+		c_class &con;
+		/** The number of cells that were computed in the last call to
+		 * compute() or update(). */
+		int recomputed;
+		/** The class constructor sets up a tracker for a container,
+		 * without computing any cells.
+		 * \param[in] con_ a reference to the container class. */
+		cell_tracker(c_class &con_) : con(con_), recomputed(0), smax(0) {}
+		void compute();
+		bool move(int n,double x,double y,double z);
+		bool remove(int n);
+		int update();
+		/** Returns the number of cells waiting to be recomputed.
+		 * \return The number of dirty cells. */
+		inline int dirty_cells() {return static_cast<int>(dl.size());}
+		/** Checks whether a particle's cell is waiting to be
+		 * recomputed.
+		 * \param[in] n the ID of the particle.
+		 * \return True if the cell is dirty, false otherwise. */
+		inline bool dirty(int n) {return tracked(n)&&st[n]==2;}
+		/** Checks whether a particle has a stored Voronoi cell. This is
+		 * false for particles that are not in the container, for
+		 * dirty cells, and for cells that were removed entirely by
+		 * walls.
+		 * \param[in] n the ID of the particle.
+		 * \return True if the particle has a stored cell, false
+		 *         otherwise. */
+		inline bool has_cell(int n) {return tracked(n)&&st[n]==1&&sr[n]>0;}
+		/** Returns the volume of a particle's stored Voronoi cell.
+		 * \param[in] n the ID of the particle.
+		 * \return The volume, or zero if there is no stored cell. */
+		inline double volume(int n) {return has_cell(n)?vol[n]:0;}
+		/** Returns the security radius of a particle's stored Voronoi
+		 * cell.
+		 * \param[in] n the ID of the particle.
+		 * \return The security radius, or zero if there is no stored
+		 *         cell. */
+		inline double security_radius(int n) {return has_cell(n)?sr[n]:0;}
+		/** Returns the neighbors of a particle's stored Voronoi cell.
+		 * \param[in] n the ID of the particle.
+		 * \param[out] v a vector in which to store the IDs of the
+		 *               neighboring particles and walls, which is
+		 *               empty if there is no stored cell. */
+		inline void neighbors(int n,std::vector<int> &v) {
+			if(has_cell(n)) v=ng[n];else v.clear();
+		}
+	private:
+		/** The largest security radius of any stored cell. This is an
+		 * upper bound, which is only reduced when all of the cells
+		 * are computed. */
+		double smax;
+		/** The state of each particle's cell: 0 if the particle is not
+		 * tracked, 1 if the cell is stored, and 2 if the cell is
+		 * dirty. */
+		std::vector<char> st;
+		/** The position of each particle when its cell was
+		 * computed. */
+		std::vector<double> pos;
+		/** The security radius of each stored cell, which is zero if
+		 * the cell was removed entirely by walls. */
+		std::vector<double> sr;
+		/** The volume of each stored cell. */
+		std::vector<double> vol;
+		/** The neighbors of each stored cell. */
+		std::vector<std::vector<int> > ng;
+		/** The IDs of the particles whose cells are dirty. */
+		std::vector<int> dl;
+		/** The IDs of the particles whose cells could not be
+		 * computed. */
+		std::vector<int> ev;
+		/** Checks whether a particle ID is within the range of the
+		 * stored cells and is tracked.
+		 * \param[in] n the ID of the particle.
+		 * \return True if the particle is tracked, false otherwise. */
+		inline bool tracked(int n) {
+			return n>=0&&n<static_cast<int>(st.size())&&st[n]!=0;
+		}
+		/** Marks a particle's cell as dirty.
+		 * \param[in] n the ID of the particle. */
+		inline void mark(int n) {
+			if(st[n]==1) {st[n]=2;dl.push_back(n);}
+		}
+		void mark_vacated(int n);
+		void mark_near(double x,double y,double z);
+		void store(int n,voronoicell_neighbor &c,bool ok,int ijk,int q);
+};
+
+/** Computes and stores the Voronoi cells of all the particles in the
+ * container, discarding anything previously stored. */
+template<class c_class>
+void cell_tracker<c_class>::compute() {
+	int n,mid=-1;
+	c_loop_all vl(con);
+	if(vl.start()) do if(vl.pid()>mid) mid=vl.pid(); while(vl.inc());
+	st.assign(mid+1,0);pos.resize(3*(mid+1));sr.assign(mid+1,0);vol.assign(mid+1,0);
+	ng.assign(mid+1,std::vector<int>());
+	dl.clear();ev.clear();smax=0;recomputed=0;
+	con.pool.setup(1);
+	voronoicell_neighbor &c=con.pool.template fetch<voronoicell_neighbor>(0);
+	if(vl.start()) do {
+		n=vl.pid();
+		if(n<0) voro_fatal_error("Negative particle ID in cell tracker",VOROPP_INTERNAL_ERROR);
+		store(n,c,con.compute_cell(c,vl),vl.ijk,vl.q);
+		recomputed++;
+	} while(vl.inc());
+}
+
+/** Moves a particle, using the move() routine of the container, and marks the
+ * cells that could be affected as dirty.
+ * \param[in] n the ID of the particle.
+ * \param[in] (x,y,z) the new position of the particle.
+ * \return True if the particle was moved, false if it is not tracked or if
+ *         the new position was outside the container, in which case the
+ *         particle is removed. */
+template<class c_class>
+bool cell_tracker<c_class>::move(int n,double x,double y,double z) {
+	if(!tracked(n)) return false;
+	double *pp=&pos[3*n];
+	if(*pp==x&&pp[1]==y&&pp[2]==z&&st[n]==1) return true;
+	mark_vacated(n);
+	mark_near(x,y,z);
+	if(!con.move(n,x,y,z)) {st[n]=0;return false;}
+	mark(n);
+	*pp=x;pp[1]=y;pp[2]=z;
+	return true;
+}
+
+/** Removes a particle, using the remove() routine of the container, and marks
+ * the cells that could be affected as dirty.
+ * \param[in] n the ID of the particle.
+ * \return True if the particle was removed, false if it was not tracked. */
+template<class c_class>
+bool cell_tracker<c_class>::remove(int n) {
+	if(!tracked(n)) return false;
+	mark_vacated(n);
+	st[n]=0;
+	ng[n].clear();
+	return con.remove(n);
+}
+
+/** Recomputes all of the dirty cells.
+ * \return The number of cells that were recomputed. */
+template<class c_class>
+int cell_tracker<c_class>::update() {
+	int ijk,q;
+	std::vector<int>::iterator it;
+	recomputed=0;
+	for(it=ev.begin();it<ev.end();it++) mark(*it);
+	ev.clear();
+	con.pool.setup(1);
+	voronoicell_neighbor &c=con.pool.template fetch<voronoicell_neighbor>(0);
+	for(it=dl.begin();it<dl.end();it++) if(st[*it]==2&&con.pix.locate(con,*it,ijk,q)) {
+		store(*it,c,con.compute_cell(c,ijk,q),ijk,q);
+		recomputed++;
+	}
+	dl.clear();
+	return recomputed;
+}
+
+/** Marks the cells that could be affected by a particle leaving its current
+ * position as dirty. If the particle's cell is up to date, then these are the
+ * neighbors of the cell, and otherwise they are found from the security
+ * radii.
+ * \param[in] n the ID of the particle. */
+template<class c_class>
+void cell_tracker<c_class>::mark_vacated(int n) {
+	if(st[n]==1) {
+		std::vector<int>::iterator it;
+		for(it=ng[n].begin();it<ng[n].end();it++)
+			if(*it>=0&&*it<static_cast<int>(st.size())) mark(*it);
+	} else mark_near(pos[3*n],pos[3*n+1],pos[3*n+2]);
+}
+
+/** Marks all of the stored cells whose security radius reaches a given
+ * position as dirty.
+ * \param[in] (x,y,z) the position. */
+template<class c_class>
+void cell_tracker<c_class>::mark_near(double x,double y,double z) {
+	int n;
+	double qx,qy,qz;
+	c_loop_subset vl(con);
+	vl.setup_sphere(x,y,z,smax,true);
+	if(vl.start()) do {
+		n=vl.pid();
+		if(n<static_cast<int>(st.size())&&st[n]==1) {
+
+			// Test the distance to the periodic image of the
+			// particle that the loop has found, since several
+			// images may be within range
+			vl.image_pos(qx,qy,qz);
+			qx-=x;qy-=y;qz-=z;
+			if(qx*qx+qy*qy+qz*qz<=sr[n]*sr[n]) mark(n);
+		}
+	} while(vl.inc());
+}
+
+/** Stores the information about a particle's Voronoi cell.
+ * \param[in] n the ID of the particle.
+ * \param[in] c the computed Voronoi cell.
+ * \param[in] ok whether the cell was computed, which is false if it was
+ *               removed entirely by walls.
+ * \param[in] (ijk,q) the location of the particle in the container. */
+template<class c_class>
+void cell_tracker<c_class>::store(int n,voronoicell_neighbor &c,bool ok,int ijk,int q) {
+	particle_real *pp=con.p[ijk]+con.ps*q;
+	pos[3*n]=*pp;pos[3*n+1]=pp[1];pos[3*n+2]=pp[2];
+	st[n]=1;
+	if(ok) {
+		sr[n]=con.r_security(c.max_radius_squared(),ijk,q);
+		if(sr[n]>smax) smax=sr[n];
+		vol[n]=c.volume();
+		c.neighbors(ng[n]);
+	} else {
+		sr[n]=0;vol[n]=0;
+		ng[n].clear();
+
+		// Record the cell to be recomputed on every update, unless
+		// the walls alone remove it
+		int ci,cj,ck=ijk/con.nxy,i,j,k,disp;
+		double x,y,z;
+		cj=(ijk-con.nxy*ck)/con.nx;ci=ijk-con.nxy*ck-con.nx*cj;
+		if(con.initialize_voronoicell(c,ijk,q,ci,cj,ck,i,j,k,x,y,z,disp)) ev.push_back(n);
+	}
+}
+
+}
+
+#endif
@@ -13,6 +13,7 @@
 #include "config.hh"
 #include "common.hh"
 #include "cell.hh"
+#include "o_custom.hh"
 
 namespace voro {
 
@@ -20,7 +21,7 @@ namespace voro {
 voronoicell_base::voronoicell_base(double max_len_sq) :
 	current_vertices(init_vertices), current_vertex_order(init_vertex_order),
 	current_delete_size(init_delete_size), current_delete2_size(init_delete2_size),
-	current_xsearch_size(init_xsearch_size),
+	current_xsearch_size(init_xsearch_size), p(0),
 	ed(new int*[current_vertices]), nu(new int[current_vertices]),
 	mask(new unsigned int[current_vertices]),
 	pts(new double[current_vertices<<2]), tol(tolerance*max_len_sq),
@@ -36,8 +37,8 @@ voronoicell_base::voronoicell_base(double max_len_sq) :
 		mem[i]=init_n_vertices;mec[i]=0;
 		mep[i]=new int[init_n_vertices*((i<<1)+1)];
 	}
-	mem[3]=init_3_vertices;mec[3]=0;
-	mep[3]=new int[init_3_vertices*7];
+	mem[3]=current_vertices;mec[3]=0;
+	mep[3]=new int[current_vertices*7];
 	for(i=4;i<current_vertex_order;i++) {
 		mem[i]=init_n_vertices;mec[i]=0;
 		mep[i]=new int[init_n_vertices*((i<<1)+1)];
@@ -65,6 +66,23 @@ void voronoicell_base::check_memory_for_copy(vc_class &vc,voronoicell_base* vb)
 	while(current_vertices<vb->p) add_memory_vertices(vc);
 }
 
+/** Extends the memory allocations so that they are at least as large as those
+ * of another cell. This allows a new cell to be prepared for a computation in
+ * which cells of a similar complexity have already been constructed, so that
+ * its memory does not need to be extended during the plane cutting.
+ * \param[in] vc a reference to the specialized version of the calling class.
+ * \param[in] vb a pointer to the class whose allocations should be matched. */
+template<class vc_class>
+void voronoicell_base::match_memory(vc_class &vc,voronoicell_base* vb) {
+	while(current_vertex_order<vb->current_vertex_order) add_memory_vorder(vc);
+	for(int i=0;i<vb->current_vertex_order;i++) while(mem[i]<vb->mem[i]) add_memory(vc,i);
+	while(current_vertices<vb->current_vertices) add_memory_vertices(vc);
+	stackp=ds;stackp2=ds2;stackp3=xse;
+	while(current_delete_size<vb->current_delete_size) add_memory_ds();
+	while(current_delete2_size<vb->current_delete2_size) add_memory_ds2();
+	while(current_xsearch_size<vb->current_xsearch_size) add_memory_xse();
+}
+
 /** Copies the vertex and edge information from another class. The routine
  * assumes that enough memory is available for the copy.
  * \param[in] vb a pointer to the class to copy. */
@@ -73,10 +91,14 @@ void voronoicell_base::copy(voronoicell_base* vb) {
 	p=vb->p;up=0;
 	for(i=0;i<current_vertex_order;i++) {
 		mec[i]=vb->mec[i];
+		if(i==3) continue;
 		for(j=0;j<mec[i]*(2*i+1);j++) mep[i][j]=vb->mep[i][j];
 		for(j=0;j<mec[i]*(2*i+1);j+=2*i+1) ed[mep[i][j+2*i]]=mep[i]+j;
 	}
-	for(i=0;i<p;i++) nu[i]=vb->nu[i];
+	for(i=0;i<p;i++) if((nu[i]=vb->nu[i])==3) {
+		ed[i]=mep[3]+7*i;
+		for(j=0;j<7;j++) ed[i][j]=vb->ed[i][j];
+	}
 	for(i=0;i<(p<<2);i++) pts[i]=vb->pts[i];
 }
 
@@ -87,10 +109,14 @@ void voronoicell_neighbor::operator=(voronoicell &c) {
 	voronoicell_base *vb=((voronoicell_base*) &c);
 	check_memory_for_copy(*this,vb);copy(vb);
 	int i,j;
-	for(i=0;i<c.current_vertex_order;i++) {
+	for(i=0;i<c.current_vertex_order;i++) if(i!=3) {
 		for(j=0;j<c.mec[i]*i;j++) mne[i][j]=0;
 		for(j=0;j<c.mec[i];j++) ne[c.mep[i][(2*i+1)*j+2*i]]=mne[i]+(j*i);
 	}
+	for(i=0;i<p;i++) if(nu[i]==3) {
+		ne[i]=mne[3]+3*i;
+		*ne[i]=ne[i][1]=ne[i][2]=0;
+	}
 }
 
 /** Copies the information from another voronoicell_neighbor class into this
@@ -100,10 +126,14 @@ void voronoicell_neighbor::operator=(voronoicell_neighbor &c) {
 	voronoicell_base *vb=((voronoicell_base*) &c);
 	check_memory_for_copy(*this,vb);copy(vb);
 	int i,j;
-	for(i=0;i<c.current_vertex_order;i++) {
+	for(i=0;i<c.current_vertex_order;i++) if(i!=3) {
 		for(j=0;j<c.mec[i]*i;j++) mne[i][j]=c.mne[i][j];
 		for(j=0;j<c.mec[i];j++) ne[c.mep[i][(2*i+1)*j+2*i]]=mne[i]+(j*i);
 	}
+	for(i=0;i<p;i++) if(nu[i]==3) {
+		ne[i]=mne[3]+3*i;
+		for(j=0;j<3;j++) ne[i][j]=c.ne[i][j];
+	}
 }
 
 /** Translates the vertices of the Voronoi cell by a given vector.
@@ -125,12 +155,14 @@ void voronoicell_base::translate(double x,double y,double z) {
  * vertex code, the auxiliary delete stack is scanned to find out how to update
  * the ed value. If the template has been instantiated with the neighbor
  * tracking turned on, then the routine also reallocates the corresponding mne
- * array.
+ * array. Since the order three vertices are stored by index, their memory is
+ * increased along with the number of vertices.
  * \param[in] i the order of the vertex memory to be increased. */
 template<class vc_class>
 void voronoicell_base::add_memory(vc_class &vc,int i) {
 	int s=(i<<1)+1;
-	if(mem[i]==0) {
+	if(i==3) add_memory_vertices(vc);
+	else if(mem[i]==0) {
 		vc.n_allocate(i,init_n_vertices);
 		mep[i]=new int[init_n_vertices*s];
 		mem[i]=init_n_vertices;
@@ -185,13 +217,16 @@ void voronoicell_base::add_memory(vc_class &vc,int i) {
 }
 
 /** Doubles the maximum number of vertices allowed, by reallocating the ed, nu,
- * and pts arrays. If the allocation exceeds the absolute maximum set in
- * max_vertices, then the routine exits with a fatal error. If the template has
- * been instantiated with the neighbor tracking turned on, then the routine
- * also reallocates the ne array. */
+ * and pts arrays, and the mep array for the order three vertices. Any ed
+ * pointers into the order three storage are moved across, including those of
+ * vertices in the middle of being modified by the plane routine. If the
+ * allocation exceeds the absolute maximum set in max_vertices, then the
+ * routine exits with a fatal error. If the template has been instantiated
+ * with the neighbor tracking turned on, then the routine also reallocates the
+ * ne array and the order three part of the mne array. */
 template<class vc_class>
 void voronoicell_base::add_memory_vertices(vc_class &vc) {
-	int i=(current_vertices<<1),j,**pp,*pnu;
+	int i=(current_vertices<<1),j,**pp,*pnu,*p3;
 	unsigned int* pmask;
 	if(i>max_vertices) voro_fatal_error("Vertex memory allocation exceeded absolute maximum",VOROPP_MEMORY_ERROR);
 #if VOROPP_VERBOSE >=2
@@ -201,6 +236,10 @@ void voronoicell_base::add_memory_vertices(vc_class &vc) {
 	pp=new int*[i];
 	for(j=0;j<current_vertices;j++) pp[j]=ed[j];
 	delete [] ed;ed=pp;
+	p3=new int[7*i];
+	for(j=0;j<7*current_vertices;j++) p3[j]=mep[3][j];
+	for(j=0;j<p;j++) if(ed[j]>=mep[3]&&ed[j]<mep[3]+7*current_vertices) ed[j]=p3+(ed[j]-mep[3]);
+	delete [] mep[3];mep[3]=p3;mem[3]=i;
 	vc.n_add_memory_vertices(i);
 	pnu=new int[i];
 	for(j=0;j<current_vertices;j++) pnu[j]=nu[j];
@@ -701,6 +740,42 @@ bool voronoicell_base::definite_min(int &lp,int &us,double &l,double &u,unsigned
 	return true;
 }
 
+/** Removes the edge information of a vertex from the mep array. For orders
+ * other than three, the last entry of the corresponding mep array is moved into
+ * the gap, and the back pointer is used to update its ed pointer. Order three
+ * vertices are stored by index, so only the count needs to be changed.
+ * \param[in] vc a reference to the specialized version of the calling class.
+ * \param[in] v the vertex to consider. */
+template<class vc_class>
+inline void voronoicell_base::delete_edges(vc_class &vc,int v) {
+	int j=nu[v],*edp=ed[v],*edd;
+	if(j==3) {mec[3]--;return;}
+	edd=mep[j]+((j<<1)+1)*--mec[j];
+	while(edp<ed[v]+(j<<1)+1) *(edp++)=*(edd++);
+	vc.n_set_aux2_copy(v,j);
+	vc.n_copy_pointer(ed[v][j<<1],v);
+	ed[ed[v][j<<1]]=ed[v];
+}
+
+/** Transfers the edge information of one vertex to another index, when the
+ * vertices are being renumbered. For order three vertices, the edge
+ * information is copied to the position for the new index.
+ * \param[in] vc a reference to the specialized version of the calling class.
+ * \param[in] a the new index.
+ * \param[in] b the vertex to move. */
+template<class vc_class>
+inline void voronoicell_base::move_edges(vc_class &vc,int a,int b) {
+	if(nu[b]==3) {
+		int *edp=mep[3]+7*a;
+		for(int l=0;l<7;l++) edp[l]=ed[b][l];
+		ed[a]=edp;
+		vc.n_copy_order3(a,b);
+	} else {
+		vc.n_copy_pointer(a,b);
+		ed[a]=ed[b];
+	}
+}
+
 /** Cuts the Voronoi cell by a particle whose center is at a separation of
  * (x,y,z) from the cell center. The value of rsq should be initially set to
  * \f$x^2+y^2+z^2\f$.
@@ -714,7 +789,7 @@ bool voronoicell_base::nplane(vc_class &vc,double x,double y,double z,double rsq
 	int i,j,lp=up,cp,qp,*dsp;
 	int us=0,ls=0;
 	unsigned int uw,lw;
-	int *edp,*edd;stackp=ds;
+	int *edp;stackp=ds;
 	double u,l=0;up=0;
 
 	// Initialize the safe testing routine
@@ -823,12 +898,7 @@ bool voronoicell_base::nplane(vc_class &vc,double x,double y,double z,double rsq
 	while(stackp>ds) {
 		--p;
 		while(ed[p][nu[p]]==-1) {
-			j=nu[p];
-			edp=ed[p];edd=(mep[j]+((j<<1)+1)*--mec[j]);
-			while(edp<ed[p]+(j<<1)+1) *(edp++)=*(edd++);
-			vc.n_set_aux2_copy(p,j);
-			vc.n_copy_pointer(ed[p][(j<<1)],p);
-			ed[ed[p][(j<<1)]]=ed[p];
+			delete_edges(vc,p);
 			--p;
 		}
 		up=*(--stackp);
@@ -840,16 +910,10 @@ bool voronoicell_base::nplane(vc_class &vc,double x,double y,double z,double rsq
 			pts[(up<<2)+2]=pts[(p<<2)+2];
 
 			// Memory management
-			j=nu[up];
-			edp=ed[up];edd=(mep[j]+((j<<1)+1)*--mec[j]);
-			while(edp<ed[up]+(j<<1)+1) *(edp++)=*(edd++);
-			vc.n_set_aux2_copy(up,j);
-			vc.n_copy_pointer(ed[up][j<<1],up);
-			vc.n_copy_pointer(up,p);
-			ed[ed[up][j<<1]]=ed[up];
+			delete_edges(vc,up);
 
 			// Edge management
-			ed[up]=ed[p];
+			move_edges(vc,up,p);
 			nu[up]=nu[p];
 			for(i=0;i<nu[up];i++) ed[ed[up][i]][ed[up][nu[up]+i]]=up;
 			ed[up][nu[up]<<1]=up;
@@ -867,7 +931,7 @@ bool voronoicell_base::nplane(vc_class &vc,double x,double y,double z,double rsq
  * \return True if cell deleted, false otherwise. */
 template<class vc_class>
 bool voronoicell_base::create_facet(vc_class &vc,int lp,int ls,double l,int us,double u,int p_id) {
-	int i,j,k,qp,qs,iqs,cp,cs,rp,*edp,*edd;
+	int i,j,k,qp,qs,iqs,cp,cs,rp,*edp;
 	unsigned int lw,qw;
 	bool new_double_edge=false,double_edge=false;
 	double q,r;
@@ -946,7 +1010,7 @@ bool voronoicell_base::create_facet(vc_class &vc,int lp,int ls,double l,int us,d
 			while (nu[p]>=current_vertex_order) add_memory_vorder(vc);
 			if(mec[nu[p]]==mem[nu[p]]) add_memory(vc,nu[p]);
 			vc.n_set_pointer(p,nu[p]);
-			ed[p]=mep[nu[p]]+((nu[p]<<1)+1)*mec[nu[p]]++;
+			ed[p]=new_edges(nu[p],p);
 			ed[p][nu[p]<<1]=p;
 
 			// Copy the edges of the original vertex into the new
@@ -1018,7 +1082,7 @@ bool voronoicell_base::create_facet(vc_class &vc,int lp,int ls,double l,int us,d
 			// one. Delete the edges of the original vertex, and
 			// update the relational table.
 			vc.n_set_pointer(p,nu[p]);
-			ed[p]=mep[nu[p]]+((nu[p]<<1)+1)*mec[nu[p]]++;
+			ed[p]=new_edges(nu[p],p);
 			ed[p][nu[p]<<1]=p;
 			us=i++;
 			while(i<nu[up]) {
@@ -1082,12 +1146,11 @@ bool voronoicell_base::create_facet(vc_class &vc,int lp,int ls,double l,int us,d
 		// This point will always have three edges. Connect one of them
 		// to lp.
 		nu[p]=3;
-		if(mec[3]==mem[3]) add_memory(vc,3);
 		vc.n_set_pointer(p,3);
 		vc.n_set(p,0,p_id);
 		vc.n_copy(p,1,up,us);
 		vc.n_copy(p,2,lp,ls);
-		ed[p]=mep[3]+7*mec[3]++;
+		ed[p]=new_edges(3,p);
 		ed[p][6]=p;
 		ed[up][us]=-1;
 		ed[lp][ls]=p;
@@ -1135,13 +1198,12 @@ bool voronoicell_base::create_facet(vc_class &vc,int lp,int ls,double l,int us,d
 			pts[(p<<2)+1]=pts[(lp<<2)+1]*r+pts[(qp<<2)+1]*l;
 			pts[(p<<2)+2]=pts[(lp<<2)+2]*r+pts[(qp<<2)+2]*l;
 			nu[p]=3;
-			if(mec[3]==mem[3]) add_memory(vc,3);
 			ls=ed[qp][qs+nu[qp]];
 			vc.n_set_pointer(p,3);
 			vc.n_set(p,0,p_id);
 			vc.n_copy(p,1,qp,qs);
 			vc.n_copy(p,2,lp,ls);
-			ed[p]=mep[3]+7*mec[3]++;
+			ed[p]=new_edges(3,p);
 			*ed[p]=cp;
 			ed[p][1]=lp;
 			ed[p][3]=cs;
@@ -1271,8 +1333,8 @@ bool voronoicell_base::create_facet(vc_class &vc,int lp,int ls,double l,int us,d
 
 					// Allocate memory and copy the edges
 					// of the previous instance into it
-					vc.n_set_aux1(k);
-					edp=mep[k]+((k<<1)+1)*mec[k]++;
+					vc.n_set_aux1(k,j);
+					edp=new_edges(k,j);
 					i=0;
 					while(i<nu[j]) {
 						vc.n_copy_aux1(j,i);
@@ -1285,13 +1347,7 @@ bool voronoicell_base::create_facet(vc_class &vc,int lp,int ls,double l,int us,d
 					// Remove the previous instance with
 					// fewer vertices from the memory
 					// structure
-					edd=mep[nu[j]]+((nu[j]<<1)+1)*--mec[nu[j]];
-					if(edd!=ed[j]) {
-						for(int lll=0;lll<=(nu[j]<<1);lll++) ed[j][lll]=edd[lll];
-						vc.n_set_aux2_copy(j,nu[j]);
-						vc.n_copy_pointer(edd[nu[j]<<1],j);
-						ed[edd[nu[j]<<1]]=ed[j];
-					}
+					delete_edges(vc,j);
 					vc.n_set_to_aux1(j);
 					ed[j]=edp;
 				} else i=nu[j];
@@ -1299,7 +1355,7 @@ bool voronoicell_base::create_facet(vc_class &vc,int lp,int ls,double l,int us,d
 
 				// Allocate a new vertex of order k
 				vc.n_set_pointer(p,k);
-				ed[p]=mep[k]+((k<<1)+1)*mec[k]++;
+				ed[p]=new_edges(k,p);
 				ed[p][k<<1]=p;
 				if(stackp2==stacke2) add_memory_ds2();
 				*(stackp2++)=qp;
@@ -1411,8 +1467,7 @@ inline bool voronoicell_base::collapse_order2(vc_class &vc) {
 			pts[(i<<2)+1]=pts[(p<<2)+1];
 			pts[(i<<2)+2]=pts[(p<<2)+2];
 			for(k=0;k<nu[p];k++) ed[ed[p][k]][ed[p][nu[p]+k]]=i;
-			vc.n_copy_pointer(i,p);
-			ed[i]=ed[p];
+			move_edges(vc,i,p);
 			nu[i]=nu[p];
 			ed[i][nu[i]<<1]=i;
 		}
@@ -1448,8 +1503,7 @@ bool voronoicell_base::collapse_order1(vc_class &vc) {
 			pts[(i<<2)+1]=pts[(p<<2)+1];
 			pts[(i<<2)+2]=pts[(p<<2)+2];
 			for(k=0;k<nu[p];k++) ed[ed[p][k]][ed[p][nu[p]+k]]=i;
-			vc.n_copy_pointer(i,p);
-			ed[i]=ed[p];
+			move_edges(vc,i,p);
 			nu[i]=nu[p];
 			ed[i][nu[i]<<1]=i;
 		}
@@ -1466,7 +1520,7 @@ bool voronoicell_base::collapse_order1(vc_class &vc) {
 template<class vc_class>
 bool voronoicell_base::delete_connection(vc_class &vc,int j,int k,bool hand) {
 	int q=hand?k:cycle_up(k,j);
-	int i=nu[j]-1,l,*edp,*edd,m;
+	int i=nu[j]-1,l,*edp,m;
 #if VOROPP_VERBOSE >=1
 	if(i<1) {
 		fputs("Zero order vertex formed\n",stderr);
@@ -1474,13 +1528,13 @@ bool voronoicell_base::delete_connection(vc_class &vc,int j,int k,bool hand) {
 	}
 #endif
 	if(mec[i]==mem[i]) add_memory(vc,i);
-	vc.n_set_aux1(i);
+	vc.n_set_aux1(i,j);
 	for(l=0;l<q;l++) vc.n_copy_aux1(j,l);
 	while(l<i) {
 		vc.n_copy_aux1_shift(j,l);
 		l++;
 	}
-	edp=mep[i]+((i<<1)+1)*mec[i]++;
+	edp=new_edges(i,j);
 	edp[i<<1]=j;
 	for(l=0;l<k;l++) {
 		edp[l]=ed[j][l];
@@ -1495,12 +1549,8 @@ bool voronoicell_base::delete_connection(vc_class &vc,int j,int k,bool hand) {
 		l++;
 	}
 
-	edd=mep[nu[j]]+((nu[j]<<1)+1)*--mec[nu[j]];
-	for(l=0;l<=(nu[j]<<1);l++) ed[j][l]=edd[l];
-	vc.n_set_aux2_copy(j,nu[j]);
-	vc.n_copy_pointer(edd[nu[j]<<1],j);
+	delete_edges(vc,j);
 	vc.n_set_to_aux1(j);
-	ed[edd[nu[j]<<1]]=ed[j];
 	ed[j]=edp;
 	nu[j]=i;
 	return true;
@@ -1830,6 +1880,144 @@ void voronoicell_base::centroid(double &cx,double &cy,double &cz) {
 	} else cx=cy=cz=0;
 }
 
+/** Computes several geometric quantities of the Voronoi cell in a single
+ * traversal of its faces, rather than traversing the faces once for each
+ * quantity. The quantities are accumulated in the same order as the individual
+ * routines, so that the results are identical to theirs.
+ * \param[in] mask a bitwise or of the cell_geometry_flag values, selecting
+ *                 the quantities to compute.
+ * \param[out] g the structure to store the results in. */
+void voronoicell_base::geometry(unsigned int mask,cell_geometry &g) {
+	const bool vo=mask&(geom_volume|geom_centroid),ce=mask&geom_centroid,
+		   ar=mask&(geom_surface_area|geom_face_areas),fa=mask&geom_face_areas,
+		   pe=mask&geom_face_perimeters,fv=mask&geom_face_vertices,
+		   no=mask&geom_normals,fq=mask&geom_face_freq_table,
+		   fo=mask&geom_face_orders;
+	int i,j,k,l,m,n,q,s=0,vp=0,ns;
+	double vol=0,cx=0,cy=0,cz=0,area=0,farea=0,perim=0,tvol,dx,dy,dz,wmag,
+	       ux=0,uy=0,uz=0,vx=0,vy=0,vz=0,wx,wy,wz,
+	       nx=0,ny=0,nz=0,ex,ey,ez;
+	if(fa) g.face_areas.clear();
+	if(pe) g.face_perimeters.clear();
+	if(fo) g.face_orders.clear();
+	if(fq) g.face_freq_table.clear();
+	if(fv) g.face_vertices.clear();
+	if(no) g.normals.clear();
+	for(i=1;i<p;i++) for(j=0;j<nu[i];j++) {
+		k=ed[i][j];
+		if(k<0) continue;
+
+		// Set up the face, starting with the edge from i to k
+		s++;q=1;ns=0;
+		ed[i][j]=-1-k;
+		l=cycle_up(ed[i][nu[i]+j],k);
+		if(vo) {
+			ux=*pts-pts[4*i];uy=pts[1]-pts[4*i+1];uz=pts[2]-pts[4*i+2];
+			vx=pts[4*k]-*pts;vy=pts[4*k+1]-pts[1];vz=pts[4*k+2]-pts[2];
+		}
+		if(fa) farea=0;
+		if(pe) {
+			dx=pts[k<<2]-pts[i<<2];
+			dy=pts[(k<<2)+1]-pts[(i<<2)+1];
+			dz=pts[(k<<2)+2]-pts[(i<<2)+2];
+			perim=sqrt(dx*dx+dy*dy+dz*dz);
+		}
+		if(fv) {g.face_vertices.push_back(0);g.face_vertices.push_back(i);}
+
+		// Trace around the face, visiting each edge from k to m
+		do {
+			q++;
+			if(fv) g.face_vertices.push_back(k);
+			m=ed[k][l];ed[k][l]=-1-m;
+			n=cycle_up(ed[k][nu[k]+l],m);
+			if(m!=i) {
+
+				// Add the contributions from the triangle
+				// formed by vertices i, k, and m
+				if(vo) {
+					wx=pts[4*m]-*pts;wy=pts[4*m+1]-pts[1];wz=pts[4*m+2]-pts[2];
+					tvol=ux*vy*wz+uy*vz*wx+uz*vx*wy-uz*vy*wx-uy*vx*wz-ux*vz*wy;
+					vol+=tvol;
+					if(ce) {
+						cx+=(wx+vx-ux)*tvol;
+						cy+=(wy+vy-uy)*tvol;
+						cz+=(wz+vz-uz)*tvol;
+					}
+					vx=wx;vy=wy;vz=wz;
+				}
+				if(ar) {
+					dx=pts[4*k]-pts[4*i];dy=pts[4*k+1]-pts[4*i+1];dz=pts[4*k+2]-pts[4*i+2];
+					ex=pts[4*m]-pts[4*i];ey=pts[4*m+1]-pts[4*i+1];ez=pts[4*m+2]-pts[4*i+2];
+					wx=dy*ez-dz*ey;wy=dz*ex-dx*ez;wz=dx*ey-dy*ex;
+					wmag=sqrt(wx*wx+wy*wy+wz*wz);
+					area+=wmag;farea+=wmag;
+				}
+			}
+			if(pe) {
+				dx=pts[m<<2]-pts[k<<2];
+				dy=pts[(m<<2)+1]-pts[(k<<2)+1];
+				dz=pts[(m<<2)+2]-pts[(k<<2)+2];
+				perim+=sqrt(dx*dx+dy*dy+dz*dz);
+			}
+
+			// Look for the normal vector, using the first edge
+			// above the tolerance and the first subsequent edge
+			// whose vector product with it is above the
+			// tolerance, as in the normals_search routine
+			if(no&&ns<2) {
+				ex=pts[4*m]-pts[4*k];ey=pts[4*m+1]-pts[4*k+1];ez=pts[4*m+2]-pts[4*k+2];
+				if(ns==0) {
+					if(ex*ex+ey*ey+ez*ez>tol) {nx=ex;ny=ey;nz=ez;ns=1;}
+				} else {
+					wx=nz*ey-ny*ez;wy=nx*ez-nz*ex;wz=ny*ex-nx*ey;
+					wmag=wx*wx+wy*wy+wz*wz;
+					if(wmag>tol) {
+						wmag=1/sqrt(wmag);
+						g.normals.push_back(wx*wmag);
+						g.normals.push_back(wy*wmag);
+						g.normals.push_back(wz*wmag);
+						ns=2;
+					}
+				}
+			}
+			k=m;l=n;
+		} while(k!=i);
+
+		// Store the quantities for the face
+		if(fa) g.face_areas.push_back(0.125*farea);
+		if(pe) g.face_perimeters.push_back(0.5*perim);
+		if(fo) g.face_orders.push_back(q);
+		if(fq) {
+			if(static_cast<unsigned int>(q)>=g.face_freq_table.size()) g.face_freq_table.resize(q+1,0);
+			g.face_freq_table[q]++;
+		}
+		if(fv) {
+			n=g.face_vertices.size();
+			g.face_vertices[vp]=n-vp-1;
+			vp=n;
+		}
+		if(no&&ns<2) {
+			g.normals.push_back(0);
+			g.normals.push_back(0);
+			g.normals.push_back(0);
+		}
+	}
+	reset_edges();
+
+	// Store the quantities for the whole cell
+	if(mask&geom_volume) g.volume=vol*(1/48.0);
+	if(mask&geom_surface_area) g.surface_area=0.125*area;
+	if(ce) {
+		if(vol>tol_cu) {
+			vol=0.125/vol;
+			g.cx=cx*vol+0.5*(*pts);
+			g.cy=cy*vol+0.5*pts[1];
+			g.cz=cz*vol+0.5*pts[2];
+		} else g.cx=g.cy=g.cz=0;
+	}
+	if(mask&geom_number_of_faces) g.number_of_faces=s;
+}
+
 /** Computes the maximum radius squared of a vertex from the center of the
  * cell. It can be used to determine when enough particles have been testing an
  * all planes that could cut the cell have been considered.
@@ -2325,6 +2513,29 @@ bool voronoicell_base::plane_intersects_guess(double x,double y,double z,double
 	return true;
 }
 
+/** Computes the largest scalar product of each of a batch of plane normals
+ * with the vertices of the cell. Since a cut can only shrink the cell, a plane
+ * whose displacement is larger than this bound cannot intersect the cell now
+ * or after any further cuts, and it can be discarded without calling nplane().
+ * The loop over the planes is innermost, so that it reads the normals with
+ * unit stride and can be vectorized.
+ * \param[in] n the number of planes.
+ * \param[in] (x,y,z) arrays holding the components of the plane normals.
+ * \param[out] m an array in which to store the bound for each plane. */
+void voronoicell_base::plane_bounds(int n,const double *x,const double *y,const double *z,double *m) {
+	int l;
+	double *pp=pts,*pe=pts+(p<<2),a,b,c,s;
+	a=*pp;b=pp[1];c=pp[2];
+	for(l=0;l<n;l++) m[l]=x[l]*a+y[l]*b+z[l]*c;
+	for(pp+=4;pp<pe;pp+=4) {
+		a=*pp;b=pp[1];c=pp[2];
+		for(l=0;l<n;l++) {
+			s=x[l]*a+y[l]*b+z[l]*c;
+			m[l]=s>m[l]?s:m[l];
+		}
+	}
+}
+
 /* This routine tests to see if a cell intersects a plane, by tracing over the
  * cell from vertex to vertex, starting at up. It is meant to be called either
  * by plane_intersects() or plane_intersects_track(), when those routines
@@ -2405,7 +2616,9 @@ int voronoicell_base::number_of_edges() {
 /** Outputs a custom string of information about the Voronoi cell. The string
  * of information follows a similar style as the C printf command, and detailed
  * information about its format is available at
- * http://math.lbl.gov/voro++/doc/custom.html.
+ * http://math.lbl.gov/voro++/doc/custom.html. The string is compiled by the
+ * custom_format class, and when writing many cells it is faster to use that
+ * class directly, so that the string is only compiled once.
  * \param[in] format the custom string to print.
  * \param[in] i the ID of the particle associated with this Voronoi cell.
  * \param[in] (x,y,z) the position of the particle associated with this Voronoi
@@ -2413,78 +2626,9 @@ int voronoicell_base::number_of_edges() {
  * \param[in] r a radius associated with the particle.
  * \param[in] fp the file handle to write to. */
 void voronoicell_base::output_custom(const char *format,int i,double x,double y,double z,double r,FILE *fp) {
-	char *fmp=(const_cast<char*>(format));
-	std::vector<int> vi;
-	std::vector<double> vd;
-	while(*fmp!=0) {
-		if(*fmp=='%') {
-			fmp++;
-			switch(*fmp) {
-
-				// Particle-related output
-				case 'i': fprintf(fp,"%d",i);break;
-				case 'x': fprintf(fp,"%g",x);break;
-				case 'y': fprintf(fp,"%g",y);break;
-				case 'z': fprintf(fp,"%g",z);break;
-				case 'q': fprintf(fp,"%g %g %g",x,y,z);break;
-				case 'r': fprintf(fp,"%g",r);break;
-
-				// Vertex-related output
-				case 'w': fprintf(fp,"%d",p);break;
-				case 'p': output_vertices(fp);break;
-				case 'P': output_vertices(x,y,z,fp);break;
-				case 'o': output_vertex_orders(fp);break;
-				case 'm': fprintf(fp,"%g",0.25*max_radius_squared());break;
-
-				// Edge-related output
-				case 'g': fprintf(fp,"%d",number_of_edges());break;
-				case 'E': fprintf(fp,"%g",total_edge_distance());break;
-				case 'e': face_perimeters(vd);voro_print_vector(vd,fp);break;
-
-				// Face-related output
-				case 's': fprintf(fp,"%d",number_of_faces());break;
-				case 'F': fprintf(fp,"%g",surface_area());break;
-				case 'A': {
-						  face_freq_table(vi);
-						  voro_print_vector(vi,fp);
-					  } break;
-				case 'a': face_orders(vi);voro_print_vector(vi,fp);break;
-				case 'f': face_areas(vd);voro_print_vector(vd,fp);break;
-				case 't': {
-						  face_vertices(vi);
-						  voro_print_face_vertices(vi,fp);
-					  } break;
-				case 'l': normals(vd);
-					  voro_print_positions(vd,fp);
-					  break;
-				case 'n': neighbors(vi);
-					  voro_print_vector(vi,fp);
-					  break;
-
-				// Volume-related output
-				case 'v': fprintf(fp,"%g",volume());break;
-				case 'c': {
-						  double cx,cy,cz;
-						  centroid(cx,cy,cz);
-						  fprintf(fp,"%g %g %g",cx,cy,cz);
-					  } break;
-				case 'C': {
-						  double cx,cy,cz;
-						  centroid(cx,cy,cz);
-						  fprintf(fp,"%g %g %g",x+cx,y+cy,z+cz);
-					  } break;
-
-				// End-of-string reached
-				case 0: fmp--;break;
-
-				// The percent sign is not part of a
-				// control sequence
-				default: putc('%',fp);putc(*fmp,fp);
-			}
-		} else putc(*fmp,fp);
-		fmp++;
-	}
-	fputs("\n",fp);
+	custom_format cf(format);
+	output_buffer ob(fp,4096);
+	cf.write(*this,i,x,y,z,r,ob);
 }
 
 /** This initializes the class to be a rectangular box. It calls the base class
@@ -2574,7 +2718,7 @@ void voronoicell_neighbor::memory_setup() {
 	mne=new int*[current_vertex_order];
 	ne=new int*[current_vertices];
 	for(i=0;i<3;i++) mne[i]=new int[init_n_vertices*i];
-	mne[3]=new int[init_3_vertices*3];
+	mne[3]=new int[current_vertices*3];
 	for(i=4;i<current_vertex_order;i++) mne[i]=new int[init_n_vertices*i];
 }
 
@@ -2620,7 +2764,7 @@ void voronoicell_base::print_edges() {
 		printf("   %d",ed[i][j]);
 		print_edges_neighbors(i);
 		printf("  %g %g %g %p",*ptsp,ptsp[1],ptsp[2],(void*) ed[i]);
-		if(ed[i]>=mep[nu[i]]+mec[nu[i]]*((nu[i]<<1)+1)) puts(" Memory error");
+		if(nu[i]==3?ed[i]!=mep[3]+7*i:ed[i]>=mep[nu[i]]+mec[nu[i]]*((nu[i]<<1)+1)) puts(" Memory error");
 		else puts("");
 	}
 }
@@ -2640,5 +2784,7 @@ template bool voronoicell_base::nplane(voronoicell&,double,double,double,double,
 template bool voronoicell_base::nplane(voronoicell_neighbor&,double,double,double,double,int);
 template void voronoicell_base::check_memory_for_copy(voronoicell&,voronoicell_base*);
 template void voronoicell_base::check_memory_for_copy(voronoicell_neighbor&,voronoicell_base*);
+template void voronoicell_base::match_memory(voronoicell&,voronoicell_base*);
+template void voronoicell_base::match_memory(voronoicell_neighbor&,voronoicell_base*);
 
 }
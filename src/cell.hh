@@ -17,6 +17,54 @@
 
 namespace voro {
 
+/** The flags that select which quantities are computed by the geometry
+ * routine of the voronoicell_base class. These can be combined with a
+ * bitwise or. */
+enum cell_geometry_flag {
+	geom_volume=1,
+	geom_surface_area=2,
+	geom_centroid=4,
+	geom_number_of_faces=8,
+	geom_face_areas=16,
+	geom_face_perimeters=32,
+	geom_face_orders=64,
+	geom_face_freq_table=128,
+	geom_face_vertices=256,
+	geom_normals=512
+};
+
+/** \brief A structure holding geometric quantities of a Voronoi cell.
+ *
+ * This structure is filled in by the geometry routine of the
+ * voronoicell_base class, which computes several quantities in a single
+ * traversal of the faces of the cell. Each member is only set if the
+ * corresponding flag was requested, and the values are identical to those
+ * given by the individual routines. The vectors are kept between calls, so
+ * that a structure that is reused for many cells does not need to allocate
+ * memory once they have grown to a sufficient size. */
+struct cell_geometry {
+	/** The volume, as given by volume(). */
+	double volume;
+	/** The surface area, as given by surface_area(). */
+	double surface_area;
+	/** The centroid, as given by centroid(). */
+	double cx,cy,cz;
+	/** The number of faces, as given by number_of_faces(). */
+	int number_of_faces;
+	/** The face areas, as given by face_areas(). */
+	std::vector<double> face_areas;
+	/** The face perimeters, as given by face_perimeters(). */
+	std::vector<double> face_perimeters;
+	/** The face orders, as given by face_orders(). */
+	std::vector<int> face_orders;
+	/** The face frequency table, as given by face_freq_table(). */
+	std::vector<int> face_freq_table;
+	/** The face vertices, as given by face_vertices(). */
+	std::vector<int> face_vertices;
+	/** The face normals, as given by normals(). */
+	std::vector<double> normals;
+};
+
 /** \brief A class representing a single Voronoi cell.
  *
  * This class represents a single Voronoi cell, as a collection of vertices
@@ -76,7 +124,12 @@ class voronoicell_base {
 		 * helps speed up the computation. It satisfies the relation
 		 * ed[ed[i][j]][ed[i][m+j]]=i. The final entry holds a back
 		 * pointer, so that ed[i+2*m]=i. The back pointers are used
-		 * when rearranging the memory. */
+		 * when rearranging the memory.
+		 *
+		 * Since most vertices have order three, these are stored with
+		 * a fixed stride, so that if vertex i has order three then
+		 * ed[i] points to mep[3]+7*i. Vertices of other orders are
+		 * packed into their mep arrays in an arbitrary order. */
 		int **ed;
 		/** This array holds the order of the vertices in the Voronoi
 		 * cell. This array is dynamically allocated, with its current
@@ -90,7 +143,7 @@ class voronoicell_base {
 		double tol_cu;
 		double big_tol;
 		voronoicell_base(double max_len_sq);
-		~voronoicell_base();
+		virtual ~voronoicell_base();
 		void init_base(double xmin,double xmax,double ymin,double ymax,double zmin,double zmax);
 		void init_octahedron_base(double l);
 		void init_tetrahedron_base(double x0,double y0,double z0,double x1,double y1,double z1,double x2,double y2,double z2,double x3,double y3,double z3);
@@ -132,6 +185,7 @@ class voronoicell_base {
 		double total_edge_distance();
 		double surface_area();
 		void centroid(double &cx,double &cy,double &cz);
+		void geometry(unsigned int mask,cell_geometry &g);
 		int number_of_faces();
 		int number_of_edges();
 		void vertex_orders(std::vector<int> &v);
@@ -192,6 +246,7 @@ class voronoicell_base {
 		bool nplane(vc_class &vc,double x,double y,double z,double rsq,int p_id);
 		bool plane_intersects(double x,double y,double z,double rsq);
 		bool plane_intersects_guess(double x,double y,double z,double rsq);
+		void plane_bounds(int n,const double *x,const double *y,const double *z,double *m);
 		void construct_relations();
 		void check_relations();
 		void check_duplicates();
@@ -240,11 +295,15 @@ class voronoicell_base {
 		 * all vertices of order p, with each vertex holding 2*p+1
 		 * integers of information. The total number of vertices held
 		 * on mep[p] is stored in mem[p]. If the space runs out, the
-		 * code allocates more using the add_memory() routine. */
+		 * code allocates more using the add_memory() routine. The
+		 * mep[3] array holds an entry for every vertex index, and is
+		 * extended by the add_memory_vertices() routine. */
 		int **mep;
 		inline void reset_edges();
 		template<class vc_class>
 		void check_memory_for_copy(vc_class &vc,voronoicell_base* vb);
+		template<class vc_class>
+		void match_memory(vc_class &vc,voronoicell_base* vb);
 		void copy(voronoicell_base* vb);
 	private:
 		/** This is the delete stack, used to store the vertices which
@@ -283,6 +342,20 @@ class voronoicell_base {
 		inline bool collapse_order2(vc_class &vc);
 		template<class vc_class>
 		bool delete_connection(vc_class &vc,int j,int k,bool hand);
+		template<class vc_class>
+		inline void delete_edges(vc_class &vc,int v);
+		template<class vc_class>
+		inline void move_edges(vc_class &vc,int a,int b);
+		/** Returns the memory to store the edge information of a
+		 * vertex of a given order, and adds to the count of vertices
+		 * with this order.
+		 * \param[in] k the order of the vertex.
+		 * \param[in] v the index of the vertex.
+		 * \return A pointer to the memory. */
+		inline int* new_edges(int k,int v) {
+			if(k==3) {mec[3]++;return mep[3]+7*v;}
+			return mep[k]+((k<<1)+1)*mec[k]++;
+		}
 		inline bool search_for_outside_edge(int &up);
 		inline void add_to_stack(int sc2,int lp);
 		inline void reset_mask() {
@@ -328,6 +401,12 @@ class voronoicell : public voronoicell_base {
 			voronoicell_base* vb((voronoicell_base*) &c);
 			check_memory_for_copy(*this,vb);copy(vb);
 		}
+		/** Extends the memory allocations of this cell so that they
+		 * are at least as large as those of another cell.
+		 * \param[in] c the cell whose allocations should be matched. */
+		inline void match_memory(voronoicell_base &c) {
+			voronoicell_base::match_memory(*this,&c);
+		}
 		/** Cuts a Voronoi cell using by the plane corresponding to the
 		 * perpendicular bisector of a particle.
 		 * \param[in] (x,y,z) the position of the particle.
@@ -400,11 +479,12 @@ class voronoicell : public voronoicell_base {
 		inline void n_set_pointer(int p,int n) {};
 		inline void n_copy(int a,int b,int c,int d) {};
 		inline void n_set(int a,int b,int c) {};
-		inline void n_set_aux1(int k) {};
+		inline void n_set_aux1(int k,int j) {};
 		inline void n_copy_aux1(int a,int b) {};
 		inline void n_copy_aux1_shift(int a,int b) {};
 		inline void n_set_aux2_copy(int a,int b) {};
 		inline void n_copy_pointer(int a,int b) {};
+		inline void n_copy_order3(int a,int b) {};
 		inline void n_set_to_aux1(int j) {};
 		inline void n_set_to_aux2(int j) {};
 		inline void n_allocate_aux1(int i) {};
@@ -504,15 +584,24 @@ class voronoicell_neighbor : public voronoicell_base {
 			std::vector<int> v;neighbors(v);
 			voro_print_vector(v,fp);
 		}
+		/** Extends the memory allocations of this cell so that they
+		 * are at least as large as those of another cell.
+		 * \param[in] c the cell whose allocations should be matched. */
+		inline void match_memory(voronoicell_base &c) {
+			voronoicell_base::match_memory(*this,&c);
+		}
 	private:
 		int *paux1;
 		int *paux2;
 		void memory_setup();
 		inline void n_allocate(int i,int m) {mne[i]=new int[m*i];}
 		inline void n_add_memory_vertices(int i) {
-			int **pp=new int*[i];
-			for(int j=0;j<current_vertices;j++) pp[j]=ne[j];
+			int j,**pp=new int*[i],*p3=new int[3*i];
+			for(j=0;j<current_vertices;j++) pp[j]=ne[j];
 			delete [] ne;ne=pp;
+			for(j=0;j<3*current_vertices;j++) p3[j]=mne[3][j];
+			for(j=0;j<p;j++) if(ne[j]>=mne[3]&&ne[j]<mne[3]+3*current_vertices) ne[j]=p3+(ne[j]-mne[3]);
+			delete [] mne[3];mne[3]=p3;
 		}
 		inline void n_add_memory_vorder(int i) {
 			int **p2=new int*[i];
@@ -520,11 +609,11 @@ class voronoicell_neighbor : public voronoicell_base {
 			delete [] mne;mne=p2;
 		}
 		inline void n_set_pointer(int p,int n) {
-			ne[p]=mne[n]+n*mec[n];
+			ne[p]=n==3?mne[3]+3*p:mne[n]+n*mec[n];
 		}
 		inline void n_copy(int a,int b,int c,int d) {ne[a][b]=ne[c][d];}
 		inline void n_set(int a,int b,int c) {ne[a][b]=c;}
-		inline void n_set_aux1(int k) {paux1=mne[k]+k*mec[k];}
+		inline void n_set_aux1(int k,int j) {paux1=k==3?mne[3]+3*j:mne[k]+k*mec[k];}
 		inline void n_copy_aux1(int a,int b) {paux1[b]=ne[a][b];}
 		inline void n_copy_aux1_shift(int a,int b) {paux1[b]=ne[a][b+1];}
 		inline void n_set_aux2_copy(int a,int b) {
@@ -532,6 +621,11 @@ class voronoicell_neighbor : public voronoicell_base {
 			for(int i=0;i<b;i++) ne[a][i]=paux2[i];
 		}
 		inline void n_copy_pointer(int a,int b) {ne[a]=ne[b];}
+		inline void n_copy_order3(int a,int b) {
+			int *q=mne[3]+3*a;
+			*q=*ne[b];q[1]=ne[b][1];q[2]=ne[b][2];
+			ne[a]=q;
+		}
 		inline void n_set_to_aux1(int j) {ne[j]=paux1;}
 		inline void n_set_to_aux2(int j) {ne[j]=paux2;}
 		inline void n_allocate_aux1(int i) {paux1=new int[i*mem[i]];}
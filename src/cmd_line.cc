@@ -7,6 +7,7 @@
 /** \file cmd_line.cc
  * \brief Source code for the command-line utility. */
 
+#include <climits>
 #include <cstring>
 
 #include "voro++.hh"
@@ -15,7 +16,8 @@ using namespace voro;
 enum blocks_mode {
 	none,
 	length_scale,
-	specified
+	specified,
+	tuned
 };
 
 // A maximum allowed number of regions, to prevent enormous amounts of memory
@@ -31,6 +33,8 @@ void help_message() {
 	     "computes the Voronoi cell for each, and then creates <filename.vol> with an\n"
 	     "additional column containing the volume of each Voronoi cell.\n\n"
 	     "Available options:\n"
+	     " -b         : Save the custom output in a columnar binary format to\n"
+	     "              <filename.vcb> instead of <filename.vol>\n"
 	     " -c <str>   : Specify a custom output string\n"
 	     " -g         : Turn on the gnuplot output to <filename.gnu>\n"
 	     " -h/--help  : Print this information\n"
@@ -47,6 +51,12 @@ void help_message() {
 	     " -py        : Make container periodic in the y direction\n"
 	     " -pz        : Make container periodic in the z direction\n"
 	     " -r         : Assume the input file has an extra coordinate for radii\n"
+	     " -s         : Only store the occupied grid blocks, allowing a finer grid to\n"
+	     "              be used for mostly empty domains. The grid must be set with\n"
+	     "              -l or -n, and the option cannot be combined with -o, -p, -px,\n"
+	     "              -py, -pz, or -r\n"
+	     " -t         : Choose the internal grid and the memory per grid block by\n"
+	     "              timing a sample of the cells for several grid sizes\n"
 	     " -v         : Verbose output\n"
 	     " --version  : Print version information\n"
 	     " -wb [6]    : Add six plane wall objects to make rectangular box containing\n"
@@ -123,13 +133,18 @@ void error_message() {
 // Carries out the Voronoi computation and outputs the results to the requested
 // files
 template<class c_loop,class c_class>
-void cmd_line_output(c_loop &vl,c_class &con,const char* format,FILE* outfile,FILE* gnu_file,FILE* povp_file,FILE* povv_file,bool verbose,double &vol,int &vcc,int &tp) {
+void cmd_line_output(c_loop &vl,c_class &con,const char* format,FILE* outfile,custom_columns* cb,FILE* gnu_file,FILE* povp_file,FILE* povv_file,bool verbose,double &vol,int &vcc,int &tp) {
 	int pid,ps=con.ps;double x,y,z,r;
-	if(con.contains_neighbor(format)) {
+	custom_format cf(format);
+	output_buffer ob(outfile);
+	if(cf.neighbor) {
 		voronoicell_neighbor c(con);
 		if(vl.start()) do if(con.compute_cell(c,vl)) {
 			vl.pos(pid,x,y,z,r);
-			if(outfile!=NULL) c.output_custom(format,pid,x,y,z,r,outfile);
+			if(outfile!=NULL) {
+				if(cb!=NULL) cb->write(c,pid,x,y,z,r);
+				else cf.write(c,pid,x,y,z,r,ob);
+			}
 			if(gnu_file!=NULL) c.draw_gnuplot(x,y,z,gnu_file);
 			if(povp_file!=NULL) {
 				fprintf(povp_file,"// id %d\n",pid);
@@ -146,7 +161,10 @@ void cmd_line_output(c_loop &vl,c_class &con,const char* format,FILE* outfile,FI
 		voronoicell c(con);
 		if(vl.start()) do if(con.compute_cell(c,vl)) {
 			vl.pos(pid,x,y,z,r);
-			if(outfile!=NULL) c.output_custom(format,pid,x,y,z,r,outfile);
+			if(outfile!=NULL) {
+				if(cb!=NULL) cb->write(c,pid,x,y,z,r);
+				else cf.write(c,pid,x,y,z,r,ob);
+			}
 			if(gnu_file!=NULL) c.draw_gnuplot(x,y,z,gnu_file);
 			if(povp_file!=NULL) {
 				fprintf(povp_file,"// id %d\n",pid);
@@ -169,6 +187,7 @@ int main(int argc,char **argv) {
 	blocks_mode bm=none;
 	bool gnuplot_output=false,povp_output=false,povv_output=false,polydisperse=false;
 	bool xperiodic=false,yperiodic=false,zperiodic=false,ordered=false,verbose=false;
+	bool binary=false,sparse=false,mem_set=false;
 	pre_container *pcon=NULL;pre_container_poly *pconp=NULL;
 	wall_list wl;
 
@@ -197,7 +216,9 @@ int main(int argc,char **argv) {
 	// We have enough arguments. Now start searching for command-line
 	// options.
 	while(i<argc-7) {
-		if(strcmp(argv[i],"-c")==0) {
+		if(strcmp(argv[i],"-b")==0) {
+			binary=true;
+		} else if(strcmp(argv[i],"-c")==0) {
 			if(i>=argc-8) {error_message();wl.deallocate();return VOROPP_CMD_LINE_ERROR;}
 			if(custom_output==0) {
 				custom_output=++i;
@@ -215,18 +236,18 @@ int main(int argc,char **argv) {
 		} else if(strcmp(argv[i],"-l")==0) {
 			if(i>=argc-8) {error_message();wl.deallocate();return VOROPP_CMD_LINE_ERROR;}
 			if(bm!=none) {
-				fputs("voro++: Conflicting options about grid setup (-l/-n)\n",stderr);
+				fputs("voro++: Conflicting options about grid setup (-l/-n/-t)\n",stderr);
 				wl.deallocate();
 				return VOROPP_CMD_LINE_ERROR;
 			}
 			bm=length_scale;
 			i++;ls=atof(argv[i]);
 		} else if(strcmp(argv[i],"-m")==0) {
-			i++;init_mem=atoi(argv[i]);
+			i++;init_mem=atoi(argv[i]);mem_set=true;
 		} else if(strcmp(argv[i],"-n")==0) {
 			if(i>=argc-10) {error_message();wl.deallocate();return VOROPP_CMD_LINE_ERROR;}
 			if(bm!=none) {
-				fputs("voro++: Conflicting options about grid setup (-l/-n)\n",stderr);
+				fputs("voro++: Conflicting options about grid setup (-l/-n/-t)\n",stderr);
 				wl.deallocate();
 				return VOROPP_CMD_LINE_ERROR;
 			}
@@ -253,6 +274,15 @@ int main(int argc,char **argv) {
 			zperiodic=true;
 		} else if(strcmp(argv[i],"-r")==0) {
 			polydisperse=true;
+		} else if(strcmp(argv[i],"-s")==0) {
+			sparse=true;
+		} else if(strcmp(argv[i],"-t")==0) {
+			if(bm!=none) {
+				fputs("voro++: Conflicting options about grid setup (-l/-n/-t)\n",stderr);
+				wl.deallocate();
+				return VOROPP_CMD_LINE_ERROR;
+			}
+			bm=tuned;
 		} else if(strcmp(argv[i],"-v")==0) {
 			verbose=true;
 		} else if(strcmp(argv[i],"--version")==0) {
@@ -324,6 +354,15 @@ int main(int argc,char **argv) {
 		return VOROPP_CMD_LINE_ERROR;
 	}
 
+	// Check that the sparse block storage is only used in the cases that it
+	// supports
+	if(sparse&&(bm==none||bm==tuned||ordered||polydisperse||xperiodic||yperiodic||zperiodic)) {
+		fputs("voro++: The -s option requires the grid to be set with -l or -n, and cannot be\n"
+		      "combined with -o, -p, -px, -py, -pz, or -r\n",stderr);
+		wl.deallocate();
+		return VOROPP_CMD_LINE_ERROR;
+	}
+
 	// Read in the dimensions of the test box, and estimate the number of
 	// boxes to divide the region up into
 	double ax=atof(argv[i]),bx=atof(argv[i+1]);
@@ -348,16 +387,25 @@ int main(int argc,char **argv) {
 		return VOROPP_CMD_LINE_ERROR;
 	}
 
-	if(bm==none) {
+	if(bm==none||bm==tuned) {
+
+		// Read the particles into a pre-container, and either estimate
+		// the grid from the number of particles, or time a sample of
+		// the cells for several grids. The tuned memory per grid block
+		// is only used if it was not set with -m.
+		int tmem;
 		if(polydisperse) {
 			pconp=new pre_container_poly(ax,bx,ay,by,az,bz,xperiodic,yperiodic,zperiodic);
 			pconp->import(argv[i+6]);
-			pconp->guess_optimal(nx,ny,nz);
+			if(bm==tuned) pconp->tune_grid(nx,ny,nz,tmem);
+			else pconp->guess_optimal(nx,ny,nz);
 		} else {
 			pcon=new pre_container(ax,bx,ay,by,az,bz,xperiodic,yperiodic,zperiodic);
 			pcon->import(argv[i+6]);
-			pcon->guess_optimal(nx,ny,nz);
+			if(bm==tuned) pcon->tune_grid(nx,ny,nz,tmem);
+			else pcon->guess_optimal(nx,ny,nz);
 		}
+		if(bm==tuned&&!mem_set) init_mem=tmem;
 	} else {
 		double nxf,nyf,nzf;
 		if(bm==length_scale) {
@@ -388,10 +436,13 @@ int main(int argc,char **argv) {
 		// provided. If the total number exceeds a cutoff then bail
 		// out, to prevent making a massive memory allocation. Do this
 		// test using floating point numbers, since huge integers could
-		// potentially wrap around to negative values.
-		if(nxf*nyf*nzf>max_regions) {
+		// potentially wrap around to negative values. If only the
+		// occupied blocks are stored, then the limit is set by the
+		// largest grid that can be indexed.
+		int mr=sparse?INT_MAX:max_regions;
+		if(nxf*nyf*nzf>mr) {
 			fprintf(stderr,"voro++: Number of computational blocks exceeds the maximum allowed of %d.\n"
-				       "Either increase the particle length scale, or recompile with an increased\nmaximum.",max_regions);
+				       "Either increase the particle length scale, or recompile with an increased\nmaximum.",mr);
 			wl.deallocate();
 			return VOROPP_MEMORY_ERROR;
 		}
@@ -407,8 +458,8 @@ int main(int argc,char **argv) {
 
 	// Open files for output
 	char *buffer=new char[flen+7];
-	sprintf(buffer,"%s.vol",argv[i+6]);
-	FILE *outfile=safe_fopen(buffer,"w"),*gnu_file,*povp_file,*povv_file;
+	sprintf(buffer,binary?"%s.vcb":"%s.vol",argv[i+6]);
+	FILE *outfile=safe_fopen(buffer,binary?"wb":"w"),*gnu_file,*povp_file,*povv_file;
 	if(gnuplot_output) {
 		sprintf(buffer,"%s.gnu",argv[i+6]);
 		gnu_file=safe_fopen(buffer,"w");
@@ -424,6 +475,7 @@ int main(int argc,char **argv) {
 	delete [] buffer;
 
 	const char *c_str=(custom_output==0?(polydisperse?"%i %q %v %r":"%i %q %v"):argv[custom_output]);
+	custom_columns *cb=binary?new custom_columns(c_str):NULL;
 
 	// Now switch depending on whether polydispersity was enabled, and
 	// whether output ordering is requested
@@ -433,42 +485,52 @@ int main(int argc,char **argv) {
 			particle_order vo;
 			container_poly con(ax,bx,ay,by,az,bz,nx,ny,nz,xperiodic,yperiodic,zperiodic,init_mem);
 			con.add_wall(wl);
-			if(bm==none) {
+			if(pconp!=NULL) {
 				pconp->setup(vo,con);delete pconp;
 			} else con.import(vo,argv[i+6]);
+			con.compact();
 
 			c_loop_order vlo(con,vo);
-			cmd_line_output(vlo,con,c_str,outfile,gnu_file,povp_file,povv_file,verbose,vol,vcc,tp);
+			cmd_line_output(vlo,con,c_str,outfile,cb,gnu_file,povp_file,povv_file,verbose,vol,vcc,tp);
 		} else {
 			container_poly con(ax,bx,ay,by,az,bz,nx,ny,nz,xperiodic,yperiodic,zperiodic,init_mem);
 			con.add_wall(wl);
 
-			if(bm==none) {
+			if(pconp!=NULL) {
 				pconp->setup(con);delete pconp;
 			} else con.import(argv[i+6]);
+			con.compact();
 
 			c_loop_all vla(con);
-			cmd_line_output(vla,con,c_str,outfile,gnu_file,povp_file,povv_file,verbose,vol,vcc,tp);
+			cmd_line_output(vla,con,c_str,outfile,cb,gnu_file,povp_file,povv_file,verbose,vol,vcc,tp);
 		}
 	} else {
 		if(ordered) {
 			particle_order vo;
 			container con(ax,bx,ay,by,az,bz,nx,ny,nz,xperiodic,yperiodic,zperiodic,init_mem);
 			con.add_wall(wl);
-			if(bm==none) {
+			if(pcon!=NULL) {
 				pcon->setup(vo,con);delete pcon;
 			} else con.import(vo,argv[i+6]);
+			con.compact();
 
 			c_loop_order vlo(con,vo);
-			cmd_line_output(vlo,con,c_str,outfile,gnu_file,povp_file,povv_file,verbose,vol,vcc,tp);
+			cmd_line_output(vlo,con,c_str,outfile,cb,gnu_file,povp_file,povv_file,verbose,vol,vcc,tp);
+		} else if(sparse) {
+			container_sparse con(ax,bx,ay,by,az,bz,nx,ny,nz,init_mem);
+			con.add_wall(wl);
+			con.import(argv[i+6]);
+			c_loop_all_sparse vla(con);
+			cmd_line_output(vla,con,c_str,outfile,cb,gnu_file,povp_file,povv_file,verbose,vol,vcc,tp);
 		} else {
 			container con(ax,bx,ay,by,az,bz,nx,ny,nz,xperiodic,yperiodic,zperiodic,init_mem);
 			con.add_wall(wl);
-			if(bm==none) {
+			if(pcon!=NULL) {
 				pcon->setup(con);delete pcon;
 			} else con.import(argv[i+6]);
+			con.compact();
 			c_loop_all vla(con);
-			cmd_line_output(vla,con,c_str,outfile,gnu_file,povp_file,povv_file,verbose,vol,vcc,tp);
+			cmd_line_output(vla,con,c_str,outfile,cb,gnu_file,povp_file,povv_file,verbose,vol,vcc,tp);
 		}
 	}
 
@@ -476,10 +538,14 @@ int main(int argc,char **argv) {
 	if(verbose) {
 		printf("Container geometry        : [%g:%g] [%g:%g] [%g:%g]\n"
 		       "Computational grid size   : %d by %d by %d (%s)\n"
+		       "Memory per grid block     : %d (%s)\n"
 		       "Filename                  : %s\n"
 		       "Output string             : %s%s\n",ax,bx,ay,by,az,bz,nx,ny,nz,
 		       bm==none?"estimated from file":(bm==length_scale?
-		       "estimated using length scale":"directly specified"),
+		       "estimated using length scale":(bm==tuned?
+		       "tuned by timing a sample of cells":"directly specified")),
+		       init_mem,mem_set?"directly specified":(bm==tuned?
+		       "tuned from the grid block occupancy":"default"),
 		       argv[i+6],c_str,custom_output==0?" (default)":"");
 		printf("Total imported particles  : %d (%.2g per grid block)\n"
 		       "Total V. cells computed   : %d\n"
@@ -488,7 +554,11 @@ int main(int argc,char **argv) {
 		       vcc,(bx-ax)*(by-ay)*(bz-az),vol);
 	}
 
-	// Close output files
+	// Write the binary output, if requested, and close output files
+	if(cb!=NULL) {
+		cb->output(outfile);
+		delete cb;
+	}
 	fclose(outfile);
 	if(gnu_file!=NULL) fclose(gnu_file);
 	if(povp_file!=NULL) fclose(povp_file);
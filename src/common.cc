@@ -7,11 +7,17 @@
 /** \file common.cc
  * \brief Implementations of the small helper functions. */
 
+#include <ctime>
+
 #include "common.hh"
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 namespace voro {
 
-void check_duplicate(int n,double x,double y,double z,int id,double *qp) {
+void check_duplicate(int n,double x,double y,double z,int id,particle_real *qp) {
 	double dx=*qp-x,dy=qp[1]-y,dz=qp[2]-z;
 	if(dx*dx+dy*dy+dz*dz<1e-10) {
 		printf("Duplicate: %d (%g,%g,%g) matches %d (%g,%g,%g)\n",n,x,y,z,id,*qp,qp[1],qp[2]);
@@ -135,4 +141,62 @@ void voro_print_face_vertices(std::vector<int> &v,FILE *fp) {
 	}
 }
 
+/** \brief Opens a temporary file.
+ *
+ * Opens a temporary file, which is used to stage output when several threads
+ * are writing to the same file. If the file cannot be opened, then the routine
+ * causes a fatal error.
+ * \return The file handle. */
+FILE* voro_tmpfile() {
+	FILE *fp=tmpfile();
+	if(fp==NULL) voro_fatal_error("Unable to open temporary file",VOROPP_FILE_ERROR);
+	return fp;
+}
+
+/** \brief Copies part of one file stream to another.
+ * \param[in] tf the file stream to read from.
+ * \param[in] (a,b) the range of positions to copy, with b being exclusive.
+ * \param[in] fp the file stream to write to. */
+void voro_copy_stream(FILE *tf,long a,long b,FILE *fp) {
+	char buf[8192];
+	size_t n;
+	fseek(tf,a,SEEK_SET);
+	while(a<b) {
+		n=fread(buf,1,b-a<8192?b-a:8192,tf);
+		if(n==0) voro_fatal_error("Error reading temporary file",VOROPP_FILE_ERROR);
+		fwrite(buf,1,n,fp);
+		a+=n;
+	}
+}
+
+/** \brief Returns the current time in seconds, using the OpenMP wall clock if
+ * available, and the processor clock otherwise. */
+double voro_wtime() {
+#ifdef _OPENMP
+	return omp_get_wtime();
+#else
+	return static_cast<double>(clock())/CLOCKS_PER_SEC;
+#endif
+}
+
+/** \brief Compares two sets of non-negative integer coordinates in Morton
+ * order.
+ *
+ * Morton order sorts points by the integer formed by interleaving the bits of
+ * their coordinates, with the z bit being the most significant at each level.
+ * Rather than forming this integer, which may not fit in a standard integer
+ * type, the routine finds the coordinate whose difference has the highest bit
+ * set, and compares the points in that coordinate.
+ * \param[in] (i1,j1,k1) the first set of coordinates.
+ * \param[in] (i2,j2,k2) the second set of coordinates.
+ * \return True if the first set comes before the second, false otherwise. */
+bool voro_morton_less(int i1,int j1,int k1,int i2,int j2,int k2) {
+	unsigned int m=i1^i2,t=j1^j2;
+	int d=i2-i1;
+	if(t>=m||t>=(t^m)) {m=t;d=j2-j1;}
+	t=k1^k2;
+	if(t>=m||t>=(t^m)) d=k2-k1;
+	return d>0;
+}
+
 }
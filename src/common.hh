@@ -18,7 +18,7 @@
 
 namespace voro {
 
-void check_duplicate(int n,double x,double y,double z,int id,double *qp);
+void check_duplicate(int n,double x,double y,double z,int id,particle_real *qp);
 
 void voro_fatal_error(const char *p,int status);
 void voro_print_positions(std::vector<double> &v,FILE *fp=stdout);
@@ -26,6 +26,10 @@ FILE* safe_fopen(const char *filename,const char *mode);
 void voro_print_vector(std::vector<int> &v,FILE *fp=stdout);
 void voro_print_vector(std::vector<double> &v,FILE *fp=stdout);
 void voro_print_face_vertices(std::vector<int> &v,FILE *fp=stdout);
+FILE* voro_tmpfile();
+void voro_copy_stream(FILE *tf,long a,long b,FILE *fp);
+double voro_wtime();
+bool voro_morton_less(int i1,int j1,int k1,int i2,int j2,int k2);
 
 }
 
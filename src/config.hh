@@ -19,9 +19,6 @@ namespace voro {
 const int init_vertices=256;
 /** The initial memory allocation for the maximum vertex order. */
 const int init_vertex_order=64;
-/** The initial memory allocation for the number of regular vertices of order
- * 3. */
-const int init_3_vertices=256;
 /** The initial memory allocation for the number of vertices of higher order.
  */
 const int init_n_vertices=8;
@@ -37,6 +34,27 @@ const int init_wall_size=32;
 const int init_ordering_size=4096;
 /** The initial size of the pre_container chunk index. */
 const int init_chunk_size=256;
+/** The initial number of runs that the block scheduler can store. */
+const int init_run_size=256;
+/** The initial number of particles that the block displacement arrays in the
+ * voro_compute class can hold. */
+const int init_block_vectors=64;
+/** The initial number of slots in the hash table of the block_mask_hashed
+ * class. This must be a power of two. */
+const int init_mask_hash_size=1024;
+/** The initial number of occupied blocks that the container_sparse class can
+ * hold. */
+const int init_sparse_blocks=256;
+/** The initial number of blocks that the container_octree class can hold. */
+const int init_octree_blocks=256;
+/** The initial number of nodes that the container_octree class can hold. */
+const int init_octree_nodes=256;
+/** The initial size of the priority queue in the octree_compute class. */
+const int init_octree_queue_size=256;
+/** The initial number of slots in the hash table of the particle_index class,
+ * which maps particle IDs to their storage locations. This must be a power of
+ * two. */
+const int init_index_size=1024;
 
 // If the initial memory is too small, the program dynamically allocates more.
 // However, if the limits below are reached, then the program bails out.
@@ -60,10 +78,68 @@ const int max_wall_size=2048;
 const int max_ordering_size=67108864;
 /** The maximum size for the pre_container chunk index. */
 const int max_chunk_size=65536;
+/** The maximum number of runs that the block scheduler can store. */
+const int max_run_size=67108864;
+/** The maximum number of slots in the hash table of the block_mask_hashed
+ * class. */
+const int max_mask_hash_size=268435456;
+/** The maximum number of occupied blocks that the container_sparse class can
+ * hold. */
+const int max_sparse_blocks=268435456;
+/** The maximum number of blocks that the container_octree class can hold. */
+const int max_octree_blocks=268435456;
+/** The maximum number of nodes that the container_octree class can hold. */
+const int max_octree_nodes=268435456;
+/** The maximum size of the priority queue in the octree_compute class. */
+const int max_octree_queue_size=268435456;
+/** The maximum number of slots in the hash table of the particle_index
+ * class. */
+const int max_index_size=268435456;
 
 /** The chunk size in the pre_container classes. */
 const int pre_container_chunk_size=1024;
 
+/** The number of chunks that the block scheduler aims to divide the particles
+ * into. The division does not depend on the number of threads, so that results
+ * that are accumulated chunk by chunk are reproducible. */
+const int sched_target_chunks=1024;
+
+/** The number of planes from a block that are tested in bulk against the
+ * vertices of a Voronoi cell before being passed to the plane cutting
+ * routine. Smaller batches are tested against a cell that has been cut down
+ * further by the previous batch, while larger batches vectorize better. */
+const int plane_batch_size=16;
+
+/** The number of particles that a leaf of the octree in the container_octree
+ * class can hold before it is divided into eight children, so that the leaves
+ * typically hold between an eighth of this and this many particles. Visiting a
+ * leaf costs more than visiting a block of a regular grid, because of the
+ * priority queue, so the best average occupancy is somewhat larger than the
+ * optimal_particles value used to set up the grids of the other
+ * containers. */
+const int octree_leaf_size=24;
+/** The maximum depth of the octree in the container_octree class. Leaves at
+ * this depth are not divided any further, which stops the tree from growing
+ * without bound when many particles are put at the same position. */
+const int octree_max_depth=40;
+
+/** The size of the blocks in which text particle files are read, which is also
+ * the smallest amount of text that is given to each thread to parse. */
+const int text_import_chunk=1048576;
+
+/** The size of the buffers that custom output is collected in before being
+ * written to a file. */
+const int output_buffer_size=1048576;
+
+/** The size of the buffers that each column of columnar binary output is
+ * collected in before being written to a temporary file. */
+const int column_buffer_size=65536;
+
+/** The distance, relative to the size of the container, within which the
+ * vertices of different Voronoi cells are taken to be the same when the faces
+ * of a tessellation are combined into a mesh. */
+const double mesh_tolerance=1e-10;
+
 #ifndef VOROPP_VERBOSE
 /** Voro++ can print a number of different status and debugging messages to
  * notify the user of special behavior, and this macro sets the amount which
@@ -75,6 +151,44 @@ const int pre_container_chunk_size=1024;
 #define VOROPP_VERBOSE 2
 #endif
 
+#ifndef VOROPP_FLOAT_PARTICLES
+/** If this is set to 1, then the containers store the particle positions and
+ * radii in single precision, which roughly halves the memory used for each
+ * particle. The Voronoi cells are still computed in double precision, using
+ * the positions rounded to single precision, so the tolerances below do not
+ * need to be changed. The library and any programs that use it must be
+ * compiled with the same setting. */
+#define VOROPP_FLOAT_PARTICLES 0
+#endif
+
+#if VOROPP_FLOAT_PARTICLES == 1
+/** The floating point type used to store the particle positions and radii in
+ * the containers. */
+typedef float particle_real;
+#else
+/** The floating point type used to store the particle positions and radii in
+ * the containers. */
+typedef double particle_real;
+#endif
+
+#ifndef VOROPP_FLOAT_VERTICES
+/** If this is set to 1, then the tessellation class stores the vertices of the
+ * Voronoi cells in single precision. The vertices are stored relative to the
+ * particle of each cell, so that their accuracy is relative to the size of the
+ * cell rather than the size of the container. */
+#define VOROPP_FLOAT_VERTICES 0
+#endif
+
+#if VOROPP_FLOAT_VERTICES == 1
+/** The floating point type used to store the vertices of the Voronoi cells in
+ * the tessellation class. */
+typedef float vertex_real;
+#else
+/** The floating point type used to store the vertices of the Voronoi cells in
+ * the tessellation class. */
+typedef double vertex_real;
+#endif
+
 /** If a point is within this distance of a cutting plane, then the code
  * assumes that point exactly lies on the plane. */
 const double tolerance=10.*std::numeric_limits<double>::epsilon();
@@ -96,6 +210,25 @@ const int max_unit_voro_shells=10;
  * container grid. */
 const double optimal_particles=5.6;
 
+/** The number of particles whose Voronoi cells are timed for each candidate
+ * grid by the grid autotuner in the pre_container classes. The particles are
+ * spread evenly through the container. */
+const int tune_sample_size=1000;
+/** The number of candidate grids that are timed by the grid autotuner. The
+ * candidates are centered on the grid chosen by guess_optimal. */
+const int tune_grid_candidates=7;
+/** The ratio between the block sizes of successive candidate grids in the
+ * grid autotuner, which is set so that the number of blocks doubles between
+ * every second candidate. */
+const double tune_grid_ratio=1.122462048309373;
+/** The number of times that the sample of cells is timed for each candidate
+ * grid, with the shortest time being used. */
+const int tune_repeats=2;
+/** The grid autotuner chooses the initial memory for each block so that at
+ * least this fraction of the blocks never need to have their memory
+ * extended. */
+const double tune_memory_fraction=0.95;
+
 /** If this is set to 1, then the code reports any instances of particles being
  * put outside of the container geometry. */
 #define VOROPP_REPORT_OUT_OF_BOUNDS 0
@@ -7,7 +7,10 @@
 /** \file container.cc
  * \brief Function implementations for the container and related classes. */
 
+#include <cstring>
+
 #include "container.hh"
+#include "c_drive.hh"
 
 namespace voro {
 
@@ -24,30 +27,37 @@ namespace voro {
  * \param[in] (xperiodic_,yperiodic_,zperiodic_) flags setting whether the
  *                                               container is periodic in each
  *                                               coordinate direction.
- * \param[in] init_mem the initial memory allocation for each block.
+ * \param[in] init_mem_ the initial memory allocation for each block.
  * \param[in] ps_ the number of floating point entries to store for each
  *                particle. */
 container_base::container_base(double ax_,double bx_,double ay_,double by_,double az_,double bz_,
-		int nx_,int ny_,int nz_,bool xperiodic_,bool yperiodic_,bool zperiodic_,int init_mem,int ps_)
+		int nx_,int ny_,int nz_,bool xperiodic_,bool yperiodic_,bool zperiodic_,int init_mem_,int ps_)
 	: voro_base(nx_,ny_,nz_,(bx_-ax_)/nx_,(by_-ay_)/ny_,(bz_-az_)/nz_),
 	ax(ax_), bx(bx_), ay(ay_), by(by_), az(az_), bz(bz_),
 	max_len_sq((bx-ax)*(bx-ax)*(xperiodic_?0.25:1)+(by-ay)*(by-ay)*(yperiodic_?0.25:1)
 		  +(bz-az)*(bz-az)*(zperiodic_?0.25:1)),
 	xperiodic(xperiodic_), yperiodic(yperiodic_), zperiodic(zperiodic_),
-	id(new int*[nxyz]), p(new double*[nxyz]), co(new int[nxyz]), mem(new int[nxyz]), ps(ps_) {
+	id(new int*[nxyz]), p(new particle_real*[nxyz]), co(new int[nxyz]), mem(new int[nxyz]),
+	init_mem(init_mem_), ps(ps_), cid(NULL), cp(NULL), cof(NULL),
+	pool(max_len_sq) {
 
 	int l;
 	for(l=0;l<nxyz;l++) co[l]=0;
 	for(l=0;l<nxyz;l++) mem[l]=init_mem;
 	for(l=0;l<nxyz;l++) id[l]=new int[init_mem];
-	for(l=0;l<nxyz;l++) p[l]=new double[ps*init_mem];
+	for(l=0;l<nxyz;l++) p[l]=new particle_real[ps*init_mem];
 }
 
 /** The container destructor frees the dynamically allocated memory. */
 container_base::~container_base() {
 	int l;
-	for(l=0;l<nxyz;l++) delete [] p[l];
-	for(l=0;l<nxyz;l++) delete [] id[l];
+	for(l=0;l<nxyz;l++) if(!compacted(l)) {
+		delete [] p[l];
+		delete [] id[l];
+	}
+	delete [] cof;
+	delete [] cp;
+	delete [] cid;
 	delete [] id;
 	delete [] p;
 	delete [] co;
@@ -91,7 +101,8 @@ void container::put(int n,double x,double y,double z) {
 	int ijk;
 	if(put_locate_block(ijk,x,y,z)) {
 		id[ijk][co[ijk]]=n;
-		double *pp=p[ijk]+3*co[ijk]++;
+		pix.current=false;
+		particle_real *pp=p[ijk]+3*co[ijk]++;
 		*(pp++)=x;*(pp++)=y;*pp=z;
 	}
 }
@@ -104,9 +115,11 @@ void container_poly::put(int n,double x,double y,double z,double r) {
 	int ijk;
 	if(put_locate_block(ijk,x,y,z)) {
 		id[ijk][co[ijk]]=n;
-		double *pp=p[ijk]+4*co[ijk]++;
+		pix.current=false;
+		particle_real *pp=p[ijk]+4*co[ijk]++;
 		*(pp++)=x;*(pp++)=y;*(pp++)=z;*pp=r;
-		if(max_radius<r) max_radius=r;
+		if(max_radius<*pp) max_radius=*pp;
+		r_grow(ijk,*pp);
 	}
 }
 
@@ -119,8 +132,9 @@ void container::put(particle_order &vo,int n,double x,double y,double z) {
 	int ijk;
 	if(put_locate_block(ijk,x,y,z)) {
 		id[ijk][co[ijk]]=n;
+		pix.current=false;
 		vo.add(ijk,co[ijk]);
-		double *pp=p[ijk]+3*co[ijk]++;
+		particle_real *pp=p[ijk]+3*co[ijk]++;
 		*(pp++)=x;*(pp++)=y;*pp=z;
 	}
 }
@@ -135,10 +149,12 @@ void container_poly::put(particle_order &vo,int n,double x,double y,double z,dou
 	int ijk;
 	if(put_locate_block(ijk,x,y,z)) {
 		id[ijk][co[ijk]]=n;
+		pix.current=false;
 		vo.add(ijk,co[ijk]);
-		double *pp=p[ijk]+4*co[ijk]++;
+		particle_real *pp=p[ijk]+4*co[ijk]++;
 		*(pp++)=x;*(pp++)=y;*(pp++)=z;*pp=r;
-		if(max_radius<r) max_radius=r;
+		if(max_radius<*pp) max_radius=*pp;
+		r_grow(ijk,*pp);
 	}
 }
 
@@ -154,6 +170,7 @@ void container_poly::put(particle_order &vo,int n,double x,double y,double z,dou
 bool container_base::put_locate_block(int &ijk,double &x,double &y,double &z) {
 	if(put_remap(ijk,x,y,z)) {
 		if(co[ijk]==mem[ijk]) add_particle_memory(ijk);
+		psoa.modify(ijk);
 		return true;
 	}
 #if VOROPP_REPORT_OUT_OF_BOUNDS ==1
@@ -304,6 +321,7 @@ bool container_poly::find_voronoi_cell(double x,double y,double z,double &rx,dou
  * \param[in] i the index of the region to reallocate. */
 void container_base::add_particle_memory(int i) {
 	int l,nmem=mem[i]<<1;
+	if(nmem<init_mem) nmem=init_mem;
 
 	// Carry out a check on the memory allocation size, and
 	// print a status message if requested
@@ -316,25 +334,202 @@ void container_base::add_particle_memory(int i) {
 	// Allocate new memory and copy in the contents of the old arrays
 	int *idp=new int[nmem];
 	for(l=0;l<co[i];l++) idp[l]=id[i][l];
-	double *pp=new double[ps*nmem];
+	particle_real *pp=new particle_real[ps*nmem];
 	for(l=0;l<ps*co[i];l++) pp[l]=p[i][l];
 
-	// Update pointers and delete old arrays
-	mem[i]=nmem;
-	delete [] id[i];id[i]=idp;
-	delete [] p[i];p[i]=pp;
+	// Update pointers and delete old arrays, unless they are part of the
+	// contiguous arrays made by the compact() routine
+	if(!compacted(i)) {delete [] id[i];delete [] p[i];}
+	mem[i]=nmem;id[i]=idp;p[i]=pp;
+}
+
+/** Rebuilds the index from particle IDs to their storage locations by
+ * scanning all of the blocks, and marks it as up to date. This is called
+ * automatically by the move() and remove() routines when a particle is not
+ * found and particles have been added since the index was last built. */
+void container_base::build_index() {
+	int ijk,q,t=0;
+	for(ijk=0;ijk<nxyz;ijk++) t+=co[ijk];
+	pix.reset(t);
+	for(ijk=0;ijk<nxyz;ijk++) for(q=0;q<co[ijk];q++) pix.insert(id[ijk][q],ijk,q);
+	pix.current=true;
+}
+
+/** Moves a particle to a new position. If the new position is within the
+ * same block, then its coordinates are overwritten. Otherwise the particle is
+ * appended to its new block and taken out of its old block by moving the last
+ * particle of the old block into its place, so that the cost does not depend
+ * on the number of particles in the container. If the container is periodic,
+ * the position is remapped into the primary domain, and if the new position
+ * is outside a non-periodic container then the particle is removed. For the
+ * container_poly class, the particle keeps its radius. Any particle_order
+ * class that refers to the particles of the affected blocks is not updated.
+ * \param[in] n the ID of the particle.
+ * \param[in] (x,y,z) the new position of the particle.
+ * \return True if the particle was moved, false if it was not in the
+ *         container or if the new position was outside the container. */
+bool container_base::move(int n,double x,double y,double z) {
+	int ijk,q,nijk;
+	if(!pix.locate(*this,n,ijk,q)) return false;
+	if(!put_remap(nijk,x,y,z)) {
+#if VOROPP_REPORT_OUT_OF_BOUNDS ==1
+		fprintf(stderr,"Out of bounds: (x,y,z)=(%g,%g,%g)\n",x,y,z);
+#endif
+		pix.erase(n);
+		pix.take(*this,ijk,q);
+		psoa.modify(ijk);
+		return false;
+	}
+	particle_real *pp;
+	if(nijk==ijk) pp=p[ijk]+ps*q;
+	else {
+		if(co[nijk]==mem[nijk]) add_particle_memory(nijk);
+		int r=co[nijk]++;
+		id[nijk][r]=n;
+		pp=p[nijk]+ps*r;
+		if(ps==4) pp[3]=p[ijk][ps*q+3];
+		pix.insert(n,nijk,r);
+		pix.take(*this,ijk,q);
+		psoa.modify(nijk);
+	}
+	*pp=x;pp[1]=y;pp[2]=z;
+	psoa.modify(ijk);
+	return true;
+}
+
+/** Removes a particle from the container, by moving the last particle of its
+ * block into its place. Any particle_order class that refers to the particles
+ * of the affected block is not updated.
+ * \param[in] n the ID of the particle.
+ * \return True if the particle was removed, false if it was not in the
+ *         container. */
+bool container_base::remove(int n) {
+	int ijk,q;
+	if(!pix.locate(*this,n,ijk,q)) return false;
+	pix.erase(n);
+	pix.take(*this,ijk,q);
+	psoa.modify(ijk);
+	return true;
+}
+
+/** Packs the particles of all blocks into contiguous arrays of IDs and
+ * positions, with the blocks laid out along a space-filling curve so that
+ * nearby blocks are close in memory. The id and p pointers of each block are
+ * set to point into these arrays, so that the loop classes and the
+ * voro_compute class work unchanged, and the separate allocation for each
+ * block is freed. This should be called once all of the particles have been
+ * imported. Particles can still be added afterwards, in which case any block
+ * that runs out of space is given its own allocation again.
+ * \param[in] mode the space-filling curve to use, which should match that of
+ *                 any c_loop_curve class used to loop over the container. */
+void container_base::compact(c_loop_curve_mode mode) {
+	int l,n,ijk,*bo=new int[nxyz],*nof=new int[nxyz];
+	int tp=total_particles(),*nid=new int[tp];
+	particle_real *np=new particle_real[ps*tp];
+
+	// Sort the blocks along the curve, and copy the particles into the
+	// new arrays
+	curve_order(nx,ny,nz,mode,bo);
+	for(n=l=0;l<nxyz;l++) {
+		ijk=bo[l];nof[ijk]=n;
+		memcpy(nid+n,id[ijk],co[ijk]*sizeof(int));
+		memcpy(np+ps*n,p[ijk],ps*co[ijk]*sizeof(particle_real));
+		n+=co[ijk];
+	}
+
+	// Free the previous storage, and point the blocks into the new arrays
+	for(ijk=0;ijk<nxyz;ijk++) {
+		if(!compacted(ijk)) {delete [] id[ijk];delete [] p[ijk];}
+		id[ijk]=nid+nof[ijk];p[ijk]=np+ps*nof[ijk];mem[ijk]=co[ijk];
+	}
+	delete [] cof;delete [] cp;delete [] cid;
+	cid=nid;cp=np;cof=nof;
+	delete [] bo;
+}
+
+/** Puts an array of particles into the container. The routine first finds the
+ * block of every particle and extends the memory of each block to fit all of
+ * its new particles at once, and then copies the particles in. Particles
+ * outside the container are skipped, as in the put routines.
+ * \param[in] n the number of particles.
+ * \param[in] pid the particle IDs.
+ * \param[in] pp the particle positions, followed by the radii if the
+ *               container stores them.
+ * \param[in] pps the number of doubles stored for each particle in pp. */
+void container_base::put_bulk(int n,const int *pid,const double *pp,int pps) {
+	int l,ijk,*bl=new int[n],*nc=new int[nxyz];
+	double x,y,z;
+	particle_real *qp;
+
+	// Find the block of each particle, and count the particles in each
+	// block
+	for(l=0;l<nxyz;l++) nc[l]=co[l];
+	for(l=0;l<n;l++) {
+		x=pp[pps*l];y=pp[pps*l+1];z=pp[pps*l+2];
+		if(put_remap(ijk,x,y,z)) {bl[l]=ijk;nc[ijk]++;}
+		else {
+			bl[l]=-1;
+#if VOROPP_REPORT_OUT_OF_BOUNDS ==1
+			fprintf(stderr,"Out of bounds: (x,y,z)=(%g,%g,%g)\n",x,y,z);
+#endif
+		}
+	}
+	for(l=0;l<nxyz;l++) while(mem[l]<nc[l]) add_particle_memory(l);
+	pix.current=false;
+
+	// Copy the particles into their blocks, remapping the positions into
+	// the primary domain for the periodic coordinates
+	for(l=0;l<n;l++) if((ijk=bl[l])>=0) {
+		x=pp[pps*l];y=pp[pps*l+1];z=pp[pps*l+2];
+		put_remap(ijk,x,y,z);
+		psoa.modify(ijk);
+		id[ijk][co[ijk]]=pid[l];
+		qp=p[ijk]+ps*co[ijk]++;
+		*qp=x;qp[1]=y;qp[2]=z;
+		if(ps==4) qp[3]=pp[pps*l+3];
+	}
+	delete [] nc;
+	delete [] bl;
+}
+
+/** Imports particles from a file in the binary particle format described in
+ * p_file.hh. The file is mapped into memory and the particles are inserted in
+ * bulk, without parsing. Any radii in the file are ignored. If the box or the
+ * periodicity stored in the file does not match the container, then the
+ * routine causes a fatal error.
+ * \param[in] filename the name of the file to read. */
+void container::import_binary(const char *filename) {
+	particle_file pf(filename);
+	double box[6]={ax,bx,ay,by,az,bz};
+	pf.check_box((xperiodic?pf_xperiodic:0)|(yperiodic?pf_yperiodic:0)|(zperiodic?pf_zperiodic:0),box);
+	put_bulk(pf.n,pf.id,pf.p,pf.ps);
+}
+
+/** Imports particles from a file in the binary particle format described in
+ * p_file.hh. The file is mapped into memory and the particles are inserted in
+ * bulk, without parsing. If the file does not contain radii, or if the box or
+ * the periodicity stored in the file does not match the container, then the
+ * routine causes a fatal error.
+ * \param[in] filename the name of the file to read. */
+void container_poly::import_binary(const char *filename) {
+	particle_file pf(filename);
+	if(!pf.radii()) voro_fatal_error("Binary particle file does not contain radii",VOROPP_FILE_ERROR);
+	double box[6]={ax,bx,ay,by,az,bz};
+	pf.check_box((xperiodic?pf_xperiodic:0)|(yperiodic?pf_yperiodic:0)|(zperiodic?pf_zperiodic:0),box);
+	put_bulk(pf.n,pf.id,pf.p,4);
+	for(int l=0;l<pf.n;l++) if(max_radius<particle_real(pf.p[4*l+3])) max_radius=particle_real(pf.p[4*l+3]);
+	lmr_ok=false;
 }
 
 /** Import a list of particles from an open file stream into the container.
  * Entries of four numbers (Particle ID, x position, y position, z position)
- * are searched for. If the file cannot be successfully read, then the routine
- * causes a fatal error.
+ * are searched for. The file is parsed in parallel using the particle_text
+ * class. If the file cannot be successfully read, then the routine causes a
+ * fatal error.
  * \param[in] fp the file handle to read from. */
 void container::import(FILE *fp) {
-	int i,j;
-	double x,y,z;
-	while((j=fscanf(fp,"%d %lg %lg %lg",&i,&x,&y,&z))==4) put(i,x,y,z);
-	if(j!=EOF) voro_fatal_error("File import error",VOROPP_FILE_ERROR);
+	particle_text pt(fp,3);
+	put_bulk(pt.n,pt.id,pt.p,3);
 }
 
 /** Import a list of particles from an open file stream, also storing the order
@@ -344,22 +539,22 @@ void container::import(FILE *fp) {
  * \param[in,out] vo a reference to an ordering class to use.
  * \param[in] fp the file handle to read from. */
 void container::import(particle_order &vo,FILE *fp) {
-	int i,j;
-	double x,y,z;
-	while((j=fscanf(fp,"%d %lg %lg %lg",&i,&x,&y,&z))==4) put(vo,i,x,y,z);
-	if(j!=EOF) voro_fatal_error("File import error",VOROPP_FILE_ERROR);
+	particle_text pt(fp,3);
+	double *pp=pt.p;
+	for(int l=0;l<pt.n;l++,pp+=3) put(vo,pt.id[l],*pp,pp[1],pp[2]);
 }
 
 /** Import a list of particles from an open file stream into the container.
  * Entries of five numbers (Particle ID, x position, y position, z position,
- * radius) are searched for. If the file cannot be successfully read, then the
+ * radius) are searched for. The file is parsed in parallel using the
+ * particle_text class. If the file cannot be successfully read, then the
  * routine causes a fatal error.
  * \param[in] fp the file handle to read from. */
 void container_poly::import(FILE *fp) {
-	int i,j;
-	double x,y,z,r;
-	while((j=fscanf(fp,"%d %lg %lg %lg %lg",&i,&x,&y,&z,&r))==5) put(i,x,y,z,r);
-	if(j!=EOF) voro_fatal_error("File import error",VOROPP_FILE_ERROR);
+	particle_text pt(fp,4);
+	put_bulk(pt.n,pt.id,pt.p,4);
+	for(int l=0;l<pt.n;l++) if(max_radius<particle_real(pt.p[4*l+3])) max_radius=particle_real(pt.p[4*l+3]);
+	lmr_ok=false;
 }
 
 /** Import a list of particles from an open file stream, also storing the order
@@ -369,10 +564,9 @@ void container_poly::import(FILE *fp) {
  * \param[in,out] vo a reference to an ordering class to use.
  * \param[in] fp the file handle to read from. */
 void container_poly::import(particle_order &vo,FILE *fp) {
-	int i,j;
-	double x,y,z,r;
-	while((j=fscanf(fp,"%d %lg %lg %lg %lg",&i,&x,&y,&z,&r))==5) put(vo,i,x,y,z,r);
-	if(j!=EOF) voro_fatal_error("File import error",VOROPP_FILE_ERROR);
+	particle_text pt(fp,4);
+	double *pp=pt.p;
+	for(int l=0;l<pt.n;l++,pp+=4) put(vo,pt.id[l],*pp,pp[1],pp[2],pp[3]);
 }
 
 /** Outputs the a list of all the container regions along with the number of
@@ -386,13 +580,106 @@ void container_base::region_count() {
 /** Clears a container of particles. */
 void container::clear() {
 	for(int *cop=co;cop<co+nxyz;cop++) *cop=0;
+	clear_soa();
 }
 
 /** Clears a container of particles, also clearing resetting the maximum radius
  * to zero. */
 void container_poly::clear() {
 	for(int *cop=co;cop<co+nxyz;cop++) *cop=0;
+	clear_soa();
 	max_radius=0;
+	lmr_ok=false;
+}
+
+/** Moves a particle, using the move() routine of the container_base class,
+ * and marks the radius map as out of date if the particle is larger than the
+ * map records for its new block.
+ * \param[in] n the ID of the particle.
+ * \param[in] (x,y,z) the new position of the particle.
+ * \return True if the particle was moved, false if it was not in the
+ *         container or if the new position was outside the container. */
+bool container_poly::move(int n,double x,double y,double z) {
+	int ijk,q;
+	if(!container_base::move(n,x,y,z)) return false;
+	if(pix.find(n,ijk,q)) r_grow(ijk,p[ijk][4*q+3]);
+	return true;
+}
+
+/** Builds the radius map, which records the maximum radius of the particles
+ * in each block, and the maximum radius of the particles in the blocks within
+ * a given reach of each block. During the Voronoi cell computation, once a
+ * cell is small enough that no particle outside the reach of its block could
+ * cut it, the search is cut off using the maximum radius near the block rather
+ * than that of the whole container, so that a few large particles only slow
+ * down the computation of the cells near them. The reach is chosen to be one
+ * block more than the maximum radius, which is enough for the cells of the
+ * smaller particles to switch over. The routines that compute all of the
+ * cells build the map if it is out of date, and otherwise it should be called
+ * after all particles have been put into the container. If the map is
+ * already current, then the routine does nothing. */
+void container_poly::build_radius_map() {
+	if(lmr_ok) return;
+	if(bmr==NULL) {bmr=new double[nxyz];lmr=new double[nxyz];}
+	int i,j,k,q,w;
+	double r,*bp=bmr,*tp=new double[nxyz];
+
+	// Find the maximum radius squared in each block
+	for(i=0;i<nxyz;i++,bp++) for(*bp=0,q=0;q<co[i];q++) {
+		r=p[i][4*q+3];
+		if(r*r>*bp) *bp=r*r;
+	}
+
+	// Set the reach of each block, and the squared distance to the
+	// nearest block outside it
+	r=boxx<boxy?boxx:boxy;if(boxz<r) r=boxz;
+	w=int(max_radius/r)+1;
+	lmr_far=w*r*w*r;
+
+	// Take the maximum over the reach of each block, one direction at a
+	// time
+	for(k=0;k<nz;k++) for(j=0;j<ny;j++) radius_line_max(bmr+nx*(j+ny*k),tp+nx*(j+ny*k),nx,1,w,xperiodic);
+	for(k=0;k<nz;k++) for(i=0;i<nx;i++) radius_line_max(tp+i+nxy*k,lmr+i+nxy*k,ny,nx,w,yperiodic);
+	for(j=0;j<ny;j++) for(i=0;i<nx;i++) radius_line_max(lmr+i+nx*j,tp+i+nx*j,nz,nxy,w,zperiodic);
+	for(i=0;i<nxyz;i++) lmr[i]=tp[i];
+	delete [] tp;
+	lmr_ok=true;
+}
+
+/** Takes the maximum of a line of values in the radius map over a window
+ * around each entry.
+ * \param[in] in a pointer to the first input value.
+ * \param[out] out a pointer to the first output value.
+ * \param[in] n the number of values in the line.
+ * \param[in] st the stride between consecutive values.
+ * \param[in] w the number of entries on each side to consider.
+ * \param[in] prd whether the line is periodic, in which case the window
+ *                wraps around. */
+void container_poly::radius_line_max(double *in,double *out,int n,int st,int w,bool prd) {
+	int i,l,lo,hi;
+	double m;
+	for(i=0;i<n;i++) {
+		lo=i-w;hi=i+w;
+		if(hi-lo>=n-1) {lo=0;hi=n-1;}
+		else if(!prd) {if(lo<0) lo=0;if(hi>=n) hi=n-1;}
+		for(m=0,l=lo;l<=hi;l++) {
+			double v=in[st*(l<0?l+n:(l>=n?l-n:l))];
+			if(v>m) m=v;
+		}
+		out[st*i]=m;
+	}
+}
+
+/** Computes the Voronoi cells for the particles in a scheduler and saves
+ * customized information about them.
+ * \param[in] bs the scheduler to use.
+ * \param[in] format the custom output string to use.
+ * \param[in] fp a file handle to write to. */
+void container::print_custom(block_scheduler &bs,const char *format,FILE *fp) {
+	drive_custom f(bs,format,fp);
+	if(contains_neighbor(format)) drive_cells_periodicity<voronoicell_neighbor>(*this,bs,f);
+	else drive_cells_periodicity<voronoicell>(*this,bs,f);
+	f.finish();
 }
 
 /** Computes all the Voronoi cells and saves customized information about them.
@@ -403,8 +690,20 @@ void container::print_custom(const char *format,FILE *fp) {
 	print_custom(vl,format,fp);
 }
 
-/** Computes all the Voronoi cells and saves customized
- * information about them.
+/** Computes the Voronoi cells for the particles in a scheduler and saves
+ * customized information about them.
+ * \param[in] bs the scheduler to use.
+ * \param[in] format the custom output string to use.
+ * \param[in] fp a file handle to write to. */
+void container_poly::print_custom(block_scheduler &bs,const char *format,FILE *fp) {
+	drive_custom f(bs,format,fp);
+	build_radius_map();
+	if(contains_neighbor(format)) drive_cells_periodicity<voronoicell_neighbor>(*this,bs,f);
+	else drive_cells_periodicity<voronoicell>(*this,bs,f);
+	f.finish();
+}
+
+/** Computes all the Voronoi cells and saves customized information about them.
  * \param[in] format the custom output string to use.
  * \param[in] fp a file handle to write to. */
 void container_poly::print_custom(const char *format,FILE *fp) {
@@ -421,6 +720,37 @@ void container::print_custom(const char *format,const char *filename) {
 	fclose(fp);
 }
 
+/** Computes the Voronoi cells for the particles in a scheduler and saves
+ * customized information about them in the columnar binary format.
+ * \param[in] bs the scheduler to use.
+ * \param[in] format the custom output string to use.
+ * \param[in] fp a file handle to write to. */
+void container::print_custom_binary(block_scheduler &bs,const char *format,FILE *fp) {
+	drive_columns f(bs,format,fp);
+	if(contains_neighbor(format)) drive_cells_periodicity<voronoicell_neighbor>(*this,bs,f);
+	else drive_cells_periodicity<voronoicell>(*this,bs,f);
+	f.finish();
+}
+
+/** Computes all the Voronoi cells and saves customized information about them
+ * in the columnar binary format.
+ * \param[in] format the custom output string to use.
+ * \param[in] fp a file handle to write to. */
+void container::print_custom_binary(const char *format,FILE *fp) {
+	c_loop_all vl(*this);
+	print_custom_binary(vl,format,fp);
+}
+
+/** Computes all the Voronoi cells and saves customized information about them
+ * in the columnar binary format.
+ * \param[in] format the custom output string to use.
+ * \param[in] filename the name of the file to write to. */
+void container::print_custom_binary(const char *format,const char *filename) {
+	FILE *fp=safe_fopen(filename,"wb");
+	print_custom_binary(format,fp);
+	fclose(fp);
+}
+
 /** Computes all the Voronoi cells and saves customized
  * information about them
  * \param[in] format the custom output string to use.
@@ -431,15 +761,63 @@ void container_poly::print_custom(const char *format,const char *filename) {
 	fclose(fp);
 }
 
+/** Computes the Voronoi cells for the particles in a scheduler and saves
+ * customized information about them in the columnar binary format.
+ * \param[in] bs the scheduler to use.
+ * \param[in] format the custom output string to use.
+ * \param[in] fp a file handle to write to. */
+void container_poly::print_custom_binary(block_scheduler &bs,const char *format,FILE *fp) {
+	drive_columns f(bs,format,fp);
+	build_radius_map();
+	if(contains_neighbor(format)) drive_cells_periodicity<voronoicell_neighbor>(*this,bs,f);
+	else drive_cells_periodicity<voronoicell>(*this,bs,f);
+	f.finish();
+}
+
+/** Computes all the Voronoi cells and saves customized information about them
+ * in the columnar binary format.
+ * \param[in] format the custom output string to use.
+ * \param[in] fp a file handle to write to. */
+void container_poly::print_custom_binary(const char *format,FILE *fp) {
+	c_loop_all vl(*this);
+	print_custom_binary(vl,format,fp);
+}
+
+/** Computes all the Voronoi cells and saves customized information about them
+ * in the columnar binary format.
+ * \param[in] format the custom output string to use.
+ * \param[in] filename the name of the file to write to. */
+void container_poly::print_custom_binary(const char *format,const char *filename) {
+	FILE *fp=safe_fopen(filename,"wb");
+	print_custom_binary(format,fp);
+	fclose(fp);
+}
+
+/** Computes the Voronoi cells for the particles in a scheduler, but does
+ * nothing with the output.
+ * \param[in] bs the scheduler to use. */
+void container::compute_cells(block_scheduler &bs) {
+	drive_none f;
+	drive_cells_periodicity<voronoicell>(*this,bs,f);
+}
+
 /** Computes all of the Voronoi cells in the container, but does nothing
  * with the output. It is useful for measuring the pure computation time
  * of the Voronoi algorithm, without any additional calculations such as
  * volume evaluation or cell output. */
 void container::compute_all_cells() {
-	voronoicell c(*this);
 	c_loop_all vl(*this);
-	if(vl.start()) do compute_cell(c,vl);
-	while(vl.inc());
+	block_scheduler bs(vl);
+	compute_cells(bs);
+}
+
+/** Computes the Voronoi cells for the particles in a scheduler, but does
+ * nothing with the output.
+ * \param[in] bs the scheduler to use. */
+void container_poly::compute_cells(block_scheduler &bs) {
+	drive_none f;
+	build_radius_map();
+	drive_cells_periodicity<voronoicell>(*this,bs,f);
 }
 
 /** Computes all of the Voronoi cells in the container, but does nothing
@@ -447,9 +825,21 @@ void container::compute_all_cells() {
  * of the Voronoi algorithm, without any additional calculations such as
  * volume evaluation or cell output. */
 void container_poly::compute_all_cells() {
-	voronoicell c(*this);
 	c_loop_all vl(*this);
-	if(vl.start()) do compute_cell(c,vl);while(vl.inc());
+	block_scheduler bs(vl);
+	compute_cells(bs);
+}
+
+/** Calculates the Voronoi cells for the particles in a scheduler and sums
+ * their volumes. The volumes are summed for each chunk, and these are then
+ * added in order, so that the result does not depend on the number of
+ * threads.
+ * \param[in] bs the scheduler to use.
+ * \return The sum of all of the computed Voronoi volumes. */
+double container::sum_cell_volumes(block_scheduler &bs) {
+	drive_volume f(bs);
+	drive_cells_periodicity<voronoicell>(*this,bs,f);
+	return f.sum();
 }
 
 /** Calculates all of the Voronoi cells and sums their volumes. In most cases
@@ -457,11 +847,22 @@ void container_poly::compute_all_cells() {
  * of the container to numerical precision.
  * \return The sum of all of the computed Voronoi volumes. */
 double container::sum_cell_volumes() {
-	voronoicell c(*this);
-	double vol=0;
 	c_loop_all vl(*this);
-	if(vl.start()) do if(compute_cell(c,vl)) vol+=c.volume();while(vl.inc());
-	return vol;
+	block_scheduler bs(vl);
+	return sum_cell_volumes(bs);
+}
+
+/** Calculates the Voronoi cells for the particles in a scheduler and sums
+ * their volumes. The volumes are summed for each chunk, and these are then
+ * added in order, so that the result does not depend on the number of
+ * threads.
+ * \param[in] bs the scheduler to use.
+ * \return The sum of all of the computed Voronoi volumes. */
+double container_poly::sum_cell_volumes(block_scheduler &bs) {
+	drive_volume f(bs);
+	build_radius_map();
+	drive_cells_periodicity<voronoicell>(*this,bs,f);
+	return f.sum();
 }
 
 /** Calculates all of the Voronoi cells and sums their volumes. In most cases
@@ -469,11 +870,161 @@ double container::sum_cell_volumes() {
  * of the container to numerical precision.
  * \return The sum of all of the computed Voronoi volumes. */
 double container_poly::sum_cell_volumes() {
-	voronoicell c(*this);
-	double vol=0;
 	c_loop_all vl(*this);
-	if(vl.start()) do if(compute_cell(c,vl)) vol+=c.volume();while(vl.inc());
-	return vol;
+	block_scheduler bs(vl);
+	return sum_cell_volumes(bs);
+}
+
+/** Computes the Voronoi cells for the particles in a scheduler and stores
+ * their neighbor graph. The neighbors recorded for each chunk are combined in
+ * order, so that the graph does not depend on the number of threads.
+ * \param[in] bs the scheduler to use.
+ * \param[out] ng the neighbor graph to fill in. */
+void container::compute_neighbor_graph(block_scheduler &bs,neighbor_graph &ng) {
+	drive_graph f(bs,ng);
+	drive_cells_periodicity<voronoicell_neighbor>(*this,bs,f);
+	ng.assemble();
+}
+
+/** Computes all of the Voronoi cells and stores their neighbor graph.
+ * \param[out] ng the neighbor graph to fill in. */
+void container::compute_neighbor_graph(neighbor_graph &ng) {
+	c_loop_all vl(*this);
+	compute_neighbor_graph(vl,ng);
+}
+
+/** Computes the Voronoi cells for the particles in a scheduler and stores
+ * their neighbor graph. The neighbors recorded for each chunk are combined in
+ * order, so that the graph does not depend on the number of threads.
+ * \param[in] bs the scheduler to use.
+ * \param[out] ng the neighbor graph to fill in. */
+void container_poly::compute_neighbor_graph(block_scheduler &bs,neighbor_graph &ng) {
+	drive_graph f(bs,ng);
+	build_radius_map();
+	drive_cells_periodicity<voronoicell_neighbor>(*this,bs,f);
+	ng.assemble();
+}
+
+/** Computes all of the Voronoi cells and stores their neighbor graph.
+ * \param[out] ng the neighbor graph to fill in. */
+void container_poly::compute_neighbor_graph(neighbor_graph &ng) {
+	c_loop_all vl(*this);
+	compute_neighbor_graph(vl,ng);
+}
+
+/** Computes the Voronoi cells for the particles in a scheduler and stores each
+ * of their faces once. The faces recorded for each chunk are combined in
+ * order, so that the numbering does not depend on the number of threads.
+ * \param[in] bs the scheduler to use.
+ * \param[out] fm the face mesh to fill in. */
+void container::compute_face_mesh(block_scheduler &bs,face_mesh &fm) {
+	drive_mesh f(bs,fm,mesh_tolerance*sqrt(max_len_sq));
+	drive_cells_periodicity<voronoicell_neighbor>(*this,bs,f);
+	fm.assemble();
+}
+
+/** Computes all of the Voronoi cells and stores each of their faces once.
+ * \param[out] fm the face mesh to fill in. */
+void container::compute_face_mesh(face_mesh &fm) {
+	c_loop_all vl(*this);
+	compute_face_mesh(vl,fm);
+}
+
+/** Computes the Voronoi cells for the particles in a scheduler and stores the
+ * finite volume Laplacian of the tessellation. The faces recorded for each
+ * chunk are combined in order, so that the matrix does not depend on the
+ * number of threads.
+ * \param[in] bs the scheduler to use.
+ * \param[out] fl the matrix to fill in. */
+void container::compute_laplacian(block_scheduler &bs,fv_laplacian &fl) {
+	drive_laplacian f(bs,fl);
+	drive_cells_periodicity<voronoicell_neighbor>(*this,bs,f);
+	fl.assemble();
+}
+
+/** Computes all of the Voronoi cells and stores the finite volume Laplacian of
+ * the tessellation.
+ * \param[out] fl the matrix to fill in. */
+void container::compute_laplacian(fv_laplacian &fl) {
+	c_loop_all vl(*this);
+	compute_laplacian(vl,fl);
+}
+
+/** Computes the Voronoi cells for the particles in a scheduler and stores them
+ * in a tessellation. The cells recorded for each chunk are then copied into
+ * place.
+ * \param[in] bs the scheduler to use.
+ * \param[out] ts the tessellation to fill in. */
+void container::compute_tessellation(block_scheduler &bs,tessellation &ts) {
+	drive_tessellation f(bs,ts);
+	drive_cells_periodicity<voronoicell_neighbor>(*this,bs,f);
+	ts.assemble();
+}
+
+/** Computes all of the Voronoi cells and stores them in a tessellation.
+ * \param[out] ts the tessellation to fill in. */
+void container::compute_tessellation(tessellation &ts) {
+	c_loop_all vl(*this);
+	compute_tessellation(vl,ts);
+}
+
+/** Computes the Voronoi cells for the particles in a scheduler and stores each
+ * of their faces once. The faces recorded for each chunk are combined in
+ * order, so that the numbering does not depend on the number of threads.
+ * \param[in] bs the scheduler to use.
+ * \param[out] fm the face mesh to fill in. */
+void container_poly::compute_face_mesh(block_scheduler &bs,face_mesh &fm) {
+	drive_mesh f(bs,fm,mesh_tolerance*sqrt(max_len_sq));
+	build_radius_map();
+	drive_cells_periodicity<voronoicell_neighbor>(*this,bs,f);
+	fm.assemble();
+}
+
+/** Computes all of the Voronoi cells and stores each of their faces once.
+ * \param[out] fm the face mesh to fill in. */
+void container_poly::compute_face_mesh(face_mesh &fm) {
+	c_loop_all vl(*this);
+	compute_face_mesh(vl,fm);
+}
+
+/** Computes the Voronoi cells for the particles in a scheduler and stores the
+ * finite volume Laplacian of the tessellation. The faces recorded for each
+ * chunk are combined in order, so that the matrix does not depend on the
+ * number of threads.
+ * \param[in] bs the scheduler to use.
+ * \param[out] fl the matrix to fill in. */
+void container_poly::compute_laplacian(block_scheduler &bs,fv_laplacian &fl) {
+	drive_laplacian f(bs,fl);
+	build_radius_map();
+	drive_cells_periodicity<voronoicell_neighbor>(*this,bs,f);
+	fl.assemble();
+}
+
+/** Computes all of the Voronoi cells and stores the finite volume Laplacian of
+ * the tessellation.
+ * \param[out] fl the matrix to fill in. */
+void container_poly::compute_laplacian(fv_laplacian &fl) {
+	c_loop_all vl(*this);
+	compute_laplacian(vl,fl);
+}
+
+/** Computes the Voronoi cells for the particles in a scheduler and stores them
+ * in a tessellation. The cells recorded for each chunk are then copied into
+ * place.
+ * \param[in] bs the scheduler to use.
+ * \param[out] ts the tessellation to fill in. */
+void container_poly::compute_tessellation(block_scheduler &bs,tessellation &ts) {
+	drive_tessellation f(bs,ts);
+	build_radius_map();
+	drive_cells_periodicity<voronoicell_neighbor>(*this,bs,f);
+	ts.assemble();
+}
+
+/** Computes all of the Voronoi cells and stores them in a tessellation.
+ * \param[out] ts the tessellation to fill in. */
+void container_poly::compute_tessellation(tessellation &ts) {
+	c_loop_all vl(*this);
+	compute_tessellation(vl,ts);
 }
 
 /** This function tests to see if a given vector lies within the container
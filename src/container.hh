@@ -17,7 +17,20 @@
 #include "common.hh"
 #include "v_base.hh"
 #include "cell.hh"
+#include "o_custom.hh"
+#include "o_columns.hh"
+#include "o_graph.hh"
+#include "o_mesh.hh"
+#include "o_laplace.hh"
+#include "o_tess.hh"
 #include "c_loops.hh"
+#include "c_sched.hh"
+#include "c_pool.hh"
+#include "c_track.hh"
+#include "p_soa.hh"
+#include "p_index.hh"
+#include "p_file.hh"
+#include "p_text.hh"
 #include "v_compute.hh"
 #include "rad_option.hh"
 
@@ -144,7 +157,7 @@ class container_base : public voro_base, public wall_list {
 		/** A two dimensional array holding particle positions. For the
 		 * derived container_poly class, this also holds particle
 		 * radii. */
-		double **p;
+		particle_real **p;
 		/** This array holds the number of particles within each
 		 * computational box of the container. */
 		int *co;
@@ -154,6 +167,9 @@ class container_base : public voro_base, public wall_list {
 		 * more is allocated using the add_particle_memory() function.
 		 */
 		int *mem;
+		/** The initial amount of memory to allocate for particles
+		 * for each block. */
+		const int init_mem;
 		/** The amount of memory in the array structure for each
 		 * particle. This is set to 3 when the basic class is
 		 * initialized, so that the array holds (x,y,z) positions. If
@@ -161,12 +177,52 @@ class container_base : public voro_base, public wall_list {
 		 * class container_poly, then this is set to 4, to also hold
 		 * the particle radii. */
 		const int ps;
+		/** An optional structure-of-arrays copy of the particle
+		 * positions, which is used to vectorize the loops over the
+		 * particles in a block. */
+		particle_soa psoa;
+		/** The contiguous array of particle IDs made by the compact()
+		 * routine, or a null pointer if the container has not been
+		 * compacted. */
+		int *cid;
+		/** The contiguous array of particle positions made by the
+		 * compact() routine. */
+		particle_real *cp;
+		/** The offset of each block in the contiguous arrays. */
+		int *cof;
+		/** An index from particle IDs to their storage locations,
+		 * which is used by the move() and remove() routines. */
+		particle_index pix;
+		/** A set of Voronoi cells for each thread, which are reused
+		 * by the routines that compute many cells. */
+		cell_pool pool;
 		container_base(double ax_,double bx_,double ay_,double by_,double az_,double bz_,
 				int nx_,int ny_,int nz_,bool xperiodic_,bool yperiodic_,bool zperiodic_,
 				int init_mem,int ps_);
 		~container_base();
 		bool point_inside(double x,double y,double z);
 		void region_count();
+		/** Makes a structure-of-arrays copy of the particle positions,
+		 * which is then used during the Voronoi cell computation. The
+		 * copy is not updated when particles are added, moved, or
+		 * removed, and any block that changes afterwards is read from
+		 * the regular particle data, so this should be called after
+		 * all particles have been put into the container. */
+		inline void build_soa() {psoa.build(nxyz,ps,co,p);}
+		/** Frees the structure-of-arrays copy of the particle
+		 * positions. */
+		inline void clear_soa() {psoa.clear();}
+		void compact(c_loop_curve_mode mode=morton);
+		void build_index();
+		bool move(int n,double x,double y,double z);
+		bool remove(int n);
+		/** Checks whether the particles of a block are stored in the
+		 * contiguous arrays made by the compact() routine.
+		 * \param[in] ijk the index of the block.
+		 * \return True if the block is compacted, false otherwise. */
+		inline bool compacted(int ijk) const {
+			return cid!=NULL&&id[ijk]==cid+cof[ijk];
+		}
 		/** Initializes the Voronoi cell prior to a compute_cell
 		 * operation for a specific particle being carried out by a
 		 * voro_compute class. The cell is initialized to fill the
@@ -191,7 +247,8 @@ class container_base : public voro_base, public wall_list {
 		template<class v_cell>
 		inline bool initialize_voronoicell(v_cell &c,int ijk,int q,int ci,int cj,int ck,
 				int &i,int &j,int &k,double &x,double &y,double &z,int &disp) {
-			double x1,x2,y1,y2,z1,z2,*pp=p[ijk]+ps*q;
+			double x1,x2,y1,y2,z1,z2;
+			particle_real *pp=p[ijk]+ps*q;
 			x=*(pp++);y=*(pp++);z=*pp;
 			if(xperiodic) {x1=-(x2=0.5*(bx-ax));i=nx;} else {x1=ax-x;x2=bx-x;i=ci;}
 			if(yperiodic) {y1=-(y2=0.5*(by-ay));j=ny;} else {y1=ay-y;y2=by-y;j=cj;}
@@ -274,6 +331,7 @@ class container_base : public voro_base, public wall_list {
 		}
 	protected:
 		void add_particle_memory(int i);
+		void put_bulk(int n,const int *pid,const double *pp,int pps);
 		bool put_locate_block(int &ijk,double &x,double &y,double &z);
 		inline bool put_remap(int &ijk,double &x,double &y,double &z);
 		inline bool remap(int &ai,int &aj,int &ak,int &ci,int &cj,int &ck,double &x,double &y,double &z,int &ijk);
@@ -320,14 +378,17 @@ class container : public container_base, public radius_mono {
 			import(vo,fp);
 			fclose(fp);
 		}
+		void import_binary(const char *filename);
+		void compute_cells(block_scheduler &bs);
 		void compute_all_cells();
 		double sum_cell_volumes();
+		double sum_cell_volumes(block_scheduler &bs);
 		/** Dumps particle IDs and positions to a file.
 		 * \param[in] vl the loop class to use.
 		 * \param[in] fp a file handle to write to. */
 		template<class c_loop>
 		void draw_particles(c_loop &vl,FILE *fp) {
-			double *pp;
+			particle_real *pp;
 			if(vl.start()) do {
 				pp=p[vl.ijk]+3*vl.q;
 				fprintf(fp,"%d %g %g %g\n",id[vl.ijk][vl.q],*pp,pp[1],pp[2]);
@@ -346,12 +407,36 @@ class container : public container_base, public radius_mono {
 			draw_particles(fp);
 			fclose(fp);
 		}
+		/** Dumps particle IDs and positions to a file in the binary
+		 * particle format described in p_file.hh.
+		 * \param[in] vl the loop class to use.
+		 * \param[in] fp a file handle to write to. */
+		template<class c_loop>
+		void draw_particles_binary(c_loop &vl,FILE *fp) {
+			double box[6]={ax,bx,ay,by,az,bz};
+			write_particles_binary(vl,id,p,ps,(xperiodic?pf_xperiodic:0)|(yperiodic?pf_yperiodic:0)|(zperiodic?pf_zperiodic:0),box,fp);
+		}
+		/** Dumps all of the particle IDs and positions to a file in the binary
+		 * particle format.
+		 * \param[in] fp a file handle to write to. */
+		inline void draw_particles_binary(FILE *fp) {
+			c_loop_all vl(*this);
+			draw_particles_binary(vl,fp);
+		}
+		/** Dumps all of the particle IDs and positions to a file in the binary
+		 * particle format.
+		 * \param[in] filename the name of the file to write to. */
+		inline void draw_particles_binary(const char *filename) {
+			FILE *fp=safe_fopen(filename,"wb");
+			draw_particles_binary(fp);
+			fclose(fp);
+		}
 		/** Dumps particle positions in POV-Ray format.
 		 * \param[in] vl the loop class to use.
 		 * \param[in] fp a file handle to write to. */
 		template<class c_loop>
 		void draw_particles_pov(c_loop &vl,FILE *fp) {
-			double *pp;
+			particle_real *pp;
 			if(vl.start()) do {
 				pp=p[vl.ijk]+3*vl.q;
 				fprintf(fp,"// id %d\nsphere{<%g,%g,%g>,s}\n",
@@ -377,7 +462,9 @@ class container : public container_base, public radius_mono {
 		 * \param[in] fp a file handle to write to. */
 		template<class c_loop>
 		void draw_cells_gnuplot(c_loop &vl,FILE *fp) {
-			voronoicell c(*this);double *pp;
+			pool.setup(1);
+			voronoicell &c=pool.fetch<voronoicell>(0);
+			particle_real *pp;
 			if(vl.start()) do if(compute_cell(c,vl)) {
 				pp=p[vl.ijk]+ps*vl.q;
 				c.draw_gnuplot(*pp,pp[1],pp[2],fp);
@@ -404,7 +491,9 @@ class container : public container_base, public radius_mono {
 		 * \param[in] fp a file handle to write to. */
 		template<class c_loop>
 		void draw_cells_pov(c_loop &vl,FILE *fp) {
-			voronoicell c(*this);double *pp;
+			pool.setup(1);
+			voronoicell &c=pool.fetch<voronoicell>(0);
+			particle_real *pp;
 			if(vl.start()) do if(compute_cell(c,vl)) {
 				fprintf(fp,"// cell %d\n",id[vl.ijk][vl.q]);
 				pp=p[vl.ijk]+ps*vl.q;
@@ -427,29 +516,88 @@ class container : public container_base, public radius_mono {
 			fclose(fp);
 		}
 		/** Computes the Voronoi cells and saves customized information
-		 * about them.
+		 * about them. The particles visited by the loop are shared
+		 * among the available threads using a block_scheduler class.
 		 * \param[in] vl the loop class to use.
 		 * \param[in] format the custom output string to use.
 		 * \param[in] fp a file handle to write to. */
 		template<class c_loop>
 		void print_custom(c_loop &vl,const char *format,FILE *fp) {
-			int ijk,q;double *pp;
-			if(contains_neighbor(format)) {
-				voronoicell_neighbor c(*this);
-				if(vl.start()) do if(compute_cell(c,vl)) {
-					ijk=vl.ijk;q=vl.q;pp=p[ijk]+ps*q;
-					c.output_custom(format,id[ijk][q],*pp,pp[1],pp[2],default_radius,fp);
-				} while(vl.inc());
-			} else {
-				voronoicell c(*this);
-				if(vl.start()) do if(compute_cell(c,vl)) {
-					ijk=vl.ijk;q=vl.q;pp=p[ijk]+ps*q;
-					c.output_custom(format,id[ijk][q],*pp,pp[1],pp[2],default_radius,fp);
-				} while(vl.inc());
-			}
+			block_scheduler bs(vl);
+			print_custom(bs,format,fp);
 		}
+		void print_custom(block_scheduler &bs,const char *format,FILE *fp=stdout);
 		void print_custom(const char *format,FILE *fp=stdout);
 		void print_custom(const char *format,const char *filename);
+		/** Computes the Voronoi cells and saves customized information
+		 * about them in the columnar binary format described in
+		 * o_columns.hh. The particles visited by the loop are shared
+		 * among the available threads using a block_scheduler class.
+		 * \param[in] vl the loop class to use.
+		 * \param[in] format the custom output string to use.
+		 * \param[in] fp a file handle to write to. */
+		template<class c_loop>
+		void print_custom_binary(c_loop &vl,const char *format,FILE *fp) {
+			block_scheduler bs(vl);
+			print_custom_binary(bs,format,fp);
+		}
+		void print_custom_binary(block_scheduler &bs,const char *format,FILE *fp);
+		void print_custom_binary(const char *format,FILE *fp);
+		void print_custom_binary(const char *format,const char *filename);
+		/** Computes the Voronoi cells and stores the neighbor graph of
+		 * the particles, in the compressed sparse row form described
+		 * in o_graph.hh. The particles visited by the loop are shared
+		 * among the available threads using a block_scheduler class.
+		 * \param[in] vl the loop class to use.
+		 * \param[out] ng the neighbor graph to fill in. */
+		template<class c_loop>
+		void compute_neighbor_graph(c_loop &vl,neighbor_graph &ng) {
+			block_scheduler bs(vl);
+			compute_neighbor_graph(bs,ng);
+		}
+		void compute_neighbor_graph(block_scheduler &bs,neighbor_graph &ng);
+		void compute_neighbor_graph(neighbor_graph &ng);
+		/** Computes the Voronoi cells and stores each of their faces
+		 * once, in the mesh described in o_mesh.hh. The particles
+		 * visited by the loop are shared among the available threads
+		 * using a block_scheduler class.
+		 * \param[in] vl the loop class to use.
+		 * \param[out] fm the face mesh to fill in. */
+		template<class c_loop>
+		void compute_face_mesh(c_loop &vl,face_mesh &fm) {
+			block_scheduler bs(vl);
+			compute_face_mesh(bs,fm);
+		}
+		void compute_face_mesh(block_scheduler &bs,face_mesh &fm);
+		void compute_face_mesh(face_mesh &fm);
+		/** Computes the Voronoi cells and stores the finite volume
+		 * Laplacian of the tessellation, in the sparse matrix
+		 * described in o_laplace.hh. The particles visited by the loop
+		 * are shared among the available threads using a
+		 * block_scheduler class.
+		 * \param[in] vl the loop class to use.
+		 * \param[out] fl the matrix to fill in. */
+		template<class c_loop>
+		void compute_laplacian(c_loop &vl,fv_laplacian &fl) {
+			block_scheduler bs(vl);
+			compute_laplacian(bs,fl);
+		}
+		void compute_laplacian(block_scheduler &bs,fv_laplacian &fl);
+		void compute_laplacian(fv_laplacian &fl);
+		/** Computes the Voronoi cells and stores them in the compact
+		 * form described in o_tess.hh, so that they can be examined
+		 * later without being recomputed. The particles visited by
+		 * the loop are shared among the available threads using a
+		 * block_scheduler class.
+		 * \param[in] vl the loop class to use.
+		 * \param[out] ts the tessellation to fill in. */
+		template<class c_loop>
+		void compute_tessellation(c_loop &vl,tessellation &ts) {
+			block_scheduler bs(vl);
+			compute_tessellation(bs,ts);
+		}
+		void compute_tessellation(block_scheduler &bs,tessellation &ts);
+		void compute_tessellation(tessellation &ts);
 		bool find_voronoi_cell(double x,double y,double z,double &rx,double &ry,double &rz,int &pid);
 		/** Computes the Voronoi cell for a particle currently being
 		 * referenced by a loop class.
@@ -488,7 +636,7 @@ class container : public container_base, public radius_mono {
 		inline bool compute_ghost_cell(v_cell &c,double x,double y,double z) {
 			int ijk;
 			if(put_locate_block(ijk,x,y,z)) {
-				double *pp=p[ijk]+3*co[ijk]++;
+				particle_real *pp=p[ijk]+3*co[ijk]++;
 				*(pp++)=x;*(pp++)=y;*pp=z;
 				bool q=compute_cell(c,ijk,co[ijk]-1);
 				co[ijk]--;
@@ -498,7 +646,7 @@ class container : public container_base, public radius_mono {
 		}
 	private:
 		voro_compute<container> vc;
-		friend class voro_compute<container>;
+		template<class c_class,class p_class,class m_class> friend class voro_compute;
 };
 
 /** \brief Extension of the container_base class for computing radical Voronoi
@@ -542,14 +690,19 @@ class container_poly : public container_base, public radius_poly {
 			import(vo,fp);
 			fclose(fp);
 		}
+		void import_binary(const char *filename);
+		bool move(int n,double x,double y,double z);
+		void build_radius_map();
+		void compute_cells(block_scheduler &bs);
 		void compute_all_cells();
 		double sum_cell_volumes();
+		double sum_cell_volumes(block_scheduler &bs);
 		/** Dumps particle IDs, positions and radii to a file.
 		 * \param[in] vl the loop class to use.
 		 * \param[in] fp a file handle to write to. */
 		template<class c_loop>
 		void draw_particles(c_loop &vl,FILE *fp) {
-			double *pp;
+			particle_real *pp;
 			if(vl.start()) do {
 				pp=p[vl.ijk]+4*vl.q;
 				fprintf(fp,"%d %g %g %g %g\n",id[vl.ijk][vl.q],*pp,pp[1],pp[2],pp[3]);
@@ -570,12 +723,38 @@ class container_poly : public container_base, public radius_poly {
 			draw_particles(fp);
 			fclose(fp);
 		}
+		/** Dumps particle IDs, positions and radii to a file in the binary
+		 * particle format described in p_file.hh.
+		 * \param[in] vl the loop class to use.
+		 * \param[in] fp a file handle to write to. */
+		template<class c_loop>
+		void draw_particles_binary(c_loop &vl,FILE *fp) {
+			double box[6]={ax,bx,ay,by,az,bz};
+			write_particles_binary(vl,id,p,ps,(xperiodic?pf_xperiodic:0)|(yperiodic?pf_yperiodic:0)|(zperiodic?pf_zperiodic:0),box,fp);
+		}
+		/** Dumps all of the particle IDs, positions and
+		 * radii to a file in the binary
+		 * particle format.
+		 * \param[in] fp a file handle to write to. */
+		inline void draw_particles_binary(FILE *fp) {
+			c_loop_all vl(*this);
+			draw_particles_binary(vl,fp);
+		}
+		/** Dumps all of the particle IDs, positions and
+		 * radii to a file in the binary
+		 * particle format.
+		 * \param[in] filename the name of the file to write to. */
+		inline void draw_particles_binary(const char *filename) {
+			FILE *fp=safe_fopen(filename,"wb");
+			draw_particles_binary(fp);
+			fclose(fp);
+		}
 		/** Dumps particle positions in POV-Ray format.
 		 * \param[in] vl the loop class to use.
 		 * \param[in] fp a file handle to write to. */
 		template<class c_loop>
 		void draw_particles_pov(c_loop &vl,FILE *fp) {
-			double *pp;
+			particle_real *pp;
 			if(vl.start()) do {
 				pp=p[vl.ijk]+4*vl.q;
 				fprintf(fp,"// id %d\nsphere{<%g,%g,%g>,%g}\n",
@@ -601,7 +780,9 @@ class container_poly : public container_base, public radius_poly {
 		 * \param[in] fp a file handle to write to. */
 		template<class c_loop>
 		void draw_cells_gnuplot(c_loop &vl,FILE *fp) {
-			voronoicell c;double *pp;
+			pool.setup(1);
+			voronoicell &c=pool.fetch<voronoicell>(0);
+			particle_real *pp;
 			if(vl.start()) do if(compute_cell(c,vl)) {
 				pp=p[vl.ijk]+ps*vl.q;
 				c.draw_gnuplot(*pp,pp[1],pp[2],fp);
@@ -628,7 +809,9 @@ class container_poly : public container_base, public radius_poly {
 		 * \param[in] fp a file handle to write to. */
 		template<class c_loop>
 		void draw_cells_pov(c_loop &vl,FILE *fp) {
-			voronoicell c(*this);double *pp;
+			pool.setup(1);
+			voronoicell &c=pool.fetch<voronoicell>(0);
+			particle_real *pp;
 			if(vl.start()) do if(compute_cell(c,vl)) {
 				fprintf(fp,"// cell %d\n",id[vl.ijk][vl.q]);
 				pp=p[vl.ijk]+ps*vl.q;
@@ -651,27 +834,17 @@ class container_poly : public container_base, public radius_poly {
 			fclose(fp);
 		}
 		/** Computes the Voronoi cells and saves customized information
-		 * about them.
+		 * about them. The particles visited by the loop are shared
+		 * among the available threads using a block_scheduler class.
 		 * \param[in] vl the loop class to use.
 		 * \param[in] format the custom output string to use.
 		 * \param[in] fp a file handle to write to. */
 		template<class c_loop>
 		void print_custom(c_loop &vl,const char *format,FILE *fp) {
-			int ijk,q;double *pp;
-			if(contains_neighbor(format)) {
-				voronoicell_neighbor c(*this);
-				if(vl.start()) do if(compute_cell(c,vl)) {
-					ijk=vl.ijk;q=vl.q;pp=p[ijk]+ps*q;
-					c.output_custom(format,id[ijk][q],*pp,pp[1],pp[2],pp[3],fp);
-				} while(vl.inc());
-			} else {
-				voronoicell c(*this);
-				if(vl.start()) do if(compute_cell(c,vl)) {
-					ijk=vl.ijk;q=vl.q;pp=p[ijk]+ps*q;
-					c.output_custom(format,id[ijk][q],*pp,pp[1],pp[2],pp[3],fp);
-				} while(vl.inc());
-			}
+			block_scheduler bs(vl);
+			print_custom(bs,format,fp);
 		}
+		void print_custom(block_scheduler &bs,const char *format,FILE *fp=stdout);
 		/** Computes the Voronoi cell for a particle currently being
 		 * referenced by a loop class.
 		 * \param[out] c a Voronoi cell class in which to store the
@@ -710,9 +883,10 @@ class container_poly : public container_base, public radius_poly {
 		inline bool compute_ghost_cell(v_cell &c,double x,double y,double z,double r) {
 			int ijk;
 			if(put_locate_block(ijk,x,y,z)) {
-				double *pp=p[ijk]+4*co[ijk]++,tm=max_radius;
+				particle_real *pp=p[ijk]+4*co[ijk]++;
+				double tm=max_radius;
 				*(pp++)=x;*(pp++)=y;*(pp++)=z;*pp=r;
-				if(r>max_radius) max_radius=r;
+				if(*pp>max_radius) max_radius=*pp;
 				bool q=compute_cell(c,ijk,co[ijk]-1);
 				co[ijk]--;max_radius=tm;
 				return q;
@@ -721,10 +895,80 @@ class container_poly : public container_base, public radius_poly {
 		}
 		void print_custom(const char *format,FILE *fp=stdout);
 		void print_custom(const char *format,const char *filename);
+		/** Computes the Voronoi cells and saves customized information
+		 * about them in the columnar binary format described in
+		 * o_columns.hh. The particles visited by the loop are shared
+		 * among the available threads using a block_scheduler class.
+		 * \param[in] vl the loop class to use.
+		 * \param[in] format the custom output string to use.
+		 * \param[in] fp a file handle to write to. */
+		template<class c_loop>
+		void print_custom_binary(c_loop &vl,const char *format,FILE *fp) {
+			block_scheduler bs(vl);
+			print_custom_binary(bs,format,fp);
+		}
+		void print_custom_binary(block_scheduler &bs,const char *format,FILE *fp);
+		void print_custom_binary(const char *format,FILE *fp);
+		void print_custom_binary(const char *format,const char *filename);
+		/** Computes the Voronoi cells and stores the neighbor graph of
+		 * the particles, in the compressed sparse row form described
+		 * in o_graph.hh. The particles visited by the loop are shared
+		 * among the available threads using a block_scheduler class.
+		 * \param[in] vl the loop class to use.
+		 * \param[out] ng the neighbor graph to fill in. */
+		template<class c_loop>
+		void compute_neighbor_graph(c_loop &vl,neighbor_graph &ng) {
+			block_scheduler bs(vl);
+			compute_neighbor_graph(bs,ng);
+		}
+		void compute_neighbor_graph(block_scheduler &bs,neighbor_graph &ng);
+		void compute_neighbor_graph(neighbor_graph &ng);
+		/** Computes the Voronoi cells and stores each of their faces
+		 * once, in the mesh described in o_mesh.hh. The particles
+		 * visited by the loop are shared among the available threads
+		 * using a block_scheduler class.
+		 * \param[in] vl the loop class to use.
+		 * \param[out] fm the face mesh to fill in. */
+		template<class c_loop>
+		void compute_face_mesh(c_loop &vl,face_mesh &fm) {
+			block_scheduler bs(vl);
+			compute_face_mesh(bs,fm);
+		}
+		void compute_face_mesh(block_scheduler &bs,face_mesh &fm);
+		void compute_face_mesh(face_mesh &fm);
+		/** Computes the Voronoi cells and stores the finite volume
+		 * Laplacian of the tessellation, in the sparse matrix
+		 * described in o_laplace.hh. The particles visited by the loop
+		 * are shared among the available threads using a
+		 * block_scheduler class.
+		 * \param[in] vl the loop class to use.
+		 * \param[out] fl the matrix to fill in. */
+		template<class c_loop>
+		void compute_laplacian(c_loop &vl,fv_laplacian &fl) {
+			block_scheduler bs(vl);
+			compute_laplacian(bs,fl);
+		}
+		void compute_laplacian(block_scheduler &bs,fv_laplacian &fl);
+		void compute_laplacian(fv_laplacian &fl);
+		/** Computes the Voronoi cells and stores them in the compact
+		 * form described in o_tess.hh, so that they can be examined
+		 * later without being recomputed. The particles visited by
+		 * the loop are shared among the available threads using a
+		 * block_scheduler class.
+		 * \param[in] vl the loop class to use.
+		 * \param[out] ts the tessellation to fill in. */
+		template<class c_loop>
+		void compute_tessellation(c_loop &vl,tessellation &ts) {
+			block_scheduler bs(vl);
+			compute_tessellation(bs,ts);
+		}
+		void compute_tessellation(block_scheduler &bs,tessellation &ts);
+		void compute_tessellation(tessellation &ts);
 		bool find_voronoi_cell(double x,double y,double z,double &rx,double &ry,double &rz,int &pid);
 	private:
 		voro_compute<container_poly> vc;
-		friend class voro_compute<container_poly>;
+		void radius_line_max(double *in,double *out,int n,int st,int w,bool prd);
+		template<class c_class,class p_class,class m_class> friend class voro_compute;
 };
 
 }
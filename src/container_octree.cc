@@ -0,0 +1,384 @@
+// Voro++, a 3D cell-based Voronoi library
+//
+// Author   : Chris H. Rycroft (LBL / UC Berkeley)
+// Email    : chr@alum.mit.edu
+// Date     : August 30th 2011
+
+/** \file container_octree.cc
+ * \brief Function implementations for the container_octree and related
+ * classes. */
+
+#include "container_octree.hh"
+#include "p_text.hh"
+#include "c_drive.hh"
+
+namespace voro {
+
+/** The class constructor allocates memory for the priority queue and the
+ * block displacement arrays.
+ * \param[in] con_ a reference to the container class to use. */
+octree_compute::octree_compute(container_octree &con_) : con(con_), hn(0),
+	hmem(init_octree_queue_size), hd(new double[hmem]), hi(new int[hmem]),
+	bmem(init_block_vectors), bv(new double[5*bmem]),
+	bvx(bv), bvy(bv+bmem), bvz(bv+2*bmem), bvr(bv+3*bmem), bvm(bv+4*bmem) {}
+
+/** The class destructor frees the dynamically allocated memory. */
+octree_compute::~octree_compute() {
+	delete [] bv;
+	delete [] hi;
+	delete [] hd;
+}
+
+/** Doubles the memory allocation for the priority queue. */
+void octree_compute::add_heap_memory() {
+	int l,nmem=hmem<<1;
+	if(nmem>max_octree_queue_size)
+		voro_fatal_error("Octree priority queue allocation exceeded absolute maximum",VOROPP_MEMORY_ERROR);
+#if VOROPP_VERBOSE >=2
+	fprintf(stderr,"Octree priority queue scaled up to %d\n",nmem);
+#endif
+	double *nhd=new double[nmem];
+	int *nhi=new int[nmem];
+	for(l=0;l<hn;l++) {nhd[l]=hd[l];nhi[l]=hi[l];}
+	delete [] hi;delete [] hd;
+	hd=nhd;hi=nhi;hmem=nmem;
+}
+
+/** Increases the memory allocation for the block displacement arrays so that
+ * they can hold at least a given number of particles.
+ * \param[in] n the number of particles that must fit. */
+void octree_compute::add_block_memory(int n) {
+	while(bmem<n) bmem<<=1;
+	if(bmem>max_particle_memory)
+		voro_fatal_error("Block vector memory allocation exceeded absolute maximum",VOROPP_MEMORY_ERROR);
+	delete [] bv;
+	bv=new double[5*bmem];
+	bvx=bv;bvy=bv+bmem;bvz=bv+2*bmem;bvr=bv+3*bmem;bvm=bv+4*bmem;
+}
+
+/** Finds the particle that is nearest to a given vector, by visiting the
+ * nodes of the octree in order of increasing distance, and stopping once the
+ * nearest remaining node is further away than the closest particle found so
+ * far.
+ * \param[in] (x,y,z) the vector to test.
+ * \param[out] ijk the block that the nearest particle is within.
+ * \param[out] l the index of the nearest particle within the block.
+ * \return True if a particle was found, false if the container is empty. */
+bool octree_compute::find_nearest(double x,double y,double z,int &ijk,int &l) {
+	int i,e,b,q;
+	double d,mrs=large_number,dx,dy,dz;
+	particle_real *pp;
+	ijk=-1;hn=0;
+	if(con.nd->n>0) push(con.nd->min_dist_sq(x,y,z),0);
+	while(hn>0) {
+		d=*hd;i=*hi;pop();
+		if(d>=mrs) break;
+		const octree_node &o=con.nd[i];
+		if(o.c>=0) {
+			for(e=o.c+8,i=o.c;i<e;i++) if(con.nd[i].n>0) {
+				d=con.nd[i].min_dist_sq(x,y,z);
+				if(d<mrs) push(d,i);
+			}
+		} else {
+			b=o.l;
+			for(q=0,pp=con.p[b];q<con.co[b];q++,pp+=3) {
+				dx=*pp-x;dy=pp[1]-y;dz=pp[2]-z;
+				d=dx*dx+dy*dy+dz*dz;
+				if(d<mrs) {mrs=d;ijk=b;l=q;}
+			}
+		}
+	}
+	return ijk!=-1;
+}
+
+/** The class constructor sets up the geometry of container, initializing the
+ * minimum and maximum coordinates in each direction. The octree initially
+ * consists of a single empty leaf covering the whole container.
+ * \param[in] (ax_,bx_) the minimum and maximum x coordinates.
+ * \param[in] (ay_,by_) the minimum and maximum y coordinates.
+ * \param[in] (az_,bz_) the minimum and maximum z coordinates.
+ * \param[in] init_mem_ the initial memory allocation for each block. */
+container_octree::container_octree(double ax_,double bx_,double ay_,double by_,double az_,double bz_,int init_mem_)
+	: ax(ax_), bx(bx_), ay(ay_), by(by_), az(az_), bz(bz_),
+	max_len_sq((bx-ax)*(bx-ax)+(by-ay)*(by-ay)+(bz-az)*(bz-az)),
+	nx(0), ny(1), nz(1), nxy(0), nxyz(0),
+	id(new int*[init_octree_blocks]), p(new particle_real*[init_octree_blocks]),
+	co(new int[init_octree_blocks]), mem(new int[init_octree_blocks]),
+	nd(new octree_node[init_octree_nodes]), nn(0), init_mem(init_mem_), ps(3),
+	pool(max_len_sq), bmem(init_octree_blocks), nmem(init_octree_nodes), oc(*this) {
+	init_root();
+}
+
+/** The container destructor frees the dynamically allocated memory. */
+container_octree::~container_octree() {
+	for(int l=0;l<nx;l++) {
+		delete [] p[l];
+		delete [] id[l];
+	}
+	delete [] nd;
+	delete [] mem;
+	delete [] co;
+	delete [] p;
+	delete [] id;
+}
+
+/** Sets up the octree as a single empty leaf that covers the whole
+ * container. */
+void container_octree::init_root() {
+	nn=1;
+	nd->xl=ax;nd->xh=bx;nd->yl=ay;nd->yh=by;nd->zl=az;nd->zh=bz;
+	nd->n=0;nd->c=-1;nd->d=0;
+	nd->l=new_block();
+}
+
+/** Creates a new empty block.
+ * \return The number of the new block. */
+int container_octree::new_block() {
+	if(nx==bmem) add_block_memory();
+	int b=nx++;
+	nxy=nxyz=nx;
+	co[b]=0;mem[b]=init_mem;
+	id[b]=new int[init_mem];
+	p[b]=new particle_real[ps*init_mem];
+	return b;
+}
+
+/** Divides a leaf of the octree into eight children, and shares its particles
+ * among them. The block of the leaf is reused for the first child.
+ * \param[in] o the index of the leaf node. */
+void container_octree::split(int o) {
+	if(nn+8>nmem) add_node_memory();
+	int b=nd[o].l,c=nn,m,q,l,n=co[b],*oid=id[b];
+	particle_real *op=p[b],*pp,*np;
+	octree_node &pa=nd[o];
+	double xm=0.5*(pa.xl+pa.xh),ym=0.5*(pa.yl+pa.yh),zm=0.5*(pa.zl+pa.zh);
+
+	// Set up the children, giving the first child a fresh copy of the
+	// block memory
+	co[b]=0;mem[b]=init_mem;
+	id[b]=new int[init_mem];
+	p[b]=new particle_real[ps*init_mem];
+	for(m=0;m<8;m++) {
+		octree_node &ch=nd[c+m];
+		if(m&1) {ch.xl=xm;ch.xh=pa.xh;} else {ch.xl=pa.xl;ch.xh=xm;}
+		if(m&2) {ch.yl=ym;ch.yh=pa.yh;} else {ch.yl=pa.yl;ch.yh=ym;}
+		if(m&4) {ch.zl=zm;ch.zh=pa.zh;} else {ch.zl=pa.zl;ch.zh=zm;}
+		ch.n=0;ch.c=-1;ch.d=pa.d+1;
+		ch.l=m==0?b:new_block();
+	}
+	pa.c=c;pa.l=-1;nn+=8;
+
+	// Move the particles into the children
+	for(q=0,pp=op;q<n;q++,pp+=3) {
+		m=c+pa.octant(*pp,pp[1],pp[2]);
+		nd[m].n++;l=nd[m].l;
+		if(co[l]==mem[l]) add_particle_memory(l);
+		id[l][co[l]]=oid[q];
+		np=p[l]+3*co[l]++;
+		*(np++)=*pp;*(np++)=pp[1];*np=pp[2];
+	}
+	delete [] op;
+	delete [] oid;
+}
+
+/** Doubles the memory allocation for the blocks. The loop classes keep copies
+ * of the block array pointers, so they must be created after this. */
+void container_octree::add_block_memory() {
+	int l,nmem_=bmem<<1;
+	if(nmem_>max_octree_blocks)
+		voro_fatal_error("Octree block memory allocation exceeded absolute maximum",VOROPP_MEMORY_ERROR);
+#if VOROPP_VERBOSE >=2
+	fprintf(stderr,"Octree block memory scaled up to %d\n",nmem_);
+#endif
+	int **nid=new int*[nmem_],*nco=new int[nmem_],*nmemp=new int[nmem_];
+	particle_real **np=new particle_real*[nmem_];
+	for(l=0;l<nx;l++) {
+		nid[l]=id[l];np[l]=p[l];nco[l]=co[l];nmemp[l]=mem[l];
+	}
+	delete [] mem;delete [] co;delete [] p;delete [] id;
+	id=nid;p=np;co=nco;mem=nmemp;bmem=nmem_;
+}
+
+/** Doubles the memory allocation for the octree nodes. */
+void container_octree::add_node_memory() {
+	int l,nmem_=nmem<<1;
+	if(nmem_>max_octree_nodes)
+		voro_fatal_error("Octree node memory allocation exceeded absolute maximum",VOROPP_MEMORY_ERROR);
+#if VOROPP_VERBOSE >=2
+	fprintf(stderr,"Octree node memory scaled up to %d\n",nmem_);
+#endif
+	octree_node *nnd=new octree_node[nmem_];
+	for(l=0;l<nn;l++) nnd[l]=nd[l];
+	delete [] nd;
+	nd=nnd;nmem=nmem_;
+}
+
+/** Increase memory for a particular block.
+ * \param[in] i the number of the block to reallocate. */
+void container_octree::add_particle_memory(int i) {
+	int l,nmem_=mem[i]<<1;
+	if(nmem_>max_particle_memory)
+		voro_fatal_error("Absolute maximum memory allocation exceeded",VOROPP_MEMORY_ERROR);
+#if VOROPP_VERBOSE >=3
+	fprintf(stderr,"Particle memory in block %d scaled up to %d\n",i,nmem_);
+#endif
+	int *idp=new int[nmem_];
+	for(l=0;l<co[i];l++) idp[l]=id[i][l];
+	particle_real *pp=new particle_real[ps*nmem_];
+	for(l=0;l<ps*co[i];l++) pp[l]=p[i][l];
+	delete [] id[i];delete [] p[i];
+	mem[i]=nmem_;id[i]=idp;p[i]=pp;
+}
+
+/** Put a particle into the octree. The tree is descended to the leaf
+ * containing the particle, and any full leaf on the way is divided.
+ * \param[in] n the numerical ID of the inserted particle.
+ * \param[in] (x,y,z) the position vector of the inserted particle. */
+void container_octree::put(int n,double x,double y,double z) {
+	if(x<ax||x>=bx||y<ay||y>=by||z<az||z>=bz) {
+#if VOROPP_REPORT_OUT_OF_BOUNDS ==1
+		fprintf(stderr,"Out of bounds: (x,y,z)=(%g,%g,%g)\n",x,y,z);
+#endif
+		return;
+	}
+
+	// Round the position to the stored precision, so that the leaf is
+	// chosen in the same way as when the leaf is later divided
+	particle_real rx=x,ry=y,rz=z;
+	int o=0,b;
+	while(true) {
+		nd[o].n++;
+		if(nd[o].c<0) {
+			b=nd[o].l;
+			if(co[b]<octree_leaf_size||nd[o].d>=octree_max_depth) break;
+			split(o);
+		}
+		o=nd[o].c+nd[o].octant(rx,ry,rz);
+	}
+	if(co[b]==mem[b]) add_particle_memory(b);
+	id[b][co[b]]=n;
+	particle_real *pp=p[b]+3*co[b]++;
+	*(pp++)=rx;*(pp++)=ry;*pp=rz;
+}
+
+/** Import a list of particles from an open file stream into the container.
+ * Entries of four numbers (Particle ID, x position, y position, z position)
+ * are searched for. The file is parsed in parallel using the particle_text
+ * class. If the file cannot be successfully read, then the routine causes a
+ * fatal error.
+ * \param[in] fp the file handle to read from. */
+void container_octree::import(FILE *fp) {
+	particle_text pt(fp,3);
+	double *pp=pt.p;
+	for(int l=0;l<pt.n;l++,pp+=3) put(pt.id[l],*pp,pp[1],pp[2]);
+}
+
+/** Clears a container of particles, freeing the memory for all of the blocks
+ * and resetting the octree to a single leaf. */
+void container_octree::clear() {
+	for(int l=0;l<nx;l++) {
+		delete [] p[l];
+		delete [] id[l];
+	}
+	nx=nxy=nxyz=0;
+	init_root();
+}
+
+/** This function tests to see if a given vector lies within the container
+ * bounds and any walls.
+ * \param[in] (x,y,z) the position vector to be tested.
+ * \return True if the point is inside the container, false if the point is
+ *         outside. */
+bool container_octree::point_inside(double x,double y,double z) {
+	if(x<ax||x>bx||y<ay||y>by||z<az||z>bz) return false;
+	return point_inside_walls(x,y,z);
+}
+
+/** Takes a vector and finds the particle whose Voronoi cell contains that
+ * vector. This is equivalent to finding the particle which is nearest to the
+ * vector. Additional wall classes are not considered by this routine.
+ * \param[in] (x,y,z) the vector to test.
+ * \param[out] (rx,ry,rz) the position of the particle whose Voronoi cell
+ *                        contains the vector.
+ * \param[out] pid the ID of the particle.
+ * \return True if a particle was found. If the vector is outside the
+ * container, or the container has no particles, then the search will not
+ * find a Voronoi cell and false is returned. */
+bool container_octree::find_voronoi_cell(double x,double y,double z,double &rx,double &ry,double &rz,int &pid) {
+	int ijk,l;
+	if(x<ax||x>bx||y<ay||y>by||z<az||z>bz||!oc.find_nearest(x,y,z,ijk,l)) return false;
+	rx=p[ijk][3*l];
+	ry=p[ijk][3*l+1];
+	rz=p[ijk][3*l+2];
+	pid=id[ijk][l];
+	return true;
+}
+
+/** Computes the Voronoi cells for the particles in a scheduler and saves
+ * customized information about them.
+ * \param[in] bs the scheduler to use.
+ * \param[in] format the custom output string to use.
+ * \param[in] fp a file handle to write to. */
+void container_octree::print_custom(block_scheduler &bs,const char *format,FILE *fp) {
+	drive_custom f(bs,format,fp);
+	if(voro_base::contains_neighbor(format)) drive_cells<voronoicell_neighbor,octree_compute>(*this,bs,f);
+	else drive_cells<voronoicell,octree_compute>(*this,bs,f);
+	f.finish();
+}
+
+/** Computes all the Voronoi cells and saves customized information about them.
+ * \param[in] format the custom output string to use.
+ * \param[in] fp a file handle to write to. */
+void container_octree::print_custom(const char *format,FILE *fp) {
+	c_loop_all vl(*this);
+	print_custom(vl,format,fp);
+}
+
+/** Computes all the Voronoi cells and saves customized information about them.
+ * \param[in] format the custom output string to use.
+ * \param[in] filename the name of the file to write to. */
+void container_octree::print_custom(const char *format,const char *filename) {
+	FILE *fp=safe_fopen(filename,"w");
+	print_custom(format,fp);
+	fclose(fp);
+}
+
+/** Computes the Voronoi cells for the particles in a scheduler, but does
+ * nothing with the output.
+ * \param[in] bs the scheduler to use. */
+void container_octree::compute_cells(block_scheduler &bs) {
+	drive_none f;
+	drive_cells<voronoicell,octree_compute>(*this,bs,f);
+}
+
+/** Computes all of the Voronoi cells in the container, but does nothing
+ * with the output. */
+void container_octree::compute_all_cells() {
+	c_loop_all vl(*this);
+	block_scheduler bs(vl);
+	compute_cells(bs);
+}
+
+/** Calculates the Voronoi cells for the particles in a scheduler and sums
+ * their volumes. The volumes are summed for each chunk, and these are then
+ * added in order, so that the result does not depend on the number of
+ * threads.
+ * \param[in] bs the scheduler to use.
+ * \return The sum of all of the computed Voronoi volumes. */
+double container_octree::sum_cell_volumes(block_scheduler &bs) {
+	drive_volume f(bs);
+	drive_cells<voronoicell,octree_compute>(*this,bs,f);
+	return f.sum();
+}
+
+/** Calculates all of the Voronoi cells and sums their volumes. In most cases
+ * without walls, the sum of the Voronoi cell volumes should equal the volume
+ * of the container to numerical precision.
+ * \return The sum of all of the computed Voronoi volumes. */
+double container_octree::sum_cell_volumes() {
+	c_loop_all vl(*this);
+	block_scheduler bs(vl);
+	return sum_cell_volumes(bs);
+}
+
+}
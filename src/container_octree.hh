@@ -0,0 +1,431 @@
+// Voro++, a 3D cell-based Voronoi library
+//
+// Author   : Chris H. Rycroft (LBL / UC Berkeley)
+// Email    : chr@alum.mit.edu
+// Date     : August 30th 2011
+
+/** \file container_octree.hh
+ * \brief Header file for the container_octree and related classes. */
+
+#ifndef VOROPP_CONTAINER_OCTREE_HH
+#define VOROPP_CONTAINER_OCTREE_HH
+
+#include <cstdio>
+
+#include "config.hh"
+#include "common.hh"
+#include "cell.hh"
+#include "c_loops.hh"
+#include "c_sched.hh"
+#include "c_pool.hh"
+#include "container.hh"
+
+namespace voro {
+
+/** \brief A structure holding a node of the octree in a container_octree
+ * class.
+ *
+ * Each node covers a rectangular box. An internal node divides its box into
+ * eight equal children, which are stored consecutively, while a leaf node
+ * refers to a block of particles in the container. */
+struct octree_node {
+	/** The minimum x coordinate of the box. */
+	double xl;
+	/** The maximum x coordinate of the box. */
+	double xh;
+	/** The minimum y coordinate of the box. */
+	double yl;
+	/** The maximum y coordinate of the box. */
+	double yh;
+	/** The minimum z coordinate of the box. */
+	double zl;
+	/** The maximum z coordinate of the box. */
+	double zh;
+	/** The total number of particles within the box. */
+	int n;
+	/** The index of the first child node, or -1 for a leaf. */
+	int c;
+	/** The block holding the particles of a leaf node, or -1 for an
+	 * internal node. */
+	int l;
+	/** The depth of the node, which is zero for the root. */
+	int d;
+	/** Computes the minimum squared distance from a point to the box.
+	 * \param[in] (x,y,z) the position of the point.
+	 * \return The squared distance, which is zero if the point is inside
+	 *         the box. */
+	inline double min_dist_sq(double x,double y,double z) const {
+		double dx=x<xl?xl-x:(x>xh?x-xh:0),
+		       dy=y<yl?yl-y:(y>yh?y-yh:0),
+		       dz=z<zl?zl-z:(z>zh?z-zh:0);
+		return dx*dx+dy*dy+dz*dz;
+	}
+	/** Finds which of the eight children of the node a point lies in.
+	 * \param[in] (x,y,z) the position of the point.
+	 * \return The child number, between 0 and 7. */
+	inline int octant(double x,double y,double z) const {
+		return (x<0.5*(xl+xh)?0:1)|(y<0.5*(yl+yh)?0:2)|(z<0.5*(zl+zh)?0:4);
+	}
+};
+
+class container_octree;
+
+/** \brief Class for computing Voronoi cells by searching an octree.
+ *
+ * This class carries out the same role as the voro_compute template, but for
+ * the container_octree class. Rather than testing the blocks of a regular grid
+ * in a fixed order, it keeps a priority queue of octree nodes, keyed by their
+ * minimum squared distance to the particle, and visits the nodes in order of
+ * increasing distance. Internal nodes are replaced by their occupied children,
+ * and the particles in leaf nodes are used to cut the cell. The search stops
+ * once the nearest remaining node is further away than the current value of
+ * the maximum radius squared of the cell, since no particle beyond this can
+ * cut it. */
+class octree_compute {
+	public:
+		octree_compute(container_octree &con_);
+		~octree_compute();
+		template<class v_cell>
+		bool compute_cell(v_cell &c,int ijk,int s);
+		/** Computes the Voronoi cell of a particle, taking the same
+		 * arguments as voro_compute::compute_cell so that the class
+		 * can be used with the drive_cells routine. The block
+		 * coordinates are not needed by the octree search and are
+		 * ignored.
+		 * \param[in,out] c a reference to a Voronoi cell class.
+		 * \param[in] ijk the block that the particle is in.
+		 * \param[in] s the index of the particle within its block.
+		 * \return False if the cell was completely removed, true
+		 *         otherwise. */
+		template<class v_cell>
+		inline bool compute_cell(v_cell &c,int ijk,int s,int ci,int cj,int ck) {
+			return compute_cell(c,ijk,s);
+		}
+		bool find_nearest(double x,double y,double z,int &ijk,int &l);
+	private:
+		/** A reference to the container class. */
+		container_octree &con;
+		/** The current number of nodes in the priority queue. */
+		int hn;
+		/** The current memory allocation for the priority queue. */
+		int hmem;
+		/** The minimum squared distance of each node in the priority
+		 * queue, stored as a binary heap. */
+		double *hd;
+		/** The indices of the nodes in the priority queue. */
+		int *hi;
+		/** The number of particles that the block displacement arrays
+		 * can hold. */
+		int bmem;
+		/** The memory for the block displacement arrays. */
+		double *bv;
+		/** The x components of the displacement vectors from the
+		 * particle being computed to the particles in a leaf. */
+		double *bvx;
+		/** The y components of the block displacement vectors. */
+		double *bvy;
+		/** The z components of the block displacement vectors. */
+		double *bvz;
+		/** The squared lengths of the block displacement vectors. */
+		double *bvr;
+		/** The bounds computed by the voronoicell_base::plane_bounds
+		 * routine for the block displacement vectors. */
+		double *bvm;
+		inline void push(double d,int i);
+		inline void pop();
+		void add_heap_memory();
+		void add_block_memory(int n);
+		template<class v_cell>
+		inline bool cut_leaf(v_cell &c,int l,int s,double x,double y,double z,double &mrs);
+};
+
+/** \brief A container class whose spatial index is an adaptive octree.
+ *
+ * This class computes regular Voronoi tessellations in a non-periodic
+ * rectangular box, in the same way as the container class. However, rather
+ * than dividing the box into a regular grid of blocks, it stores the particles
+ * in the leaves of an octree. When a particle is put into a leaf that is
+ * already full, the leaf is divided into eight children and its particles are
+ * shared among them, so that the number of particles in each leaf stays close
+ * to the optimal block occupancy in both the dense and sparse parts of the
+ * domain. This is useful for strongly clustered particle arrangements, where
+ * any regular grid is either too coarse in the clusters or too fine in the
+ * gaps between them.
+ *
+ * The particles in each leaf are stored as a block, with the blocks numbered
+ * consecutively in a single dimension, so that the standard c_loop_all class
+ * and the block_scheduler class can be used to loop over the particles. The
+ * loop classes should be created after all of the particles have been added,
+ * since adding particles may create new blocks. The Voronoi cells are computed
+ * with an octree_compute class. */
+class container_octree : public wall_list {
+	public:
+		/** The minimum x coordinate of the container. */
+		const double ax;
+		/** The maximum x coordinate of the container. */
+		const double bx;
+		/** The minimum y coordinate of the container. */
+		const double ay;
+		/** The maximum y coordinate of the container. */
+		const double by;
+		/** The minimum z coordinate of the container. */
+		const double az;
+		/** The maximum z coordinate of the container. */
+		const double bz;
+		/** The maximum length squared that could be encountered in the
+		 * Voronoi cell calculation. */
+		const double max_len_sq;
+		/** The number of blocks, equal to the number of leaves in the
+		 * octree. The blocks are indexed in a single dimension, so
+		 * this is also the number of blocks in the x direction. */
+		int nx;
+		/** The number of blocks in the y direction, which is always
+		 * one. */
+		int ny;
+		/** The number of blocks in the z direction, which is always
+		 * one. */
+		int nz;
+		/** A copy of the number of blocks, for use by the loop
+		 * classes. */
+		int nxy;
+		/** A copy of the number of blocks, for use by the loop
+		 * classes. */
+		int nxyz;
+		/** This array holds the numerical IDs of each particle in each
+		 * block. */
+		int **id;
+		/** A two dimensional array holding particle positions. */
+		particle_real **p;
+		/** This array holds the number of particles within each
+		 * block. */
+		int *co;
+		/** This array holds the maximum amount of particle memory for
+		 * each block. */
+		int *mem;
+		/** The nodes of the octree, with the root node first. */
+		octree_node *nd;
+		/** The number of nodes in the octree. */
+		int nn;
+		/** The initial amount of memory to allocate for particles
+		 * for each block. */
+		const int init_mem;
+		/** The amount of memory in the array structure for each
+		 * particle, which is set to 3 to hold (x,y,z) positions. */
+		const int ps;
+		/** A set of Voronoi cells for each thread, which are reused
+		 * by the routines that compute many cells. */
+		cell_pool pool;
+		container_octree(double ax_,double bx_,double ay_,double by_,double az_,double bz_,int init_mem_);
+		~container_octree();
+		void clear();
+		void put(int n,double x,double y,double z);
+		void import(FILE *fp=stdin);
+		/** Imports a list of particles from an open file stream into
+		 * the container. Entries of four numbers (Particle ID, x
+		 * position, y position, z position) are searched for. If the
+		 * file cannot be successfully read, then the routine causes a
+		 * fatal error.
+		 * \param[in] filename the name of the file to open and read
+		 *                     from. */
+		inline void import(const char* filename) {
+			FILE *fp=safe_fopen(filename,"r");
+			import(fp);
+			fclose(fp);
+		}
+		bool point_inside(double x,double y,double z);
+		/** Returns the total number of stored particles, which is
+		 * held in the root node of the octree.
+		 * \return The number of particles. */
+		inline int total_particles() {return nd->n;}
+		/** Returns the number of leaves in the octree that hold
+		 * particles.
+		 * \return The number of occupied leaves. */
+		inline int occupied_blocks() {
+			int ob=0;
+			for(int *cop=co;cop<co+nxyz;cop++) if(*cop>0) ob++;
+			return ob;
+		}
+		void compute_cells(block_scheduler &bs);
+		void compute_all_cells();
+		double sum_cell_volumes();
+		double sum_cell_volumes(block_scheduler &bs);
+		/** Dumps particle IDs and positions to a file.
+		 * \param[in] vl the loop class to use.
+		 * \param[in] fp a file handle to write to. */
+		template<class c_loop>
+		void draw_particles(c_loop &vl,FILE *fp) {
+			particle_real *pp;
+			if(vl.start()) do {
+				pp=p[vl.ijk]+3*vl.q;
+				fprintf(fp,"%d %g %g %g\n",id[vl.ijk][vl.q],*pp,pp[1],pp[2]);
+			} while(vl.inc());
+		}
+		/** Dumps all of the particle IDs and positions to a file.
+		 * \param[in] fp a file handle to write to. */
+		inline void draw_particles(FILE *fp=stdout) {
+			c_loop_all vl(*this);
+			draw_particles(vl,fp);
+		}
+		/** Dumps all of the particle IDs and positions to a file.
+		 * \param[in] filename the name of the file to write to. */
+		inline void draw_particles(const char *filename) {
+			FILE *fp=safe_fopen(filename,"w");
+			draw_particles(fp);
+			fclose(fp);
+		}
+		/** Computes the Voronoi cells and saves customized information
+		 * about them. The particles visited by the loop are shared
+		 * among the available threads using a block_scheduler class.
+		 * \param[in] vl the loop class to use.
+		 * \param[in] format the custom output string to use.
+		 * \param[in] fp a file handle to write to. */
+		template<class c_loop>
+		void print_custom(c_loop &vl,const char *format,FILE *fp) {
+			block_scheduler bs(vl);
+			print_custom(bs,format,fp);
+		}
+		void print_custom(block_scheduler &bs,const char *format,FILE *fp=stdout);
+		void print_custom(const char *format,FILE *fp=stdout);
+		void print_custom(const char *format,const char *filename);
+		bool find_voronoi_cell(double x,double y,double z,double &rx,double &ry,double &rz,int &pid);
+		/** Computes the Voronoi cell for a particle currently being
+		 * referenced by a loop class.
+		 * \param[out] c a Voronoi cell class in which to store the
+		 * 		 computed cell.
+		 * \param[in] vl the loop class to use.
+		 * \return True if the cell was computed. If the cell cannot be
+		 * computed, if it is removed entirely by a wall or boundary
+		 * condition, then the routine returns false. */
+		template<class v_cell,class c_loop>
+		inline bool compute_cell(v_cell &c,c_loop &vl) {
+			return oc.compute_cell(c,vl.ijk,vl.q);
+		}
+		/** Computes the Voronoi cell for given particle.
+		 * \param[out] c a Voronoi cell class in which to store the
+		 * 		 computed cell.
+		 * \param[in] ijk the block that the particle is within.
+		 * \param[in] q the index of the particle within the block.
+		 * \return True if the cell was computed. If the cell cannot be
+		 * computed, if it is removed entirely by a wall or boundary
+		 * condition, then the routine returns false. */
+		template<class v_cell>
+		inline bool compute_cell(v_cell &c,int ijk,int q) {
+			return oc.compute_cell(c,ijk,q);
+		}
+	private:
+		/** The current memory allocation for the blocks. */
+		int bmem;
+		/** The current memory allocation for the octree nodes. */
+		int nmem;
+		octree_compute oc;
+		void init_root();
+		int new_block();
+		void split(int o);
+		void add_block_memory();
+		void add_node_memory();
+		void add_particle_memory(int i);
+};
+
+/** Adds a node to the priority queue.
+ * \param[in] d the minimum squared distance of the node.
+ * \param[in] i the index of the node. */
+inline void octree_compute::push(double d,int i) {
+	int k,pk;
+	if(hn==hmem) add_heap_memory();
+	for(k=hn++;k>0;k=pk) {
+		pk=(k-1)>>1;
+		if(hd[pk]<=d) break;
+		hd[k]=hd[pk];hi[k]=hi[pk];
+	}
+	hd[k]=d;hi[k]=i;
+}
+
+/** Removes the node with the smallest minimum squared distance from the
+ * priority queue. */
+inline void octree_compute::pop() {
+	int k=0,ck,i=hi[--hn];
+	double d=hd[hn];
+	while((ck=2*k+1)<hn) {
+		if(ck+1<hn&&hd[ck+1]<hd[ck]) ck++;
+		if(d<=hd[ck]) break;
+		hd[k]=hd[ck];hi[k]=hi[ck];k=ck;
+	}
+	hd[k]=d;hi[k]=i;
+}
+
+/** Cuts a Voronoi cell by the planes of all the particles in a leaf of the
+ * octree. The planes are taken in batches, and each batch is first tested in
+ * bulk against the vertices of the cell, in the same way as in the
+ * voro_compute::cut_block routine.
+ * \param[in,out] c a reference to a Voronoi cell.
+ * \param[in] l the block of the leaf.
+ * \param[in] s the index of the particle being computed within the block, or
+ *              -1 if the particle is not in this block.
+ * \param[in] (x,y,z) the position of the particle being computed.
+ * \param[in,out] mrs the maximum radius squared of the cell, which is
+ *                     recomputed if any of the planes reached the cell.
+ * \return False if the cell was completely removed during the computation,
+ *         true otherwise. */
+template<class v_cell>
+inline bool octree_compute::cut_leaf(v_cell &c,int l,int s,double x,double y,double z,double &mrs) {
+	int q,lb,le,n=con.co[l];
+	bool cut=false;
+	particle_real *pp=con.p[l];
+	if(n>bmem) add_block_memory(n);
+	for(q=0;q<n;q++,pp+=3) {
+		bvx[q]=*pp-x;bvy[q]=pp[1]-y;bvz[q]=pp[2]-z;
+		bvr[q]=bvx[q]*bvx[q]+bvy[q]*bvy[q]+bvz[q]*bvz[q];
+	}
+	if(s>=0) bvr[s]=large_number;
+	for(lb=0;lb<n;lb=le) {
+		le=lb+plane_batch_size;if(le>n) le=n;
+		c.plane_bounds(le-lb,bvx+lb,bvy+lb,bvz+lb,bvm+lb);
+		for(q=lb;q<le;q++) if(bvm[q]-bvr[q]>-c.big_tol) {
+			if(!c.nplane(bvx[q],bvy[q],bvz[q],bvr[q],con.id[l][q])) return false;
+			cut=true;
+		}
+	}
+	if(cut) mrs=c.max_radius_squared();
+	return true;
+}
+
+/** Computes the Voronoi cell of a particle. The cell is initialized to fill
+ * the container and cut by any walls, and the nodes of the octree are then
+ * visited in order of increasing distance from the particle. Whenever a leaf
+ * cuts the cell, the maximum radius squared of the cell is recomputed, and any
+ * node that is further away than this is discarded.
+ * \param[in,out] c a reference to a Voronoi cell.
+ * \param[in] ijk the block that the particle is within.
+ * \param[in] s the index of the particle within the block.
+ * \return False if the cell was completely removed during the computation,
+ *         true otherwise. */
+template<class v_cell>
+bool octree_compute::compute_cell(v_cell &c,int ijk,int s) {
+	particle_real *pp=con.p[ijk]+3*s;
+	double x=*pp,y=pp[1],z=pp[2],mrs,d;
+	int i,e,l;
+	c.init(con.ax-x,con.bx-x,con.ay-y,con.by-y,con.az-z,con.bz-z);
+	if(!con.apply_walls(c,x,y,z)) return false;
+
+	// Test the particle's own leaf first, and then search the octree
+	// starting from the root
+	mrs=c.max_radius_squared();
+	if(!cut_leaf(c,ijk,s,x,y,z,mrs)) return false;
+	hn=0;push(0,0);
+	while(hn>0) {
+		d=*hd;i=*hi;pop();
+		if(d>mrs) break;
+		const octree_node &o=con.nd[i];
+		if(o.c>=0) {
+			for(e=o.c+8,i=o.c;i<e;i++) if(con.nd[i].n>0) {
+				d=con.nd[i].min_dist_sq(x,y,z);
+				if(d<mrs) push(d,i);
+			}
+		} else if((l=o.l)!=ijk&&!cut_leaf(c,l,-1,x,y,z,mrs)) return false;
+	}
+	return true;
+}
+
+}
+
+#endif
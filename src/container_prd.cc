@@ -9,6 +9,7 @@
  * related classes. */
 
 #include "container_prd.hh"
+#include "c_drive.hh"
 
 namespace voro {
 
@@ -31,8 +32,9 @@ container_periodic_base::container_periodic_base(double bx_,double bxy_,double b
 	: unitcell(bx_,bxy_,by_,bxz_,byz_,bz_),
 	voro_base(nx_,ny_,nz_,bx_/nx_,by_/ny_,bz_/nz_), max_len_sq(unit_voro.max_radius_squared()),
 	ey(int(max_uv_y*ysp+1)), ez(int(max_uv_z*zsp+1)), wy(ny+ey), wz(nz+ez),
-	oy(ny+2*ey), oz(nz+2*ez), oxyz(nx*oy*oz), id(new int*[oxyz]), p(new double*[oxyz]),
-	co(new int[oxyz]), mem(new int[oxyz]), img(new char[oxyz]), init_mem(init_mem_), ps(ps_) {
+	oy(ny+2*ey), oz(nz+2*ez), oxyz(nx*oy*oz), id(new int*[oxyz]), p(new particle_real*[oxyz]),
+	co(new int[oxyz]), mem(new int[oxyz]), img(new char[oxyz]), init_mem(init_mem_), ps(ps_),
+	pool(max_len_sq), img_stale(false) {
 	int i,j,k,l;
 
 	// Clear the global arrays
@@ -45,7 +47,7 @@ container_periodic_base::container_periodic_base(double bx_,double bxy_,double b
 		l=i+nx*(j+oy*k);
 		mem[l]=init_mem;
 		id[l]=new int[init_mem];
-		p[l]=new double[ps*init_mem];
+		p[l]=new particle_real[ps*init_mem];
 	}
 }
 
@@ -96,7 +98,8 @@ void container_periodic::put(int n,double x,double y,double z) {
 	put_locate_block(ijk,x,y,z);
 	for(int l=0;l<co[ijk];l++) check_duplicate(n,x,y,z,id[ijk][l],p[ijk]+3*l);
 	id[ijk][co[ijk]]=n;
-	double *pp=p[ijk]+3*co[ijk]++;
+	pix.current=false;
+	particle_real *pp=p[ijk]+3*co[ijk]++;
 	*(pp++)=x;*(pp++)=y;*pp=z;
 }
 
@@ -109,9 +112,10 @@ void container_periodic_poly::put(int n,double x,double y,double z,double r) {
 	put_locate_block(ijk,x,y,z);
 	for(int l=0;l<co[ijk];l++) check_duplicate(n,x,y,z,id[ijk][l],p[ijk]+4*l);
 	id[ijk][co[ijk]]=n;
-	double *pp=p[ijk]+4*co[ijk]++;
+	pix.current=false;
+	particle_real *pp=p[ijk]+4*co[ijk]++;
 	*(pp++)=x;*(pp++)=y;*(pp++)=z;*pp=r;
-	if(max_radius<r) max_radius=r;
+	if(max_radius<*pp) max_radius=*pp;
 }
 
 /** Put a particle into the correct region of the container.
@@ -125,7 +129,8 @@ void container_periodic::put(int n,double x,double y,double z,int &ai,int &aj,in
 	put_locate_block(ijk,x,y,z,ai,aj,ak);
 	for(int l=0;l<co[ijk];l++) check_duplicate(n,x,y,z,id[ijk][l],p[ijk]+3*l);
 	id[ijk][co[ijk]]=n;
-	double *pp=p[ijk]+3*co[ijk]++;
+	pix.current=false;
+	particle_real *pp=p[ijk]+3*co[ijk]++;
 	*(pp++)=x;*(pp++)=y;*pp=z;
 }
 
@@ -142,9 +147,10 @@ void container_periodic_poly::put(int n,double x,double y,double z,double r,int
 	for(int l=0;l<co[ijk];l++) check_duplicate(n,x,y,z,id[ijk][l],p[ijk]+4*l);
 
 	id[ijk][co[ijk]]=n;
-	double *pp=p[ijk]+4*co[ijk]++;
+	pix.current=false;
+	particle_real *pp=p[ijk]+4*co[ijk]++;
 	*(pp++)=x;*(pp++)=y;*(pp++)=z;*pp=r;
-	if(max_radius<r) max_radius=r;
+	if(max_radius<*pp) max_radius=*pp;
 }
 
 /** Put a particle into the correct region of the container, also recording
@@ -156,8 +162,9 @@ void container_periodic::put(particle_order &vo,int n,double x,double y,double z
 	int ijk;
 	put_locate_block(ijk,x,y,z);
 	id[ijk][co[ijk]]=n;
+	pix.current=false;
 	vo.add(ijk,co[ijk]);
-	double *pp=p[ijk]+3*co[ijk]++;
+	particle_real *pp=p[ijk]+3*co[ijk]++;
 	*(pp++)=x;*(pp++)=y;*pp=z;
 }
 
@@ -171,10 +178,11 @@ void container_periodic_poly::put(particle_order &vo,int n,double x,double y,dou
 	int ijk;
 	put_locate_block(ijk,x,y,z);
 	id[ijk][co[ijk]]=n;
+	pix.current=false;
 	vo.add(ijk,co[ijk]);
-	double *pp=p[ijk]+4*co[ijk]++;
+	particle_real *pp=p[ijk]+4*co[ijk]++;
 	*(pp++)=x;*(pp++)=y;*(pp++)=z;*pp=r;
-	if(max_radius<r) max_radius=r;
+	if(max_radius<*pp) max_radius=*pp;
 }
 
 /** Takes a particle position vector and computes the region index into which
@@ -213,6 +221,7 @@ void container_periodic_base::put_locate_block(int &ijk,double &x,double &y,doub
 	j+=ey;k+=ez;
 	ijk+=nx*(j+oy*k);
 	if(co[ijk]==mem[ijk]) add_particle_memory(ijk);
+	psoa.modify(ijk);
 }
 
 /** Takes a particle position vector and computes the region index into which
@@ -253,6 +262,7 @@ void container_periodic_base::put_locate_block(int &ijk,double &x,double &y,doub
 	j+=ey;k+=ez;
 	ijk+=nx*(j+oy*k);
 	if(co[ijk]==mem[ijk]) add_particle_memory(ijk);
+	psoa.modify(ijk);
 }
 
 /** Takes a position vector and remaps it into the primary domain.
@@ -366,7 +376,7 @@ void container_periodic_base::add_particle_memory(int i) {
 	if(mem[i]==0) {
 		mem[i]=init_mem;
 		id[i]=new int[init_mem];
-		p[i]=new double[ps*init_mem];
+		p[i]=new particle_real[ps*init_mem];
 		return;
 	}
 
@@ -383,7 +393,7 @@ void container_periodic_base::add_particle_memory(int i) {
 	// Allocate new memory and copy in the contents of the old arrays
 	int *idp=new int[nmem];
 	for(l=0;l<co[i];l++) idp[l]=id[i][l];
-	double *pp=new double[ps*nmem];
+	particle_real *pp=new particle_real[ps*nmem];
 	for(l=0;l<ps*co[i];l++) pp[l]=p[i][l];
 
 	// Update pointers and delete old arrays
@@ -392,16 +402,45 @@ void container_periodic_base::add_particle_memory(int i) {
 	delete [] p[i];p[i]=pp;
 }
 
+/** Imports particles from a file in the binary particle format described in
+ * p_file.hh. The file is mapped into memory and the particles are put into the
+ * container directly from it, without parsing. Any radii in the file are
+ * ignored. If the box stored in the file does not match the container, then
+ * the routine causes a fatal error.
+ * \param[in] filename the name of the file to read. */
+void container_periodic::import_binary(const char *filename) {
+	particle_file pf(filename);
+	double box[6]={bx,bxy,by,bxz,byz,bz};
+	pf.check_box(pf_xperiodic|pf_yperiodic|pf_zperiodic|pf_triclinic,box);
+	const double *pp=pf.p;
+	for(int l=0;l<pf.n;l++,pp+=pf.ps) put(pf.id[l],*pp,pp[1],pp[2]);
+}
+
+/** Imports particles from a file in the binary particle format described in
+ * p_file.hh. The file is mapped into memory and the particles are put into the
+ * container directly from it, without parsing. If the file does not contain
+ * radii, or if the box stored in the file does not match the container, then
+ * the routine causes a fatal error.
+ * \param[in] filename the name of the file to read. */
+void container_periodic_poly::import_binary(const char *filename) {
+	particle_file pf(filename);
+	if(!pf.radii()) voro_fatal_error("Binary particle file does not contain radii",VOROPP_FILE_ERROR);
+	double box[6]={bx,bxy,by,bxz,byz,bz};
+	pf.check_box(pf_xperiodic|pf_yperiodic|pf_zperiodic|pf_triclinic,box);
+	const double *pp=pf.p;
+	for(int l=0;l<pf.n;l++,pp+=4) put(pf.id[l],*pp,pp[1],pp[2],pp[3]);
+}
+
 /** Import a list of particles from an open file stream into the container.
  * Entries of four numbers (Particle ID, x position, y position, z position)
- * are searched for. If the file cannot be successfully read, then the routine
- * causes a fatal error.
+ * are searched for. The file is parsed in parallel using the particle_text
+ * class. If the file cannot be successfully read, then the routine causes a
+ * fatal error.
  * \param[in] fp the file handle to read from. */
 void container_periodic::import(FILE *fp) {
-	int i,j;
-	double x,y,z;
-	while((j=fscanf(fp,"%d %lg %lg %lg",&i,&x,&y,&z))==4) put(i,x,y,z);
-	if(j!=EOF) voro_fatal_error("File import error",VOROPP_FILE_ERROR);
+	particle_text pt(fp,3);
+	double *pp=pt.p;
+	for(int l=0;l<pt.n;l++,pp+=3) put(pt.id[l],*pp,pp[1],pp[2]);
 }
 
 /** Import a list of particles from an open file stream, also storing the order
@@ -411,22 +450,21 @@ void container_periodic::import(FILE *fp) {
  * \param[in,out] vo a reference to an ordering class to use.
  * \param[in] fp the file handle to read from. */
 void container_periodic::import(particle_order &vo,FILE *fp) {
-	int i,j;
-	double x,y,z;
-	while((j=fscanf(fp,"%d %lg %lg %lg",&i,&x,&y,&z))==4) put(vo,i,x,y,z);
-	if(j!=EOF) voro_fatal_error("File import error",VOROPP_FILE_ERROR);
+	particle_text pt(fp,3);
+	double *pp=pt.p;
+	for(int l=0;l<pt.n;l++,pp+=3) put(vo,pt.id[l],*pp,pp[1],pp[2]);
 }
 
 /** Import a list of particles from an open file stream into the container.
  * Entries of five numbers (Particle ID, x position, y position, z position,
- * radius) are searched for. If the file cannot be successfully read, then the
+ * radius) are searched for. The file is parsed in parallel using the
+ * particle_text class. If the file cannot be successfully read, then the
  * routine causes a fatal error.
  * \param[in] fp the file handle to read from. */
 void container_periodic_poly::import(FILE *fp) {
-	int i,j;
-	double x,y,z,r;
-	while((j=fscanf(fp,"%d %lg %lg %lg %lg",&i,&x,&y,&z,&r))==5) put(i,x,y,z,r);
-	if(j!=EOF) voro_fatal_error("File import error",VOROPP_FILE_ERROR);
+	particle_text pt(fp,4);
+	double *pp=pt.p;
+	for(int l=0;l<pt.n;l++,pp+=4) put(pt.id[l],*pp,pp[1],pp[2],pp[3]);
 }
 
 /** Import a list of particles from an open file stream, also storing the order
@@ -436,10 +474,9 @@ void container_periodic_poly::import(FILE *fp) {
  * \param[in,out] vo a reference to an ordering class to use.
  * \param[in] fp the file handle to read from. */
 void container_periodic_poly::import(particle_order &vo,FILE *fp) {
-	int i,j;
-	double x,y,z,r;
-	while((j=fscanf(fp,"%d %lg %lg %lg %lg",&i,&x,&y,&z,&r))==5) put(vo,i,x,y,z,r);
-	if(j!=EOF) voro_fatal_error("File import error",VOROPP_FILE_ERROR);
+	particle_text pt(fp,4);
+	double *pp=pt.p;
+	for(int l=0;l<pt.n;l++,pp+=4) put(vo,pt.id[l],*pp,pp[1],pp[2],pp[3]);
 }
 
 /** Outputs the a list of all the container regions along with the number of
@@ -453,15 +490,31 @@ void container_periodic_base::region_count() {
 /** Clears a container of particles. */
 void container_periodic::clear() {
 	for(int *cop=co;cop<co+nxyz;cop++) *cop=0;
+	clear_soa();
 }
 
 /** Clears a container of particles, also clearing resetting the maximum radius
  * to zero. */
 void container_periodic_poly::clear() {
 	for(int *cop=co;cop<co+nxyz;cop++) *cop=0;
+	clear_soa();
 	max_radius=0;
 }
 
+/** Computes the Voronoi cells for the particles in a scheduler and saves
+ * customized information about them. Since the threads cannot safely create
+ * periodic images on demand, all of the images are created beforehand.
+ * \param[in] bs the scheduler to use.
+ * \param[in] format the custom output string to use.
+ * \param[in] fp a file handle to write to. */
+void container_periodic::print_custom(block_scheduler &bs,const char *format,FILE *fp) {
+	drive_custom f(bs,format,fp);
+	create_all_images();
+	if(contains_neighbor(format)) drive_cells<voronoicell_neighbor,voro_compute<container_periodic> >(*this,bs,f);
+	else drive_cells<voronoicell,voro_compute<container_periodic> >(*this,bs,f);
+	f.finish();
+}
+
 /** Computes all the Voronoi cells and saves customized information about them.
  * \param[in] format the custom output string to use.
  * \param[in] fp a file handle to write to. */
@@ -470,8 +523,21 @@ void container_periodic::print_custom(const char *format,FILE *fp) {
 	print_custom(vl,format,fp);
 }
 
-/** Computes all the Voronoi cells and saves customized
- * information about them.
+/** Computes the Voronoi cells for the particles in a scheduler and saves
+ * customized information about them. Since the threads cannot safely create
+ * periodic images on demand, all of the images are created beforehand.
+ * \param[in] bs the scheduler to use.
+ * \param[in] format the custom output string to use.
+ * \param[in] fp a file handle to write to. */
+void container_periodic_poly::print_custom(block_scheduler &bs,const char *format,FILE *fp) {
+	drive_custom f(bs,format,fp);
+	create_all_images();
+	if(contains_neighbor(format)) drive_cells<voronoicell_neighbor,voro_compute<container_periodic_poly> >(*this,bs,f);
+	else drive_cells<voronoicell,voro_compute<container_periodic_poly> >(*this,bs,f);
+	f.finish();
+}
+
+/** Computes all the Voronoi cells and saves customized information about them.
  * \param[in] format the custom output string to use.
  * \param[in] fp a file handle to write to. */
 void container_periodic_poly::print_custom(const char *format,FILE *fp) {
@@ -488,6 +554,40 @@ void container_periodic::print_custom(const char *format,const char *filename) {
 	fclose(fp);
 }
 
+/** Computes the Voronoi cells for the particles in a scheduler and saves
+ * customized information about them in the columnar binary format. Since the
+ * threads cannot safely create periodic images on demand, all of the images
+ * are created beforehand.
+ * \param[in] bs the scheduler to use.
+ * \param[in] format the custom output string to use.
+ * \param[in] fp a file handle to write to. */
+void container_periodic::print_custom_binary(block_scheduler &bs,const char *format,FILE *fp) {
+	drive_columns f(bs,format,fp);
+	create_all_images();
+	if(contains_neighbor(format)) drive_cells<voronoicell_neighbor,voro_compute<container_periodic> >(*this,bs,f);
+	else drive_cells<voronoicell,voro_compute<container_periodic> >(*this,bs,f);
+	f.finish();
+}
+
+/** Computes all the Voronoi cells and saves customized information about them
+ * in the columnar binary format.
+ * \param[in] format the custom output string to use.
+ * \param[in] fp a file handle to write to. */
+void container_periodic::print_custom_binary(const char *format,FILE *fp) {
+	c_loop_all_periodic vl(*this);
+	print_custom_binary(vl,format,fp);
+}
+
+/** Computes all the Voronoi cells and saves customized information about them
+ * in the columnar binary format.
+ * \param[in] format the custom output string to use.
+ * \param[in] filename the name of the file to write to. */
+void container_periodic::print_custom_binary(const char *format,const char *filename) {
+	FILE *fp=safe_fopen(filename,"wb");
+	print_custom_binary(format,fp);
+	fclose(fp);
+}
+
 /** Computes all the Voronoi cells and saves customized
  * information about them
  * \param[in] format the custom output string to use.
@@ -498,15 +598,224 @@ void container_periodic_poly::print_custom(const char *format,const char *filena
 	fclose(fp);
 }
 
+/** Computes the Voronoi cells for the particles in a scheduler and saves
+ * customized information about them in the columnar binary format. Since the
+ * threads cannot safely create periodic images on demand, all of the images
+ * are created beforehand.
+ * \param[in] bs the scheduler to use.
+ * \param[in] format the custom output string to use.
+ * \param[in] fp a file handle to write to. */
+void container_periodic_poly::print_custom_binary(block_scheduler &bs,const char *format,FILE *fp) {
+	drive_columns f(bs,format,fp);
+	create_all_images();
+	if(contains_neighbor(format)) drive_cells<voronoicell_neighbor,voro_compute<container_periodic_poly> >(*this,bs,f);
+	else drive_cells<voronoicell,voro_compute<container_periodic_poly> >(*this,bs,f);
+	f.finish();
+}
+
+/** Computes all the Voronoi cells and saves customized information about them
+ * in the columnar binary format.
+ * \param[in] format the custom output string to use.
+ * \param[in] fp a file handle to write to. */
+void container_periodic_poly::print_custom_binary(const char *format,FILE *fp) {
+	c_loop_all_periodic vl(*this);
+	print_custom_binary(vl,format,fp);
+}
+
+/** Computes all the Voronoi cells and saves customized information about them
+ * in the columnar binary format.
+ * \param[in] format the custom output string to use.
+ * \param[in] filename the name of the file to write to. */
+void container_periodic_poly::print_custom_binary(const char *format,const char *filename) {
+	FILE *fp=safe_fopen(filename,"wb");
+	print_custom_binary(format,fp);
+	fclose(fp);
+}
+
+/** Computes the Voronoi cells for the particles in a scheduler and stores
+ * their neighbor graph. The neighbors recorded for each chunk are combined in
+ * order, so that the graph does not depend on the number of threads.
+ * \param[in] bs the scheduler to use.
+ * \param[out] ng the neighbor graph to fill in. */
+void container_periodic::compute_neighbor_graph(block_scheduler &bs,neighbor_graph &ng) {
+	drive_graph f(bs,ng);
+	create_all_images();
+	drive_cells<voronoicell_neighbor,voro_compute<container_periodic> >(*this,bs,f);
+	ng.assemble();
+}
+
+/** Computes all of the Voronoi cells and stores their neighbor graph.
+ * \param[out] ng the neighbor graph to fill in. */
+void container_periodic::compute_neighbor_graph(neighbor_graph &ng) {
+	c_loop_all_periodic vl(*this);
+	compute_neighbor_graph(vl,ng);
+}
+
+/** Computes the Voronoi cells for the particles in a scheduler and stores
+ * their neighbor graph. The neighbors recorded for each chunk are combined in
+ * order, so that the graph does not depend on the number of threads.
+ * \param[in] bs the scheduler to use.
+ * \param[out] ng the neighbor graph to fill in. */
+void container_periodic_poly::compute_neighbor_graph(block_scheduler &bs,neighbor_graph &ng) {
+	drive_graph f(bs,ng);
+	create_all_images();
+	drive_cells<voronoicell_neighbor,voro_compute<container_periodic_poly> >(*this,bs,f);
+	ng.assemble();
+}
+
+/** Computes all of the Voronoi cells and stores their neighbor graph.
+ * \param[out] ng the neighbor graph to fill in. */
+void container_periodic_poly::compute_neighbor_graph(neighbor_graph &ng) {
+	c_loop_all_periodic vl(*this);
+	compute_neighbor_graph(vl,ng);
+}
+
+/** Computes the Voronoi cells for the particles in a scheduler and stores each
+ * of their faces once. The faces recorded for each chunk are combined in
+ * order, so that the numbering does not depend on the number of threads.
+ * \param[in] bs the scheduler to use.
+ * \param[out] fm the face mesh to fill in. */
+void container_periodic::compute_face_mesh(block_scheduler &bs,face_mesh &fm) {
+	drive_mesh f(bs,fm,mesh_tolerance*sqrt(max_len_sq));
+	create_all_images();
+	drive_cells<voronoicell_neighbor,voro_compute<container_periodic> >(*this,bs,f);
+	fm.assemble();
+}
+
+/** Computes all of the Voronoi cells and stores each of their faces once.
+ * \param[out] fm the face mesh to fill in. */
+void container_periodic::compute_face_mesh(face_mesh &fm) {
+	c_loop_all_periodic vl(*this);
+	compute_face_mesh(vl,fm);
+}
+
+/** Computes the Voronoi cells for the particles in a scheduler and stores the
+ * finite volume Laplacian of the tessellation. The faces recorded for each
+ * chunk are combined in order, so that the matrix does not depend on the
+ * number of threads.
+ * \param[in] bs the scheduler to use.
+ * \param[out] fl the matrix to fill in. */
+void container_periodic::compute_laplacian(block_scheduler &bs,fv_laplacian &fl) {
+	drive_laplacian f(bs,fl);
+	create_all_images();
+	drive_cells<voronoicell_neighbor,voro_compute<container_periodic> >(*this,bs,f);
+	fl.assemble();
+}
+
+/** Computes all of the Voronoi cells and stores the finite volume Laplacian of
+ * the tessellation.
+ * \param[out] fl the matrix to fill in. */
+void container_periodic::compute_laplacian(fv_laplacian &fl) {
+	c_loop_all_periodic vl(*this);
+	compute_laplacian(vl,fl);
+}
+
+/** Computes the Voronoi cells for the particles in a scheduler and stores them
+ * in a tessellation. The cells recorded for each chunk are then copied into
+ * place.
+ * \param[in] bs the scheduler to use.
+ * \param[out] ts the tessellation to fill in. */
+void container_periodic::compute_tessellation(block_scheduler &bs,tessellation &ts) {
+	drive_tessellation f(bs,ts);
+	create_all_images();
+	drive_cells<voronoicell_neighbor,voro_compute<container_periodic> >(*this,bs,f);
+	ts.assemble();
+}
+
+/** Computes all of the Voronoi cells and stores them in a tessellation.
+ * \param[out] ts the tessellation to fill in. */
+void container_periodic::compute_tessellation(tessellation &ts) {
+	c_loop_all_periodic vl(*this);
+	compute_tessellation(vl,ts);
+}
+
+/** Computes the Voronoi cells for the particles in a scheduler and stores each
+ * of their faces once. The faces recorded for each chunk are combined in
+ * order, so that the numbering does not depend on the number of threads.
+ * \param[in] bs the scheduler to use.
+ * \param[out] fm the face mesh to fill in. */
+void container_periodic_poly::compute_face_mesh(block_scheduler &bs,face_mesh &fm) {
+	drive_mesh f(bs,fm,mesh_tolerance*sqrt(max_len_sq));
+	create_all_images();
+	drive_cells<voronoicell_neighbor,voro_compute<container_periodic_poly> >(*this,bs,f);
+	fm.assemble();
+}
+
+/** Computes all of the Voronoi cells and stores each of their faces once.
+ * \param[out] fm the face mesh to fill in. */
+void container_periodic_poly::compute_face_mesh(face_mesh &fm) {
+	c_loop_all_periodic vl(*this);
+	compute_face_mesh(vl,fm);
+}
+
+/** Computes the Voronoi cells for the particles in a scheduler and stores the
+ * finite volume Laplacian of the tessellation. The faces recorded for each
+ * chunk are combined in order, so that the matrix does not depend on the
+ * number of threads.
+ * \param[in] bs the scheduler to use.
+ * \param[out] fl the matrix to fill in. */
+void container_periodic_poly::compute_laplacian(block_scheduler &bs,fv_laplacian &fl) {
+	drive_laplacian f(bs,fl);
+	create_all_images();
+	drive_cells<voronoicell_neighbor,voro_compute<container_periodic_poly> >(*this,bs,f);
+	fl.assemble();
+}
+
+/** Computes all of the Voronoi cells and stores the finite volume Laplacian of
+ * the tessellation.
+ * \param[out] fl the matrix to fill in. */
+void container_periodic_poly::compute_laplacian(fv_laplacian &fl) {
+	c_loop_all_periodic vl(*this);
+	compute_laplacian(vl,fl);
+}
+
+/** Computes the Voronoi cells for the particles in a scheduler and stores them
+ * in a tessellation. The cells recorded for each chunk are then copied into
+ * place.
+ * \param[in] bs the scheduler to use.
+ * \param[out] ts the tessellation to fill in. */
+void container_periodic_poly::compute_tessellation(block_scheduler &bs,tessellation &ts) {
+	drive_tessellation f(bs,ts);
+	create_all_images();
+	drive_cells<voronoicell_neighbor,voro_compute<container_periodic_poly> >(*this,bs,f);
+	ts.assemble();
+}
+
+/** Computes all of the Voronoi cells and stores them in a tessellation.
+ * \param[out] ts the tessellation to fill in. */
+void container_periodic_poly::compute_tessellation(tessellation &ts) {
+	c_loop_all_periodic vl(*this);
+	compute_tessellation(vl,ts);
+}
+
+/** Computes the Voronoi cells for the particles in a scheduler, but does
+ * nothing with the output. Since the threads cannot safely create periodic
+ * images on demand, all of the images are created beforehand.
+ * \param[in] bs the scheduler to use. */
+void container_periodic::compute_cells(block_scheduler &bs) {
+	drive_none f;
+	create_all_images();
+	drive_cells<voronoicell,voro_compute<container_periodic> >(*this,bs,f);
+}
+
 /** Computes all of the Voronoi cells in the container, but does nothing
  * with the output. It is useful for measuring the pure computation time
  * of the Voronoi algorithm, without any additional calculations such as
  * volume evaluation or cell output. */
 void container_periodic::compute_all_cells() {
-	voronoicell c(*this);
 	c_loop_all_periodic vl(*this);
-	if(vl.start()) do compute_cell(c,vl);
-	while(vl.inc());
+	block_scheduler bs(vl);
+	compute_cells(bs);
+}
+
+/** Computes the Voronoi cells for the particles in a scheduler, but does
+ * nothing with the output. Since the threads cannot safely create periodic
+ * images on demand, all of the images are created beforehand.
+ * \param[in] bs the scheduler to use. */
+void container_periodic_poly::compute_cells(block_scheduler &bs) {
+	drive_none f;
+	create_all_images();
+	drive_cells<voronoicell,voro_compute<container_periodic_poly> >(*this,bs,f);
 }
 
 /** Computes all of the Voronoi cells in the container, but does nothing
@@ -514,9 +823,22 @@ void container_periodic::compute_all_cells() {
  * of the Voronoi algorithm, without any additional calculations such as
  * volume evaluation or cell output. */
 void container_periodic_poly::compute_all_cells() {
-	voronoicell c(*this);
 	c_loop_all_periodic vl(*this);
-	if(vl.start()) do compute_cell(c,vl);while(vl.inc());
+	block_scheduler bs(vl);
+	compute_cells(bs);
+}
+
+/** Calculates the Voronoi cells for the particles in a scheduler and sums
+ * their volumes. The volumes are summed for each chunk, and these are then
+ * added in order, so that the result does not depend on the number of
+ * threads.
+ * \param[in] bs the scheduler to use.
+ * \return The sum of all of the computed Voronoi volumes. */
+double container_periodic::sum_cell_volumes(block_scheduler &bs) {
+	drive_volume f(bs);
+	create_all_images();
+	drive_cells<voronoicell,voro_compute<container_periodic> >(*this,bs,f);
+	return f.sum();
 }
 
 /** Calculates all of the Voronoi cells and sums their volumes. In most cases
@@ -524,11 +846,22 @@ void container_periodic_poly::compute_all_cells() {
  * of the container to numerical precision.
  * \return The sum of all of the computed Voronoi volumes. */
 double container_periodic::sum_cell_volumes() {
-	voronoicell c(*this);
-	double vol=0;
 	c_loop_all_periodic vl(*this);
-	if(vl.start()) do if(compute_cell(c,vl)) vol+=c.volume();while(vl.inc());
-	return vol;
+	block_scheduler bs(vl);
+	return sum_cell_volumes(bs);
+}
+
+/** Calculates the Voronoi cells for the particles in a scheduler and sums
+ * their volumes. The volumes are summed for each chunk, and these are then
+ * added in order, so that the result does not depend on the number of
+ * threads.
+ * \param[in] bs the scheduler to use.
+ * \return The sum of all of the computed Voronoi volumes. */
+double container_periodic_poly::sum_cell_volumes(block_scheduler &bs) {
+	drive_volume f(bs);
+	create_all_images();
+	drive_cells<voronoicell,voro_compute<container_periodic_poly> >(*this,bs,f);
+	return f.sum();
 }
 
 /** Calculates all of the Voronoi cells and sums their volumes. In most cases
@@ -536,16 +869,90 @@ double container_periodic::sum_cell_volumes() {
  * of the container to numerical precision.
  * \return The sum of all of the computed Voronoi volumes. */
 double container_periodic_poly::sum_cell_volumes() {
-	voronoicell c(*this);
-	double vol=0;
 	c_loop_all_periodic vl(*this);
-	if(vl.start()) do if(compute_cell(c,vl)) vol+=c.volume();while(vl.inc());
-	return vol;
+	block_scheduler bs(vl);
+	return sum_cell_volumes(bs);
+}
+
+/** Rebuilds the index from particle IDs to their storage locations by
+ * scanning the blocks of the primary domain, and marks it as up to date. This
+ * is called automatically by the move() and remove() routines when a particle
+ * is not found and particles have been added since the index was last built.
+ */
+void container_periodic_base::build_index() {
+	int i,j,k,l,q,t=0;
+	for(k=ez;k<wz;k++) for(j=ey;j<wy;j++) for(i=0,l=nx*(j+oy*k);i<nx;i++,l++) t+=co[l];
+	pix.reset(t);
+	for(k=ez;k<wz;k++) for(j=ey;j<wy;j++) for(i=0,l=nx*(j+oy*k);i<nx;i++,l++)
+		for(q=0;q<co[l];q++) pix.insert(id[l][q],l,q);
+	pix.current=true;
+}
+
+/** Moves a particle to a new position, which is remapped into the primary
+ * domain. If the new position is within the same block, then its coordinates
+ * are overwritten. Otherwise the particle is appended to its new block and
+ * taken out of its old block by moving the last particle of the old block into
+ * its place, so that the cost does not depend on the number of particles in
+ * the container. For the container_periodic_poly class, the particle keeps its
+ * radius. The periodic images are discarded, and are made again when they are
+ * next needed. Any particle_order class that refers to the particles of the
+ * affected blocks is not updated.
+ * \param[in] n the ID of the particle.
+ * \param[in] (x,y,z) the new position of the particle.
+ * \return True if the particle was moved, false if it was not in the
+ *         container. */
+bool container_periodic_base::move(int n,double x,double y,double z) {
+	int ijk,q,nijk;
+	if(!pix.locate(*this,n,ijk,q)) return false;
+	put_locate_block(nijk,x,y,z);
+	particle_real *pp;
+	if(nijk==ijk) pp=p[ijk]+ps*q;
+	else {
+		int r=co[nijk]++;
+		id[nijk][r]=n;
+		pp=p[nijk]+ps*r;
+		if(ps==4) pp[3]=p[ijk][ps*q+3];
+		pix.insert(n,nijk,r);
+		pix.take(*this,ijk,q);
+	}
+	*pp=x;pp[1]=y;pp[2]=z;
+	psoa.modify(ijk);
+	img_stale=true;
+	return true;
+}
+
+/** Removes a particle from the container, by moving the last particle of its
+ * block into its place. The periodic images are discarded, and are made again
+ * when they are next needed. Any particle_order class that refers to the
+ * particles of the affected block is not updated.
+ * \param[in] n the ID of the particle.
+ * \return True if the particle was removed, false if it was not in the
+ *         container. */
+bool container_periodic_base::remove(int n) {
+	int ijk,q;
+	if(!pix.locate(*this,n,ijk,q)) return false;
+	pix.erase(n);
+	pix.take(*this,ijk,q);
+	psoa.modify(ijk);
+	img_stale=true;
+	return true;
+}
+
+/** Discards all of the periodic images, by emptying the blocks outside the
+ * primary domain and clearing the record of which images have been made. */
+void container_periodic_base::reset_images() {
+	int i,j,k,l;
+	for(k=l=0;k<oz;k++) for(j=0;j<oy;j++) for(i=0;i<nx;i++,l++) {
+		if(j<ey||j>=wy||k<ez||k>=wz) {co[l]=0;psoa.modify(l);}
+		img[l]=0;
+	}
+	img_stale=false;
 }
 
-/** This routine creates all periodic images of the particles. It is meant for
- * diagnostic purposes only, since usually periodic images are dynamically
- * created in when they are referenced. */
+/** This routine creates all periodic images of the particles. Usually periodic
+ * images are dynamically created when they are referenced, but this is not
+ * safe when several threads are computing cells at once, so the routines that
+ * loop over all cells call this first. */
 void container_periodic_base::create_all_images() {
 	int i,j,k;
 	for(k=0;k<oz;k++) for(j=0;j<oy;j++) for(i=0;i<nx;i++) create_periodic_image(i,j,k);
@@ -555,7 +962,8 @@ void container_periodic_base::create_all_images() {
  * This is useful for diagnosing problems with periodic image computation. */
 void container_periodic_base::check_compartmentalized() {
 	int c,l,i,j,k;
-	double mix,miy,miz,max,may,maz,*pp;
+	double mix,miy,miz,max,may,maz;
+	particle_real *pp;
 	for(k=l=0;k<oz;k++) for(j=0;j<oy;j++) for(i=0;i<nx;i++,l++) if(mem[l]>0) {
 
 		// Compute the block's bounds, adding in a small tolerance
@@ -763,7 +1171,8 @@ void container_periodic_base::create_vertical_image(int di,int dj,int dk) {
  * \param[in] (dx,dy,dz) the displacement vector to add to the particle. */
 void container_periodic_base::put_image(int reg,int fijk,int l,double dx,double dy,double dz) {
 	if(co[reg]==mem[reg]) add_particle_memory(reg);
-	double *p1=p[reg]+ps*co[reg],*p2=p[fijk]+ps*l;
+	psoa.modify(reg);
+	particle_real *p1=p[reg]+ps*co[reg],*p2=p[fijk]+ps*l;
 	*(p1++)=*(p2++)+dx;
 	*(p1++)=*(p2++)+dy;
 	*p1=*p2+dz;
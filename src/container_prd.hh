@@ -17,7 +17,19 @@
 #include "common.hh"
 #include "v_base.hh"
 #include "cell.hh"
+#include "o_custom.hh"
+#include "o_columns.hh"
+#include "o_graph.hh"
+#include "o_mesh.hh"
+#include "o_laplace.hh"
+#include "o_tess.hh"
 #include "c_loops.hh"
+#include "c_sched.hh"
+#include "c_pool.hh"
+#include "p_soa.hh"
+#include "p_index.hh"
+#include "p_file.hh"
+#include "p_text.hh"
 #include "v_compute.hh"
 #include "unitcell.hh"
 #include "rad_option.hh"
@@ -69,7 +81,7 @@ class container_periodic_base : public unitcell, public voro_base {
 		/** A two dimensional array holding particle positions. For the
 		 * derived container_poly class, this also holds particle
 		 * radii. */
-		double **p;
+		particle_real **p;
 		/** This array holds the number of particles within each
 		 * computational box of the container. */
 		int *co;
@@ -92,6 +104,16 @@ class container_periodic_base : public unitcell, public voro_base {
 		 * class container_poly, then this is set to 4, to also hold
 		 * the particle radii. */
 		const int ps;
+		/** An optional structure-of-arrays copy of the particle
+		 * positions, which is used to vectorize the loops over the
+		 * particles in a block. */
+		particle_soa psoa;
+		/** A set of Voronoi cells for each thread, which are reused
+		 * by the routines that compute many cells. */
+		cell_pool pool;
+		/** An index from particle IDs to their storage locations,
+		 * which is used by the move() and remove() routines. */
+		particle_index pix;
 		container_periodic_base(double bx_,double bxy_,double by_,double bxz_,double byz_,double bz_,
 				int nx_,int ny_,int nz_,int init_mem_,int ps);
 		~container_periodic_base();
@@ -103,6 +125,21 @@ class container_periodic_base : public unitcell, public voro_base {
 				printf("%d %g %g %g\n",id[ijk][q],p[ijk][ps*q],p[ijk][ps*q+1],p[ijk][ps*q+2]);
 		}
 		void region_count();
+		/** Makes a structure-of-arrays copy of the particle positions,
+		 * which is then used during the Voronoi cell computation. All
+		 * of the periodic images are created first, so that they are
+		 * included in the copy. The copy is not updated when particles
+		 * are added, moved, or removed, and any block that changes
+		 * afterwards is read from the regular particle data, so this
+		 * should be called after all particles have been put into the
+		 * container. */
+		inline void build_soa() {
+			create_all_images();
+			psoa.build(oxyz,ps,co,p);
+		}
+		/** Frees the structure-of-arrays copy of the particle
+		 * positions. */
+		inline void clear_soa() {psoa.clear();}
 		/** Initializes the Voronoi cell prior to a compute_cell
 		 * operation for a specific particle being carried out by a
 		 * voro_compute class. The cell is initialized to be the
@@ -124,7 +161,7 @@ class container_periodic_base : public unitcell, public voro_base {
 		template<class v_cell>
 		inline bool initialize_voronoicell(v_cell &c,int ijk,int q,int ci,int cj,int ck,int &i,int &j,int &k,double &x,double &y,double &z,int &disp) {
 			c=unit_voro;
-			double *pp=p[ijk]+ps*q;
+			particle_real *pp=p[ijk]+ps*q;
 			x=*(pp++);y=*(pp++);z=*pp;
 			i=nx;j=ey;k=ez;
 			return true;
@@ -177,7 +214,14 @@ class container_periodic_base : public unitcell, public voro_base {
 		}
 		void create_all_images();
 		void check_compartmentalized();
+		void build_index();
+		bool move(int n,double x,double y,double z);
+		bool remove(int n);
 	protected:
+		/** A flag that is set when particles have been moved or
+		 * removed since the periodic images were made, so that the
+		 * images must be discarded before any more are made. */
+		bool img_stale;
 		void add_particle_memory(int i);
 		void put_locate_block(int &ijk,double &x,double &y,double &z);
 		void put_locate_block(int &ijk,double &x,double &y,double &z,int &ai,int &aj,int &ak);
@@ -188,16 +232,23 @@ class container_periodic_base : public unitcell, public voro_base {
 		 * where the image block may comprise of particles from up to
 		 * two primary blocks. Otherwise is calls the more complex
 		 * create_vertical_image where the image block may comprise of
-		 * particles from up to four primary blocks.
+		 * particles from up to four primary blocks. Blocks whose images
+		 * are already complete are skipped, so that once all images
+		 * have been made, the routine does not alter the container.
+		 * If particles have been moved or removed, then all of the
+		 * images are discarded first.
 		 * \param[in] (di,dj,dk) the coordinates of the image block to
 		 *                       create. */
 		inline void create_periodic_image(int di,int dj,int dk) {
+			if(img_stale) reset_images();
 			if(di<0||di>=nx||dj<0||dj>=oy||dk<0||dk>=oz)
 				voro_fatal_error("Constructing periodic image for nonexistent point",VOROPP_INTERNAL_ERROR);
+			int dijk=di+nx*(dj+oy*dk);
 			if(dk>=ez&&dk<wz) {
-				if(dj<ey||dj>=wy) create_side_image(di,dj,dk);
-			} else create_vertical_image(di,dj,dk);
+				if((dj<ey||dj>=wy)&&img[dijk]!=3) create_side_image(di,dj,dk);
+			} else if(img[dijk]!=15) create_vertical_image(di,dj,dk);
 		}
+		void reset_images();
 		void create_side_image(int di,int dj,int dk);
 		void create_vertical_image(int di,int dj,int dk);
 		void put_image(int reg,int fijk,int l,double dx,double dy,double dz);
@@ -246,14 +297,17 @@ class container_periodic : public container_periodic_base, public radius_mono {
 			import(vo,fp);
 			fclose(fp);
 		}
+		void import_binary(const char *filename);
+		void compute_cells(block_scheduler &bs);
 		void compute_all_cells();
 		double sum_cell_volumes();
+		double sum_cell_volumes(block_scheduler &bs);
 		/** Dumps particle IDs and positions to a file.
 		 * \param[in] vl the loop class to use.
 		 * \param[in] fp a file handle to write to. */
 		template<class c_loop>
 		void draw_particles(c_loop &vl,FILE *fp) {
-			double *pp;
+			particle_real *pp;
 			if(vl.start()) do {
 				pp=p[vl.ijk]+3*vl.q;
 				fprintf(fp,"%d %g %g %g\n",id[vl.ijk][vl.q],*pp,pp[1],pp[2]);
@@ -272,12 +326,36 @@ class container_periodic : public container_periodic_base, public radius_mono {
 			draw_particles(fp);
 			fclose(fp);
 		}
+		/** Dumps particle IDs and positions to a file in the binary
+		 * particle format described in p_file.hh.
+		 * \param[in] vl the loop class to use.
+		 * \param[in] fp a file handle to write to. */
+		template<class c_loop>
+		void draw_particles_binary(c_loop &vl,FILE *fp) {
+			double box[6]={bx,bxy,by,bxz,byz,bz};
+			write_particles_binary(vl,id,p,ps,pf_xperiodic|pf_yperiodic|pf_zperiodic|pf_triclinic,box,fp);
+		}
+		/** Dumps all of the particle IDs and positions to a file in the binary
+		 * particle format.
+		 * \param[in] fp a file handle to write to. */
+		inline void draw_particles_binary(FILE *fp) {
+			c_loop_all_periodic vl(*this);
+			draw_particles_binary(vl,fp);
+		}
+		/** Dumps all of the particle IDs and positions to a file in the binary
+		 * particle format.
+		 * \param[in] filename the name of the file to write to. */
+		inline void draw_particles_binary(const char *filename) {
+			FILE *fp=safe_fopen(filename,"wb");
+			draw_particles_binary(fp);
+			fclose(fp);
+		}
 		/** Dumps particle positions in POV-Ray format.
 		 * \param[in] vl the loop class to use.
 		 * \param[in] fp a file handle to write to. */
 		template<class c_loop>
 		void draw_particles_pov(c_loop &vl,FILE *fp) {
-			double *pp;
+			particle_real *pp;
 			if(vl.start()) do {
 				pp=p[vl.ijk]+3*vl.q;
 				fprintf(fp,"// id %d\nsphere{<%g,%g,%g>,s}\n",
@@ -303,7 +381,9 @@ class container_periodic : public container_periodic_base, public radius_mono {
 		 * \param[in] fp a file handle to write to. */
 		template<class c_loop>
 		void draw_cells_gnuplot(c_loop &vl,FILE *fp) {
-			voronoicell c(*this);double *pp;
+			pool.setup(1);
+			voronoicell &c=pool.fetch<voronoicell>(0);
+			particle_real *pp;
 			if(vl.start()) do if(compute_cell(c,vl)) {
 				pp=p[vl.ijk]+ps*vl.q;
 				c.draw_gnuplot(*pp,pp[1],pp[2],fp);
@@ -330,7 +410,9 @@ class container_periodic : public container_periodic_base, public radius_mono {
 		 * \param[in] fp a file handle to write to. */
 		template<class c_loop>
 		void draw_cells_pov(c_loop &vl,FILE *fp) {
-			voronoicell c(*this);double *pp;
+			pool.setup(1);
+			voronoicell &c=pool.fetch<voronoicell>(0);
+			particle_real *pp;
 			if(vl.start()) do if(compute_cell(c,vl)) {
 				fprintf(fp,"// cell %d\n",id[vl.ijk][vl.q]);
 				pp=p[vl.ijk]+ps*vl.q;
@@ -353,29 +435,88 @@ class container_periodic : public container_periodic_base, public radius_mono {
 			fclose(fp);
 		}
 		/** Computes the Voronoi cells and saves customized information
-		 * about them.
+		 * about them. The particles visited by the loop are shared
+		 * among the available threads using a block_scheduler class.
 		 * \param[in] vl the loop class to use.
 		 * \param[in] format the custom output string to use.
 		 * \param[in] fp a file handle to write to. */
 		template<class c_loop>
 		void print_custom(c_loop &vl,const char *format,FILE *fp) {
-			int ijk,q;double *pp;
-			if(contains_neighbor(format)) {
-				voronoicell_neighbor c(*this);
-				if(vl.start()) do if(compute_cell(c,vl)) {
-					ijk=vl.ijk;q=vl.q;pp=p[ijk]+ps*q;
-					c.output_custom(format,id[ijk][q],*pp,pp[1],pp[2],default_radius,fp);
-				} while(vl.inc());
-			} else {
-				voronoicell c(*this);
-				if(vl.start()) do if(compute_cell(c,vl)) {
-					ijk=vl.ijk;q=vl.q;pp=p[ijk]+ps*q;
-					c.output_custom(format,id[ijk][q],*pp,pp[1],pp[2],default_radius,fp);
-				} while(vl.inc());
-			}
+			block_scheduler bs(vl);
+			print_custom(bs,format,fp);
 		}
+		void print_custom(block_scheduler &bs,const char *format,FILE *fp=stdout);
 		void print_custom(const char *format,FILE *fp=stdout);
 		void print_custom(const char *format,const char *filename);
+		/** Computes the Voronoi cells and saves customized information
+		 * about them in the columnar binary format described in
+		 * o_columns.hh. The particles visited by the loop are shared
+		 * among the available threads using a block_scheduler class.
+		 * \param[in] vl the loop class to use.
+		 * \param[in] format the custom output string to use.
+		 * \param[in] fp a file handle to write to. */
+		template<class c_loop>
+		void print_custom_binary(c_loop &vl,const char *format,FILE *fp) {
+			block_scheduler bs(vl);
+			print_custom_binary(bs,format,fp);
+		}
+		void print_custom_binary(block_scheduler &bs,const char *format,FILE *fp);
+		void print_custom_binary(const char *format,FILE *fp);
+		void print_custom_binary(const char *format,const char *filename);
+		/** Computes the Voronoi cells and stores the neighbor graph of
+		 * the particles, in the compressed sparse row form described
+		 * in o_graph.hh. The particles visited by the loop are shared
+		 * among the available threads using a block_scheduler class.
+		 * \param[in] vl the loop class to use.
+		 * \param[out] ng the neighbor graph to fill in. */
+		template<class c_loop>
+		void compute_neighbor_graph(c_loop &vl,neighbor_graph &ng) {
+			block_scheduler bs(vl);
+			compute_neighbor_graph(bs,ng);
+		}
+		void compute_neighbor_graph(block_scheduler &bs,neighbor_graph &ng);
+		void compute_neighbor_graph(neighbor_graph &ng);
+		/** Computes the Voronoi cells and stores each of their faces
+		 * once, in the mesh described in o_mesh.hh. The particles
+		 * visited by the loop are shared among the available threads
+		 * using a block_scheduler class.
+		 * \param[in] vl the loop class to use.
+		 * \param[out] fm the face mesh to fill in. */
+		template<class c_loop>
+		void compute_face_mesh(c_loop &vl,face_mesh &fm) {
+			block_scheduler bs(vl);
+			compute_face_mesh(bs,fm);
+		}
+		void compute_face_mesh(block_scheduler &bs,face_mesh &fm);
+		void compute_face_mesh(face_mesh &fm);
+		/** Computes the Voronoi cells and stores the finite volume
+		 * Laplacian of the tessellation, in the sparse matrix
+		 * described in o_laplace.hh. The particles visited by the loop
+		 * are shared among the available threads using a
+		 * block_scheduler class.
+		 * \param[in] vl the loop class to use.
+		 * \param[out] fl the matrix to fill in. */
+		template<class c_loop>
+		void compute_laplacian(c_loop &vl,fv_laplacian &fl) {
+			block_scheduler bs(vl);
+			compute_laplacian(bs,fl);
+		}
+		void compute_laplacian(block_scheduler &bs,fv_laplacian &fl);
+		void compute_laplacian(fv_laplacian &fl);
+		/** Computes the Voronoi cells and stores them in the compact
+		 * form described in o_tess.hh, so that they can be examined
+		 * later without being recomputed. The particles visited by
+		 * the loop are shared among the available threads using a
+		 * block_scheduler class.
+		 * \param[in] vl the loop class to use.
+		 * \param[out] ts the tessellation to fill in. */
+		template<class c_loop>
+		void compute_tessellation(c_loop &vl,tessellation &ts) {
+			block_scheduler bs(vl);
+			compute_tessellation(bs,ts);
+		}
+		void compute_tessellation(block_scheduler &bs,tessellation &ts);
+		void compute_tessellation(tessellation &ts);
 		bool find_voronoi_cell(double x,double y,double z,double &rx,double &ry,double &rz,int &pid);
 		/** Computes the Voronoi cell for a particle currently being
 		 * referenced by a loop class.
@@ -414,7 +555,7 @@ class container_periodic : public container_periodic_base, public radius_mono {
 		inline bool compute_ghost_cell(v_cell &c,double x,double y,double z) {
 			int ijk;
 			put_locate_block(ijk,x,y,z);
-			double *pp=p[ijk]+3*co[ijk]++;
+			particle_real *pp=p[ijk]+3*co[ijk]++;
 			*(pp++)=x;*(pp++)=y;*(pp++)=z;
 			bool q=compute_cell(c,ijk,co[ijk]-1);
 			co[ijk]--;
@@ -422,7 +563,7 @@ class container_periodic : public container_periodic_base, public radius_mono {
 		}
 	private:
 		voro_compute<container_periodic> vc;
-		friend class voro_compute<container_periodic>;
+		template<class c_class,class p_class,class m_class> friend class voro_compute;
 };
 
 /** \brief Extension of the container_periodic_base class for computing radical
@@ -467,14 +608,17 @@ class container_periodic_poly : public container_periodic_base, public radius_po
 			import(vo,fp);
 			fclose(fp);
 		}
+		void import_binary(const char *filename);
+		void compute_cells(block_scheduler &bs);
 		void compute_all_cells();
 		double sum_cell_volumes();
+		double sum_cell_volumes(block_scheduler &bs);
 		/** Dumps particle IDs, positions and radii to a file.
 		 * \param[in] vl the loop class to use.
 		 * \param[in] fp a file handle to write to. */
 		template<class c_loop>
 		void draw_particles(c_loop &vl,FILE *fp) {
-			double *pp;
+			particle_real *pp;
 			if(vl.start()) do {
 				pp=p[vl.ijk]+4*vl.q;
 				fprintf(fp,"%d %g %g %g %g\n",id[vl.ijk][vl.q],*pp,pp[1],pp[2],pp[3]);
@@ -495,12 +639,38 @@ class container_periodic_poly : public container_periodic_base, public radius_po
 			draw_particles(fp);
 			fclose(fp);
 		}
+		/** Dumps particle IDs, positions and radii to a file in the binary
+		 * particle format described in p_file.hh.
+		 * \param[in] vl the loop class to use.
+		 * \param[in] fp a file handle to write to. */
+		template<class c_loop>
+		void draw_particles_binary(c_loop &vl,FILE *fp) {
+			double box[6]={bx,bxy,by,bxz,byz,bz};
+			write_particles_binary(vl,id,p,ps,pf_xperiodic|pf_yperiodic|pf_zperiodic|pf_triclinic,box,fp);
+		}
+		/** Dumps all of the particle IDs, positions and
+		 * radii to a file in the binary
+		 * particle format.
+		 * \param[in] fp a file handle to write to. */
+		inline void draw_particles_binary(FILE *fp) {
+			c_loop_all_periodic vl(*this);
+			draw_particles_binary(vl,fp);
+		}
+		/** Dumps all of the particle IDs, positions and
+		 * radii to a file in the binary
+		 * particle format.
+		 * \param[in] filename the name of the file to write to. */
+		inline void draw_particles_binary(const char *filename) {
+			FILE *fp=safe_fopen(filename,"wb");
+			draw_particles_binary(fp);
+			fclose(fp);
+		}
 		/** Dumps particle positions in POV-Ray format.
 		 * \param[in] vl the loop class to use.
 		 * \param[in] fp a file handle to write to. */
 		template<class c_loop>
 		void draw_particles_pov(c_loop &vl,FILE *fp) {
-			double *pp;
+			particle_real *pp;
 			if(vl.start()) do {
 				pp=p[vl.ijk]+4*vl.q;
 				fprintf(fp,"// id %d\nsphere{<%g,%g,%g>,%g}\n",
@@ -526,7 +696,9 @@ class container_periodic_poly : public container_periodic_base, public radius_po
 		 * \param[in] fp a file handle to write to. */
 		template<class c_loop>
 		void draw_cells_gnuplot(c_loop &vl,FILE *fp) {
-			voronoicell c(*this);double *pp;
+			pool.setup(1);
+			voronoicell &c=pool.fetch<voronoicell>(0);
+			particle_real *pp;
 			if(vl.start()) do if(compute_cell(c,vl)) {
 				pp=p[vl.ijk]+ps*vl.q;
 				c.draw_gnuplot(*pp,pp[1],pp[2],fp);
@@ -553,7 +725,9 @@ class container_periodic_poly : public container_periodic_base, public radius_po
 		 * \param[in] fp a file handle to write to. */
 		template<class c_loop>
 		void draw_cells_pov(c_loop &vl,FILE *fp) {
-			voronoicell c(*this);double *pp;
+			pool.setup(1);
+			voronoicell &c=pool.fetch<voronoicell>(0);
+			particle_real *pp;
 			if(vl.start()) do if(compute_cell(c,vl)) {
 				fprintf(fp,"// cell %d\n",id[vl.ijk][vl.q]);
 				pp=p[vl.ijk]+ps*vl.q;
@@ -576,27 +750,17 @@ class container_periodic_poly : public container_periodic_base, public radius_po
 			fclose(fp);
 		}
 		/** Computes the Voronoi cells and saves customized information
-		 * about them.
+		 * about them. The particles visited by the loop are shared
+		 * among the available threads using a block_scheduler class.
 		 * \param[in] vl the loop class to use.
 		 * \param[in] format the custom output string to use.
 		 * \param[in] fp a file handle to write to. */
 		template<class c_loop>
 		void print_custom(c_loop &vl,const char *format,FILE *fp) {
-			int ijk,q;double *pp;
-			if(contains_neighbor(format)) {
-				voronoicell_neighbor c(*this);
-				if(vl.start()) do if(compute_cell(c,vl)) {
-					ijk=vl.ijk;q=vl.q;pp=p[ijk]+ps*q;
-					c.output_custom(format,id[ijk][q],*pp,pp[1],pp[2],pp[3],fp);
-				} while(vl.inc());
-			} else {
-				voronoicell c(*this);
-				if(vl.start()) do if(compute_cell(c,vl)) {
-					ijk=vl.ijk;q=vl.q;pp=p[ijk]+ps*q;
-					c.output_custom(format,id[ijk][q],*pp,pp[1],pp[2],pp[3],fp);
-				} while(vl.inc());
-			}
+			block_scheduler bs(vl);
+			print_custom(bs,format,fp);
 		}
+		void print_custom(block_scheduler &bs,const char *format,FILE *fp=stdout);
 		/** Computes the Voronoi cell for a particle currently being
 		 * referenced by a loop class.
 		 * \param[out] c a Voronoi cell class in which to store the
@@ -635,19 +799,89 @@ class container_periodic_poly : public container_periodic_base, public radius_po
 		inline bool compute_ghost_cell(v_cell &c,double x,double y,double z,double r) {
 			int ijk;
 			put_locate_block(ijk,x,y,z);
-			double *pp=p[ijk]+4*co[ijk]++,tm=max_radius;
+			particle_real *pp=p[ijk]+4*co[ijk]++;
+				double tm=max_radius;
 			*(pp++)=x;*(pp++)=y;*(pp++)=z;*pp=r;
-			if(r>max_radius) max_radius=r;
+			if(*pp>max_radius) max_radius=*pp;
 			bool q=compute_cell(c,ijk,co[ijk]-1);
 			co[ijk]--;max_radius=tm;
 			return q;
 		}
 		void print_custom(const char *format,FILE *fp=stdout);
 		void print_custom(const char *format,const char *filename);
+		/** Computes the Voronoi cells and saves customized information
+		 * about them in the columnar binary format described in
+		 * o_columns.hh. The particles visited by the loop are shared
+		 * among the available threads using a block_scheduler class.
+		 * \param[in] vl the loop class to use.
+		 * \param[in] format the custom output string to use.
+		 * \param[in] fp a file handle to write to. */
+		template<class c_loop>
+		void print_custom_binary(c_loop &vl,const char *format,FILE *fp) {
+			block_scheduler bs(vl);
+			print_custom_binary(bs,format,fp);
+		}
+		void print_custom_binary(block_scheduler &bs,const char *format,FILE *fp);
+		void print_custom_binary(const char *format,FILE *fp);
+		void print_custom_binary(const char *format,const char *filename);
+		/** Computes the Voronoi cells and stores the neighbor graph of
+		 * the particles, in the compressed sparse row form described
+		 * in o_graph.hh. The particles visited by the loop are shared
+		 * among the available threads using a block_scheduler class.
+		 * \param[in] vl the loop class to use.
+		 * \param[out] ng the neighbor graph to fill in. */
+		template<class c_loop>
+		void compute_neighbor_graph(c_loop &vl,neighbor_graph &ng) {
+			block_scheduler bs(vl);
+			compute_neighbor_graph(bs,ng);
+		}
+		void compute_neighbor_graph(block_scheduler &bs,neighbor_graph &ng);
+		void compute_neighbor_graph(neighbor_graph &ng);
+		/** Computes the Voronoi cells and stores each of their faces
+		 * once, in the mesh described in o_mesh.hh. The particles
+		 * visited by the loop are shared among the available threads
+		 * using a block_scheduler class.
+		 * \param[in] vl the loop class to use.
+		 * \param[out] fm the face mesh to fill in. */
+		template<class c_loop>
+		void compute_face_mesh(c_loop &vl,face_mesh &fm) {
+			block_scheduler bs(vl);
+			compute_face_mesh(bs,fm);
+		}
+		void compute_face_mesh(block_scheduler &bs,face_mesh &fm);
+		void compute_face_mesh(face_mesh &fm);
+		/** Computes the Voronoi cells and stores the finite volume
+		 * Laplacian of the tessellation, in the sparse matrix
+		 * described in o_laplace.hh. The particles visited by the loop
+		 * are shared among the available threads using a
+		 * block_scheduler class.
+		 * \param[in] vl the loop class to use.
+		 * \param[out] fl the matrix to fill in. */
+		template<class c_loop>
+		void compute_laplacian(c_loop &vl,fv_laplacian &fl) {
+			block_scheduler bs(vl);
+			compute_laplacian(bs,fl);
+		}
+		void compute_laplacian(block_scheduler &bs,fv_laplacian &fl);
+		void compute_laplacian(fv_laplacian &fl);
+		/** Computes the Voronoi cells and stores them in the compact
+		 * form described in o_tess.hh, so that they can be examined
+		 * later without being recomputed. The particles visited by
+		 * the loop are shared among the available threads using a
+		 * block_scheduler class.
+		 * \param[in] vl the loop class to use.
+		 * \param[out] ts the tessellation to fill in. */
+		template<class c_loop>
+		void compute_tessellation(c_loop &vl,tessellation &ts) {
+			block_scheduler bs(vl);
+			compute_tessellation(bs,ts);
+		}
+		void compute_tessellation(block_scheduler &bs,tessellation &ts);
+		void compute_tessellation(tessellation &ts);
 		bool find_voronoi_cell(double x,double y,double z,double &rx,double &ry,double &rz,int &pid);
 	private:
 		voro_compute<container_periodic_poly> vc;
-		friend class voro_compute<container_periodic_poly>;
+		template<class c_class,class p_class,class m_class> friend class voro_compute;
 };
 
 }
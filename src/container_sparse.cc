@@ -0,0 +1,297 @@
+// Voro++, a 3D cell-based Voronoi library
+//
+// Author   : Chris H. Rycroft (LBL / UC Berkeley)
+// Email    : chr@alum.mit.edu
+// Date     : August 30th 2011
+
+/** \file container_sparse.cc
+ * \brief Function implementations for the container_sparse class. */
+
+#include <climits>
+
+#include "container_sparse.hh"
+#include "p_text.hh"
+#include "c_drive.hh"
+
+namespace voro {
+
+/** The class constructor sets up the geometry of container, initializing the
+ * minimum and maximum coordinates in each direction. It divides the container
+ * into a rectangular grid of blocks, but no memory is allocated for a block
+ * until a particle is put into it.
+ * \param[in] (ax_,bx_) the minimum and maximum x coordinates.
+ * \param[in] (ay_,by_) the minimum and maximum y coordinates.
+ * \param[in] (az_,bz_) the minimum and maximum z coordinates.
+ * \param[in] (nx_,ny_,nz_) the number of grid blocks in each of the three
+ *			    coordinate directions.
+ * \param[in] init_mem_ the initial memory allocation for each occupied
+ *                      block. */
+container_sparse::container_sparse(double ax_,double bx_,double ay_,double by_,double az_,double bz_,
+		int nx_,int ny_,int nz_,int init_mem_)
+	: voro_base(check_grid(nx_,ny_,nz_),ny_,nz_,(bx_-ax_)/nx_,(by_-ay_)/ny_,(bz_-az_)/nz_),
+	ax(ax_), bx(bx_), ay(ay_), by(by_), az(az_), bz(bz_),
+	max_len_sq((bx-ax)*(bx-ax)+(by-ay)*(by-ay)+(bz-az)*(bz-az)),
+	id(new int*[init_sparse_blocks]), p(new particle_real*[init_sparse_blocks]),
+	co(new int[init_sparse_blocks]), mem(new int[init_sparse_blocks]),
+	bg(new int[init_sparse_blocks]), nb(1), init_mem(init_mem_), ps(3),
+	pool(max_len_sq), bmem(init_sparse_blocks), hmem(init_sparse_blocks<<1),
+	hm(hmem-1), hs(new int[hmem]), vc(*this,nx_,ny_,nz_) {
+	*id=NULL;*p=NULL;*co=*mem=0;*bg=-1;
+	for(int l=0;l<hmem;l++) hs[l]=0;
+}
+
+/** The container destructor frees the dynamically allocated memory. */
+container_sparse::~container_sparse() {
+	for(int l=1;l<nb;l++) {
+		delete [] p[l];
+		delete [] id[l];
+	}
+	delete [] hs;
+	delete [] bg;
+	delete [] mem;
+	delete [] co;
+	delete [] p;
+	delete [] id;
+}
+
+/** Checks that the total number of blocks in a grid can be indexed with an
+ * int, and causes a fatal error if it cannot.
+ * \param[in] (nx_,ny_,nz_) the number of grid blocks in each of the three
+ *			    coordinate directions.
+ * \return The number of grid blocks in the x direction. */
+int container_sparse::check_grid(int nx_,int ny_,int nz_) {
+	if(double(nx_)*double(ny_)*double(nz_)>double(INT_MAX))
+		voro_fatal_error("Number of grid blocks is too large to be indexed",VOROPP_MEMORY_ERROR);
+	return nx_;
+}
+
+/** Creates a new empty block for a grid block, and adds it to the hash table.
+ * If the table becomes more than half full, then its size is doubled and all
+ * of the blocks are added to it again.
+ * \param[in] g the index of the grid block.
+ * \return The number of the new block. */
+int container_sparse::new_block(int g) {
+	int b,l;
+	unsigned int h;
+	if(nb==bmem) add_block_memory();
+	b=nb++;
+	bg[b]=g;co[b]=0;mem[b]=init_mem;
+	id[b]=new int[init_mem];
+	p[b]=new particle_real[ps*init_mem];
+	if((nb<<1)>hmem) {
+		delete [] hs;
+		hmem<<=1;hm=hmem-1;
+		hs=new int[hmem];
+		for(l=0;l<hmem;l++) hs[l]=0;
+#if VOROPP_VERBOSE >=2
+		fprintf(stderr,"Block hash table scaled up to %d\n",hmem);
+#endif
+		l=1;
+	} else l=b;
+	for(;l<nb;l++) {
+		h=block_hash(bg[l])&hm;
+		while(hs[h]!=0) h=(h+1)&hm;
+		hs[h]=l;
+	}
+	return b;
+}
+
+/** Doubles the memory allocation for the blocks. The voro_compute class of
+ * the container keeps copies of the block array pointers, so these are also
+ * updated. */
+void container_sparse::add_block_memory() {
+	int l,nmem=bmem<<1;
+	if(nmem>max_sparse_blocks)
+		voro_fatal_error("Sparse block memory allocation exceeded absolute maximum",VOROPP_MEMORY_ERROR);
+#if VOROPP_VERBOSE >=2
+	fprintf(stderr,"Sparse block memory scaled up to %d\n",nmem);
+#endif
+	int **nid=new int*[nmem],*nco=new int[nmem],*nmemp=new int[nmem],*nbg=new int[nmem];
+	particle_real **np=new particle_real*[nmem];
+	for(l=0;l<nb;l++) {
+		nid[l]=id[l];np[l]=p[l];nco[l]=co[l];nmemp[l]=mem[l];nbg[l]=bg[l];
+	}
+	delete [] bg;delete [] mem;delete [] co;delete [] p;delete [] id;
+	id=nid;p=np;co=nco;mem=nmemp;bg=nbg;bmem=nmem;
+	vc.id=id;vc.p=p;vc.co=co;
+}
+
+/** Increase memory for a particular block.
+ * \param[in] i the number of the block to reallocate. */
+void container_sparse::add_particle_memory(int i) {
+	int l,nmem=mem[i]<<1;
+	if(nmem>max_particle_memory)
+		voro_fatal_error("Absolute maximum memory allocation exceeded",VOROPP_MEMORY_ERROR);
+#if VOROPP_VERBOSE >=3
+	fprintf(stderr,"Particle memory in block %d scaled up to %d\n",i,nmem);
+#endif
+	int *idp=new int[nmem];
+	for(l=0;l<co[i];l++) idp[l]=id[i][l];
+	particle_real *pp=new particle_real[ps*nmem];
+	for(l=0;l<ps*co[i];l++) pp[l]=p[i][l];
+	delete [] id[i];delete [] p[i];
+	mem[i]=nmem;id[i]=idp;p[i]=pp;
+}
+
+/** This routine takes a particle position vector, tries to find the block
+ * that it is within, creating the block if it has not been occupied, and
+ * checks that there is enough memory within the block to store it.
+ * \param[out] ijk the block number.
+ * \param[in] (x,y,z) the particle position.
+ * \return True if the particle can be successfully placed into the container,
+ * false otherwise. */
+bool container_sparse::put_locate_block(int &ijk,double &x,double &y,double &z) {
+	int i=step_int((x-ax)*xsp),j=step_int((y-ay)*ysp),k=step_int((z-az)*zsp);
+	if(i<0||i>=nx||j<0||j>=ny||k<0||k>=nz) {
+#if VOROPP_REPORT_OUT_OF_BOUNDS ==1
+		fprintf(stderr,"Out of bounds: (x,y,z)=(%g,%g,%g)\n",x,y,z);
+#endif
+		return false;
+	}
+	int g=i+nx*j+nxy*k;
+	ijk=block(g);
+	if(ijk==0) ijk=new_block(g);
+	if(co[ijk]==mem[ijk]) add_particle_memory(ijk);
+	psoa.modify(ijk);
+	return true;
+}
+
+/** Put a particle into the correct block of the container.
+ * \param[in] n the numerical ID of the inserted particle.
+ * \param[in] (x,y,z) the position vector of the inserted particle. */
+void container_sparse::put(int n,double x,double y,double z) {
+	int ijk;
+	if(put_locate_block(ijk,x,y,z)) {
+		id[ijk][co[ijk]]=n;
+		particle_real *pp=p[ijk]+3*co[ijk]++;
+		*(pp++)=x;*(pp++)=y;*pp=z;
+	}
+}
+
+/** Import a list of particles from an open file stream into the container.
+ * Entries of four numbers (Particle ID, x position, y position, z position)
+ * are searched for. The file is parsed in parallel using the particle_text
+ * class. If the file cannot be successfully read, then the routine causes a
+ * fatal error.
+ * \param[in] fp the file handle to read from. */
+void container_sparse::import(FILE *fp) {
+	particle_text pt(fp,3);
+	double *pp=pt.p;
+	for(int l=0;l<pt.n;l++,pp+=3) put(pt.id[l],*pp,pp[1],pp[2]);
+}
+
+/** Clears a container of particles, freeing the memory for all of the
+ * blocks. */
+void container_sparse::clear() {
+	for(int l=1;l<nb;l++) {
+		delete [] p[l];
+		delete [] id[l];
+	}
+	nb=1;
+	for(int l=0;l<hmem;l++) hs[l]=0;
+	clear_soa();
+}
+
+/** This function tests to see if a given vector lies within the container
+ * bounds and any walls.
+ * \param[in] (x,y,z) the position vector to be tested.
+ * \return True if the point is inside the container, false if the point is
+ *         outside. */
+bool container_sparse::point_inside(double x,double y,double z) {
+	if(x<ax||x>bx||y<ay||y>by||z<az||z>bz) return false;
+	return point_inside_walls(x,y,z);
+}
+
+/** Takes a vector and finds the particle whose Voronoi cell contains that
+ * vector. This is equivalent to finding the particle which is nearest to the
+ * vector. Additional wall classes are not considered by this routine.
+ * \param[in] (x,y,z) the vector to test.
+ * \param[out] (rx,ry,rz) the position of the particle whose Voronoi cell
+ *                        contains the vector.
+ * \param[out] pid the ID of the particle.
+ * \return True if a particle was found. If the container has no particles,
+ * then the search will not find a Voronoi cell and false is returned. */
+bool container_sparse::find_voronoi_cell(double x,double y,double z,double &rx,double &ry,double &rz,int &pid) {
+	int ci=step_int((x-ax)*xsp),cj=step_int((y-ay)*ysp),ck=step_int((z-az)*zsp);
+	particle_record w;
+	double mrs;
+	if(ci<0||ci>=nx||cj<0||cj>=ny||ck<0||ck>=nz) return false;
+	vc.find_voronoi_cell(x,y,z,ci,cj,ck,block(ci+nx*cj+nxy*ck),w,mrs);
+	if(w.ijk!=-1) {
+		rx=p[w.ijk][3*w.l];
+		ry=p[w.ijk][3*w.l+1];
+		rz=p[w.ijk][3*w.l+2];
+		pid=id[w.ijk][w.l];
+		return true;
+	}
+	return false;
+}
+
+/** Computes the Voronoi cells for the particles in a scheduler and saves
+ * customized information about them.
+ * \param[in] bs the scheduler to use.
+ * \param[in] format the custom output string to use.
+ * \param[in] fp a file handle to write to. */
+void container_sparse::print_custom(block_scheduler &bs,const char *format,FILE *fp) {
+	drive_custom f(bs,format,fp);
+	if(contains_neighbor(format)) drive_cells<voronoicell_neighbor,voro_compute<container_sparse,periodicity_runtime,block_mask_hashed> >(*this,bs,f);
+	else drive_cells<voronoicell,voro_compute<container_sparse,periodicity_runtime,block_mask_hashed> >(*this,bs,f);
+	f.finish();
+}
+
+/** Computes all the Voronoi cells and saves customized information about them.
+ * \param[in] format the custom output string to use.
+ * \param[in] fp a file handle to write to. */
+void container_sparse::print_custom(const char *format,FILE *fp) {
+	c_loop_all_sparse vl(*this);
+	print_custom(vl,format,fp);
+}
+
+/** Computes all the Voronoi cells and saves customized information about them.
+ * \param[in] format the custom output string to use.
+ * \param[in] filename the name of the file to write to. */
+void container_sparse::print_custom(const char *format,const char *filename) {
+	FILE *fp=safe_fopen(filename,"w");
+	print_custom(format,fp);
+	fclose(fp);
+}
+
+/** Computes the Voronoi cells for the particles in a scheduler, but does
+ * nothing with the output.
+ * \param[in] bs the scheduler to use. */
+void container_sparse::compute_cells(block_scheduler &bs) {
+	drive_none f;
+	drive_cells<voronoicell,voro_compute<container_sparse,periodicity_runtime,block_mask_hashed> >(*this,bs,f);
+}
+
+/** Computes all of the Voronoi cells in the container, but does nothing
+ * with the output. */
+void container_sparse::compute_all_cells() {
+	c_loop_all_sparse vl(*this);
+	block_scheduler bs(vl);
+	compute_cells(bs);
+}
+
+/** Calculates the Voronoi cells for the particles in a scheduler and sums
+ * their volumes. The volumes are summed for each chunk, and these are then
+ * added in order, so that the result does not depend on the number of
+ * threads.
+ * \param[in] bs the scheduler to use.
+ * \return The sum of all of the computed Voronoi volumes. */
+double container_sparse::sum_cell_volumes(block_scheduler &bs) {
+	drive_volume f(bs);
+	drive_cells<voronoicell,voro_compute<container_sparse,periodicity_runtime,block_mask_hashed> >(*this,bs,f);
+	return f.sum();
+}
+
+/** Calculates all of the Voronoi cells and sums their volumes. In most cases
+ * without walls, the sum of the Voronoi cell volumes should equal the volume
+ * of the container to numerical precision.
+ * \return The sum of all of the computed Voronoi volumes. */
+double container_sparse::sum_cell_volumes() {
+	c_loop_all_sparse vl(*this);
+	block_scheduler bs(vl);
+	return sum_cell_volumes(bs);
+}
+
+}
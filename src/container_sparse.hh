@@ -0,0 +1,324 @@
+// Voro++, a 3D cell-based Voronoi library
+//
+// Author   : Chris H. Rycroft (LBL / UC Berkeley)
+// Email    : chr@alum.mit.edu
+// Date     : August 30th 2011
+
+/** \file container_sparse.hh
+ * \brief Header file for the container_sparse and related classes. */
+
+#ifndef VOROPP_CONTAINER_SPARSE_HH
+#define VOROPP_CONTAINER_SPARSE_HH
+
+#include <cstdio>
+
+#include "config.hh"
+#include "common.hh"
+#include "v_base.hh"
+#include "cell.hh"
+#include "c_loops.hh"
+#include "c_sched.hh"
+#include "c_pool.hh"
+#include "p_soa.hh"
+#include "v_compute.hh"
+#include "rad_option.hh"
+#include "container.hh"
+
+namespace voro {
+
+/** \brief Class for looping over all of the particles in a container_sparse
+ * class.
+ *
+ * This loop class scans the occupied blocks of a container_sparse class in
+ * the order that they were first occupied, and scans all the particles within
+ * each block in order. Empty parts of the domain are not visited. */
+class c_loop_all_sparse : public c_loop_base {
+	public:
+		/** The constructor copies several necessary constants from the
+		 * base container class.
+		 * \param[in] con the container class to use. */
+		template<class c_class>
+		c_loop_all_sparse(c_class &con) : c_loop_base(con), nb(con.nb), bg(con.bg) {}
+		/** Sets the class to consider the first particle.
+		 * \return True if there is any particle to consider, false
+		 * otherwise. */
+		inline bool start() {
+			for(ijk=1;ijk<nb;ijk++) if(co[ijk]>0) {
+				q=0;grid_pos();
+				return true;
+			}
+			return false;
+		}
+		/** Finds the next particle to test.
+		 * \return True if there is another particle, false if no more
+		 * particles are available. */
+		inline bool inc() {
+			q++;
+			if(q>=co[ijk]) {
+				q=0;
+				do {
+					ijk++;
+					if(ijk==nb) return false;
+				} while(co[ijk]==0);
+				grid_pos();
+			}
+			return true;
+		}
+	private:
+		/** The number of blocks in the container, including the
+		 * empty block zero. */
+		const int nb;
+		/** The grid index of each block in the container. */
+		const int *bg;
+		/** Decodes the grid coordinates of the current block. */
+		inline void grid_pos() {
+			k=bg[ijk]/nxy;
+			int r=bg[ijk]-nxy*k;
+			j=r/nx;i=r-nx*j;
+		}
+};
+
+/** \brief A container class that only stores the occupied blocks of its grid.
+ *
+ * This class computes regular Voronoi tessellations in a non-periodic
+ * rectangular box, in the same way as the container class. However, rather
+ * than allocating memory for every block of the grid, it only creates a block
+ * when a particle is first put into it. The occupied blocks are numbered
+ * consecutively from one, and a hash table maps the index of each grid block
+ * to its number. Block zero is always empty, and any grid block that has not
+ * been occupied maps onto it, so that the voro_compute template can search
+ * the grid in the usual way. The search uses the block_mask_hashed policy, so
+ * that its memory depends on the number of blocks tested rather than the
+ * total number of blocks. The memory and looping cost of the class therefore
+ * scale with the number of occupied blocks, which allows very fine grids to be
+ * used for domains that are mostly empty. The total number of grid blocks
+ * must fit in an int. */
+class container_sparse : public voro_base, public wall_list, public radius_mono {
+	public:
+		/** The minimum x coordinate of the container. */
+		const double ax;
+		/** The maximum x coordinate of the container. */
+		const double bx;
+		/** The minimum y coordinate of the container. */
+		const double ay;
+		/** The maximum y coordinate of the container. */
+		const double by;
+		/** The minimum z coordinate of the container. */
+		const double az;
+		/** The maximum z coordinate of the container. */
+		const double bz;
+		/** The maximum length squared that could be encountered in the
+		 * Voronoi cell calculation. */
+		const double max_len_sq;
+		/** This array holds the numerical IDs of each particle in each
+		 * block. */
+		int **id;
+		/** A two dimensional array holding particle positions. */
+		particle_real **p;
+		/** This array holds the number of particles within each
+		 * block. */
+		int *co;
+		/** This array holds the maximum amount of particle memory for
+		 * each block. */
+		int *mem;
+		/** This array holds the grid index of each block. */
+		int *bg;
+		/** The number of blocks, including the empty block zero. */
+		int nb;
+		/** The initial amount of memory to allocate for particles
+		 * for each block. */
+		const int init_mem;
+		/** The amount of memory in the array structure for each
+		 * particle, which is set to 3 to hold (x,y,z) positions. */
+		const int ps;
+		/** An optional structure-of-arrays copy of the particle
+		 * positions, which is used to vectorize the loops over the
+		 * particles in a block. */
+		particle_soa psoa;
+		/** A set of Voronoi cells for each thread, which are reused
+		 * by the routines that compute many cells. */
+		cell_pool pool;
+		container_sparse(double ax_,double bx_,double ay_,double by_,double az_,double bz_,
+				int nx_,int ny_,int nz_,int init_mem);
+		~container_sparse();
+		void clear();
+		void put(int n,double x,double y,double z);
+		void import(FILE *fp=stdin);
+		/** Imports a list of particles from an open file stream into
+		 * the container. Entries of four numbers (Particle ID, x
+		 * position, y position, z position) are searched for. If the
+		 * file cannot be successfully read, then the routine causes a
+		 * fatal error.
+		 * \param[in] filename the name of the file to open and read
+		 *                     from. */
+		inline void import(const char* filename) {
+			FILE *fp=safe_fopen(filename,"r");
+			import(fp);
+			fclose(fp);
+		}
+		bool point_inside(double x,double y,double z);
+		/** Sums up the total number of stored particles.
+		 * \return The number of particles. */
+		inline int total_particles() {
+			int tp=0;
+			for(int *cop=co+1;cop<co+nb;cop++) tp+=*cop;
+			return tp;
+		}
+		/** Makes a structure-of-arrays copy of the particle positions,
+		 * which is then used during the Voronoi cell computation. The
+		 * copy is not updated when particles are added, moved, or
+		 * removed, and any block that changes afterwards is read from
+		 * the regular particle data, so this should be called after
+		 * all particles have been put into the container. */
+		inline void build_soa() {psoa.build(nb,ps,co,p);}
+		/** Frees the structure-of-arrays copy of the particle
+		 * positions. */
+		inline void clear_soa() {psoa.clear();}
+		/** Finds the block corresponding to a grid block.
+		 * \param[in] g the index of the grid block.
+		 * \return The block number, or zero if the grid block has not
+		 *         been occupied. */
+		inline int block(int g) {
+			int b;
+			unsigned int h=block_hash(g)&hm;
+			while((b=hs[h])!=0) {
+				if(bg[b]==g) return b;
+				h=(h+1)&hm;
+			}
+			return 0;
+		}
+		/** Initializes the Voronoi cell prior to a compute_cell
+		 * operation for a specific particle being carried out by a
+		 * voro_compute class. The cell is initialized to fill the
+		 * entire container, and then any walls that have been added
+		 * are applied. The parameters are described in
+		 * container_base::initialize_voronoicell.
+		 * \return False if the plane cuts applied by walls completely
+		 * removed the cell, true otherwise. */
+		template<class v_cell>
+		inline bool initialize_voronoicell(v_cell &c,int ijk,int q,int ci,int cj,int ck,
+				int &i,int &j,int &k,double &x,double &y,double &z,int &disp) {
+			particle_real *pp=p[ijk]+ps*q;
+			x=*(pp++);y=*(pp++);z=*pp;
+			c.init(ax-x,bx-x,ay-y,by-y,az-z,bz-z);
+			if(!apply_walls(c,x,y,z)) return false;
+			i=ci;j=cj;k=ck;disp=0;
+			return true;
+		}
+		/** Initializes parameters for a find_voronoi_cell call within
+		 * the voro_compute template. The parameters are described in
+		 * container_base::initialize_search. */
+		inline void initialize_search(int ci,int cj,int ck,int ijk,int &i,int &j,int &k,int &disp) {
+			i=ci;j=cj;k=ck;disp=0;
+		}
+		/** Returns the position of a particle currently being computed
+		 * relative to the computational block that it is within.
+		 * \param[in] (x,y,z) the position of the particle.
+		 * \param[in] (ci,cj,ck) the block that the particle is within.
+		 * \param[out] (fx,fy,fz) the position relative to the block.
+		 */
+		inline void frac_pos(double x,double y,double z,double ci,double cj,double ck,
+				double &fx,double &fy,double &fz) {
+			fx=x-ax-boxx*ci;
+			fy=y-ay-boxy*cj;
+			fz=z-az-boxz*ck;
+		}
+		/** Finds the block at given grid coordinates. The parameters
+		 * are described in container_base::region_index.
+		 * \return The block number, or zero if the grid block has not
+		 *         been occupied. */
+		inline int region_index(int ci,int cj,int ck,int ei,int ej,int ek,double &qx,double &qy,double &qz,int &disp) {
+			return block(ei+nx*ej+nxy*ek);
+		}
+		void compute_cells(block_scheduler &bs);
+		void compute_all_cells();
+		double sum_cell_volumes();
+		double sum_cell_volumes(block_scheduler &bs);
+		/** Dumps particle IDs and positions to a file.
+		 * \param[in] vl the loop class to use.
+		 * \param[in] fp a file handle to write to. */
+		template<class c_loop>
+		void draw_particles(c_loop &vl,FILE *fp) {
+			particle_real *pp;
+			if(vl.start()) do {
+				pp=p[vl.ijk]+3*vl.q;
+				fprintf(fp,"%d %g %g %g\n",id[vl.ijk][vl.q],*pp,pp[1],pp[2]);
+			} while(vl.inc());
+		}
+		/** Dumps all of the particle IDs and positions to a file.
+		 * \param[in] fp a file handle to write to. */
+		inline void draw_particles(FILE *fp=stdout) {
+			c_loop_all_sparse vl(*this);
+			draw_particles(vl,fp);
+		}
+		/** Dumps all of the particle IDs and positions to a file.
+		 * \param[in] filename the name of the file to write to. */
+		inline void draw_particles(const char *filename) {
+			FILE *fp=safe_fopen(filename,"w");
+			draw_particles(fp);
+			fclose(fp);
+		}
+		/** Computes the Voronoi cells and saves customized information
+		 * about them. The particles visited by the loop are shared
+		 * among the available threads using a block_scheduler class.
+		 * \param[in] vl the loop class to use.
+		 * \param[in] format the custom output string to use.
+		 * \param[in] fp a file handle to write to. */
+		template<class c_loop>
+		void print_custom(c_loop &vl,const char *format,FILE *fp) {
+			block_scheduler bs(vl);
+			print_custom(bs,format,fp);
+		}
+		void print_custom(block_scheduler &bs,const char *format,FILE *fp=stdout);
+		void print_custom(const char *format,FILE *fp=stdout);
+		void print_custom(const char *format,const char *filename);
+		bool find_voronoi_cell(double x,double y,double z,double &rx,double &ry,double &rz,int &pid);
+		/** Computes the Voronoi cell for a particle currently being
+		 * referenced by a loop class.
+		 * \param[out] c a Voronoi cell class in which to store the
+		 * 		 computed cell.
+		 * \param[in] vl the loop class to use.
+		 * \return True if the cell was computed. If the cell cannot be
+		 * computed, if it is removed entirely by a wall or boundary
+		 * condition, then the routine returns false. */
+		template<class v_cell,class c_loop>
+		inline bool compute_cell(v_cell &c,c_loop &vl) {
+			return vc.compute_cell(c,vl.ijk,vl.q,vl.i,vl.j,vl.k);
+		}
+		/** Computes the Voronoi cell for given particle.
+		 * \param[out] c a Voronoi cell class in which to store the
+		 * 		 computed cell.
+		 * \param[in] ijk the block that the particle is within.
+		 * \param[in] q the index of the particle within the block.
+		 * \return True if the cell was computed. If the cell cannot be
+		 * computed, if it is removed entirely by a wall or boundary
+		 * condition, then the routine returns false. */
+		template<class v_cell>
+		inline bool compute_cell(v_cell &c,int ijk,int q) {
+			int k=bg[ijk]/nxy,ijkt=bg[ijk]-nxy*k,j=ijkt/nx,i=ijkt-j*nx;
+			return vc.compute_cell(c,ijk,q,i,j,k);
+		}
+	private:
+		/** The current memory allocation for the blocks. */
+		int bmem;
+		/** The number of slots in the hash table, which is a power of
+		 * two. */
+		int hmem;
+		/** A bit mask for reducing a hash value to a slot, set to
+		 * hmem-1. */
+		unsigned int hm;
+		/** The hash table, holding the number of the block stored in
+		 * each slot, or zero if the slot is empty. */
+		int *hs;
+		voro_compute<container_sparse,periodicity_runtime,block_mask_hashed> vc;
+		static int check_grid(int nx_,int ny_,int nz_);
+		int new_block(int g);
+		void add_block_memory();
+		void add_particle_memory(int i);
+		bool put_locate_block(int &ijk,double &x,double &y,double &z);
+		template<class c_class,class p_class,class m_class> friend class voro_compute;
+};
+
+}
+
+#endif
@@ -0,0 +1,274 @@
+// Voro++, a 3D cell-based Voronoi library
+//
+// Author   : Chris H. Rycroft (LBL / UC Berkeley)
+// Email    : chr@alum.mit.edu
+// Date     : August 30th 2011
+
+/** \file o_columns.cc
+ * \brief Function implementations for the custom_columns class. */
+
+#include <cstring>
+
+#include "o_columns.hh"
+
+namespace voro {
+
+/** The class constructor finds the columns in a custom output string, and
+ * opens a temporary file for each staged stream.
+ * \param[in] format the custom output string. */
+custom_columns::custom_columns(const char *format) : neighbor(false), n_col(0),
+	n(0), code(new char[32]), cs(new int[32]), gmask(0) {
+	const char *fmp=format;
+	char type;
+	bool var;
+	int k,width;
+	while(*fmp!=0) {
+		if(*fmp=='%') {
+			fmp++;
+			if(*fmp==0) break;
+			if(strchr("ixyzqrwpPomgEesFAaftlnvcC",*fmp)!=NULL&&memchr(code,*fmp,n_col)==NULL) {
+				if(*fmp=='n') neighbor=true;
+				gmask|=custom_format::geometry_flag(*fmp);
+				code[n_col++]=*fmp;
+			}
+		}
+		fmp++;
+	}
+
+	// Assign the streams that hold the number of entries for the
+	// variable-length columns
+	n_str=n_col;
+	for(k=0;k<n_col;k++) {
+		column_type(code[k],type,var,width);
+		cs[k]=var?n_str++:-1;
+	}
+	tf=new FILE*[n_str];
+	ob=new output_buffer*[n_str];
+	for(k=0;k<n_str;k++) {
+		tf[k]=voro_tmpfile();
+		ob[k]=new output_buffer(tf[k],column_buffer_size);
+	}
+}
+
+/** The class destructor closes the temporary files and frees the dynamically
+ * allocated memory. */
+custom_columns::~custom_columns() {
+	for(int k=0;k<n_str;k++) {
+		delete ob[k];
+		fclose(tf[k]);
+	}
+	delete [] ob;
+	delete [] tf;
+	delete [] cs;
+	delete [] code;
+}
+
+/** Finds the format of the column for a control character.
+ * \param[in] code the control character.
+ * \param[out] type the type of the values, 'i' for ints or 'd' for doubles.
+ * \param[out] var whether the column has a variable length.
+ * \param[out] width the number of values in each entry. */
+void custom_columns::column_type(char code,char &type,bool &var,int &width) {
+	type=strchr("iwgsAatno",code)!=NULL?'i':'d';
+	var=strchr("pPoeAaftln",code)!=NULL;
+	width=strchr("qpPlcC",code)!=NULL?3:1;
+}
+
+/** Writes the values in a vector to a variable-length column, and the number
+ * of entries to its count stream.
+ * \param[in] k the column.
+ * \param[in] v the vector.
+ * \param[in] m the number of values in each entry. */
+void custom_columns::put_list(int k,std::vector<int> &v,int m) {
+	if(v.size()>0) ob[k]->put(reinterpret_cast<const char*>(&v[0]),v.size()*sizeof(int));
+	put_int(cs[k],v.size()/m);
+}
+
+/** Writes the values in a vector to a variable-length column, and the number
+ * of entries to its count stream.
+ * \param[in] k the column.
+ * \param[in] v the vector.
+ * \param[in] m the number of values in each entry. */
+void custom_columns::put_list(int k,std::vector<double> &v,int m) {
+	if(v.size()>0) ob[k]->put(reinterpret_cast<const char*>(&v[0]),v.size()*sizeof(double));
+	put_int(cs[k],v.size()/m);
+}
+
+/** Writes the columns for a Voronoi cell.
+ * \param[in] c the Voronoi cell.
+ * \param[in] i the ID of the particle associated with the cell.
+ * \param[in] (x,y,z) the position of the particle associated with the cell.
+ * \param[in] r a radius associated with the particle. */
+void custom_columns::write(voronoicell_base &c,int i,double x,double y,double z,double r) {
+	double *ptsp;
+	if(gmask) c.geometry(gmask,g);
+	for(int k=0;k<n_col;k++) switch(code[k]) {
+
+		// Particle-related output
+		case 'i': put_int(k,i);break;
+		case 'x': put_double(k,x);break;
+		case 'y': put_double(k,y);break;
+		case 'z': put_double(k,z);break;
+		case 'q': put_double(k,x);put_double(k,y);put_double(k,z);break;
+		case 'r': put_double(k,r);break;
+
+		// Vertex-related output
+		case 'w': put_int(k,c.p);break;
+		case 'p': for(ptsp=c.pts;ptsp<c.pts+(c.p<<2);ptsp+=4) {
+				  put_double(k,*ptsp*0.5);
+				  put_double(k,ptsp[1]*0.5);
+				  put_double(k,ptsp[2]*0.5);
+			  }
+			  put_int(cs[k],c.p);break;
+		case 'P': for(ptsp=c.pts;ptsp<c.pts+(c.p<<2);ptsp+=4) {
+				  put_double(k,x+*ptsp*0.5);
+				  put_double(k,y+ptsp[1]*0.5);
+				  put_double(k,z+ptsp[2]*0.5);
+			  }
+			  put_int(cs[k],c.p);break;
+		case 'o': ob[k]->put(reinterpret_cast<const char*>(c.nu),c.p*sizeof(int));
+			  put_int(cs[k],c.p);break;
+		case 'm': put_double(k,0.25*c.max_radius_squared());break;
+
+		// Edge-related output
+		case 'g': put_int(k,c.number_of_edges());break;
+		case 'E': put_double(k,c.total_edge_distance());break;
+		case 'e': put_list(k,g.face_perimeters,1);break;
+
+		// Face-related output
+		case 's': put_int(k,g.number_of_faces);break;
+		case 'F': put_double(k,g.surface_area);break;
+		case 'A': put_list(k,g.face_freq_table,1);break;
+		case 'a': put_list(k,g.face_orders,1);break;
+		case 'f': put_list(k,g.face_areas,1);break;
+		case 't': put_list(k,g.face_vertices,1);break;
+		case 'l': put_list(k,g.normals,3);break;
+		case 'n': c.neighbors(vn);put_list(k,vn,1);break;
+
+		// Volume-related output
+		case 'v': put_double(k,g.volume);break;
+		case 'c': put_double(k,g.cx);put_double(k,g.cy);put_double(k,g.cz);break;
+		case 'C': put_double(k,x+g.cx);put_double(k,y+g.cy);put_double(k,z+g.cz);
+	}
+	n++;
+}
+
+/** Records the current positions in the staged streams, and the number of
+ * cells written.
+ * \param[out] o an array in which to store the marks(), which must have
+ *               space for marks() values. */
+void custom_columns::mark(long *o) {
+	for(int s=0;s<n_str;s++) o[s]=ob[s]->tell();
+	o[n_str]=n;
+}
+
+/** Writes all of the cells written by this instance to a file in the columnar
+ * binary format.
+ * \param[in] fp the file handle to write to. */
+void custom_columns::output(FILE *fp) {
+	int m=marks(),t=0;
+	long *so=new long[2*m];
+	custom_columns *cc=this;
+	for(int s=0;s<m;s++) so[s]=0;
+	mark(so+m);
+	assemble(&cc,1,1,&t,so,fp);
+	delete [] so;
+}
+
+/** Writes zeros to a file so that its position is a multiple of eight bytes.
+ * \param[in] fp the file handle to write to.
+ * \param[in,out] pos the position in the file, which is updated. */
+void custom_columns::pad(FILE *fp,long &pos) {
+	static const char z[8]={0,0,0,0,0,0,0,0};
+	int k=(8-pos%8)%8;
+	fwrite(z,1,k,fp);pos+=k;
+}
+
+/** Combines the columns written by several instances into a file in the
+ * columnar binary format. The output is made up of a sequence of segments,
+ * each of which is a range of cells written by one instance, as delimited by
+ * two calls to the mark routine.
+ * \param[in] cc an array of the instances, all made from the same custom
+ *               output string.
+ * \param[in] nt the number of instances.
+ * \param[in] ns the number of segments.
+ * \param[in] sth the instance that wrote each segment.
+ * \param[in] so an array of the marks at the start and end of each segment,
+ *               with the 2k and 2k+1 groups of marks() values corresponding
+ *               to the start and end of segment k.
+ * \param[in] fp the file handle to write to. */
+void custom_columns::assemble(custom_columns **cc,int nt,int ns,const int *sth,const long *so,FILE *fp) {
+	custom_columns &c0=**cc;
+	const int m=c0.marks(),bs=1024;
+	int j,k,s,l,q,n=0,width,cb[bs];
+	long pos,o,*sz=new long[c0.n_str];
+	const long *sp;
+	bool var;
+	column_file_header h;
+	column_file_entry *ce=new column_file_entry[c0.n_col];
+	FILE *tf;
+
+	// Write out the buffers of all of the instances, and find the total
+	// number of cells and the total size of each stream
+	for(j=0;j<nt;j++) for(s=0;s<c0.n_str;s++) cc[j]->ob[s]->flush();
+	for(s=0;s<c0.n_str;s++) sz[s]=0;
+	for(j=0;j<ns;j++) {
+		sp=so+2*m*j;
+		for(s=0;s<c0.n_str;s++) sz[s]+=sp[m+s]-sp[s];
+		n+=sp[m+c0.n_str]-sp[c0.n_str];
+	}
+
+	// Set up the header and the column descriptions
+	memcpy(h.magic,"VORO++CB",8);
+	h.version=cf_version;h.n_col=c0.n_col;h.n=n;h.offset_size=sizeof(long);
+	pos=sizeof(column_file_header)+c0.n_col*sizeof(column_file_entry);
+	for(k=0;k<c0.n_col;k++) {
+		column_file_entry &e=ce[k];
+		column_type(c0.code[k],e.type,var,width);
+		e.code=c0.code[k];e.var=var?1:0;e.pad=0;e.width=width;
+		pos+=(8-pos%8)%8;
+		e.data=pos;pos+=sz[k];
+		e.count=var?sz[k]/((e.type=='i'?sizeof(int):sizeof(double))*width):n;
+		pos+=(8-pos%8)%8;
+		if(var) {e.index=pos;pos+=(n+1)*sizeof(long);}
+		else e.index=0;
+	}
+	fwrite(&h,sizeof(column_file_header),1,fp);
+	fwrite(ce,sizeof(column_file_entry),c0.n_col,fp);
+
+	// Write the values of each column, copying the segments in order,
+	// followed by the index array of each variable-length column
+	pos=sizeof(column_file_header)+c0.n_col*sizeof(column_file_entry);
+	for(k=0;k<c0.n_col;k++) {
+		pad(fp,pos);
+		for(j=0;j<ns;j++) {
+			sp=so+2*m*j;
+			voro_copy_stream(cc[sth[j]]->tf[k],sp[k],sp[m+k],fp);
+		}
+		pos+=sz[k];
+		if(ce[k].var) {
+			pad(fp,pos);
+			o=0;fwrite(&o,sizeof(long),1,fp);
+			s=c0.cs[k];
+			for(j=0;j<ns;j++) {
+				sp=so+2*m*j;
+				tf=cc[sth[j]]->tf[s];
+				fseek(tf,sp[s],SEEK_SET);
+				for(l=(sp[m+s]-sp[s])/sizeof(int);l>0;l-=q) {
+					q=l<bs?l:bs;
+					if(fread(cb,sizeof(int),q,tf)!=static_cast<size_t>(q))
+						voro_fatal_error("Error reading temporary file",VOROPP_FILE_ERROR);
+					for(int *cp=cb;cp<cb+q;cp++) {
+						o+=*cp;
+						fwrite(&o,sizeof(long),1,fp);
+					}
+				}
+			}
+			pos+=(n+1)*sizeof(long);
+		}
+	}
+	delete [] ce;
+	delete [] sz;
+}
+
+}
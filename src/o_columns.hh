@@ -0,0 +1,155 @@
+// Voro++, a 3D cell-based Voronoi library
+//
+// Author   : Chris H. Rycroft (LBL / UC Berkeley)
+// Email    : chr@alum.mit.edu
+// Date     : August 30th 2011
+
+/** \file o_columns.hh
+ * \brief Header file for the custom_columns class, which writes custom
+ * information about Voronoi cells in a columnar binary format. */
+
+#ifndef VOROPP_O_COLUMNS_HH
+#define VOROPP_O_COLUMNS_HH
+
+#include <cstdio>
+#include <vector>
+
+#include "config.hh"
+#include "common.hh"
+#include "cell.hh"
+#include "o_custom.hh"
+
+namespace voro {
+
+/** The version number of the columnar binary format. */
+const int cf_version=1;
+
+/** \brief The header of a columnar binary file.
+ *
+ * A columnar binary file consists of this header, followed by a
+ * column_file_entry for each column, followed by the column data. Each
+ * column's values, and each column's index array, start at a multiple of eight
+ * bytes from the start of the file, so that the file can be memory-mapped and
+ * the columns used directly as arrays. All values are stored in the native
+ * byte order of the machine. */
+struct column_file_header {
+	/** The characters "VORO++CB", identifying the format. */
+	char magic[8];
+	/** The version of the format, which is also used to detect files
+	 * written with a different byte order. */
+	int version;
+	/** The number of columns. */
+	int n_col;
+	/** The number of Voronoi cells, which is the number of rows. */
+	int n;
+	/** The size in bytes of the file positions and index entries, which is
+	 * the size of a long. */
+	int offset_size;
+};
+
+/** \brief A description of a column in a columnar binary file.
+ *
+ * Each column holds one of the quantities that can be requested in a custom
+ * output string. A fixed-width column holds width values for each cell. A
+ * variable-length column holds a list of entries for each cell, each made up
+ * of width values, together with an index array of n+1 entry offsets, so that
+ * the entries for cell k are those from index[k] up to, but not including,
+ * index[k+1]. */
+struct column_file_entry {
+	/** The control character from the custom output string. */
+	char code;
+	/** The type of the values, which is 'i' for four-byte ints and 'd'
+	 * for eight-byte doubles. */
+	char type;
+	/** Whether the column has a variable length. */
+	char var;
+	/** Padding, which is set to zero. */
+	char pad;
+	/** The number of values in each entry. */
+	int width;
+	/** The position in the file of the values. */
+	long data;
+	/** The position in the file of the index array, or zero for a
+	 * fixed-width column. */
+	long index;
+	/** The total number of entries in the column. */
+	long count;
+};
+
+/** \brief A class for writing custom information about Voronoi cells in a
+ * columnar binary format.
+ *
+ * This class takes a custom output string, as used by the print_custom
+ * routines, and writes one binary column for each distinct control sequence
+ * in it, ignoring any other text. The vertex, face, and neighbor lists are
+ * stored in variable-length columns. The face vertex list for %t is stored as
+ * the same sequence of integers that is printed in text form, with each face
+ * given by its number of vertices followed by the vertex indices.
+ *
+ * Since the number of cells is not known until all of them have been
+ * computed, each column is staged in a temporary file. Several instances can
+ * be used by different threads, and the mark routine records the positions in
+ * the staged columns, so that the assemble routine can then combine the
+ * output for a sequence of segments, written by any of the instances, into a
+ * single file. */
+class custom_columns {
+	public:
+		/** Whether the custom output string requires neighbor
+		 * information, meaning that it contains "%n". */
+		bool neighbor;
+		/** The number of columns. */
+		int n_col;
+		/** The number of Voronoi cells written. */
+		int n;
+		custom_columns(const char *format);
+		~custom_columns();
+		void write(voronoicell_base &c,int i,double x,double y,double z,double r);
+		void mark(long *o);
+		/** Returns the number of values that the mark routine
+		 * records.
+		 * \return The number of values. */
+		inline int marks() {return n_str+1;}
+		void output(FILE *fp);
+		static void assemble(custom_columns **cc,int nt,int ns,const int *sth,const long *so,FILE *fp);
+	private:
+		/** The control characters of the columns. */
+		char *code;
+		/** The number of staged streams, which is one for each column
+		 * plus an additional one holding the number of entries for
+		 * each cell in each variable-length column. */
+		int n_str;
+		/** The stream index holding the number of entries for each
+		 * variable-length column, or -1 for fixed-width columns. */
+		int *cs;
+		/** The temporary files that the streams are staged in. */
+		FILE **tf;
+		/** The output buffers for the streams. */
+		output_buffer **ob;
+		/** A bitwise or of the cell_geometry_flag values for the
+		 * quantities that the columns require. */
+		unsigned int gmask;
+		/** The geometric quantities of the current cell. */
+		cell_geometry g;
+		/** A vector used to hold the neighbors. */
+		std::vector<int> vn;
+		/** Adds an integer to a stream.
+		 * \param[in] s the stream.
+		 * \param[in] v the integer. */
+		inline void put_int(int s,int v) {
+			ob[s]->put(reinterpret_cast<const char*>(&v),sizeof(int));
+		}
+		/** Adds a floating point number to a stream.
+		 * \param[in] s the stream.
+		 * \param[in] v the number. */
+		inline void put_double(int s,double v) {
+			ob[s]->put(reinterpret_cast<const char*>(&v),sizeof(double));
+		}
+		void put_list(int k,std::vector<int> &v,int m);
+		void put_list(int k,std::vector<double> &v,int m);
+		static void column_type(char code,char &type,bool &var,int &width);
+		static void pad(FILE *fp,long &pos);
+};
+
+}
+
+#endif
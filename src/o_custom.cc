@@ -0,0 +1,339 @@
+// Voro++, a 3D cell-based Voronoi library
+//
+// Author   : Chris H. Rycroft (LBL / UC Berkeley)
+// Email    : chr@alum.mit.edu
+// Date     : August 30th 2011
+
+/** \file o_custom.cc
+ * \brief Function implementations for the output_buffer and custom_format
+ * classes. */
+
+#include <cmath>
+#include <cstring>
+
+#include "o_custom.hh"
+
+namespace voro {
+
+/** The class constructor allocates the buffer.
+ * \param[in] fp_ the file handle to write to.
+ * \param[in] size_ the size of the buffer, which must be at least 64. */
+output_buffer::output_buffer(FILE *fp_,int size_) : fp(fp_), size(size_),
+	buf(new char[size]), bp(buf), be(buf+size), off(0) {}
+
+/** The class destructor writes out any remaining characters and frees the
+ * buffer. */
+output_buffer::~output_buffer() {
+	flush();
+	delete [] buf;
+}
+
+/** Writes the contents of the buffer to the file. */
+void output_buffer::flush() {
+	if(bp>buf) {
+		fwrite(buf,1,bp-buf,fp);
+		off+=bp-buf;bp=buf;
+	}
+}
+
+/** Adds a string of characters to the buffer.
+ * \param[in] s a pointer to the characters.
+ * \param[in] n the number of characters. */
+void output_buffer::put(const char *s,int n) {
+	while(be-bp<n) {
+		int k=be-bp;
+		memcpy(bp,s,k);bp=be;
+		s+=k;n-=k;flush();
+	}
+	memcpy(bp,s,n);bp+=n;
+}
+
+/** Adds the decimal digits of a non-negative integer to the buffer, assuming
+ * that there is space for them.
+ * \param[in] u the integer. */
+void output_buffer::put_int_digits(unsigned int u) {
+	char d[10],*dp=d;
+	do {*(dp++)='0'+u%10;u/=10;} while(u>0);
+	while(dp>d) *(bp++)=*(--dp);
+}
+
+/** Adds an integer to the buffer, in the same format as the %d conversion of
+ * printf.
+ * \param[in] i the integer. */
+void output_buffer::put_int(int i) {
+	reserve(16);
+	if(i<0) {
+		*(bp++)='-';
+		put_int_digits(0u-static_cast<unsigned int>(i));
+	} else put_int_digits(i);
+}
+
+/** Adds a floating point number to the buffer, in the same format as the %g
+ * conversion of printf. The number is scaled by a power of ten so that its six
+ * significant digits form the integer part, and this is rounded. The power of
+ * ten is exactly representable and the scaling introduces a single rounding
+ * error, which can only change the result if the fractional part is very close
+ * to one half. In that case, and for numbers that are zero, very small, very
+ * large, or not finite, the routine uses sprintf.
+ * \param[in] v the number. */
+void output_buffer::put_double(double v) {
+	static const double p10[23]={1e0,1e1,1e2,1e3,1e4,1e5,1e6,1e7,1e8,1e9,1e10,
+		1e11,1e12,1e13,1e14,1e15,1e16,1e17,1e18,1e19,1e20,1e21,1e22};
+	double a=v<0?-v:v,m,fl;
+	reserve(32);
+	if(a>=1e-16&&a<1e26) {
+		int e=static_cast<int>(floor(log10(a))),k=5-e,nd=6,i;
+		m=k>=0?a*p10[k]:a/p10[-k];
+		if(m<1e5) {k++;e--;m=k>=0?a*p10[k]:a/p10[-k];}
+		else if(m>=1e6) {k--;e++;m=k>=0?a*p10[k]:a/p10[-k];}
+		fl=floor(m);
+		if(fabs(m-fl-0.5)>1e-8) {
+			unsigned int d=static_cast<unsigned int>(fl)+(m-fl>0.5?1:0);
+			char s[6];
+			if(d==1000000) {d=100000;e++;}
+
+			// Find the significant digits, removing trailing zeros
+			while(d%10==0) {d/=10;nd--;}
+			for(i=nd-1;i>=0;i--) {s[i]='0'+d%10;d/=10;}
+			if(v<0) *(bp++)='-';
+			if(e<-4||e>=6) {
+
+				// Use scientific notation
+				*(bp++)=*s;
+				if(nd>1) {
+					*(bp++)='.';
+					for(i=1;i<nd;i++) *(bp++)=s[i];
+				}
+				*(bp++)='e';
+				if(e<0) {*(bp++)='-';e=-e;} else *(bp++)='+';
+				if(e<10) *(bp++)='0';
+				put_int_digits(e);
+			} else if(e>=0) {
+
+				// Use fixed notation for a number that is at
+				// least one
+				for(i=0;i<=e;i++) *(bp++)=i<nd?s[i]:'0';
+				if(nd>e+1) {
+					*(bp++)='.';
+					for(;i<nd;i++) *(bp++)=s[i];
+				}
+			} else {
+
+				// Use fixed notation for a number that is
+				// less than one
+				*(bp++)='0';*(bp++)='.';
+				for(i=-1;i>e;i--) *(bp++)='0';
+				for(i=0;i<nd;i++) *(bp++)=s[i];
+			}
+			return;
+		}
+	}
+	bp+=sprintf(bp,"%g",v);
+}
+
+/** Adds a vector of integers to the buffer, separated by spaces.
+ * \param[in] v the vector. */
+void output_buffer::put_vector(std::vector<int> &v) {
+	for(unsigned int k=0;k<v.size();k++) {
+		if(k>0) put(' ');
+		put_int(v[k]);
+	}
+}
+
+/** Adds a vector of floating point numbers to the buffer, separated by spaces.
+ * \param[in] v the vector. */
+void output_buffer::put_vector(std::vector<double> &v) {
+	for(unsigned int k=0;k<v.size();k++) {
+		if(k>0) put(' ');
+		put_double(v[k]);
+	}
+}
+
+/** Adds a vector of positions to the buffer as bracketed triplets, in the same
+ * format as voro_print_positions.
+ * \param[in] v the vector. */
+void output_buffer::put_positions(std::vector<double> &v) {
+	for(unsigned int k=0;k<v.size();k+=3) {
+		if(k>0) put(' ');
+		put('(');put_double(v[k]);
+		put(',');put_double(v[k+1]);
+		put(',');put_double(v[k+2]);
+		put(')');
+	}
+}
+
+/** Adds a vector of face vertex information to the buffer as bracketed lists,
+ * in the same format as voro_print_face_vertices.
+ * \param[in] v the vector. */
+void output_buffer::put_face_vertices(std::vector<int> &v) {
+	unsigned int j,k=0;
+	while(k<v.size()) {
+		if(k>0) put(' ');
+		put('(');
+		for(j=k+1+v[k],k++;k<j;k++) {
+			put_int(v[k]);
+			if(k+1<j) put(',');
+		}
+		put(')');
+	}
+}
+
+/** The class constructor translates a custom output format string into a list
+ * of instructions.
+ * \param[in] format the custom output format string. */
+custom_format::custom_format(const char *format) : neighbor(false), n_op(0),
+	op(new int[strlen(format)+1]), lit(new char[strlen(format)+1]),
+	ls(new int[strlen(format)+2]), gmask(0) {
+	const char *fmp=format;
+	int nl=0,ll=0;
+	*ls=0;
+	while(*fmp!=0) {
+		if(*fmp=='%') {
+			fmp++;
+			switch(*fmp) {
+				case 'i': case 'x': case 'y': case 'z': case 'q':
+				case 'r': case 'w': case 'p': case 'P': case 'o':
+				case 'm': case 'g': case 'E': case 'e': case 's':
+				case 'F': case 'A': case 'a': case 'f': case 't':
+				case 'l': case 'n': case 'v': case 'c': case 'C':
+
+					// Close the current literal string,
+					// and add the control character
+					if(ll>ls[nl]) {op[n_op++]=-1-nl;ls[++nl]=ll;}
+					op[n_op++]=*fmp;
+					if(*fmp=='n') neighbor=true;
+					gmask|=geometry_flag(*fmp);
+					break;
+
+				// End-of-string reached
+				case 0: fmp--;break;
+
+				// The percent sign is not part of a control
+				// sequence
+				default: lit[ll++]='%';lit[ll++]=*fmp;
+			}
+		} else lit[ll++]=*fmp;
+		fmp++;
+	}
+	lit[ll++]='\n';
+	op[n_op++]=-1-nl;ls[++nl]=ll;
+}
+
+/** The class destructor frees the dynamically allocated memory. */
+custom_format::~custom_format() {
+	delete [] ls;
+	delete [] lit;
+	delete [] op;
+}
+
+/** Finds the geometric quantity that is required by a control character of a
+ * custom output string.
+ * \param[in] code the control character.
+ * \return The cell_geometry_flag value for the quantity, or zero if the
+ *         control character does not require one. */
+unsigned int custom_format::geometry_flag(int code) {
+	switch(code) {
+		case 'v': return geom_volume;
+		case 'F': return geom_surface_area;
+		case 'c': case 'C': return geom_centroid;
+		case 's': return geom_number_of_faces;
+		case 'f': return geom_face_areas;
+		case 'e': return geom_face_perimeters;
+		case 'a': return geom_face_orders;
+		case 'A': return geom_face_freq_table;
+		case 't': return geom_face_vertices;
+		case 'l': return geom_normals;
+	}
+	return 0;
+}
+
+/** Writes the vertices of a Voronoi cell to an output buffer as bracketed
+ * triplets, using the local coordinate system.
+ * \param[in] c the Voronoi cell.
+ * \param[in] ob the output buffer to write to. */
+void custom_format::put_vertices(voronoicell_base &c,output_buffer &ob) {
+	for(double *ptsp=c.pts;ptsp<c.pts+(c.p<<2);ptsp+=4) {
+		if(ptsp>c.pts) ob.put(' ');
+		ob.put('(');ob.put_double(*ptsp*0.5);
+		ob.put(',');ob.put_double(ptsp[1]*0.5);
+		ob.put(',');ob.put_double(ptsp[2]*0.5);
+		ob.put(')');
+	}
+}
+
+/** Writes the vertices of a Voronoi cell to an output buffer as bracketed
+ * triplets, using the global coordinate system.
+ * \param[in] c the Voronoi cell.
+ * \param[in] (x,y,z) the position of the particle associated with the cell.
+ * \param[in] ob the output buffer to write to. */
+void custom_format::put_vertices(voronoicell_base &c,double x,double y,double z,output_buffer &ob) {
+	for(double *ptsp=c.pts;ptsp<c.pts+(c.p<<2);ptsp+=4) {
+		if(ptsp>c.pts) ob.put(' ');
+		ob.put('(');ob.put_double(x+*ptsp*0.5);
+		ob.put(',');ob.put_double(y+ptsp[1]*0.5);
+		ob.put(',');ob.put_double(z+ptsp[2]*0.5);
+		ob.put(')');
+	}
+}
+
+/** Writes custom information about a Voronoi cell to an output buffer,
+ * following the compiled format string and ending with a newline.
+ * \param[in] c the Voronoi cell.
+ * \param[in] i the ID of the particle associated with the cell.
+ * \param[in] (x,y,z) the position of the particle associated with the cell.
+ * \param[in] r a radius associated with the particle.
+ * \param[in] ob the output buffer to write to. */
+void custom_format::write(voronoicell_base &c,int i,double x,double y,double z,double r,output_buffer &ob) {
+	if(gmask) c.geometry(gmask,g);
+	for(int *opp=op;opp<op+n_op;opp++) switch(*opp) {
+
+		// Particle-related output
+		case 'i': ob.put_int(i);break;
+		case 'x': ob.put_double(x);break;
+		case 'y': ob.put_double(y);break;
+		case 'z': ob.put_double(z);break;
+		case 'q': ob.put_double(x);ob.put(' ');
+			  ob.put_double(y);ob.put(' ');
+			  ob.put_double(z);break;
+		case 'r': ob.put_double(r);break;
+
+		// Vertex-related output
+		case 'w': ob.put_int(c.p);break;
+		case 'p': put_vertices(c,ob);break;
+		case 'P': put_vertices(c,x,y,z,ob);break;
+		case 'o': for(int *nup=c.nu;nup<c.nu+c.p;nup++) {
+				  if(nup>c.nu) ob.put(' ');
+				  ob.put_int(*nup);
+			  } break;
+		case 'm': ob.put_double(0.25*c.max_radius_squared());break;
+
+		// Edge-related output
+		case 'g': ob.put_int(c.number_of_edges());break;
+		case 'E': ob.put_double(c.total_edge_distance());break;
+		case 'e': ob.put_vector(g.face_perimeters);break;
+
+		// Face-related output
+		case 's': ob.put_int(g.number_of_faces);break;
+		case 'F': ob.put_double(g.surface_area);break;
+		case 'A': ob.put_vector(g.face_freq_table);break;
+		case 'a': ob.put_vector(g.face_orders);break;
+		case 'f': ob.put_vector(g.face_areas);break;
+		case 't': ob.put_face_vertices(g.face_vertices);break;
+		case 'l': ob.put_positions(g.normals);break;
+		case 'n': c.neighbors(vn);ob.put_vector(vn);break;
+
+		// Volume-related output
+		case 'v': ob.put_double(g.volume);break;
+		case 'c': ob.put_double(g.cx);ob.put(' ');
+			  ob.put_double(g.cy);ob.put(' ');
+			  ob.put_double(g.cz);break;
+		case 'C': ob.put_double(x+g.cx);ob.put(' ');
+			  ob.put_double(y+g.cy);ob.put(' ');
+			  ob.put_double(z+g.cz);break;
+
+		// Literal strings
+		default: ob.put(lit+ls[-1-*opp],ls[-*opp]-ls[-1-*opp]);
+	}
+}
+
+}
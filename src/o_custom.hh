@@ -0,0 +1,119 @@
+// Voro++, a 3D cell-based Voronoi library
+//
+// Author   : Chris H. Rycroft (LBL / UC Berkeley)
+// Email    : chr@alum.mit.edu
+// Date     : August 30th 2011
+
+/** \file o_custom.hh
+ * \brief Header file for the output_buffer and custom_format classes, which
+ * write custom information about Voronoi cells. */
+
+#ifndef VOROPP_O_CUSTOM_HH
+#define VOROPP_O_CUSTOM_HH
+
+#include <cstdio>
+#include <vector>
+
+#include "config.hh"
+#include "common.hh"
+#include "cell.hh"
+
+namespace voro {
+
+/** \brief A class for buffering text output to a file.
+ *
+ * This class collects text in a fixed-size memory buffer, which is written to
+ * a file in a single call when it is full, or when the class is destroyed.
+ * Integers and floating point numbers are formatted directly into the buffer,
+ * giving the same characters as the %d and %g conversions of printf. */
+class output_buffer {
+	public:
+		output_buffer(FILE *fp_,int size_=output_buffer_size);
+		~output_buffer();
+		/** Ensures that there is space in the buffer for a given
+		 * number of characters, writing out the buffer if necessary.
+		 * \param[in] n the number of characters. */
+		inline void reserve(int n) {
+			if(be-bp<n) flush();
+		}
+		/** Adds a character to the buffer.
+		 * \param[in] c the character. */
+		inline void put(char c) {
+			reserve(1);*(bp++)=c;
+		}
+		void put(const char *s,int n);
+		void put_int(int i);
+		void put_double(double v);
+		void put_vector(std::vector<int> &v);
+		void put_vector(std::vector<double> &v);
+		void put_positions(std::vector<double> &v);
+		void put_face_vertices(std::vector<int> &v);
+		/** Returns the position in the output stream that the next
+		 * character will be written to, counting from where the
+		 * stream was when the class was constructed.
+		 * \return The position. */
+		inline long tell() {return off+(bp-buf);}
+		void flush();
+	private:
+		/** The file handle to write to. */
+		FILE *fp;
+		/** The size of the buffer. */
+		const int size;
+		/** The buffer. */
+		char *buf;
+		/** A pointer to the next free character in the buffer. */
+		char *bp;
+		/** A pointer to the end of the buffer. */
+		char *be;
+		/** The number of characters that have been written out. */
+		long off;
+		void put_int_digits(unsigned int u);
+};
+
+/** \brief A class holding a compiled custom output format string.
+ *
+ * This class translates a custom output format string, as described at
+ * http://math.lbl.gov/voro++/doc/custom.html, into a list of instructions
+ * once, so that the string does not need to be scanned again for each
+ * Voronoi cell. When writing a cell, all of the face-based quantities that the
+ * format requires are computed together by the geometry routine of the cell,
+ * in a single traversal of its faces, and the vectors used to hold face
+ * information are kept between cells, so that no memory is allocated once
+ * they have grown to a sufficient size. Since these vectors are modified while
+ * writing, each thread should use its own instance. */
+class custom_format {
+	public:
+		/** Whether the format string requires neighbor information,
+		 * meaning that it contains "%n". */
+		bool neighbor;
+		custom_format(const char *format);
+		~custom_format();
+		void write(voronoicell_base &c,int i,double x,double y,double z,double r,output_buffer &ob);
+		static unsigned int geometry_flag(int code);
+	private:
+		/** The number of instructions. */
+		int n_op;
+		/** The instructions. Each entry is either a control character
+		 * from the format string, or a negative number -1-k to write
+		 * the kth literal string. */
+		int *op;
+		/** The literal strings that appear between the control
+		 * sequences, stored one after another. */
+		char *lit;
+		/** The starting position of each literal string in lit, with
+		 * an extra entry at the end holding the total length. */
+		int *ls;
+		/** A bitwise or of the cell_geometry_flag values for the
+		 * quantities that the format string requires. */
+		unsigned int gmask;
+		/** The geometric quantities of the current cell. */
+		cell_geometry g;
+		/** A vector holding the neighbors. */
+		std::vector<int> vn;
+		void put_vertices(voronoicell_base &c,output_buffer &ob);
+		void put_vertices(voronoicell_base &c,double x,double y,double z,output_buffer &ob);
+};
+
+}
+
+#endif
@@ -0,0 +1,150 @@
+// Voro++, a 3D cell-based Voronoi library
+//
+// Author   : Chris H. Rycroft (LBL / UC Berkeley)
+// Email    : chr@alum.mit.edu
+// Date     : August 30th 2011
+
+/** \file o_graph.cc
+ * \brief Function implementations for the neighbor_graph class. */
+
+#include "o_graph.hh"
+
+namespace voro {
+
+/** Prepares the graph to receive the neighbors of the cells computed for a
+ * block_scheduler, discarding anything previously stored.
+ * \param[in] nt_ the number of threads that will add cells.
+ * \param[in] nc the number of chunks in the scheduler. */
+void neighbor_graph::setup(int nt_,int nc) {
+	nt=nt_;n=0;
+	off.clear();adj.clear();weight.clear();
+	ce.assign(nc,std::vector<int>());
+	cw.assign(weights?nc:0,std::vector<double>());
+	tn.resize(nt);ta.resize(nt);
+}
+
+/** Records the neighbors of a computed Voronoi cell. If the cell has several
+ * faces in common with the same neighbor, which can happen in small periodic
+ * systems, then the neighbor is recorded once with the total area of the
+ * faces. If weights are stored, then the face areas are used as the weights.
+ * Walls, and faces that the cell shares with its own periodic image, are
+ * skipped.
+ * \param[in] t the thread number.
+ * \param[in] ch the chunk that the cell belongs to.
+ * \param[in] i the ID of the particle.
+ * \param[in] c the computed Voronoi cell. */
+void neighbor_graph::add(int t,int ch,int i,voronoicell_neighbor &c) {
+	c.neighbors(tn[t]);
+	if(weights) c.face_areas(ta[t]);
+	add(ch,i,tn[t],ta[t]);
+}
+
+/** Records a list of neighbors of a particle, along with a value for each
+ * one that is stored as its weight if weights are stored.
+ * Repeated neighbors are recorded once, with the sum of their values, and
+ * negative IDs and the particle's own ID are skipped.
+ * \param[in] ch the chunk that the particle belongs to.
+ * \param[in] i the ID of the particle.
+ * \param[in,out] v the IDs of the neighbors, which are sorted.
+ * \param[in,out] a the values for the neighbors, which are sorted along with
+ *                  the IDs. */
+void neighbor_graph::add(int ch,int i,std::vector<int> &v,std::vector<double> &a) {
+	std::vector<int> &e=ce[ch];
+	int j,k,l,s=static_cast<int>(v.size());
+	double b=0;
+
+	// Sort the neighbors, using an insertion sort since the lists are
+	// short
+	for(k=1;k<s;k++) {
+		j=v[k];if(weights) b=a[k];
+		for(l=k;l>0&&v[l-1]>j;l--) {
+			v[l]=v[l-1];
+			if(weights) a[l]=a[l-1];
+		}
+		v[l]=j;if(weights) a[l]=b;
+	}
+
+	// Record each neighbor once, merging repeated entries
+	for(k=0;k<s;k=l) {
+		j=v[k];
+		for(l=k+1;l<s&&v[l]==j;l++) if(weights) a[k]+=a[l];
+		if(j<0||j==i) continue;
+		e.push_back(i);e.push_back(j);
+		if(weights) cw[ch].push_back(a[k]);
+	}
+}
+
+/** Combines the neighbors recorded for all of the chunks into the compressed
+ * sparse row arrays. Each recorded pair is entered into the rows of both
+ * particles, so that the graph is symmetric even if only one of the two cells
+ * found the shared face, and the two entries for each pair are then merged.
+ * The rows are sorted and merged in parallel. */
+void neighbor_graph::assemble() {
+	int ch,i,j,k,l,nc=static_cast<int>(ce.size());
+	unsigned int q;
+
+	// Find the number of rows, and count the entries in each row
+	for(ch=0;ch<nc;ch++) for(q=0;q<ce[ch].size();q++)
+		if(ce[ch][q]>=n) n=ce[ch][q]+1;
+	off.assign(n+1,0);
+	for(ch=0;ch<nc;ch++) for(q=0;q<ce[ch].size();q+=2) {
+		off[ce[ch][q]+1]++;off[ce[ch][q+1]+1]++;
+	}
+	for(i=0;i<n;i++) off[i+1]+=off[i];
+
+	// Scatter the entries into the rows in chunk order
+	std::vector<int> ps(off.begin(),off.end()-1),tc(off[n]),deg(n);
+	std::vector<double> tv(weights?off[n]:0);
+	for(ch=0;ch<nc;ch++) {
+		for(q=0;q<ce[ch].size();q+=2) {
+			i=ce[ch][q];j=ce[ch][q+1];
+			tc[ps[i]]=j;tc[ps[j]]=i;
+			if(weights) tv[ps[i]]=tv[ps[j]]=cw[ch][q>>1];
+			ps[i]++;ps[j]++;
+		}
+		std::vector<int>().swap(ce[ch]);
+		if(weights) std::vector<double>().swap(cw[ch]);
+	}
+
+	// Sort each row and merge the two entries for each pair, averaging
+	// their weights
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(nt) private(j,k,l)
+#endif
+	for(i=0;i<n;i++) {
+		int *cp=&tc[0]+off[i],s=off[i+1]-off[i],m=0;
+		double b=0,*vp=weights?&tv[0]+off[i]:NULL;
+		for(k=1;k<s;k++) {
+			j=cp[k];if(weights) b=vp[k];
+			for(l=k;l>0&&cp[l-1]>j;l--) {
+				cp[l]=cp[l-1];
+				if(weights) vp[l]=vp[l-1];
+			}
+			cp[l]=j;if(weights) vp[l]=b;
+		}
+		for(k=0;k<s;k=l) {
+			b=weights?vp[k]:0;
+			for(l=k+1;l<s&&cp[l]==cp[k];l++) if(weights) b+=vp[l];
+			cp[m]=cp[k];
+			if(weights) vp[m]=b/(l-k);
+			m++;
+		}
+		deg[i]=m;
+	}
+
+	// Compact the rows into the final arrays
+	for(k=i=0;i<n;i++) {k+=deg[i];deg[i]=k-deg[i];}
+	adj.resize(k);
+	if(weights) weight.resize(k);
+	for(i=0;i<n;i++) {
+		l=i+1<n?deg[i+1]:k;
+		for(j=deg[i];j<l;j++) {
+			adj[j]=tc[off[i]+j-deg[i]];
+			if(weights) weight[j]=tv[off[i]+j-deg[i]];
+		}
+	}
+	for(i=0;i<n;i++) off[i]=deg[i];
+	off[n]=k;
+}
+
+}
@@ -0,0 +1,89 @@
+// Voro++, a 3D cell-based Voronoi library
+//
+// Author   : Chris H. Rycroft (LBL / UC Berkeley)
+// Email    : chr@alum.mit.edu
+// Date     : August 30th 2011
+
+/** \file o_graph.hh
+ * \brief Header file for the neighbor_graph class, which stores the
+ * neighbor graph of a Voronoi tessellation in compressed sparse row form. */
+
+#ifndef VOROPP_O_GRAPH_HH
+#define VOROPP_O_GRAPH_HH
+
+#include <vector>
+
+#include "config.hh"
+#include "cell.hh"
+
+namespace voro {
+
+/** \brief A class for storing the neighbor graph of all the Voronoi cells in a
+ * container.
+ *
+ * The graph is stored in compressed sparse row form, with one row for each
+ * particle ID from zero up to the largest ID in the container. The neighbors
+ * of particle i are the entries of adj from off[i] up to, but not including,
+ * off[i+1], in increasing order. Each row only lists each neighbor once, and
+ * the graph is symmetric, so that if j is listed as a neighbor of i, then i
+ * is listed as a neighbor of j. Walls, which have negative IDs, are not
+ * included. If weights are requested, then a weight is stored alongside each
+ * entry, as the average of the values found from the two cells. The
+ * compute_neighbor_graph routines of the container classes use the area of the
+ * faces shared by the two cells as the weight, while other classes that build
+ * on the graph can pass their own values to the second add routine, such as
+ * the fv_laplacian class, which stores the ratio 2h/A for each pair of cells.
+ *
+ * The container classes fill in the graph with their compute_neighbor_graph
+ * routines. Each thread passes its cells to the add routine, which records
+ * the neighbors in a list for each chunk of a block_scheduler, and the
+ * assemble routine then combines the lists in chunk order, so that the
+ * result does not depend on the number of threads. The particle IDs should
+ * be non-negative, since they are used to index the rows. */
+class neighbor_graph {
+	public:
+		/** Whether the weights are stored. */
+		const bool weights;
+		/** The number of rows, which is one more than the largest
+		 * particle ID. */
+		int n;
+		/** The row offsets, which has n+1 entries. */
+		std::vector<int> off;
+		/** The neighbor IDs of each row. */
+		std::vector<int> adj;
+		/** The weight of each entry, if weights are stored, which is
+		 * the area of the shared faces for a graph filled in by the
+		 * container classes. */
+		std::vector<double> weight;
+		/** The class constructor sets up an empty graph.
+		 * \param[in] weights_ whether to store the weights. */
+		neighbor_graph(bool weights_=false) : weights(weights_), n(0), nt(1) {}
+		void setup(int nt_,int nc);
+		void add(int t,int ch,int i,voronoicell_neighbor &c);
+		void add(int ch,int i,std::vector<int> &v,std::vector<double> &a);
+		void assemble();
+		/** Returns the number of neighbors of a particle.
+		 * \param[in] i the ID of the particle.
+		 * \return The number of neighbors. */
+		inline int degree(int i) {return i>=0&&i<n?off[i+1]-off[i]:0;}
+		/** Returns the total number of entries in the graph, which is
+		 * twice the number of neighboring pairs.
+		 * \return The number of entries. */
+		inline int entries() {return n>0?off[n]:0;}
+	private:
+		/** The number of threads to use. */
+		int nt;
+		/** The entries recorded for each chunk, as pairs of particle
+		 * IDs. */
+		std::vector<std::vector<int> > ce;
+		/** The weights recorded for each chunk. */
+		std::vector<std::vector<double> > cw;
+		/** The neighbors of the current cell of each thread. */
+		std::vector<std::vector<int> > tn;
+		/** The face areas of the current cell of each thread. */
+		std::vector<std::vector<double> > ta;
+};
+
+}
+
+#endif
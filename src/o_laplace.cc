@@ -0,0 +1,130 @@
+// Voro++, a 3D cell-based Voronoi library
+//
+// Author   : Chris H. Rycroft (LBL / UC Berkeley)
+// Email    : chr@alum.mit.edu
+// Date     : August 30th 2011
+
+/** \file o_laplace.cc
+ * \brief Function implementations for the fv_laplacian class. */
+
+#include "o_laplace.hh"
+
+namespace voro {
+
+/** Prepares the matrix to receive the cells computed for a block_scheduler,
+ * discarding anything previously stored.
+ * \param[in] nt_ the number of threads that will add cells.
+ * \param[in] nc the number of chunks in the scheduler. */
+void fv_laplacian::setup(int nt_,int nc) {
+	nt=nt_;n=0;
+	off.clear();col.clear();val.clear();mass.clear();
+	ng.setup(nt,nc);
+	ci.assign(nc,std::vector<int>());
+	cv.assign(volumes?nc:0,std::vector<double>());
+	tg.resize(nt);tn.resize(nt);tv.resize(nt);tr.resize(nt);
+}
+
+/** Records the faces of a computed Voronoi cell, and its volume if the
+ * volumes are stored. If the cell has several faces in common with the same
+ * neighbor, which can happen in small periodic systems, then their
+ * contributions A/2h are added. Walls, faces that the cell shares with its own
+ * periodic image, and faces of zero area are skipped.
+ * \param[in] t the thread number.
+ * \param[in] ch the chunk that the cell belongs to.
+ * \param[in] i the ID of the particle.
+ * \param[in] c the computed Voronoi cell. */
+void fv_laplacian::add(int t,int ch,int i,voronoicell_neighbor &c) {
+	cell_geometry &g=tg[t];
+	std::vector<int> &v=tn[t];
+	std::vector<double> &q=tv[t],&r=tr[t];
+	int k,l,m,s,*vp;
+	double *q0,*q1,*q2,ux,uy,uz,wx,wy,wz,ax,ay,az,h;
+	c.neighbors(v);
+	c.geometry(geom_face_vertices|(volumes?geom_volume:0),g);
+	c.vertices(q);
+	ci[ch].push_back(i);
+	if(volumes) cv[ch].push_back(g.volume);
+	s=static_cast<int>(v.size());
+	r.resize(s);
+	for(k=l=0;k<s;k++,l+=g.face_vertices[l]+1) {
+		if(v[k]<0||v[k]==i) {v[k]=-1;continue;}
+
+		// Compute twice the vector area of the face by dividing it into
+		// a fan of triangles. This points into the cell, since the
+		// vertices are listed clockwise when viewed from outside. The
+		// area and the normal are both found from it, which remains
+		// accurate for faces that are too small for the normals
+		// routine to handle.
+		vp=&g.face_vertices[l+1];q0=&q[3*vp[0]];ax=ay=az=0;
+		for(m=2;m<g.face_vertices[l];m++) {
+			q1=&q[3*vp[m-1]];q2=&q[3*vp[m]];
+			ux=q1[0]-q0[0];uy=q1[1]-q0[1];uz=q1[2]-q0[2];
+			wx=q2[0]-q0[0];wy=q2[1]-q0[1];wz=q2[2]-q0[2];
+			ax+=uy*wz-uz*wy;ay+=uz*wx-ux*wz;az+=ux*wy-uy*wx;
+		}
+
+		// Find A/2h, where A is the area of the face and h is the
+		// distance from the particle to its plane
+		h=-(ax*q0[0]+ay*q0[1]+az*q0[2]);
+		if(h==0) {v[k]=-1;continue;}
+		r[k]=0.25*(ax*ax+ay*ay+az*az)/h;
+
+		// Combine the face with any earlier face with the same
+		// neighbor
+		for(m=0;m<k;m++) if(v[m]==v[k]) {r[m]+=r[k];v[k]=-1;break;}
+	}
+	for(k=0;k<s;k++) if(v[k]>=0) {
+		if(r[k]==0) v[k]=-1;
+		else r[k]=1/r[k];
+	}
+	ng.add(ch,i,v,r);
+}
+
+/** Combines the faces recorded for all of the chunks into the matrix. The
+ * neighbor graph averages the two values of 2h/A for each pair of
+ * neighbors, and the rows of the matrix are then built from it in
+ * parallel. */
+void fv_laplacian::assemble() {
+	int ch,i;
+	unsigned int q;
+	ng.assemble();
+
+	// Find the number of rows, and store the cell volumes
+	n=ng.n;
+	for(ch=0;ch<static_cast<int>(ci.size());ch++)
+		for(q=0;q<ci[ch].size();q++) if(ci[ch][q]>=n) n=ci[ch][q]+1;
+	if(volumes) {
+		mass.assign(n,0);
+		for(ch=0;ch<static_cast<int>(ci.size());ch++) {
+			for(q=0;q<ci[ch].size();q++) mass[ci[ch][q]]=cv[ch][q];
+			std::vector<double>().swap(cv[ch]);
+		}
+	}
+	for(ch=0;ch<static_cast<int>(ci.size());ch++) std::vector<int>().swap(ci[ch]);
+
+	// Each row has the entries of the neighbor graph plus a diagonal
+	// entry
+	off.resize(n+1);
+	for(i=0;i<=n;i++) off[i]=(i<ng.n?ng.off[i]:ng.entries())+i;
+	col.resize(off[n]);val.resize(off[n]);
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(nt)
+#endif
+	for(i=0;i<n;i++) {
+		int k=off[i],dk=-1,l,le=i<ng.n?ng.off[i+1]:0;
+		double w,sum=0;
+		for(l=i<ng.n?ng.off[i]:0;l<le;l++) {
+			if(dk<0&&ng.adj[l]>i) dk=k++;
+			col[k]=ng.adj[l];
+			w=1/ng.weight[l];
+			val[k++]=w;sum+=w;
+		}
+		if(dk<0) dk=k;
+		col[dk]=i;val[dk]=-sum;
+	}
+	std::vector<int>().swap(ng.off);
+	std::vector<int>().swap(ng.adj);
+	std::vector<double>().swap(ng.weight);
+}
+
+}
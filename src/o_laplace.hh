@@ -0,0 +1,98 @@
+// Voro++, a 3D cell-based Voronoi library
+//
+// Author   : Chris H. Rycroft (LBL / UC Berkeley)
+// Email    : chr@alum.mit.edu
+// Date     : August 30th 2011
+
+/** \file o_laplace.hh
+ * \brief Header file for the fv_laplacian class, which stores the finite
+ * volume Laplacian of a Voronoi tessellation as a sparse matrix. */
+
+#ifndef VOROPP_O_LAPLACE_HH
+#define VOROPP_O_LAPLACE_HH
+
+#include <vector>
+
+#include "config.hh"
+#include "cell.hh"
+#include "o_graph.hh"
+
+namespace voro {
+
+/** \brief A class for storing the finite volume Laplacian of all the Voronoi
+ * cells in a container as a sparse matrix.
+ *
+ * The matrix is stored in compressed sparse row form, with one row for each
+ * particle ID from zero up to the largest ID in the container. The
+ * off-diagonal entry between two neighboring particles i and j is A/d, where A
+ * is the area of the face between their cells and d is the distance between
+ * them, and the diagonal entry is minus the sum of the off-diagonal entries in
+ * the row, so that the faces with walls give a zero flux boundary condition.
+ * The entries of each row, including the diagonal, are in increasing order of
+ * column. If requested, the volumes of the cells are also stored, to be used
+ * as the mass vector.
+ *
+ * The distance between the particles is not needed explicitly. Each cell
+ * records, for each face, the distance h from its particle to the plane of
+ * the face, and the distance between the particles is the sum of the values
+ * of h found by the two cells. This holds for the radical tessellation, and
+ * for neighbors that are periodic images. If only one of the two cells found
+ * the face, then the distance is taken to be twice its value of h.
+ *
+ * The container classes fill in the matrix with their compute_laplacian
+ * routines. Each thread passes its cells to the add routine, which records
+ * the faces in a list for each chunk of a block_scheduler, and the assemble
+ * routine then combines the lists in chunk order, and builds the rows in
+ * parallel, so that the result does not depend on the number of threads. */
+class fv_laplacian {
+	public:
+		/** Whether the cell volumes are stored. */
+		const bool volumes;
+		/** The number of rows, which is one more than the largest
+		 * particle ID. */
+		int n;
+		/** The row offsets, which has n+1 entries. */
+		std::vector<int> off;
+		/** The column of each entry. */
+		std::vector<int> col;
+		/** The value of each entry. */
+		std::vector<double> val;
+		/** The volume of the cell of each particle, if the volumes are
+		 * stored, which is zero for IDs that are not in the
+		 * container. */
+		std::vector<double> mass;
+		/** The class constructor sets up an empty matrix.
+		 * \param[in] volumes_ whether to store the cell volumes. */
+		fv_laplacian(bool volumes_=false) : volumes(volumes_), n(0), nt(1), ng(true) {}
+		void setup(int nt_,int nc);
+		void add(int t,int ch,int i,voronoicell_neighbor &c);
+		void assemble();
+		/** Returns the total number of entries in the matrix,
+		 * including the diagonal.
+		 * \return The number of entries. */
+		inline int entries() {return n>0?off[n]:0;}
+	private:
+		/** The number of threads to use. */
+		int nt;
+		/** The graph in which the neighbors are combined, storing
+		 * the ratio 2h/A for each face as its weight, so that the two
+		 * values for each pair are averaged to give d/A. */
+		neighbor_graph ng;
+		/** The particle IDs of the cells recorded for each chunk. */
+		std::vector<std::vector<int> > ci;
+		/** The volumes of the cells recorded for each chunk. */
+		std::vector<std::vector<double> > cv;
+		/** The geometric quantities of the current cell of each
+		 * thread. */
+		std::vector<cell_geometry> tg;
+		/** The neighbors of the current cell of each thread. */
+		std::vector<std::vector<int> > tn;
+		/** The vertex positions of the current cell of each thread. */
+		std::vector<std::vector<double> > tv;
+		/** The face values of the current cell of each thread. */
+		std::vector<std::vector<double> > tr;
+};
+
+}
+
+#endif
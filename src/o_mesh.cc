@@ -0,0 +1,184 @@
+// Voro++, a 3D cell-based Voronoi library
+//
+// Author   : Chris H. Rycroft (LBL / UC Berkeley)
+// Email    : chr@alum.mit.edu
+// Date     : August 30th 2011
+
+/** \file o_mesh.cc
+ * \brief Function implementations for the face_mesh class. */
+
+#include <cmath>
+
+#include "o_mesh.hh"
+
+namespace voro {
+
+/** Prepares the mesh to receive the faces of the cells computed for a
+ * block_scheduler, discarding anything previously stored.
+ * \param[in] nt the number of threads that will add cells.
+ * \param[in] nc the number of chunks in the scheduler.
+ * \param[in] tol_ the distance within which vertices are taken to be the
+ *                 same. */
+void face_mesh::setup(int nt,int nc,double tol_) {
+	tol=tol_;nv=nf=0;
+	pts.clear();fo.clear();fv.clear();own.clear();
+	area.clear();nor.clear();cen.clear();
+	cp.assign(nc,std::vector<double>());
+	cfo.assign(nc,std::vector<int>());
+	cfv.assign(nc,std::vector<int>());
+	cown.assign(nc,std::vector<int>());
+	cfd.assign(nc,std::vector<double>());
+	tn.resize(nt);tf.resize(nt);tv.resize(nt);
+}
+
+/** Records the faces of a computed Voronoi cell that it owns. These are the
+ * faces with walls, the faces with particles that have a larger ID, and, for
+ * a cell that neighbors its own periodic image, one of each pair of faces
+ * with the image, chosen by the direction of the normal. The faces that belong
+ * to a neighboring cell are skipped before any of their geometry is computed,
+ * so that the area, normal, and centroid of each shared face are only computed
+ * once.
+ * \param[in] t the thread number.
+ * \param[in] ch the chunk that the cell belongs to.
+ * \param[in] i the ID of the particle.
+ * \param[in] (x,y,z) the position of the particle.
+ * \param[in] c the computed Voronoi cell. */
+void face_mesh::add(int t,int ch,int i,double x,double y,double z,voronoicell_neighbor &c) {
+	std::vector<int> &v=tn[t],&f=tf[t],&fvc=cfv[ch];
+	std::vector<double> &q=tv[t],&p=cp[ch],&d=cfd[ch];
+	int j,k,l,m,s,b=-1,*vp;
+	bool hv=false;
+	double n[3],*q0,*q1,*q2,ux,uy,uz,wx,wy,wz,ex,ey,ez,a,at,cx,cy,cz;
+	c.neighbors(v);
+	c.face_vertices(f);
+	for(k=l=0;k<static_cast<int>(v.size());k++,l+=m+1) {
+		m=f[l];j=v[k];
+
+		// Skip faces that belong to the other cell
+		if(j>=0&&j<i) continue;
+
+		// Compute the cell's vertices, the first time that one of its
+		// faces is examined
+		if(!hv) {c.vertices(x,y,z,q);hv=true;}
+
+		// Compute the vector area and the centroid of the face by
+		// dividing it into a fan of triangles. The vector area points
+		// into the cell, since the vertices are listed clockwise when
+		// viewed from outside, so it is reversed to give the normal.
+		vp=&f[l+1];q0=&q[3*vp[0]];*n=n[1]=n[2]=at=cx=cy=cz=0;
+		for(s=2;s<m;s++) {
+			q1=&q[3*vp[s-1]];q2=&q[3*vp[s]];
+			ux=q1[0]-q0[0];uy=q1[1]-q0[1];uz=q1[2]-q0[2];
+			wx=q2[0]-q0[0];wy=q2[1]-q0[1];wz=q2[2]-q0[2];
+			ex=uy*wz-uz*wy;ey=uz*wx-ux*wz;ez=ux*wy-uy*wx;
+			*n-=ex;n[1]-=ey;n[2]-=ez;
+			a=sqrt(ex*ex+ey*ey+ez*ez);
+			at+=a;
+			cx+=a*(q0[0]+q1[0]+q2[0]);
+			cy+=a*(q0[1]+q1[1]+q2[1]);
+			cz+=a*(q0[2]+q1[2]+q2[2]);
+		}
+		a=sqrt(*n**n+n[1]*n[1]+n[2]*n[2]);
+		if(a>0) {*n/=a;n[1]/=a;n[2]/=a;}
+
+		// For a face with the cell's own periodic image, keep only the
+		// one whose normal points in the positive direction of its
+		// largest component
+		if(j==i) {
+			s=fabs(n[0])>fabs(n[1])?0:1;
+			if(fabs(n[2])>fabs(n[s])) s=2;
+			if(n[s]<0) continue;
+		}
+		if(at>0) {at=1/(3*at);cx*=at;cy*=at;cz*=at;}
+		else {
+			for(s=0;s<m;s++) {q1=&q[3*vp[s]];cx+=*q1;cy+=q1[1];cz+=q1[2];}
+			cx/=m;cy/=m;cz/=m;
+		}
+
+		// Record the cell's vertices, the first time that one of its
+		// faces is kept. The face vertices are stored in reverse order,
+		// since the cell lists them clockwise when viewed from
+		// outside.
+		if(b<0) {
+			b=static_cast<int>(p.size()/3);
+			p.insert(p.end(),q.begin(),q.end());
+		}
+		cown[ch].push_back(i);cown[ch].push_back(j);
+		cfo[ch].push_back(m);
+		for(s=m-1;s>=0;s--) fvc.push_back(b+vp[s]);
+		d.push_back(0.5*a);
+		d.push_back(*n);d.push_back(n[1]);d.push_back(n[2]);
+		d.push_back(cx);d.push_back(cy);d.push_back(cz);
+	}
+}
+
+/** Combines the faces recorded for all of the chunks into the mesh, merging
+ * the vertices of different cells that lie within the tolerance of each other.
+ * The vertices are merged in chunk order, so that each one takes the position
+ * from the first face that refers to it. */
+void face_mesh::assemble() {
+	int ch,k,l,m,s,nc=static_cast<int>(cp.size()),tot=0;
+	for(ch=0;ch<nc;ch++) {
+		tot+=static_cast<int>(cp[ch].size()/3);
+		nf+=static_cast<int>(cfo[ch].size());
+	}
+
+	// Set up the spatial hash table with at least twice as many buckets
+	// as there are vertices to merge
+	for(k=1;k<2*tot;k<<=1);
+	hh.assign(k,-1);hn.clear();
+	fo.resize(nf+1);fo[0]=0;
+	own.reserve(2*nf);area.reserve(nf);nor.reserve(3*nf);cen.reserve(3*nf);
+
+	// Add the faces of each chunk, mapping the chunk's vertices onto the
+	// merged vertices as they are first referenced
+	for(l=ch=0;ch<nc;ch++) {
+		std::vector<int> lm(cp[ch].size()/3,-1);
+		std::vector<double> &d=cfd[ch];
+		int *vp=cfv[ch].empty()?NULL:&cfv[ch][0];
+		for(k=0;k<static_cast<int>(cfo[ch].size());k++,l++) {
+			m=cfo[ch][k];
+			for(s=0;s<m;s++,vp++) {
+				if(lm[*vp]<0) lm[*vp]=merge_vertex(&cp[ch][3**vp]);
+				fv.push_back(lm[*vp]);
+			}
+			fo[l+1]=fo[l]+m;
+			own.push_back(cown[ch][2*k]);own.push_back(cown[ch][2*k+1]);
+			area.push_back(d[7*k]);
+			nor.push_back(d[7*k+1]);nor.push_back(d[7*k+2]);nor.push_back(d[7*k+3]);
+			cen.push_back(d[7*k+4]);cen.push_back(d[7*k+5]);cen.push_back(d[7*k+6]);
+		}
+		std::vector<double>().swap(cp[ch]);
+		std::vector<int>().swap(cfo[ch]);
+		std::vector<int>().swap(cfv[ch]);
+		std::vector<int>().swap(cown[ch]);
+		std::vector<double>().swap(cfd[ch]);
+	}
+	std::vector<int>().swap(hh);
+	std::vector<int>().swap(hn);
+}
+
+/** Finds the vertex of the mesh within the tolerance of a given position,
+ * adding a new vertex if there is none. The positions are sorted into a grid
+ * whose spacing is twice the tolerance, so that only the grid cell containing
+ * the position, and the neighboring grid cells on the side of each face that
+ * it is nearest to, need to be searched.
+ * \param[in] p the position.
+ * \return The index of the vertex. */
+int face_mesh::merge_vertex(const double *p) {
+	int di,dj,dk,l;
+	double fx=*p/(2*tol),fy=p[1]/(2*tol),fz=p[2]/(2*tol),dx,dy,dz;
+	long a=static_cast<long>(floor(fx)),b=static_cast<long>(floor(fy)),c=static_cast<long>(floor(fz)),
+	     sa=fx-a<0.5?-1:1,sb=fy-b<0.5?-1:1,sc=fz-c<0.5?-1:1;
+	for(dk=0;dk<2;dk++) for(dj=0;dj<2;dj++) for(di=0;di<2;di++)
+		for(l=hh[bucket(a+di*sa,b+dj*sb,c+dk*sc)];l>=0;l=hn[l]) {
+			dx=pts[3*l]-*p;dy=pts[3*l+1]-p[1];dz=pts[3*l+2]-p[2];
+			if(dx*dx+dy*dy+dz*dz<=tol*tol) return l;
+		}
+	l=bucket(a,b,c);
+	hn.push_back(hh[l]);hh[l]=nv;
+	pts.push_back(*p);pts.push_back(p[1]);pts.push_back(p[2]);
+	return nv++;
+}
+
+}
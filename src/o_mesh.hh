@@ -0,0 +1,117 @@
+// Voro++, a 3D cell-based Voronoi library
+//
+// Author   : Chris H. Rycroft (LBL / UC Berkeley)
+// Email    : chr@alum.mit.edu
+// Date     : August 30th 2011
+
+/** \file o_mesh.hh
+ * \brief Header file for the face_mesh class, which stores each face of a
+ * Voronoi tessellation once, as a polygonal mesh with shared vertices. */
+
+#ifndef VOROPP_O_MESH_HH
+#define VOROPP_O_MESH_HH
+
+#include <vector>
+
+#include "config.hh"
+#include "cell.hh"
+
+namespace voro {
+
+/** \brief A class for storing the faces of all the Voronoi cells in a
+ * container, with each face that is shared by two cells stored once.
+ *
+ * Each face has two owners: the particle whose cell it was taken from, and
+ * the particle or wall on the other side, which is negative for a wall. A face
+ * between two particles is taken from the cell of the particle with the
+ * smaller ID, so that its normal points from the first owner to the second.
+ * For each face, the area, the unit normal, and the centroid are stored, along
+ * with the indices of its vertices, which are listed anticlockwise when
+ * viewed from the second owner, so that they agree with the normal. The
+ * vertices of the faces are shared, and vertices of different cells that lie
+ * within a small distance of each other are taken to be the same. In a
+ * periodic container, each face is given in the frame of the cell it was
+ * taken from, so that the faces on either side of a periodic boundary may
+ * refer to different periodic images of the same vertex, which are then
+ * stored separately.
+ *
+ * The container classes fill in the mesh with their compute_face_mesh
+ * routines. Each thread passes its cells to the add routine, which records
+ * the faces in a list for each chunk of a block_scheduler, and the assemble
+ * routine then combines the lists in chunk order, so that the numbering of
+ * the faces and vertices does not depend on the number of threads. */
+class face_mesh {
+	public:
+		/** The number of vertices. */
+		int nv;
+		/** The number of faces. */
+		int nf;
+		/** The vertex positions, with three entries for each
+		 * vertex. */
+		std::vector<double> pts;
+		/** The face offsets, which has nf+1 entries, so that the
+		 * vertices of face k are the entries of fv from fo[k] up to,
+		 * but not including, fo[k+1]. */
+		std::vector<int> fo;
+		/** The vertex indices of each face. */
+		std::vector<int> fv;
+		/** The two owners of each face. */
+		std::vector<int> own;
+		/** The area of each face. */
+		std::vector<double> area;
+		/** The unit normal of each face, with three entries for each
+		 * face. */
+		std::vector<double> nor;
+		/** The centroid of each face, with three entries for each
+		 * face. */
+		std::vector<double> cen;
+		/** The class constructor sets up an empty mesh. */
+		face_mesh() : nv(0), nf(0), tol(0) {}
+		void setup(int nt,int nc,double tol_);
+		void add(int t,int ch,int i,double x,double y,double z,voronoicell_neighbor &c);
+		void assemble();
+	private:
+		/** The distance within which vertices are taken to be the
+		 * same. */
+		double tol;
+		/** The vertex positions recorded for each chunk. */
+		std::vector<std::vector<double> > cp;
+		/** The number of vertices of each face recorded for each
+		 * chunk. */
+		std::vector<std::vector<int> > cfo;
+		/** The vertex indices of the faces recorded for each chunk,
+		 * relative to the chunk's vertex positions. */
+		std::vector<std::vector<int> > cfv;
+		/** The owners of the faces recorded for each chunk. */
+		std::vector<std::vector<int> > cown;
+		/** The area, normal, and centroid of the faces recorded for
+		 * each chunk, with seven entries for each face. */
+		std::vector<std::vector<double> > cfd;
+		/** The neighbors of the current cell of each thread. */
+		std::vector<std::vector<int> > tn;
+		/** The face vertices of the current cell of each thread. */
+		std::vector<std::vector<int> > tf;
+		/** The vertex positions of the current cell of each thread. */
+		std::vector<std::vector<double> > tv;
+		/** The first vertex in each bucket of the spatial hash table
+		 * used to merge vertices. */
+		std::vector<int> hh;
+		/** The next vertex in the same bucket of the spatial hash
+		 * table. */
+		std::vector<int> hn;
+		int merge_vertex(const double *p);
+		/** Computes the bucket of the spatial hash table for a cell of
+		 * the merging grid.
+		 * \param[in] (a,b,c) the grid cell.
+		 * \return The bucket. */
+		inline int bucket(long a,long b,long c) {
+			unsigned long h=static_cast<unsigned long>(a)*73856093ul
+				^static_cast<unsigned long>(b)*19349663ul
+				^static_cast<unsigned long>(c)*83492791ul;
+			return static_cast<int>(h&(hh.size()-1));
+		}
+};
+
+}
+
+#endif
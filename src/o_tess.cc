@@ -0,0 +1,226 @@
+// Voro++, a 3D cell-based Voronoi library
+//
+// Author   : Chris H. Rycroft (LBL / UC Berkeley)
+// Email    : chr@alum.mit.edu
+// Date     : August 30th 2011
+
+/** \file o_tess.cc
+ * \brief Function implementations for the tessellation class. */
+
+#include <climits>
+
+#include "o_tess.hh"
+#include "common.hh"
+
+namespace voro {
+
+/** Prepares the tessellation to receive the cells computed for a
+ * block_scheduler, discarding anything previously stored.
+ * \param[in] nt_ the number of threads that will add cells.
+ * \param[in] nc the number of chunks in the scheduler. */
+void tessellation::setup(int nt_,int nc) {
+	nt=nt_;n=0;
+	pos.clear();vo.clear();pts.clear();fo.clear();
+	nb.clear();fvo.clear();fv.clear();
+	ci.assign(nc,std::vector<int>());
+	cpos.assign(nc,std::vector<double>());
+	ccnt.assign(nc,std::vector<int>());
+	cpts.assign(nc,std::vector<vertex_real>());
+	cnb.assign(nc,std::vector<int>());
+	cfs.assign(nc,std::vector<int>());
+	cfv.assign(nc,std::vector<int>());
+	tn.resize(nt);tf.resize(nt);tv.resize(nt);
+}
+
+/** Records a computed Voronoi cell.
+ * \param[in] t the thread number.
+ * \param[in] ch the chunk that the cell belongs to.
+ * \param[in] i the ID of the particle.
+ * \param[in] (x,y,z) the position of the particle.
+ * \param[in] c the computed Voronoi cell. */
+void tessellation::add(int t,int ch,int i,double x,double y,double z,voronoicell_neighbor &c) {
+	std::vector<int> &v=tn[t],&f=tf[t],&s=cfs[ch],&w=cfv[ch];
+	std::vector<double> &q=tv[t],&p=cpos[ch];
+	unsigned int k;
+	int m;
+	c.neighbors(v);
+	c.face_vertices(f);
+	c.vertices(q);
+	ci[ch].push_back(i);
+	p.push_back(x);p.push_back(y);p.push_back(z);
+	ccnt[ch].push_back(static_cast<int>(q.size()/3));
+	ccnt[ch].push_back(static_cast<int>(v.size()));
+	cpts[ch].insert(cpts[ch].end(),q.begin(),q.end());
+	cnb[ch].insert(cnb[ch].end(),v.begin(),v.end());
+	for(k=0;k<f.size();k+=m+1) {
+		m=f[k];s.push_back(m);
+		w.insert(w.end(),f.begin()+(k+1),f.begin()+(k+1+m));
+	}
+}
+
+/** Copies the cells recorded for all of the chunks into place. The offsets of
+ * the rows are found first, after which the chunks are copied in parallel,
+ * and the memory for each chunk is released once it has been copied. Since
+ * the offsets are 32-bit, the totals are accumulated in size_t, and the
+ * routine stops with an error if three times the number of vertices, or the
+ * number of face vertices, does not fit in an int. */
+void tessellation::assemble() {
+	int ch,i,k,nc=static_cast<int>(ci.size());
+	unsigned int q;
+	size_t sv=0,sf=0;
+	std::vector<int> cb(nc+1,0),src;
+
+	// Find the number of rows, and the cell that is kept for each ID,
+	// numbering the cells in chunk order
+	n=0;
+	for(ch=0;ch<nc;ch++) {
+		cb[ch+1]=cb[ch]+static_cast<int>(ci[ch].size());
+		for(q=0;q<ci[ch].size();q++) if(ci[ch][q]>=n) n=ci[ch][q]+1;
+	}
+	src.assign(n,-1);
+	for(ch=0;ch<nc;ch++) for(q=0;q<ci[ch].size();q++) src[ci[ch][q]]=cb[ch]+q;
+
+	// Set up the vertex and face offsets of the rows
+	vo.assign(n+1,0);fo.assign(n+1,0);
+	for(ch=0;ch<nc;ch++) for(q=0;q<ci[ch].size();q++) {
+		i=ci[ch][q];
+		if(src[i]==cb[ch]+static_cast<int>(q)) {
+			vo[i+1]=ccnt[ch][2*q];
+			fo[i+1]=ccnt[ch][2*q+1];
+		}
+	}
+	for(i=0;i<n;i++) {
+		sv+=vo[i+1];sf+=fo[i+1];
+		if(3*sv>INT_MAX||sf>INT_MAX) index_overflow();
+		vo[i+1]=static_cast<int>(sv);fo[i+1]=static_cast<int>(sf);
+	}
+	pos.assign(3*n,0);pts.resize(3*sv);nb.resize(sf);
+	fvo.resize(fo[n]+1);fvo[0]=0;
+
+	// Copy the positions, vertices, and neighbors into place, along with
+	// the number of vertices of each face
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(nt) schedule(dynamic)
+#endif
+	for(ch=0;ch<nc;ch++) {
+		int j,l,id,nv,nf,js=static_cast<int>(ci[ch].size());
+		size_t pv=0,pf=0;
+		for(j=0;j<js;j++,pv+=nv,pf+=nf) {
+			id=ci[ch][j];nv=ccnt[ch][2*j];nf=ccnt[ch][2*j+1];
+			if(src[id]!=cb[ch]+j) continue;
+			for(l=0;l<3;l++) pos[3*id+l]=cpos[ch][3*j+l];
+			for(l=0;l<3*nv;l++) pts[3*vo[id]+l]=cpts[ch][3*pv+l];
+			for(l=0;l<nf;l++) {
+				nb[fo[id]+l]=cnb[ch][pf+l];
+				fvo[fo[id]+l+1]=cfs[ch][pf+l];
+			}
+		}
+		std::vector<double>().swap(cpos[ch]);
+		std::vector<vertex_real>().swap(cpts[ch]);
+		std::vector<int>().swap(cnb[ch]);
+	}
+	for(sv=0,k=0;k<fo[n];k++) {
+		sv+=fvo[k+1];
+		if(sv>INT_MAX) index_overflow();
+		fvo[k+1]=static_cast<int>(sv);
+	}
+	fv.resize(sv);
+
+	// Copy the face vertices into place
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(nt) schedule(dynamic)
+#endif
+	for(ch=0;ch<nc;ch++) {
+		int j,l,m,r,id,nf,js=static_cast<int>(ci[ch].size());
+		size_t pf=0,pw=0;
+		for(j=0;j<js;j++,pf+=nf) {
+			id=ci[ch][j];nf=ccnt[ch][2*j+1];
+			for(l=0;l<nf;l++,pw+=m) {
+				m=cfs[ch][pf+l];
+				if(src[id]==cb[ch]+j)
+					for(r=0;r<m;r++) fv[fvo[fo[id]+l]+r]=cfv[ch][pw+r];
+			}
+		}
+		std::vector<int>().swap(ci[ch]);
+		std::vector<int>().swap(ccnt[ch]);
+		std::vector<int>().swap(cfs[ch]);
+		std::vector<int>().swap(cfv[ch]);
+	}
+}
+
+/** Stops with an error when the tessellation is too large for its 32-bit
+ * offsets. */
+void tessellation::index_overflow() {
+	voro_fatal_error("Tessellation offsets exceeded absolute maximum",VOROPP_MEMORY_ERROR);
+}
+
+/** Returns the vertices of the cell of a particle, in the same form as the
+ * vertices routine of the voronoicell classes.
+ * \param[in] i the ID of the particle.
+ * \param[out] v the positions of the vertices, with three entries for each
+ *               vertex. */
+void tessellation::vertices(int i,std::vector<double> &v) {
+	int k,l=0;
+	if(i<0||i>=n) {v.clear();return;}
+	v.resize(3*(vo[i+1]-vo[i]));
+	for(k=3*vo[i];k<3*vo[i+1];k+=3) {
+		v[l++]=pos[3*i]+pts[k];
+		v[l++]=pos[3*i+1]+pts[k+1];
+		v[l++]=pos[3*i+2]+pts[k+2];
+	}
+}
+
+/** Returns the neighbors of the cell of a particle, in the order of its
+ * faces.
+ * \param[in] i the ID of the particle.
+ * \param[out] v the neighbor across each face. */
+void tessellation::neighbors(int i,std::vector<int> &v) {
+	if(i<0||i>=n) {v.clear();return;}
+	v.assign(nb.begin()+fo[i],nb.begin()+fo[i+1]);
+}
+
+/** Returns the vertices of each face of the cell of a particle, in the same
+ * form as the face_vertices routine of the voronoicell classes, where the
+ * number of vertices of each face is followed by their indices.
+ * \param[in] i the ID of the particle.
+ * \param[out] v the face vertices. */
+void tessellation::face_vertices(int i,std::vector<int> &v) {
+	int k;
+	v.clear();
+	if(i<0||i>=n) return;
+	for(k=fo[i];k<fo[i+1];k++) {
+		v.push_back(fvo[k+1]-fvo[k]);
+		v.insert(v.end(),fv.begin()+fvo[k],fv.begin()+fvo[k+1]);
+	}
+}
+
+/** Calculates the volume of the cell of a particle, by dividing each face into
+ * a fan of triangles, each of which forms a tetrahedron with the particle.
+ * \param[in] i the ID of the particle.
+ * \return The volume, which is zero if the cell is not stored. */
+double tessellation::volume(int i) {
+	int k,l;
+	double vol=0,ux,uy,uz,wx,wy,wz;
+	vertex_real *vp,*q0,*q1,*q2;
+	if(!exists(i)) return 0;
+	vp=&pts[3*vo[i]];
+	for(k=fo[i];k<fo[i+1];k++) {
+		q0=vp+3*fv[fvo[k]];
+		for(l=fvo[k]+2;l<fvo[k+1];l++) {
+			q1=vp+3*fv[l-1];q2=vp+3*fv[l];
+			ux=q1[0]-q0[0];uy=q1[1]-q0[1];uz=q1[2]-q0[2];
+			wx=q2[0]-q0[0];wy=q2[1]-q0[1];wz=q2[2]-q0[2];
+			vol-=q0[0]*(uy*wz-uz*wy)+q0[1]*(uz*wx-ux*wz)+q0[2]*(ux*wy-uy*wx);
+		}
+	}
+	return vol*(1/6.0);
+}
+
+/** Returns the memory allocated for the stored cells.
+ * \return The number of bytes. */
+size_t tessellation::memory_used() {
+	return vector_memory(pos)+vector_memory(vo)+vector_memory(pts)+vector_memory(fo)
+	      +vector_memory(nb)+vector_memory(fvo)+vector_memory(fv);
+}
+
+}
@@ -0,0 +1,129 @@
+// Voro++, a 3D cell-based Voronoi library
+//
+// Author   : Chris H. Rycroft (LBL / UC Berkeley)
+// Email    : chr@alum.mit.edu
+// Date     : August 30th 2011
+
+/** \file o_tess.hh
+ * \brief Header file for the tessellation class, which stores all of the
+ * Voronoi cells of a container in a compact form. */
+
+#ifndef VOROPP_O_TESS_HH
+#define VOROPP_O_TESS_HH
+
+#include <cstddef>
+#include <vector>
+
+#include "config.hh"
+#include "cell.hh"
+
+namespace voro {
+
+/** \brief A class for storing all of the Voronoi cells in a container, so
+ * that they can be examined repeatedly without being recomputed.
+ *
+ * Each cell is reduced to its vertices, the vertices of each of its faces, and
+ * the neighbor across each face, which are held in flat arrays in compressed
+ * sparse row form, with one row for each particle ID from zero up to the
+ * largest ID in the container. The vertices of the cell of particle i are
+ * entries vo[i] up to, but not including, vo[i+1] of the vertex array, and
+ * are stored relative to the particle, using the precision set by
+ * VOROPP_FLOAT_VERTICES in config.hh. Its faces are entries fo[i] up to, but
+ * not including, fo[i+1] of the face arrays, and the vertices of face k are
+ * the entries of fv from fvo[k] up to, but not including, fvo[k+1], given as
+ * indices into the cell's own vertices and listed clockwise when viewed from
+ * outside, as in the voronoicell classes. All of the offsets are 32-bit, so
+ * three times the total number of vertices, and the total number of face
+ * vertices, must fit in an int, and the assemble routine stops with an error
+ * if they do not. A particle ID that is not in the container, or whose cell
+ * could not be computed, has an empty row.
+ *
+ * The container classes fill in the tessellation with their
+ * compute_tessellation routines. Each thread passes its cells to the add
+ * routine, which records them in a list for each chunk of a block_scheduler,
+ * and the assemble routine then copies the lists into place in parallel. The
+ * particle IDs should be non-negative, and if an ID appears more than once,
+ * then the cell that comes last in the order of the scheduler is kept. */
+class tessellation {
+	public:
+		/** The number of rows, which is one more than the largest
+		 * particle ID. */
+		int n;
+		/** The position of the particle of each row, with three
+		 * entries for each row. */
+		std::vector<double> pos;
+		/** The vertex offsets of each row, which has n+1 entries. */
+		std::vector<int> vo;
+		/** The vertex positions relative to the particles, with three
+		 * entries for each vertex. */
+		std::vector<vertex_real> pts;
+		/** The face offsets of each row, which has n+1 entries. */
+		std::vector<int> fo;
+		/** The neighbor across each face, which is negative for a
+		 * wall. */
+		std::vector<int> nb;
+		/** The offsets of the vertices of each face, which has one
+		 * more entry than the number of faces. */
+		std::vector<int> fvo;
+		/** The vertices of each face, as indices into the vertices of
+		 * the cell. */
+		std::vector<int> fv;
+		/** The class constructor sets up an empty tessellation. */
+		tessellation() : n(0), nt(1) {}
+		void setup(int nt_,int nc);
+		void add(int t,int ch,int i,double x,double y,double z,voronoicell_neighbor &c);
+		void assemble();
+		/** Returns whether the cell of a particle is stored.
+		 * \param[in] i the ID of the particle.
+		 * \return True if the cell is stored, false otherwise. */
+		inline bool exists(int i) {return i>=0&&i<n&&fo[i+1]>fo[i];}
+		/** Returns the number of vertices of the cell of a particle.
+		 * \param[in] i the ID of the particle.
+		 * \return The number of vertices. */
+		inline int number_of_vertices(int i) {return i>=0&&i<n?vo[i+1]-vo[i]:0;}
+		/** Returns the number of faces of the cell of a particle.
+		 * \param[in] i the ID of the particle.
+		 * \return The number of faces. */
+		inline int number_of_faces(int i) {return i>=0&&i<n?fo[i+1]-fo[i]:0;}
+		void vertices(int i,std::vector<double> &v);
+		void neighbors(int i,std::vector<int> &v);
+		void face_vertices(int i,std::vector<int> &v);
+		double volume(int i);
+		size_t memory_used();
+	private:
+		/** The number of threads to use. */
+		int nt;
+		/** The particle IDs of the cells recorded for each chunk. */
+		std::vector<std::vector<int> > ci;
+		/** The particle positions of the cells recorded for each
+		 * chunk. */
+		std::vector<std::vector<double> > cpos;
+		/** The number of vertices and faces of the cells recorded for
+		 * each chunk, with two entries for each cell. */
+		std::vector<std::vector<int> > ccnt;
+		/** The vertex positions of the cells recorded for each chunk. */
+		std::vector<std::vector<vertex_real> > cpts;
+		/** The neighbors across the faces recorded for each chunk. */
+		std::vector<std::vector<int> > cnb;
+		/** The number of vertices of each face recorded for each
+		 * chunk. */
+		std::vector<std::vector<int> > cfs;
+		/** The vertices of the faces recorded for each chunk. */
+		std::vector<std::vector<int> > cfv;
+		/** The neighbors of the current cell of each thread. */
+		std::vector<std::vector<int> > tn;
+		/** The face vertices of the current cell of each thread. */
+		std::vector<std::vector<int> > tf;
+		/** The vertex positions of the current cell of each thread. */
+		std::vector<std::vector<double> > tv;
+		/** Returns the memory allocated for a vector.
+		 * \param[in] v the vector.
+		 * \return The number of bytes. */
+		template<class T>
+		inline size_t vector_memory(std::vector<T> &v) {return v.capacity()*sizeof(T);}
+		void index_overflow();
+};
+
+}
+
+#endif
@@ -0,0 +1,107 @@
+// Voro++, a 3D cell-based Voronoi library
+//
+// Author   : Chris H. Rycroft (LBL / UC Berkeley)
+// Email    : chr@alum.mit.edu
+// Date     : August 30th 2011
+
+/** \file p_file.cc
+ * \brief Function implementations for the particle_file class. */
+
+#include <cstring>
+
+#include "p_file.hh"
+
+#if VOROPP_USE_MMAP == 1
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace voro {
+
+/** The class constructor reads a binary particle file, mapping it into memory
+ * if possible, and checks that its header and size are consistent. If the
+ * file cannot be read or is not a valid binary particle file, then the routine
+ * causes a fatal error.
+ * \param[in] filename the name of the file to read. */
+particle_file::particle_file(const char *filename) {
+#if VOROPP_USE_MMAP == 1
+	int fd=open(filename,O_RDONLY);
+	struct stat st;
+	if(fd==-1||fstat(fd,&st)==-1) {
+		fprintf(stderr,"voro++: Unable to open file '%s'\n",filename);
+		exit(VOROPP_FILE_ERROR);
+	}
+	len=st.st_size;
+	if(len<sizeof(particle_file_header)) voro_fatal_error("Binary particle file is too short",VOROPP_FILE_ERROR);
+	void *m=mmap(NULL,len,PROT_READ,MAP_PRIVATE,fd,0);
+	close(fd);
+	if(m==MAP_FAILED) voro_fatal_error("Unable to map binary particle file",VOROPP_FILE_ERROR);
+	buf=static_cast<char*>(m);
+#else
+	FILE *fp=safe_fopen(filename,"rb");
+	fseek(fp,0,SEEK_END);
+	long l=ftell(fp);
+	if(l<long(sizeof(particle_file_header))) voro_fatal_error("Binary particle file is too short",VOROPP_FILE_ERROR);
+	len=l;buf=new char[len];
+	fseek(fp,0,SEEK_SET);
+	if(fread(buf,1,len,fp)!=len) voro_fatal_error("File import error",VOROPP_FILE_ERROR);
+	fclose(fp);
+#endif
+
+	// Check the header, and that the file is the expected size
+	const particle_file_header *h=reinterpret_cast<const particle_file_header*>(buf);
+	if(memcmp(h->magic,"VORO++PB",8)!=0) voro_fatal_error("Not a binary particle file",VOROPP_FILE_ERROR);
+	if(h->version!=pf_version) voro_fatal_error("Unsupported binary particle file version or byte order",VOROPP_FILE_ERROR);
+	n=h->n;flags=h->flags;ps=radii()?4:3;box=h->box;
+	size_t io=sizeof(particle_file_header),po=io+sizeof(int)*(n+(n&1));
+	if(n<0||len!=po+sizeof(double)*ps*n) voro_fatal_error("Binary particle file has the wrong size",VOROPP_FILE_ERROR);
+	id=reinterpret_cast<const int*>(buf+io);
+	p=reinterpret_cast<const double*>(buf+po);
+}
+
+/** The class destructor unmaps or frees the file contents. */
+particle_file::~particle_file() {
+#if VOROPP_USE_MMAP == 1
+	munmap(buf,len);
+#else
+	delete [] buf;
+#endif
+}
+
+/** Checks that the periodicity and box type flags and the box geometry stored
+ * in the file header match those of a container. If they do not, then the
+ * routine causes a fatal error. The pf_radii flag is not compared.
+ * \param[in] cflags the periodicity and box type flags of the container.
+ * \param[in] cbox the six values describing the box geometry of the
+ *                 container. */
+void particle_file::check_box(int cflags,const double *cbox) const {
+	if((flags&~pf_radii)!=cflags) voro_fatal_error("Binary particle file periodicity does not match the container",VOROPP_FILE_ERROR);
+	for(int l=0;l<6;l++) if(box[l]!=cbox[l])
+		voro_fatal_error("Binary particle file box does not match the container",VOROPP_FILE_ERROR);
+}
+
+/** Writes the header of a binary particle file.
+ * \param[in] fp the file handle to write to.
+ * \param[in] n the number of particles.
+ * \param[in] flags the flags describing the file contents.
+ * \param[in] box the six values describing the box geometry. */
+void particle_file::write_header(FILE *fp,int n,int flags,const double *box) {
+	particle_file_header h;
+	memcpy(h.magic,"VORO++PB",8);
+	h.version=pf_version;h.flags=flags;h.n=n;h.pad=0;
+	for(int l=0;l<6;l++) h.box[l]=box[l];
+	fwrite(&h,sizeof(particle_file_header),1,fp);
+}
+
+/** Writes the padding that follows the particle IDs, so that the particle
+ * positions are aligned to eight bytes.
+ * \param[in] fp the file handle to write to.
+ * \param[in] n the number of particles. */
+void particle_file::write_padding(FILE *fp,int n) {
+	int z=0;
+	if(n&1) fwrite(&z,sizeof(int),1,fp);
+}
+
+}
@@ -0,0 +1,138 @@
+// Voro++, a 3D cell-based Voronoi library
+//
+// Author   : Chris H. Rycroft (LBL / UC Berkeley)
+// Email    : chr@alum.mit.edu
+// Date     : August 30th 2011
+
+/** \file p_file.hh
+ * \brief Header file for the particle_file class, which reads the binary
+ * particle format. */
+
+#ifndef VOROPP_P_FILE_HH
+#define VOROPP_P_FILE_HH
+
+#include <cstdio>
+#include <cstddef>
+
+#include "config.hh"
+#include "common.hh"
+
+/** If this is set to 1, then binary particle files are read by mapping them
+ * into memory. Otherwise they are read into a buffer in a single call. The
+ * default is to use memory mapping on Unix-like systems. */
+#ifndef VOROPP_USE_MMAP
+#if defined(__unix__) || defined(__APPLE__)
+#define VOROPP_USE_MMAP 1
+#else
+#define VOROPP_USE_MMAP 0
+#endif
+#endif
+
+namespace voro {
+
+/** The flag in a binary particle file that is set if the file contains
+ * particle radii. */
+const int pf_radii=1;
+/** The flag in a binary particle file that is set if the x coordinate is
+ * periodic. */
+const int pf_xperiodic=2;
+/** The flag in a binary particle file that is set if the y coordinate is
+ * periodic. */
+const int pf_yperiodic=4;
+/** The flag in a binary particle file that is set if the z coordinate is
+ * periodic. */
+const int pf_zperiodic=8;
+/** The flag in a binary particle file that is set if the box is a periodic
+ * parallelepiped, as used by the container_periodic classes. */
+const int pf_triclinic=16;
+/** The version number of the binary particle format. */
+const int pf_version=1;
+
+/** \brief The header of a binary particle file.
+ *
+ * A binary particle file consists of this header, followed by the particle
+ * IDs as an array of ints, followed by four bytes of padding if the number of
+ * particles is odd, followed by the particle positions as an array of doubles.
+ * For each particle there are three doubles (x,y,z), or four doubles (x,y,z,r)
+ * if the pf_radii flag is set. All values are stored in the native byte order
+ * of the machine, using four-byte ints and eight-byte doubles. */
+struct particle_file_header {
+	/** The characters "VORO++PB", identifying the format. */
+	char magic[8];
+	/** The version of the format, which is also used to detect files
+	 * written with a different byte order. */
+	int version;
+	/** A combination of the pf_radii, pf_xperiodic, pf_yperiodic,
+	 * pf_zperiodic, and pf_triclinic flags. */
+	int flags;
+	/** The number of particles. */
+	int n;
+	/** Padding, which is set to zero. */
+	int pad;
+	/** The geometry of the box. For a rectangular box this holds
+	 * (ax,bx,ay,by,az,bz), and for a periodic parallelepiped it holds
+	 * (bx,bxy,by,bxz,byz,bz). */
+	double box[6];
+};
+
+/** \brief A class for reading a binary particle file.
+ *
+ * This class maps a binary particle file into memory, checks its header, and
+ * provides pointers directly into the particle IDs and positions, so that the
+ * particles can be inserted into a container without any parsing. */
+class particle_file {
+	public:
+		/** The number of particles in the file. */
+		int n;
+		/** The flags stored in the file header. */
+		int flags;
+		/** The number of doubles stored for each particle. */
+		int ps;
+		/** The geometry of the box stored in the file header. */
+		const double *box;
+		/** The particle IDs. */
+		const int *id;
+		/** The particle positions, and radii if present. */
+		const double *p;
+		particle_file(const char *filename);
+		~particle_file();
+		/** Checks whether the file contains particle radii.
+		 * \return True if radii are present, false otherwise. */
+		inline bool radii() const {return (flags&pf_radii)!=0;}
+		void check_box(int cflags,const double *cbox) const;
+		static void write_header(FILE *fp,int n,int flags,const double *box);
+		static void write_padding(FILE *fp,int n);
+	private:
+		/** The memory holding the contents of the file. */
+		char *buf;
+		/** The size of the file in bytes. */
+		size_t len;
+};
+
+/** Writes the particles in a loop to a file in the binary particle format.
+ * \param[in] vl the loop class to use.
+ * \param[in] id the particle IDs in each block of the container.
+ * \param[in] p the particle positions in each block of the container.
+ * \param[in] ps the number of values stored for each particle, which is
+ *               written to the file.
+ * \param[in] flags the periodicity and box type flags to write, to which the
+ *                  pf_radii flag is added if ps is 4.
+ * \param[in] box the geometry of the box.
+ * \param[in] fp the file handle to write to. */
+template<class c_loop>
+void write_particles_binary(c_loop &vl,int **id,particle_real **p,int ps,int flags,const double *box,FILE *fp) {
+	int n=0;
+	if(vl.start()) do n++; while(vl.inc());
+	particle_file::write_header(fp,n,ps==4?flags|pf_radii:flags,box);
+	if(vl.start()) do fwrite(id[vl.ijk]+vl.q,sizeof(int),1,fp); while(vl.inc());
+	particle_file::write_padding(fp,n);
+	double q[4];
+	if(vl.start()) do {
+		for(int l=0;l<ps;l++) q[l]=p[vl.ijk][ps*vl.q+l];
+		fwrite(q,sizeof(double),ps,fp);
+	} while(vl.inc());
+}
+
+}
+
+#endif
@@ -0,0 +1,115 @@
+// Voro++, a 3D cell-based Voronoi library
+//
+// Author   : Chris H. Rycroft (LBL / UC Berkeley)
+// Email    : chr@alum.mit.edu
+// Date     : August 30th 2011
+
+/** \file p_index.cc
+ * \brief Function implementations for the particle_index class. */
+
+#include "p_index.hh"
+#include "common.hh"
+
+namespace voro {
+
+/** Empties the table, making sure that it has enough slots to hold a given
+ * number of entries without growing.
+ * \param[in] m the number of entries. */
+void particle_index::reset(int m) {
+	int nmem=hmem>0?hmem:init_index_size;
+	while(nmem<2*m) {
+		nmem<<=1;
+		if(nmem>max_index_size)
+			voro_fatal_error("Particle index allocation exceeded absolute maximum",VOROPP_MEMORY_ERROR);
+	}
+	if(nmem>hmem) {
+		delete [] ht;
+		allocate(nmem);
+	} else {
+		for(int *tp=ht+1;tp<ht+3*hmem;tp+=3) *tp=-1;
+		n=0;
+	}
+}
+
+/** Records the storage location of a particle, replacing any previous entry
+ * for the same ID.
+ * \param[in] i the ID of the particle.
+ * \param[in] ijk the block that the particle is within.
+ * \param[in] q the index of the particle within the block. */
+void particle_index::insert(int i,int ijk,int q) {
+	if(hmem==0) allocate(init_index_size);
+	int *tp=ht+3*hash(i);
+	while(tp[1]>=0) {
+		if(*tp==i) {tp[1]=ijk;tp[2]=q;return;}
+		tp+=3;if(tp==ht+3*hmem) tp=ht;
+	}
+	*tp=i;tp[1]=ijk;tp[2]=q;
+	if(++n>(hmem>>1)) {
+
+		// Double the size of the table and copy across the entries
+		int omem=hmem,*oht=ht,*op;
+		if(omem<<1>max_index_size)
+			voro_fatal_error("Particle index allocation exceeded absolute maximum",VOROPP_MEMORY_ERROR);
+#if VOROPP_VERBOSE >=2
+		fprintf(stderr,"Particle index memory scaled up to %d\n",omem<<1);
+#endif
+		allocate(omem<<1);
+		for(op=oht;op<oht+3*omem;op+=3) if(op[1]>=0) {
+			tp=ht+3*hash(*op);
+			while(tp[1]>=0) {tp+=3;if(tp==ht+3*hmem) tp=ht;}
+			*tp=*op;tp[1]=op[1];tp[2]=op[2];n++;
+		}
+		delete [] oht;
+	}
+}
+
+/** Looks up the storage location of a particle.
+ * \param[in] i the ID of the particle.
+ * \param[out] ijk the block that the particle is within.
+ * \param[out] q the index of the particle within the block.
+ * \return True if there is an entry for the particle, false otherwise. */
+bool particle_index::find(int i,int &ijk,int &q) {
+	if(hmem==0) return false;
+	int *tp=ht+3*hash(i);
+	while(tp[1]>=0) {
+		if(*tp==i) {ijk=tp[1];q=tp[2];return true;}
+		tp+=3;if(tp==ht+3*hmem) tp=ht;
+	}
+	return false;
+}
+
+/** Removes the entry for a particle, if there is one. The entries in the
+ * rest of the probe sequence are shifted back to fill the gap, so that they
+ * can still be found.
+ * \param[in] i the ID of the particle. */
+void particle_index::erase(int i) {
+	if(hmem==0) return;
+	unsigned int h=hash(i),j,k;
+	while(ht[3*h+1]>=0) {
+		if(ht[3*h]==i) break;
+		h=(h+1)&hm;
+	}
+	if(ht[3*h+1]<0) return;
+	for(j=h;;) {
+		j=(j+1)&hm;
+		if(ht[3*j+1]<0) break;
+
+		// Leave the entry in place if its first slot lies cyclically
+		// within (h,j], and otherwise move it back into the gap
+		k=hash(ht[3*j]);
+		if(h<j?(h<k&&k<=j):(h<k||k<=j)) continue;
+		ht[3*h]=ht[3*j];ht[3*h+1]=ht[3*j+1];ht[3*h+2]=ht[3*j+2];h=j;
+	}
+	ht[3*h+1]=-1;n--;
+}
+
+/** Allocates an empty table with a given number of slots.
+ * \param[in] nmem the number of slots, which must be a power of two. */
+void particle_index::allocate(int nmem) {
+	hmem=nmem;hm=hmem-1;n=0;
+	for(hs=0;(1<<hs)<hmem;hs++);
+	ht=new int[3*hmem];
+	for(int *tp=ht+1;tp<ht+3*hmem;tp+=3) *tp=-1;
+}
+
+}
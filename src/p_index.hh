@@ -0,0 +1,117 @@
+// Voro++, a 3D cell-based Voronoi library
+//
+// Author   : Chris H. Rycroft (LBL / UC Berkeley)
+// Email    : chr@alum.mit.edu
+// Date     : August 30th 2011
+
+/** \file p_index.hh
+ * \brief Header file for the particle_index class. */
+
+#ifndef VOROPP_P_INDEX_HH
+#define VOROPP_P_INDEX_HH
+
+#include <cstdlib>
+
+#include "config.hh"
+
+namespace voro {
+
+/** \brief A hash table that maps particle IDs to their storage locations.
+ *
+ * This class records the block and the position within the block of each
+ * particle in a container, so that a particle can be moved or removed by its
+ * ID without searching the container. The table uses open addressing with
+ * linear probing, and entries are erased by shifting later entries back, so
+ * that no deleted markers are left behind. No memory is allocated until the
+ * first entry is inserted.
+ *
+ * The containers do not update the index as particles are added, and instead
+ * mark it as out of date. Each lookup is made through the locate() routine,
+ * which checks the entry against the container, and rebuilds the index only
+ * if the entry does not match and the index is marked as out of date. */
+class particle_index {
+	public:
+		/** The number of entries in the table. */
+		int n;
+		/** Whether the table holds every particle in the container.
+		 * This is set by the container's build_index() routine, and
+		 * is cleared when particles are added to the container. */
+		bool current;
+		/** The class constructor sets up an empty table. */
+		particle_index() : n(0), current(false), hmem(0), hm(0), ht(NULL), hs(0) {}
+		/** The class destructor frees the dynamically allocated
+		 * memory. */
+		~particle_index() {delete [] ht;}
+		void reset(int m);
+		void insert(int i,int ijk,int q);
+		bool find(int i,int &ijk,int &q);
+		void erase(int i);
+		/** Finds the storage location of a particle in a container.
+		 * The entry in the table is checked against the container.
+		 * If it does not match and the index is out of date, then the
+		 * index is rebuilt by the container's build_index() routine
+		 * and the search is repeated, while if the index is up to
+		 * date, then the particle is not in the container.
+		 * \param[in] con a reference to the container class.
+		 * \param[in] i the ID of the particle.
+		 * \param[out] ijk the block that the particle is within.
+		 * \param[out] q the index of the particle within the block.
+		 * \return True if the particle is in the container, false
+		 *         otherwise. */
+		template<class c_class>
+		bool locate(c_class &con,int i,int &ijk,int &q) {
+			if(find(i,ijk,q)&&q<con.co[ijk]&&con.id[ijk][q]==i) return true;
+			if(current) return false;
+			con.build_index();
+			return find(i,ijk,q);
+		}
+		/** Takes a particle out of a block of a container, by moving
+		 * the last particle of the block into its place and updating
+		 * the entry of the moved particle. The entry of the particle
+		 * being taken out is not altered.
+		 * \param[in] con a reference to the container class.
+		 * \param[in] ijk the block that the particle is within.
+		 * \param[in] q the index of the particle within the block. */
+		template<class c_class>
+		void take(c_class &con,int ijk,int q) {
+			int l=--con.co[ijk];
+			if(q<l) {
+				int m=con.id[ijk][q]=con.id[ijk][l];
+				particle_real *pp=con.p[ijk]+con.ps*q,*lp=con.p[ijk]+con.ps*l;
+				for(int c=0;c<con.ps;c++) pp[c]=lp[c];
+				insert(m,ijk,q);
+			}
+		}
+	private:
+		/** The number of slots in the table, which is a power of
+		 * two. */
+		int hmem;
+		/** A bit mask for reducing a hash value to a slot, set to
+		 * hmem-1. */
+		unsigned int hm;
+		/** The table entries, holding the particle ID, the block,
+		 * and the index within the block for each slot, stored
+		 * together so that a lookup touches a single cache line. The
+		 * block is set to -1 if the slot is empty. */
+		int *ht;
+		/** The base two logarithm of the number of slots. */
+		int hs;
+		/** Computes the first slot to probe for a particle. The high
+		 * bits of the ID are folded onto the low bits, rather than
+		 * being fully scrambled, so that particles with consecutive
+		 * IDs are stored in consecutive slots. This means that
+		 * updating the particles in order of their IDs reads the
+		 * table sequentially, while IDs that are spaced by a large
+		 * power of two are still spread over the table.
+		 * \param[in] i the ID of the particle.
+		 * \return The slot. */
+		inline unsigned int hash(int i) {
+			unsigned int u=static_cast<unsigned int>(i);
+			return (u^(u>>hs))&hm;
+		}
+		void allocate(int nmem);
+};
+
+}
+
+#endif
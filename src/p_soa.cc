@@ -0,0 +1,51 @@
+// Voro++, a 3D cell-based Voronoi library
+//
+// Author   : Chris H. Rycroft (LBL / UC Berkeley)
+// Email    : chr@alum.mit.edu
+// Date     : August 30th 2011
+
+/** \file p_soa.cc
+ * \brief Function implementations for the particle_soa class. */
+
+#include "p_soa.hh"
+
+namespace voro {
+
+/** Makes a structure-of-arrays copy of the particle data in a container,
+ * replacing any previous copy.
+ * \param[in] nb_ the number of blocks in the container.
+ * \param[in] ps the number of floating point entries stored for each particle.
+ * \param[in] co the number of particles in each block.
+ * \param[in] p the particle positions in each block. */
+void particle_soa::build(int nb_,int ps,int *co,particle_real **p) {
+	int ijk,l,n;particle_real *pp;
+	clear();
+	nb=nb_;so=new int[nb+1];sm=new unsigned int[nb];
+
+	// Compute the offset of each block, and reset its modification count
+	for(n=ijk=0;ijk<nb;ijk++) {so[ijk]=n;n+=co[ijk];sm[ijk]=0;}
+	so[nb]=n;
+
+	// Allocate the coordinate arrays, and copy the data into them
+	sx=new particle_real[n];sy=new particle_real[n];sz=new particle_real[n];
+	if(ps==4) sr=new particle_real[n];
+	for(ijk=0;ijk<nb;ijk++) for(l=so[ijk],pp=p[ijk];l<so[ijk+1];l++,pp+=ps) {
+		sx[l]=*pp;sy[l]=pp[1];sz[l]=pp[2];
+		if(ps==4) sr[l]=pp[3];
+	}
+}
+
+/** Frees the copy, so that the regular particle data is used for all blocks.
+ */
+void particle_soa::clear() {
+	if(nb==0) return;
+	delete [] sr;
+	delete [] sz;
+	delete [] sy;
+	delete [] sx;
+	delete [] sm;
+	delete [] so;
+	nb=0;so=NULL;sm=NULL;sx=sy=sz=sr=NULL;
+}
+
+}
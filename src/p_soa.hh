@@ -0,0 +1,77 @@
+// Voro++, a 3D cell-based Voronoi library
+//
+// Author   : Chris H. Rycroft (LBL / UC Berkeley)
+// Email    : chr@alum.mit.edu
+// Date     : August 30th 2011
+
+/** \file p_soa.hh
+ * \brief Header file for the particle_soa class. */
+
+#ifndef VOROPP_P_SOA_HH
+#define VOROPP_P_SOA_HH
+
+#include <cstdlib>
+
+#include "config.hh"
+
+namespace voro {
+
+/** \brief A structure-of-arrays copy of the particle positions in a container.
+ *
+ * The containers store the positions of the particles in each block as
+ * interleaved (x,y,z) or (x,y,z,r) entries. This class holds a copy of the
+ * same data where all of the x coordinates are stored contiguously, followed
+ * by all of the y coordinates, and so on, sorted by block so that the
+ * particles of a block occupy a contiguous range of each array. This allows
+ * the loops over the particles in a block during the Voronoi cell computation
+ * to be vectorized. The coordinates are stored with the same precision as the
+ * container's particle data. The copy is not updated when the particles
+ * change. Instead, the containers record each change to a block with the
+ * modify() routine, and the copy is only used for the blocks that have not
+ * been modified since it was made. */
+class particle_soa {
+	public:
+		/** The number of blocks in the copy, or zero if no copy has
+		 * been made. */
+		int nb;
+		/** The offset of the first particle of each block in the
+		 * coordinate arrays. It has an additional entry at the end
+		 * holding the total number of particles. */
+		int *so;
+		/** The number of times that each block has been modified
+		 * since the copy was made. */
+		unsigned int *sm;
+		/** The x coordinates of the particles. */
+		particle_real *sx;
+		/** The y coordinates of the particles. */
+		particle_real *sy;
+		/** The z coordinates of the particles. */
+		particle_real *sz;
+		/** The radii of the particles, or a null pointer if the
+		 * container does not store radii. */
+		particle_real *sr;
+		/** The class constructor sets up an empty copy. */
+		particle_soa() : nb(0), so(NULL), sm(NULL), sx(NULL), sy(NULL), sz(NULL), sr(NULL) {}
+		/** The class destructor frees the dynamically allocated
+		 * memory. */
+		~particle_soa() {clear();}
+		void build(int nb_,int ps,int *co,particle_real **p);
+		void clear();
+		/** Records that the particles in a block have changed, so that
+		 * the copy of the block is no longer used.
+		 * \param[in] ijk the index of the block. */
+		inline void modify(int ijk) {
+			if(ijk<nb) sm[ijk]++;
+		}
+		/** Checks whether the copy can be used for a given block.
+		 * \param[in] ijk the index of the block.
+		 * \return True if the copy holds the block and the block has
+		 *         not been modified since, false otherwise. */
+		inline bool current(int ijk) const {
+			return ijk<nb&&sm[ijk]==0;
+		}
+};
+
+}
+
+#endif
@@ -0,0 +1,195 @@
+// Voro++, a 3D cell-based Voronoi library
+//
+// Author   : Chris H. Rycroft (LBL / UC Berkeley)
+// Email    : chr@alum.mit.edu
+// Date     : August 30th 2011
+
+/** \file p_text.cc
+ * \brief Function implementations for the particle_text class. */
+
+#include <cstdlib>
+#include <cstring>
+
+#include "p_text.hh"
+
+namespace voro {
+
+/** The class constructor reads all of the remaining records from a file
+ * stream. The stream is first counted, in parallel, to find the number of
+ * values in each chunk, so that each thread knows which of its values are IDs,
+ * and the chunks are then parsed in parallel. If the stream cannot be parsed,
+ * then the routine causes a fatal error.
+ * \param[in] fp the file handle to read from.
+ * \param[in] ps_ the number of floating point values after the ID in each
+ *                record. */
+particle_text::particle_text(FILE *fp,int ps_) : n(0), ps(ps_), id(NULL), p(NULL) {
+	size_t len;
+	char *buf=read_stream(fp,len);
+	int c,nc=1,t,*ct;
+	bool ok=true;
+
+	// Divide the buffer into chunks, each starting at the beginning of a
+	// line
+#ifdef _OPENMP
+	nc=omp_get_max_threads();
+#endif
+	if(static_cast<size_t>(nc)>len/text_import_chunk+1) nc=len/text_import_chunk+1;
+	const char **cs=new const char*[nc+1];
+	ct=new int[nc+1];
+	*cs=buf;cs[nc]=buf+len;
+	for(c=1;c<nc;c++) {
+		const char *q=buf+len/nc*c;
+		if(q<cs[c-1]) q=cs[c-1];
+		while(q<buf+len&&*q!='\n') q++;
+		cs[c]=q<buf+len?q+1:q;
+	}
+
+	// Count the values in each chunk, and check that the total is a whole
+	// number of records
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(nc)
+#endif
+	for(c=0;c<nc;c++) ct[c+1]=count_tokens(cs[c],cs[c+1]);
+	for(*ct=0,c=0;c<nc;c++) ct[c+1]+=ct[c];
+	t=ct[nc];
+	if(t%(ps+1)!=0) ok=false;
+	else {
+
+		// Parse the chunks
+		n=t/(ps+1);
+		id=new int[n];p=new double[ps*n];
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(nc) reduction(&&:ok)
+#endif
+		for(c=0;c<nc;c++) ok=parse_chunk(cs[c],cs[c+1],ct[c])&&ok;
+	}
+	delete [] ct;
+	delete [] cs;
+	delete [] buf;
+	if(!ok) voro_fatal_error("File import error",VOROPP_FILE_ERROR);
+}
+
+/** Reads the remainder of a file stream into memory in large blocks.
+ * \param[in] fp the file handle to read from.
+ * \param[out] len the number of bytes read.
+ * \return A pointer to a newly allocated buffer holding the bytes. */
+char* particle_text::read_stream(FILE *fp,size_t &len) {
+	size_t m=text_import_chunk,r;
+	char *buf=new char[m],*nbuf;
+	len=0;
+	while((r=fread(buf+len,1,m-len,fp))>0) {
+		len+=r;
+		if(len==m) {
+			nbuf=new char[m<<1];
+			memcpy(nbuf,buf,len);
+			delete [] buf;
+			buf=nbuf;m<<=1;
+		}
+	}
+	if(ferror(fp)) voro_fatal_error("File import error",VOROPP_FILE_ERROR);
+	return buf;
+}
+
+/** Counts the number of whitespace-separated values in a range of characters.
+ * \param[in] (s,e) the range of characters.
+ * \return The number of values. */
+int particle_text::count_tokens(const char *s,const char *e) {
+	int t=0;
+	while(true) {
+		while(s<e&&space(*s)) s++;
+		if(s==e) return t;
+		t++;
+		while(s<e&&!space(*s)) s++;
+	}
+}
+
+/** Parses the values in a chunk, storing them in the id and p arrays.
+ * \param[in] (s,e) the range of characters in the chunk.
+ * \param[in] g the index of the first value in the chunk among all of the
+ *              values in the stream.
+ * \return True if all of the values were parsed successfully, false
+ *         otherwise. */
+bool particle_text::parse_chunk(const char *s,const char *e,int g) {
+	const char *te;
+	int r=g%(ps+1),q=g/(ps+1);
+	while(true) {
+		while(s<e&&space(*s)) s++;
+		if(s==e) return true;
+		te=s;
+		while(te<e&&!space(*te)) te++;
+		if(r==0) {
+			if(!parse_int(s,te,id[q])) return false;
+		} else if(!parse_double(s,te,p[ps*q+r-1])) return false;
+		if(++r>ps) {r=0;q++;}
+		s=te;
+	}
+}
+
+/** Parses an integer, in the same format as the %d conversion of fscanf.
+ * \param[in] (s,e) the range of characters holding the integer.
+ * \param[out] v the integer.
+ * \return True if the whole range is a valid integer, false otherwise. */
+bool particle_text::parse_int(const char *s,const char *e,int &v) {
+	bool neg=false;
+	if(*s=='-') {neg=true;s++;} else if(*s=='+') s++;
+	if(s==e) return false;
+	for(v=0;s<e;s++) {
+		if(*s<'0'||*s>'9') return false;
+		v=10*v+(*s-'0');
+	}
+	if(neg) v=-v;
+	return true;
+}
+
+/** Parses a floating point number, in the same format as the %lg conversion of
+ * fscanf. Numbers with at most fifteen significant digits and a small decimal
+ * exponent, which covers most particle files, are converted directly, since
+ * the mantissa and power of ten are then exactly representable and a single
+ * multiplication or division gives the correctly rounded result. Other numbers
+ * are passed to strtod.
+ * \param[in] (s,e) the range of characters holding the number.
+ * \param[out] v the number.
+ * \return True if the whole range is a valid number, false otherwise. */
+bool particle_text::parse_double(const char *s,const char *e,double &v) {
+	static const double p10[23]={1e0,1e1,1e2,1e3,1e4,1e5,1e6,1e7,1e8,1e9,1e10,
+		1e11,1e12,1e13,1e14,1e15,1e16,1e17,1e18,1e19,1e20,1e21,1e22};
+	const char *q=s;
+	bool neg=false,dig=false;
+	int nd=0,ex=0,x;
+	double m=0;
+
+	// Read the sign, and the digits before and after the decimal point
+	if(*q=='-') {neg=true;q++;} else if(*q=='+') q++;
+	for(;q<e&&*q>='0'&&*q<='9';q++) {
+		dig=true;
+		if(m>0||*q!='0') {m=10*m+(*q-'0');nd++;}
+	}
+	if(q<e&&*q=='.') for(q++;q<e&&*q>='0'&&*q<='9';q++) {
+		dig=true;ex--;
+		if(m>0||*q!='0') {m=10*m+(*q-'0');nd++;}
+	}
+
+	// Read the exponent
+	if(dig&&q<e&&(*q=='e'||*q=='E')) {
+		bool eneg=false;
+		if(++q<e&&(*q=='-'||*q=='+')) eneg=*(q++)=='-';
+		if(q==e) dig=false;
+		for(x=0;q<e&&*q>='0'&&*q<='9';q++) if(x<10000) x=10*x+(*q-'0');
+		ex+=eneg?-x:x;
+	}
+
+	// Use the direct conversion if possible, and otherwise use strtod
+	if(dig&&q==e&&nd<=15&&ex>=-22&&ex<=22) {
+		v=ex<0?m/p10[-ex]:m*p10[ex];
+		if(neg) v=-v;
+		return true;
+	}
+	char sb[64],*b=e-s<64?sb:new char[e-s+1],*be;
+	memcpy(b,s,e-s);b[e-s]=0;
+	v=strtod(b,&be);
+	bool ok=be==b+(e-s)&&be!=b;
+	if(b!=sb) delete [] b;
+	return ok;
+}
+
+}
@@ -0,0 +1,67 @@
+// Voro++, a 3D cell-based Voronoi library
+//
+// Author   : Chris H. Rycroft (LBL / UC Berkeley)
+// Email    : chr@alum.mit.edu
+// Date     : August 30th 2011
+
+/** \file p_text.hh
+ * \brief Header file for the particle_text class, which parses text particle
+ * files in parallel. */
+
+#ifndef VOROPP_P_TEXT_HH
+#define VOROPP_P_TEXT_HH
+
+#include <cstdio>
+#include <cstddef>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "config.hh"
+#include "common.hh"
+
+namespace voro {
+
+/** \brief A class for reading a text particle file.
+ *
+ * This class reads a text file of particle records, each consisting of an
+ * integer ID followed by a fixed number of floating point values, such as the
+ * (x,y,z) position or the (x,y,z,r) position and radius. It reads the whole
+ * stream into memory in large blocks, and then splits it into line-aligned
+ * chunks that are parsed on several threads using a hand-written number
+ * parser. Like the fscanf-based routines it replaces, it treats all
+ * whitespace, including line breaks, as separators between values, and it
+ * causes a fatal error if any value is malformed or if the last record is
+ * incomplete. The parsed values are the same as those produced by fscanf. */
+class particle_text {
+	public:
+		/** The number of particles read. */
+		int n;
+		/** The number of floating point values in each record. */
+		const int ps;
+		/** The particle IDs. */
+		int *id;
+		/** The floating point values of the particles. */
+		double *p;
+		particle_text(FILE *fp,int ps_);
+		/** The class destructor frees the dynamically allocated
+		 * memory. */
+		~particle_text() {
+			delete [] p;
+			delete [] id;
+		}
+	private:
+		char *read_stream(FILE *fp,size_t &len);
+		static inline bool space(char c) {
+			return c==' '||c=='\n'||c=='\t'||c=='\r'||c=='\v'||c=='\f';
+		}
+		static int count_tokens(const char *s,const char *e);
+		bool parse_chunk(const char *s,const char *e,int g);
+		static bool parse_int(const char *s,const char *e,int &v);
+		static bool parse_double(const char *s,const char *e,double &v);
+};
+
+}
+
+#endif
@@ -62,6 +62,110 @@ void pre_container_base::guess_optimal(int &nx,int &ny,int &nz) {
 	nz=int(dz*ilscale+1);
 }
 
+/** Times the computation of the Voronoi cells for an evenly spaced sample of
+ * the particles in a container. The particles are visited in the order of the
+ * blocks, and the sample is timed several times, with the shortest time being
+ * used.
+ * \param[in] con the container to use.
+ * \param[in] st the spacing between the sampled particles.
+ * \return The time taken, in seconds. */
+template<class c_class>
+static double tune_sample_time(c_class &con,int st) {
+	int q,r;
+	double t,bt=large_number;
+	voronoicell c(con);
+	c_loop_all vl(con);
+	for(r=0;r<tune_repeats;r++) {
+		t=voro_wtime();
+		if(vl.start()) {
+			q=0;
+			do {
+				if(q==0) {con.compute_cell(c,vl);q=st;}
+				q--;
+			} while(vl.inc());
+		}
+		t=voro_wtime()-t;
+		if(t<bt) bt=t;
+	}
+	return bt;
+}
+
+/** Finds the smallest initial memory for each block that is large enough to
+ * hold the particles of at least tune_memory_fraction of the occupied blocks
+ * in a container.
+ * \param[in] con the container to use.
+ * \return The initial memory. */
+template<class c_class>
+static int tune_block_memory(c_class &con) {
+	int l,m=0,*h,s=0,no;
+	for(l=0;l<con.nxyz;l++) if(con.co[l]>m) m=con.co[l];
+	h=new int[m+1];
+	for(l=0;l<=m;l++) h[l]=0;
+	for(l=0;l<con.nxyz;l++) h[con.co[l]]++;
+	no=con.nxyz-*h;
+	for(l=1;l<m;l++) {
+		s+=h[l];
+		if(s>=tune_memory_fraction*no) break;
+	}
+	delete [] h;
+	return l;
+}
+
+/** Chooses the grid of blocks and the initial memory for each block by
+ * timing a sample of the Voronoi cells for several candidate grids. The
+ * candidates have block sizes that are spaced by tune_grid_ratio and centered
+ * on the grid chosen by guess_optimal. For each candidate, a container is set
+ * up with all of the particles, and the cells of an evenly spaced sample of
+ * tune_sample_size particles are timed. The fastest grid is chosen, and the
+ * initial memory is then chosen from the number of particles in its blocks.
+ * \param[in] pc the pre-container class holding the particles.
+ * \param[out] (nx,ny,nz) the number of blocks to use.
+ * \param[out] init_mem the initial memory for each block. */
+template<class c_class,class pc_class>
+static void tune_grid_search(pc_class &pc,int &nx,int &ny,int &nz,int &init_mem) {
+	int k,mx,my,mz,n=pc.total_particles(),st=n/tune_sample_size;
+	double dx=pc.bx-pc.ax,dy=pc.by-pc.ay,dz=pc.bz-pc.az,sc,t,bt=large_number,
+	       ilscale=pow(n/(optimal_particles*dx*dy*dz),1/3.0);
+	if(st<1) st=1;
+	nx=ny=nz=0;
+	for(k=0;k<tune_grid_candidates;k++) {
+		sc=ilscale*pow(tune_grid_ratio,k-0.5*(tune_grid_candidates-1));
+		mx=int(dx*sc+1);my=int(dy*sc+1);mz=int(dz*sc+1);
+		if(k>0&&mx==nx&&my==ny&&mz==nz) continue;
+		c_class con(pc.ax,pc.bx,pc.ay,pc.by,pc.az,pc.bz,mx,my,mz,
+			    pc.xperiodic,pc.yperiodic,pc.zperiodic,8);
+		pc.setup(con);
+		t=tune_sample_time(con,st);
+#if VOROPP_VERBOSE >=2
+		fprintf(stderr,"Grid %d by %d by %d: %g s for the sample\n",mx,my,mz,t);
+#endif
+		if(t<bt) {
+			bt=t;nx=mx;ny=my;nz=mz;
+			init_mem=tune_block_memory(con);
+		}
+	}
+}
+
+/** Chooses the grid of blocks and the initial memory for each block of a
+ * container class, by timing the computation of a sample of the Voronoi cells
+ * for several candidate grids. This is slower than guess_optimal, but can
+ * find a much better grid if the particles are not uniformly distributed.
+ * \param[out] (nx,ny,nz) the number of blocks to use.
+ * \param[out] init_mem the initial memory for each block. */
+void pre_container::tune_grid(int &nx,int &ny,int &nz,int &init_mem) {
+	tune_grid_search<container>(*this,nx,ny,nz,init_mem);
+}
+
+/** Chooses the grid of blocks and the initial memory for each block of a
+ * container_poly class, by timing the computation of a sample of the Voronoi
+ * cells for several candidate grids. This is slower than guess_optimal, but
+ * can find a much better grid if the particles are not uniformly distributed.
+ * \param[out] (nx,ny,nz) the number of blocks to use.
+ * \param[out] init_mem the initial memory for each block. */
+void pre_container_poly::tune_grid(int &nx,int &ny,int &nz,int &init_mem) {
+	tune_grid_search<container_poly>(*this,nx,ny,nz,init_mem);
+}
+
 /** Stores a particle ID and position, allocating a new memory chunk if
  * necessary. For coordinate directions in which the container is not periodic,
  * the routine checks to make sure that the particle is within the container
@@ -184,14 +288,14 @@ void pre_container_poly::setup(particle_order &vo,container_poly &con) {
 
 /** Import a list of particles from an open file stream into the container.
  * Entries of four numbers (Particle ID, x position, y position, z position)
- * are searched for. If the file cannot be successfully read, then the routine
- * causes a fatal error.
+ * are searched for. The file is parsed in parallel using the particle_text
+ * class. If the file cannot be successfully read, then the routine causes a
+ * fatal error.
  * \param[in] fp the file handle to read from. */
 void pre_container::import(FILE *fp) {
-	int i,j;
-	double x,y,z;
-	while((j=fscanf(fp,"%d %lg %lg %lg",&i,&x,&y,&z))==4) put(i,x,y,z);
-	if(j!=EOF) voro_fatal_error("File import error",VOROPP_FILE_ERROR);
+	particle_text pt(fp,3);
+	double *pp=pt.p;
+	for(int l=0;l<pt.n;l++,pp+=3) put(pt.id[l],*pp,pp[1],pp[2]);
 }
 
 /** Import a list of particles from an open file stream, also storing the order
@@ -200,10 +304,36 @@ void pre_container::import(FILE *fp) {
  * successfully read, then the routine causes a fatal error.
  * \param[in] fp the file handle to read from. */
 void pre_container_poly::import(FILE *fp) {
-	int i,j;
-	double x,y,z,r;
-	while((j=fscanf(fp,"%d %lg %lg %lg %lg",&i,&x,&y,&z,&r))==5) put(i,x,y,z,r);
-	if(j!=EOF) voro_fatal_error("File import error",VOROPP_FILE_ERROR);
+	particle_text pt(fp,4);
+	double *pp=pt.p;
+	for(int l=0;l<pt.n;l++,pp+=4) put(pt.id[l],*pp,pp[1],pp[2],pp[3]);
+}
+
+/** Imports particles from a file in the binary particle format described in
+ * p_file.hh, without parsing. Any radii in the file are ignored. If the box or
+ * the periodicity stored in the file does not match the container, then the
+ * routine causes a fatal error.
+ * \param[in] filename the name of the file to read. */
+void pre_container::import_binary(const char *filename) {
+	particle_file pf(filename);
+	double box[6]={ax,bx,ay,by,az,bz};
+	pf.check_box((xperiodic?pf_xperiodic:0)|(yperiodic?pf_yperiodic:0)|(zperiodic?pf_zperiodic:0),box);
+	const double *pp=pf.p;
+	for(int l=0;l<pf.n;l++,pp+=pf.ps) put(pf.id[l],*pp,pp[1],pp[2]);
+}
+
+/** Imports particles from a file in the binary particle format described in
+ * p_file.hh, without parsing. If the file does not contain radii, or if the
+ * box or the periodicity stored in the file does not match the container, then
+ * the routine causes a fatal error.
+ * \param[in] filename the name of the file to read. */
+void pre_container_poly::import_binary(const char *filename) {
+	particle_file pf(filename);
+	if(!pf.radii()) voro_fatal_error("Binary particle file does not contain radii",VOROPP_FILE_ERROR);
+	double box[6]={ax,bx,ay,by,az,bz};
+	pf.check_box((xperiodic?pf_xperiodic:0)|(yperiodic?pf_yperiodic:0)|(zperiodic?pf_zperiodic:0),box);
+	const double *pp=pf.p;
+	for(int l=0;l<pf.n;l++,pp+=4) put(pf.id[l],*pp,pp[1],pp[2],pp[3]);
 }
 
 /** Allocates a new chunk of memory for storing particles. */
@@ -121,8 +121,10 @@ class pre_container : public pre_container_base {
 			import(fp);
 			fclose(fp);
 		}
+		void import_binary(const char *filename);
 		void setup(container &con);
 		void setup(particle_order &vo,container &con);
+		void tune_grid(int &nx,int &ny,int &nz,int &init_mem);
 };
 
 /** \brief A class for storing an arbitrary number of particles with radius
@@ -153,8 +155,10 @@ class pre_container_poly : public pre_container_base {
 			import(fp);
 			fclose(fp);
 		}
+		void import_binary(const char *filename);
 		void setup(container_poly &con);
 		void setup(particle_order &vo,container_poly &con);
+		void tune_grid(int &nx,int &ny,int &nz,int &init_mem);
 };
 
 }
@@ -11,10 +11,34 @@
 #ifndef VOROPP_RAD_OPTION_HH
 #define VOROPP_RAD_OPTION_HH
 
+#include <cstdlib>
 #include <cmath>
 
 namespace voro {
 
+/** \brief Structure for holding the constants that are set up prior to
+ * computing a single Voronoi cell.
+ *
+ * Each voro_compute class holds its own copy of this structure and passes it
+ * to the radius routines, so that several threads can compute Voronoi cells
+ * within the same container concurrently. */
+struct radius_scratch {
+	/** The radius squared of the particle whose cell is being
+	 * computed. */
+	double r_rad;
+	/** The radius squared of the particle minus the maximum radius
+	 * squared of any particle that could cut the cell. */
+	double r_mul;
+	/** The scaling factor used during a plane bounds check. */
+	double r_val;
+	/** The radius squared of the particle minus the maximum radius
+	 * squared of the particles near its block. */
+	double r_loc;
+	/** The squared distance beyond which the particles near the block
+	 * lie, or zero if the local maximum radius is not being used. */
+	double r_far;
+};
+
 /** \brief Class containing all of the routines that are specific to computing
  * the regular Voronoi tessellation.
  *
@@ -22,26 +46,47 @@ namespace voro {
  * and during the Voronoi cell computation, these routines are used to create
  * the regular Voronoi tessellation. */
 class radius_mono {
+	public:
+		/** Computes the distance beyond which no particle could cut
+		 * a Voronoi cell that has been computed. For the regular
+		 * tessellation, this is twice the maximum distance to a
+		 * Voronoi vertex.
+		 * \param[in] mrs the maximum distance to a Voronoi vertex
+		 *                multiplied by two, squared.
+		 * \param[in] ijk the block that the particle is within.
+		 * \param[in] q the index of the particle within the block.
+		 * \return The distance. */
+		inline double r_security(double mrs,int ijk,int q) {return sqrt(mrs);}
 	protected:
 		/** This is called prior to computing a Voronoi cell for a
 		 * given particle to initialize any required constants.
 		 * \param[in] ijk the block that the particle is within.
-		 * \param[in] s the index of the particle within the block. */
-		inline void r_init(int ijk,int s) {}
+		 * \param[in] s the index of the particle within the block.
+		 * \param[in,out] rsc the per-computation constants to use. */
+		inline void r_init(int ijk,int s,radius_scratch &rsc) {}
+		/** Switches to a tighter radius bound once the cell is small
+		 * enough, which is not needed for the regular tessellation.
+		 * \param[in] mrs the current maximum distance to a Voronoi
+		 *                vertex multiplied by two.
+		 * \param[in,out] rsc the per-computation constants to use. */
+		inline void r_localize(double mrs,radius_scratch &rsc) {}
 		/** Sets a required constant to be used when carrying out a
-		 * plane bounds check. */
-		inline void r_prime(double rv) {}
+		 * plane bounds check.
+		 * \param[in,out] rsc the per-computation constants to use. */
+		inline void r_prime(double rv,radius_scratch &rsc) {}
 		/** Carries out a radius bounds check.
 		 * \param[in] crs the radius squared to be tested.
 		 * \param[in] mrs the current maximum distance to a Voronoi
 		 *                vertex multiplied by two.
+		 * \param[in,out] rsc the per-computation constants to use.
 		 * \return True if particles at this radius could not possibly
 		 * cut the cell, false otherwise. */
-		inline bool r_ctest(double crs,double mrs) {return crs>mrs;}
+		inline bool r_ctest(double crs,double mrs,radius_scratch &rsc) {return crs>mrs;}
 		/** Scales a plane displacement during a plane bounds check.
 		 * \param[in] lrs the plane displacement.
+		 * \param[in,out] rsc the per-computation constants to use.
 		 * \return The scaled value. */
-		inline double r_cutoff(double lrs) {return lrs;}
+		inline double r_cutoff(double lrs,radius_scratch &rsc) {return lrs;}
 		/** Adds the maximum radius squared to a given value.
 		 * \param[in] rs the value to consider.
 		 * \return The value with the radius squared added. */
@@ -58,8 +103,9 @@ class radius_mono {
 		 * \param[in] rs the initial plane displacement.
 		 * \param[in] ijk the block that the particle is within.
 		 * \param[in] q the index of the particle within the block.
+		 * \param[in,out] rsc the per-computation constants to use.
 		 * \return The scaled plane displacement. */
-		inline double r_scale(double rs,int ijk,int q) {return rs;}
+		inline double r_scale(double rs,int ijk,int q,radius_scratch &rsc) {return rs;}
 		/** Scales a plane displacement prior to use in the plane
 		 * cutting algorithm, and also checks if it could possibly cut
 		 * the cell.
@@ -68,9 +114,10 @@ class radius_mono {
 		 *                vertex multiplied by two.
 		 * \param[in] ijk the block that the particle is within.
 		 * \param[in] q the index of the particle within the block.
+		 * \param[in,out] rsc the per-computation constants to use.
 		 * \return True if the cell could possibly cut the cell, false
 		 * otherwise. */
-		inline bool r_scale_check(double &rs,double mrs,int ijk,int q) {return rs<mrs;}
+		inline bool r_scale_check(double &rs,double mrs,int ijk,int q,radius_scratch &rsc) {return rs<mrs;}
 };
 
 /**  \brief Class containing all of the routines that are specific to computing
@@ -82,37 +129,99 @@ class radius_mono {
 class radius_poly {
 	public:
 		/** A two-dimensional array holding particle positions and radii. */
-		double **ppr;
+		particle_real **ppr;
 		/** The current maximum radius of any particle, used to
 		 * determine when to cut off the radical Voronoi computation.
 		 * */
 		double max_radius;
+		/** The maximum radius squared of the particles in each block,
+		 * recorded when the radius map was built. */
+		double *bmr;
+		/** The maximum radius squared of the particles in the blocks
+		 * within a given reach of each block. */
+		double *lmr;
+		/** The squared distance from a particle to the nearest block
+		 * outside the reach of its own block. */
+		double lmr_far;
+		/** Whether the radius map is current, so that no particle has
+		 * a larger radius than the map records for its block. */
+		bool lmr_ok;
 		/** The class constructor sets the maximum particle radius to
-		 * be zero. */
-		radius_poly() : max_radius(0) {}
+		 * be zero, without building a radius map. */
+		radius_poly() : max_radius(0), bmr(NULL), lmr(NULL), lmr_far(0), lmr_ok(false) {}
+		/** The class destructor frees the radius map. */
+		~radius_poly() {
+			delete [] bmr;
+			delete [] lmr;
+		}
+		/** Computes the distance beyond which no particle could cut
+		 * a Voronoi cell that has been computed. A particle at
+		 * distance d with radius r cuts the cell only if
+		 * d^2+r_i^2-r^2<2dR, where r_i is the radius of the cell's
+		 * particle and R is the maximum distance to a Voronoi vertex,
+		 * so the distance is found by solving this with r set to the
+		 * maximum radius.
+		 * \param[in] mrs the maximum distance to a Voronoi vertex
+		 *                multiplied by two, squared.
+		 * \param[in] ijk the block that the particle is within.
+		 * \param[in] q the index of the particle within the block.
+		 * \return The distance. */
+		inline double r_security(double mrs,int ijk,int q) {
+			double hr=0.25*mrs;
+			return sqrt(hr)+sqrt(hr+max_radius*max_radius-rad_squared(ijk,q));
+		}
 	protected:
 		/** This is called prior to computing a Voronoi cell for a
 		 * given particle to initialize any required constants.
 		 * \param[in] ijk the block that the particle is within.
-		 * \param[in] s the index of the particle within the block. */
-		inline void r_init(int ijk,int s) {
-			r_rad=ppr[ijk][4*s+3]*ppr[ijk][4*s+3];
-			r_mul=r_rad-max_radius*max_radius;
+		 * \param[in] s the index of the particle within the block.
+		 * \param[in,out] rsc the per-computation constants to use. */
+		inline void r_init(int ijk,int s,radius_scratch &rsc) {
+			rsc.r_rad=rad_squared(ijk,s);
+			rsc.r_mul=rsc.r_rad-max_radius*max_radius;
+			if(lmr_ok&&lmr[ijk]<max_radius*max_radius) {
+				rsc.r_loc=rsc.r_rad-lmr[ijk];
+				rsc.r_far=lmr_far;
+			} else rsc.r_far=0;
+		}
+		/** Switches the radius bounds checks from the maximum radius
+		 * of any particle to the maximum radius of the particles near
+		 * the block, once the cell is small enough that no particle
+		 * outside the reach of the block could cut it. Since the cell
+		 * only shrinks during the computation, the switch is never
+		 * undone.
+		 * \param[in] mrs the current maximum distance to a Voronoi
+		 *                vertex multiplied by two.
+		 * \param[in,out] rsc the per-computation constants to use. */
+		inline void r_localize(double mrs,radius_scratch &rsc) {
+			if(rsc.r_far>0&&r_ctest(rsc.r_far,mrs,rsc)) {
+				rsc.r_mul=rsc.r_loc;rsc.r_far=0;
+			}
+		}
+		/** Marks the radius map as out of date if a particle that has
+		 * been added to a block is larger than the map records.
+		 * \param[in] ijk the block that the particle is within.
+		 * \param[in] r the radius of the particle. */
+		inline void r_grow(int ijk,double r) {
+			if(lmr_ok&&r*r>bmr[ijk]) lmr_ok=false;
 		}
 		/** Sets a required constant to be used when carrying out a
-		 * plane bounds check. */
-		inline void r_prime(double rv) {r_val=1+r_mul/rv;}
+		 * plane bounds check.
+		 * \param[in,out] rsc the per-computation constants to use. */
+		inline void r_prime(double rv,radius_scratch &rsc) {rsc.r_val=1+rsc.r_mul/rv;}
 		/** Carries out a radius bounds check.
 		 * \param[in] crs the radius squared to be tested.
 		 * \param[in] mrs the current maximum distance to a Voronoi
 		 *                vertex multiplied by two.
+		 * \param[in,out] rsc the per-computation constants to use.
 		 * \return True if particles at this radius could not possibly
 		 * cut the cell, false otherwise. */
-		inline bool r_ctest(double crs,double mrs) {return crs+r_mul>sqrt(mrs*crs);}
+		inline bool r_ctest(double crs,double mrs,radius_scratch &rsc) {return crs+rsc.r_mul>sqrt(mrs*crs);}
 		/** Scales a plane displacement during a plane bounds check.
 		 * \param[in] lrs the plane displacement.
+		 * \param[in,out] rsc the per-computation constants to use.
 		 * \return The scaled value. */
-		inline double r_cutoff(double lrs) {return lrs*r_val;}
+		inline double r_cutoff(double lrs,radius_scratch &rsc) {return lrs*rsc.r_val;}
 		/** Adds the maximum radius squared to a given value.
 		 * \param[in] rs the value to consider.
 		 * \return The value with the radius squared added. */
@@ -124,16 +233,17 @@ class radius_poly {
 		 * \param[in] q the index of the particle within the block.
 		 * \return The value with the radius squared subtracted. */
 		inline double r_current_sub(double rs,int ijk,int q) {
-			return rs-ppr[ijk][4*q+3]*ppr[ijk][4*q+3];
+			return rs-rad_squared(ijk,q);
 		}
 		/** Scales a plane displacement prior to use in the plane cutting
 		 * algorithm.
 		 * \param[in] rs the initial plane displacement.
 		 * \param[in] ijk the block that the particle is within.
 		 * \param[in] q the index of the particle within the block.
+		 * \param[in,out] rsc the per-computation constants to use.
 		 * \return The scaled plane displacement. */
-		inline double r_scale(double rs,int ijk,int q) {
-			return rs+r_rad-ppr[ijk][4*q+3]*ppr[ijk][4*q+3];
+		inline double r_scale(double rs,int ijk,int q,radius_scratch &rsc) {
+			return rs+rsc.r_rad-rad_squared(ijk,q);
 		}
 		/** Scales a plane displacement prior to use in the plane
 		 * cutting algorithm, and also checks if it could possibly cut
@@ -143,15 +253,24 @@ class radius_poly {
 		 *                vertex multiplied by two.
 		 * \param[in] ijk the block that the particle is within.
 		 * \param[in] q the index of the particle within the block.
+		 * \param[in,out] rsc the per-computation constants to use.
 		 * \return True if the cell could possibly cut the cell, false
 		 * otherwise. */
-		inline bool r_scale_check(double &rs,double mrs,int ijk,int q) {
+		inline bool r_scale_check(double &rs,double mrs,int ijk,int q,radius_scratch &rsc) {
 			double trs=rs;
-			rs+=r_rad-ppr[ijk][4*q+3]*ppr[ijk][4*q+3];
+			rs+=rsc.r_rad-rad_squared(ijk,q);
 			return rs<sqrt(mrs*trs);
 		}
 	private:
-		double r_rad,r_mul,r_val;
+		/** Computes the radius squared of a particle in double
+		 * precision, since the radii may be stored in single precision.
+		 * \param[in] ijk the block that the particle is within.
+		 * \param[in] q the index of the particle within the block.
+		 * \return The radius squared. */
+		inline double rad_squared(int ijk,int q) {
+			double r=ppr[ijk][4*q+3];
+			return r*r;
+		}
 };
 
 }
@@ -12,22 +12,139 @@
 #include "rad_option.hh"
 #include "container.hh"
 #include "container_prd.hh"
+#include "container_sparse.hh"
 
 namespace voro {
 
+/** The class constructor allocates an empty table. The table size is
+ * independent of the number of blocks in the mask.
+ * \param[in] hxyz_ the number of blocks in the mask, which is unused. */
+block_mask_hashed::block_mask_hashed(int hxyz_) : hmem(init_mask_hash_size),
+	hm(hmem-1), n(0), mv(0), mk(new int[hmem]), mg(new unsigned int[hmem]) {
+	reset();
+}
+
+/** Doubles the size of the table, copying across the blocks that have been
+ * marked in the current computation. */
+void block_mask_hashed::grow() {
+	int l,omem=hmem,*omk=mk;
+	unsigned int h,*omg=mg;
+	hmem<<=1;
+	if(hmem>max_mask_hash_size)
+		voro_fatal_error("Hashed mask allocation exceeded absolute maximum",VOROPP_MEMORY_ERROR);
+#if VOROPP_VERBOSE >=2
+	fprintf(stderr,"Hashed mask memory scaled up to %d\n",hmem);
+#endif
+	hm=hmem-1;
+	mk=new int[hmem];mg=new unsigned int[hmem];
+	reset();
+	for(l=0;l<omem;l++) if(omg[l]==mv) {
+		h=hash(omk[l]);
+		while(mg[h]==mv) h=(h+1)&hm;
+		mg[h]=mv;mk[h]=omk[l];
+	}
+	delete [] omg;
+	delete [] omk;
+}
+
+/** Resets all slots of the table to be empty. */
+void block_mask_hashed::reset() {
+	for(unsigned int *mp=mg;mp<mg+hmem;mp++) *mp=0;
+}
+
 /** The class constructor initializes constants from the container class, and
  * sets up the mask and queue used for Voronoi computations.
  * \param[in] con_ a reference to the container class to use.
  * \param[in] (hx_,hy_,hz_) the size of the mask to use. */
-template<class c_class>
-voro_compute<c_class>::voro_compute(c_class &con_,int hx_,int hy_,int hz_) :
+template<class c_class,class p_class,class m_class>
+voro_compute<c_class,p_class,m_class>::voro_compute(c_class &con_,int hx_,int hy_,int hz_) :
 	con(con_), boxx(con_.boxx), boxy(con_.boxy), boxz(con_.boxz),
 	xsp(con_.xsp), ysp(con_.ysp), zsp(con_.zsp),
 	hx(hx_), hy(hy_), hz(hz_), hxy(hx_*hy_), hxyz(hxy*hz_), ps(con_.ps),
 	id(con_.id), p(con_.p), co(con_.co), bxsq(boxx*boxx+boxy*boxy+boxz*boxz),
-	mv(0), qu_size(3*(3+hxy+hz*(hx+hy))), wl(con_.wl), mrad(con_.mrad),
-	mask(new unsigned int[hxyz]), qu(new int[qu_size]), qu_l(qu+qu_size) {
-	reset_mask();
+	qu_size(m_class::queue_size(hx,hy,hz)), wl(con_.wl), mrad(con_.mrad),
+	mask(hxyz), qu(new int[qu_size]), qu_l(qu+qu_size),
+	bmem(init_block_vectors), bv(new double[5*bmem]),
+	bvx(bv), bvy(bv+bmem), bvz(bv+2*bmem), bvr(bv+3*bmem), bvm(bv+4*bmem) {}
+
+/** The class constructor initializes constants from the container class, and
+ * sets up the mask and queue used for Voronoi computations, using a mask of
+ * the same size as that of the container's own voro_compute class. This is
+ * used to set up a separate class for each thread.
+ * \param[in] con_ a reference to the container class to use. */
+template<class c_class,class p_class,class m_class>
+voro_compute<c_class,p_class,m_class>::voro_compute(c_class &con_) :
+	con(con_), boxx(con_.boxx), boxy(con_.boxy), boxz(con_.boxz),
+	xsp(con_.xsp), ysp(con_.ysp), zsp(con_.zsp),
+	hx(con_.vc.hx), hy(con_.vc.hy), hz(con_.vc.hz), hxy(hx*hy), hxyz(hxy*hz), ps(con_.ps),
+	id(con_.id), p(con_.p), co(con_.co), bxsq(boxx*boxx+boxy*boxy+boxz*boxz),
+	qu_size(m_class::queue_size(hx,hy,hz)), wl(con_.wl), mrad(con_.mrad),
+	mask(hxyz), qu(new int[qu_size]), qu_l(qu+qu_size),
+	bmem(init_block_vectors), bv(new double[5*bmem]),
+	bvx(bv), bvy(bv+bmem), bvz(bv+2*bmem), bvr(bv+3*bmem), bvm(bv+4*bmem) {}
+
+/** Computes the displacement vectors from a position to all of the particles
+ * in a block, and their squared lengths, storing them in the bvx, bvy, bvz,
+ * and bvr arrays. If the container has an up-to-date structure-of-arrays copy
+ * of the block, then this is read instead of the interleaved particle data, so
+ * that the loop can be vectorized.
+ * \param[in] ijk the index of the block.
+ * \param[in] (x,y,z) the position to compute the displacements from. */
+template<class c_class,class p_class,class m_class>
+inline void voro_compute<c_class,p_class,m_class>::block_vectors(int ijk,double x,double y,double z) {
+	int l,n=co[ijk];
+	if(n>bmem) add_block_memory(n);
+	if(con.psoa.current(ijk)) {
+		int o=con.psoa.so[ijk];
+		const particle_real *sx=con.psoa.sx+o,*sy=con.psoa.sy+o,*sz=con.psoa.sz+o;
+		double *vx=bvx,*vy=bvy,*vz=bvz,*vr=bvr;
+		for(l=0;l<n;l++) {
+			vx[l]=sx[l]-x;vy[l]=sy[l]-y;vz[l]=sz[l]-z;
+			vr[l]=vx[l]*vx[l]+vy[l]*vy[l]+vz[l]*vz[l];
+		}
+	} else {
+		particle_real *pp=p[ijk];
+		for(l=0;l<n;l++,pp+=ps) {
+			bvx[l]=*pp-x;bvy[l]=pp[1]-y;bvz[l]=pp[2]-z;
+			bvr[l]=bvx[l]*bvx[l]+bvy[l]*bvy[l]+bvz[l]*bvz[l];
+		}
+	}
+}
+
+/** Increases the memory allocation for the block displacement arrays so that
+ * they can hold at least a given number of particles.
+ * \param[in] n the number of particles that must fit. */
+template<class c_class,class p_class,class m_class>
+void voro_compute<c_class,p_class,m_class>::add_block_memory(int n) {
+	while(bmem<n) bmem<<=1;
+	if(bmem>max_particle_memory)
+		voro_fatal_error("Block vector memory allocation exceeded absolute maximum",VOROPP_MEMORY_ERROR);
+	delete [] bv;
+	bv=new double[5*bmem];
+	bvx=bv;bvy=bv+bmem;bvz=bv+2*bmem;bvr=bv+3*bmem;bvm=bv+4*bmem;
+}
+
+/** Cuts a Voronoi cell by the planes of all the particles in a block, using
+ * the displacement vectors in the bvx, bvy, and bvz arrays and the scaled
+ * plane displacements in the bvr array. The planes are taken in batches,
+ * and each batch is first tested in bulk against the vertices of the cell, so
+ * that only those planes that could intersect it are passed to the nplane
+ * routine.
+ * \param[in,out] c a reference to a Voronoi cell.
+ * \param[in] ijk the index of the block.
+ * \return False if the cell was completely removed during the computation,
+ *         true otherwise. */
+template<class c_class,class p_class,class m_class>
+template<class v_cell>
+inline bool voro_compute<c_class,p_class,m_class>::cut_block(v_cell &c,int ijk) {
+	int l,lb,le,n=co[ijk];
+	for(lb=0;lb<n;lb=le) {
+		le=lb+plane_batch_size;if(le>n) le=n;
+		c.plane_bounds(le-lb,bvx+lb,bvy+lb,bvz+lb,bvm+lb);
+		for(l=lb;l<le;l++)
+			if(bvm[l]-bvr[l]>-c.big_tol&&!c.nplane(bvx[l],bvy[l],bvz[l],bvr[l],id[ijk][l])) return false;
+	}
+	return true;
 }
 
 /** Scans all of the particles within a block to see if any of them have a
@@ -43,14 +160,12 @@ voro_compute<c_class>::voro_compute(c_class &con_,int hx_,int hy_,int hz_) :
  *		    vector is within.
  * \param[in,out] mrs the current minimum distance, that may be updated if a
  * 		      closer particle is found. */
-template<class c_class>
-inline void voro_compute<c_class>::scan_all(int ijk,double x,double y,double z,int di,int dj,int dk,particle_record &w,double &mrs) {
-	double x1,y1,z1,rs;bool in_block=false;
+template<class c_class,class p_class,class m_class>
+inline void voro_compute<c_class,p_class,m_class>::scan_all(int ijk,double x,double y,double z,int di,int dj,int dk,particle_record &w,double &mrs) {
+	double rs;bool in_block=false;
+	block_vectors(ijk,x,y,z);
 	for(int l=0;l<co[ijk];l++) {
-		x1=p[ijk][ps*l]-x;
-		y1=p[ijk][ps*l+1]-y;
-		z1=p[ijk][ps*l+2]-z;
-		rs=con.r_current_sub(x1*x1+y1*y1+z1*z1,ijk,l);
+		rs=con.r_current_sub(bvr[l],ijk,l);
 		if(rs<mrs) {mrs=rs;w.l=l;in_block=true;}
 	}
 	if(in_block) {w.ijk=ijk;w.di=di;w.dj=dj,w.dk=dk;}
@@ -67,17 +182,18 @@ inline void voro_compute<c_class>::scan_all(int ijk,double x,double y,double z,i
  * \param[out] w a reference to a particle record in which to store information
  * 		 about the particle whose Voronoi cell the vector is within.
  * \param[out] mrs the minimum computed distance. */
-template<class c_class>
-void voro_compute<c_class>::find_voronoi_cell(double x,double y,double z,int ci,int cj,int ck,int ijk,particle_record &w,double &mrs) {
+template<class c_class,class p_class,class m_class>
+void voro_compute<c_class,p_class,m_class>::find_voronoi_cell(double x,double y,double z,int ci,int cj,int ck,int ijk,particle_record &w,double &mrs) {
 	double qx=0,qy=0,qz=0,rs;
 	int i,j,k,di,dj,dk,ei,ej,ek,f,g,disp;
 	double fx,fy,fz,mxs,mys,mzs,*radp;
-	unsigned int q,*e,*mijk;
+	unsigned int q,*e;
+	int mijk;
 
 	// Init setup for parameters to return
 	w.ijk=-1;mrs=large_number;
 
-	con.initialize_search(ci,cj,ck,ijk,i,j,k,disp);
+	p_class::initialize_search(con,ci,cj,ck,ijk,i,j,k,disp);
 
 	// Test all particles in the particle's local region first
 	scan_all(ijk,x,y,z,0,0,0,w,mrs);
@@ -152,7 +268,7 @@ void voro_compute<c_class>::find_voronoi_cell(double x,double y,double z,int ci,
 
 		// Now compute which region we are going to loop over, adding a
 		// displacement for the periodic cases
-		ijk=con.region_index(ci,cj,ck,ei,ej,ek,qx,qy,qz,disp);
+		ijk=p_class::region_index(con,ci,cj,ck,ei,ej,ek,qx,qy,qz,disp);
 
 		// If mrs is bigger than the maximum distance to the block,
 		// then we have to test all particles in the block for
@@ -162,8 +278,7 @@ void voro_compute<c_class>::find_voronoi_cell(double x,double y,double z,int ci,
 	} while(g<f);
 
 	// Update mask value and initialize queue
-	mv++;
-	if(mv==0) {reset_mask();mv=1;}
+	mask.advance();
 	int *qu_s=qu,*qu_e=qu;
 
 	while(g<wl_seq_length-1) {
@@ -187,8 +302,8 @@ void voro_compute<c_class>::find_voronoi_cell(double x,double y,double z,int ci,
 		ei=di+i;if(ei<0||ei>=hx) continue;
 		ej=dj+j;if(ej<0||ej>=hy) continue;
 		ek=dk+k;if(ek<0||ek>=hz) continue;
-		mijk=mask+ei+hx*(ej+hy*ek);
-		*mijk=mv;
+		mijk=ei+hx*(ej+hy*ek);
+		mask.mark(mijk);
 
 		// Skip this block if it is further away than the current
 		// minimum radius
@@ -196,7 +311,7 @@ void voro_compute<c_class>::find_voronoi_cell(double x,double y,double z,int ci,
 
 		// Now compute which region we are going to loop over, adding a
 		// displacement for the periodic cases
-		ijk=con.region_index(ci,cj,ck,ei,ej,ek,qx,qy,qz,disp);
+		ijk=p_class::region_index(con,ci,cj,ck,ei,ej,ek,qx,qy,qz,disp);
 		scan_all(ijk,x-qx,y-qy,z-qz,di,dj,dk,w,mrs);
 
 		if(qu_e>qu_l-18) add_list_memory(qu_s,qu_e);
@@ -217,7 +332,7 @@ void voro_compute<c_class>::find_voronoi_cell(double x,double y,double z,int ci,
 		di=ei-i;dj=ej-j;dk=ek-k;
 		if(compute_min_radius(di,dj,dk,fx,fy,fz,mrs)) continue;
 
-		ijk=con.region_index(ci,cj,ck,ei,ej,ek,qx,qy,qz,disp);
+		ijk=p_class::region_index(con,ci,cj,ck,ei,ej,ek,qx,qy,qz,disp);
 		scan_all(ijk,x-qx,y-qy,z-qz,di,dj,dk,w,mrs);
 
 		// Test the neighbors of the current block, and add them to the
@@ -232,35 +347,35 @@ void voro_compute<c_class>::find_voronoi_cell(double x,double y,double z,int ci,
  * will definitely have enough memory to add six entries at the end.
  * \param[in] (ei,ej,ek) the block to consider.
  * \param[in,out] qu_e a pointer to the end of the queue. */
-template<class c_class>
-inline void voro_compute<c_class>::add_to_mask(int ei,int ej,int ek,int *&qu_e) {
-	unsigned int *mijk=mask+ei+hx*(ej+hy*ek);
-	if(ek>0) if(*(mijk-hxy)!=mv) {if(qu_e==qu_l) qu_e=qu;*(mijk-hxy)=mv;*(qu_e++)=ei;*(qu_e++)=ej;*(qu_e++)=ek-1;}
-	if(ej>0) if(*(mijk-hx)!=mv) {if(qu_e==qu_l) qu_e=qu;*(mijk-hx)=mv;*(qu_e++)=ei;*(qu_e++)=ej-1;*(qu_e++)=ek;}
-	if(ei>0) if(*(mijk-1)!=mv) {if(qu_e==qu_l) qu_e=qu;*(mijk-1)=mv;*(qu_e++)=ei-1;*(qu_e++)=ej;*(qu_e++)=ek;}
-	if(ei<hx-1) if(*(mijk+1)!=mv) {if(qu_e==qu_l) qu_e=qu;*(mijk+1)=mv;*(qu_e++)=ei+1;*(qu_e++)=ej;*(qu_e++)=ek;}
-	if(ej<hy-1) if(*(mijk+hx)!=mv) {if(qu_e==qu_l) qu_e=qu;*(mijk+hx)=mv;*(qu_e++)=ei;*(qu_e++)=ej+1;*(qu_e++)=ek;}
-	if(ek<hz-1) if(*(mijk+hxy)!=mv) {if(qu_e==qu_l) qu_e=qu;*(mijk+hxy)=mv;*(qu_e++)=ei;*(qu_e++)=ej;*(qu_e++)=ek+1;}
+template<class c_class,class p_class,class m_class>
+inline void voro_compute<c_class,p_class,m_class>::add_to_mask(int ei,int ej,int ek,int *&qu_e) {
+	int mijk=ei+hx*(ej+hy*ek);
+	if(ek>0) if(mask.mark_new(mijk-hxy)) {if(qu_e==qu_l) qu_e=qu;*(qu_e++)=ei;*(qu_e++)=ej;*(qu_e++)=ek-1;}
+	if(ej>0) if(mask.mark_new(mijk-hx)) {if(qu_e==qu_l) qu_e=qu;*(qu_e++)=ei;*(qu_e++)=ej-1;*(qu_e++)=ek;}
+	if(ei>0) if(mask.mark_new(mijk-1)) {if(qu_e==qu_l) qu_e=qu;*(qu_e++)=ei-1;*(qu_e++)=ej;*(qu_e++)=ek;}
+	if(ei<hx-1) if(mask.mark_new(mijk+1)) {if(qu_e==qu_l) qu_e=qu;*(qu_e++)=ei+1;*(qu_e++)=ej;*(qu_e++)=ek;}
+	if(ej<hy-1) if(mask.mark_new(mijk+hx)) {if(qu_e==qu_l) qu_e=qu;*(qu_e++)=ei;*(qu_e++)=ej+1;*(qu_e++)=ek;}
+	if(ek<hz-1) if(mask.mark_new(mijk+hxy)) {if(qu_e==qu_l) qu_e=qu;*(qu_e++)=ei;*(qu_e++)=ej;*(qu_e++)=ek+1;}
 }
 
 /** Scans a worklist entry and adds any blocks to the queue
  * \param[in] (ei,ej,ek) the block to consider.
  * \param[in,out] qu_e a pointer to the end of the queue. */
-template<class c_class>
-inline void voro_compute<c_class>::scan_bits_mask_add(unsigned int q,unsigned int *mijk,int ei,int ej,int ek,int *&qu_e) {
+template<class c_class,class p_class,class m_class>
+inline void voro_compute<c_class,p_class,m_class>::scan_bits_mask_add(unsigned int q,int mijk,int ei,int ej,int ek,int *&qu_e) {
 	const unsigned int b1=1<<21,b2=1<<22,b3=1<<24,b4=1<<25,b5=1<<27,b6=1<<28;
 	if((q&b2)==b2) {
-		if(ei>0) {*(mijk-1)=mv;*(qu_e++)=ei-1;*(qu_e++)=ej;*(qu_e++)=ek;}
-		if((q&b1)==0&&ei<hx-1) {*(mijk+1)=mv;*(qu_e++)=ei+1;*(qu_e++)=ej;*(qu_e++)=ek;}
-	} else if((q&b1)==b1&&ei<hx-1) {*(mijk+1)=mv;*(qu_e++)=ei+1;*(qu_e++)=ej;*(qu_e++)=ek;}
+		if(ei>0) {mask.mark(mijk-1);*(qu_e++)=ei-1;*(qu_e++)=ej;*(qu_e++)=ek;}
+		if((q&b1)==0&&ei<hx-1) {mask.mark(mijk+1);*(qu_e++)=ei+1;*(qu_e++)=ej;*(qu_e++)=ek;}
+	} else if((q&b1)==b1&&ei<hx-1) {mask.mark(mijk+1);*(qu_e++)=ei+1;*(qu_e++)=ej;*(qu_e++)=ek;}
 	if((q&b4)==b4) {
-		if(ej>0) {*(mijk-hx)=mv;*(qu_e++)=ei;*(qu_e++)=ej-1;*(qu_e++)=ek;}
-		if((q&b3)==0&&ej<hy-1) {*(mijk+hx)=mv;*(qu_e++)=ei;*(qu_e++)=ej+1;*(qu_e++)=ek;}
-	} else if((q&b3)==b3&&ej<hy-1) {*(mijk+hx)=mv;*(qu_e++)=ei;*(qu_e++)=ej+1;*(qu_e++)=ek;}
+		if(ej>0) {mask.mark(mijk-hx);*(qu_e++)=ei;*(qu_e++)=ej-1;*(qu_e++)=ek;}
+		if((q&b3)==0&&ej<hy-1) {mask.mark(mijk+hx);*(qu_e++)=ei;*(qu_e++)=ej+1;*(qu_e++)=ek;}
+	} else if((q&b3)==b3&&ej<hy-1) {mask.mark(mijk+hx);*(qu_e++)=ei;*(qu_e++)=ej+1;*(qu_e++)=ek;}
 	if((q&b6)==b6) {
-		if(ek>0) {*(mijk-hxy)=mv;*(qu_e++)=ei;*(qu_e++)=ej;*(qu_e++)=ek-1;}
-		if((q&b5)==0&&ek<hz-1) {*(mijk+hxy)=mv;*(qu_e++)=ei;*(qu_e++)=ej;*(qu_e++)=ek+1;}
-	} else if((q&b5)==b5&&ek<hz-1) {*(mijk+hxy)=mv;*(qu_e++)=ei;*(qu_e++)=ej;*(qu_e++)=ek+1;}
+		if(ek>0) {mask.mark(mijk-hxy);*(qu_e++)=ei;*(qu_e++)=ej;*(qu_e++)=ek-1;}
+		if((q&b5)==0&&ek<hz-1) {mask.mark(mijk+hxy);*(qu_e++)=ei;*(qu_e++)=ej;*(qu_e++)=ek+1;}
+	} else if((q&b5)==b5&&ek<hz-1) {mask.mark(mijk+hxy);*(qu_e++)=ei;*(qu_e++)=ej;*(qu_e++)=ek+1;}
 }
 
 /** This routine computes a Voronoi cell for a single particle in the
@@ -286,18 +401,19 @@ inline void voro_compute<c_class>::scan_bits_mask_add(unsigned int q,unsigned in
  *                       in relative to the container data structure.
  * \return False if the Voronoi cell was completely removed during the
  *         computation and has zero volume, true otherwise. */
-template<class c_class>
+template<class c_class,class p_class,class m_class>
 template<class v_cell>
-bool voro_compute<c_class>::compute_cell(v_cell &c,int ijk,int s,int ci,int cj,int ck) {
+bool voro_compute<c_class,p_class,m_class>::compute_cell(v_cell &c,int ijk,int s,int ci,int cj,int ck) {
 	static const int count_list[8]={7,11,15,19,26,35,45,59},*count_e=count_list+8;
-	double x,y,z,x1,y1,z1,qx=0,qy=0,qz=0;
-	double xlo,ylo,zlo,xhi,yhi,zhi,x2,y2,z2,rs;
+	double x,y,z,qx=0,qy=0,qz=0;
+	double xlo,ylo,zlo,xhi,yhi,zhi;
 	int i,j,k,di,dj,dk,ei,ej,ek,f,g,l,disp;
 	double fx,fy,fz,gxs,gys,gzs,*radp;
-	unsigned int q,*e,*mijk;
+	unsigned int q,*e;
+	int mijk;
 
-	if(!con.initialize_voronoicell(c,ijk,s,ci,cj,ck,i,j,k,x,y,z,disp)) return false;
-	con.r_init(ijk,s);
+	if(!p_class::initialize_voronoicell(con,c,ijk,s,ci,cj,ck,i,j,k,x,y,z,disp)) return false;
+	con.r_init(ijk,s,rsc);
 
 	// Initialize the Voronoi cell to fill the entire container
 	double crs,mrs;
@@ -305,27 +421,17 @@ bool voro_compute<c_class>::compute_cell(v_cell &c,int ijk,int s,int ci,int cj,i
 	int next_count=3,*count_p=(const_cast<int*> (count_list));
 
 	// Test all particles in the particle's local region first
-	for(l=0;l<s;l++) {
-		x1=p[ijk][ps*l]-x;
-		y1=p[ijk][ps*l+1]-y;
-		z1=p[ijk][ps*l+2]-z;
-		rs=con.r_scale(x1*x1+y1*y1+z1*z1,ijk,l);
-		if(!c.nplane(x1,y1,z1,rs,id[ijk][l])) return false;
-	}
-	l++;
-	while(l<co[ijk]) {
-		x1=p[ijk][ps*l]-x;
-		y1=p[ijk][ps*l+1]-y;
-		z1=p[ijk][ps*l+2]-z;
-		rs=con.r_scale(x1*x1+y1*y1+z1*z1,ijk,l);
-		if(!c.nplane(x1,y1,z1,rs,id[ijk][l])) return false;
-		l++;
-	}
+	block_vectors(ijk,x,y,z);
+	for(l=0;l<co[ijk];l++) bvr[l]=con.r_scale(bvr[l],ijk,l,rsc);
+	bvr[s]=large_number;
+	if(!cut_block(c,ijk)) return false;
 
 	// Now compute the maximum distance squared from the cell center to a
 	// vertex. This is used to cut off the calculation since we only need
-	// to test out to twice this range.
+	// to test out to twice this range. Once the cell is small enough, the
+	// radius bounds only need to consider the particles near the block.
 	mrs=c.max_radius_squared();
+	con.r_localize(mrs,rsc);
 
 	// Now compute the fractional position of the particle within its
 	// region and store it in (fx,fy,fz). We use this to compute an index
@@ -370,12 +476,13 @@ bool voro_compute<c_class>::compute_cell(v_cell &c,int ijk,int s,int ci,int cj,i
 		// maximum radius squared
 		if(g==next_count) {
 			mrs=c.max_radius_squared();
+			con.r_localize(mrs,rsc);
 			if(count_p!=count_e) next_count=*(count_p++);
 		}
 
 		// If mrs is less than the minimum distance to any untested
 		// block, then we are done
-		if(con.r_ctest(radp[g],mrs)) return true;
+		if(con.r_ctest(radp[g],mrs,rsc)) return true;
 		g++;
 
 		// Load in a block off the worklist, permute it with the
@@ -400,33 +507,21 @@ bool voro_compute<c_class>::compute_cell(v_cell &c,int ijk,int s,int ci,int cj,i
 
 		// Now compute which region we are going to loop over, adding a
 		// displacement for the periodic cases
-		ijk=con.region_index(ci,cj,ck,ei,ej,ek,qx,qy,qz,disp);
+		ijk=p_class::region_index(con,ci,cj,ck,ei,ej,ek,qx,qy,qz,disp);
 
 		// If mrs is bigger than the maximum distance to the block,
 		// then we have to test all particles in the block for
 		// intersections. Otherwise, we do additional checks and skip
 		// those particles which can't possibly intersect the block.
 		if(co[ijk]>0) {
-			l=0;x2=x-qx;y2=y-qy;z2=z-qz;
-			if(!con.r_ctest(crs,mrs)) {
-				do {
-					x1=p[ijk][ps*l]-x2;
-					y1=p[ijk][ps*l+1]-y2;
-					z1=p[ijk][ps*l+2]-z2;
-					rs=con.r_scale(x1*x1+y1*y1+z1*z1,ijk,l);
-					if(!c.nplane(x1,y1,z1,rs,id[ijk][l])) return false;
-					l++;
-				} while (l<co[ijk]);
+			block_vectors(ijk,x-qx,y-qy,z-qz);
+			if(!con.r_ctest(crs,mrs,rsc)) {
+				for(l=0;l<co[ijk];l++) bvr[l]=con.r_scale(bvr[l],ijk,l,rsc);
 			} else {
-				do {
-					x1=p[ijk][ps*l]-x2;
-					y1=p[ijk][ps*l+1]-y2;
-					z1=p[ijk][ps*l+2]-z2;
-					rs=x1*x1+y1*y1+z1*z1;
-					if(con.r_scale_check(rs,mrs,ijk,l)&&!c.nplane(x1,y1,z1,rs,id[ijk][l])) return false;
-					l++;
-				} while (l<co[ijk]);
+				for(l=0;l<co[ijk];l++)
+					if(!con.r_scale_check(bvr[l],mrs,ijk,l,rsc)) bvr[l]=large_number;
 			}
+			if(!cut_block(c,ijk)) return false;
 		}
 	} while(g<f);
 
@@ -440,8 +535,7 @@ bool voro_compute<c_class>::compute_cell(v_cell &c,int ijk,int s,int ci,int cj,i
 	// points in a list in case we have to go block by block. Update the
 	// mask counter, and if it wraps around then reset the whole mask; that
 	// will only happen once every 2^32 tries.
-	mv++;
-	if(mv==0) {reset_mask();mv=1;}
+	mask.advance();
 
 	// Set the queue pointers
 	int *qu_s=qu,*qu_e=qu;
@@ -452,12 +546,13 @@ bool voro_compute<c_class>::compute_cell(v_cell &c,int ijk,int s,int ci,int cj,i
 		// maximum radius squared
 		if(g==next_count) {
 			mrs=c.max_radius_squared();
+			con.r_localize(mrs,rsc);
 			if(count_p!=count_e) next_count=*(count_p++);
 		}
 
 		// If mrs is less than the minimum distance to any untested
 		// block, then we are done
-		if(con.r_ctest(radp[g],mrs)) return true;
+		if(con.r_ctest(radp[g],mrs,rsc)) return true;
 		g++;
 
 		// Load in a block off the worklist, permute it with the
@@ -474,8 +569,8 @@ bool voro_compute<c_class>::compute_cell(v_cell &c,int ijk,int s,int ci,int cj,i
 		ei=di+i;if(ei<0||ei>=hx) continue;
 		ej=dj+j;if(ej<0||ej>=hy) continue;
 		ek=dk+k;if(ek<0||ek>=hz) continue;
-		mijk=mask+ei+hx*(ej+hy*ek);
-		*mijk=mv;
+		mijk=ei+hx*(ej+hy*ek);
+		mask.mark(mijk);
 
 		// Call the compute_min_max_radius() function. This returns
 		// true if the minimum distance to the block is bigger than the
@@ -486,33 +581,21 @@ bool voro_compute<c_class>::compute_cell(v_cell &c,int ijk,int s,int ci,int cj,i
 
 		// Now compute which region we are going to loop over, adding a
 		// displacement for the periodic cases
-		ijk=con.region_index(ci,cj,ck,ei,ej,ek,qx,qy,qz,disp);
+		ijk=p_class::region_index(con,ci,cj,ck,ei,ej,ek,qx,qy,qz,disp);
 
 		// If mrs is bigger than the maximum distance to the block,
 		// then we have to test all particles in the block for
 		// intersections. Otherwise, we do additional checks and skip
 		// those particles which can't possibly intersect the block.
 		if(co[ijk]>0) {
-			l=0;x2=x-qx;y2=y-qy;z2=z-qz;
-			if(!con.r_ctest(crs,mrs)) {
-				do {
-					x1=p[ijk][ps*l]-x2;
-					y1=p[ijk][ps*l+1]-y2;
-					z1=p[ijk][ps*l+2]-z2;
-					rs=con.r_scale(x1*x1+y1*y1+z1*z1,ijk,l);
-					if(!c.nplane(x1,y1,z1,rs,id[ijk][l])) return false;
-					l++;
-				} while (l<co[ijk]);
+			block_vectors(ijk,x-qx,y-qy,z-qz);
+			if(!con.r_ctest(crs,mrs,rsc)) {
+				for(l=0;l<co[ijk];l++) bvr[l]=con.r_scale(bvr[l],ijk,l,rsc);
 			} else {
-				do {
-					x1=p[ijk][ps*l]-x2;
-					y1=p[ijk][ps*l+1]-y2;
-					z1=p[ijk][ps*l+2]-z2;
-					rs=x1*x1+y1*y1+z1*z1;
-					if(con.r_scale_check(rs,mrs,ijk,l)&&!c.nplane(x1,y1,z1,rs,id[ijk][l])) return false;
-					l++;
-				} while (l<co[ijk]);
+				for(l=0;l<co[ijk];l++)
+					if(!con.r_scale_check(bvr[l],mrs,ijk,l,rsc)) bvr[l]=large_number;
 			}
+			if(!cut_block(c,ijk)) return false;
 		}
 
 		// If there might not be enough memory on the list for these
@@ -526,7 +609,7 @@ bool voro_compute<c_class>::compute_cell(v_cell &c,int ijk,int s,int ci,int cj,i
 	}
 
 	// Do a check to see if we've reached the radius cutoff
-	if(con.r_ctest(radp[g],mrs)) return true;
+	if(con.r_ctest(radp[g],mrs,rsc)) return true;
 
 	// We were unable to completely compute the cell based on the blocks in
 	// the worklist, so now we have to go block by block, reading in items
@@ -592,21 +675,15 @@ bool voro_compute<c_class>::compute_cell(v_cell &c,int ijk,int s,int ci,int cj,i
 
 		// Now compute the region that we are going to test over, and
 		// set a displacement vector for the periodic cases
-		ijk=con.region_index(ci,cj,ck,ei,ej,ek,qx,qy,qz,disp);
+		ijk=p_class::region_index(con,ci,cj,ck,ei,ej,ek,qx,qy,qz,disp);
 
 		// Loop over all the elements in the block to test for cuts. It
 		// would be possible to exclude some of these cases by testing
 		// against mrs, but this will probably not save time.
 		if(co[ijk]>0) {
-			l=0;x2=x-qx;y2=y-qy;z2=z-qz;
-			do {
-				x1=p[ijk][ps*l]-x2;
-				y1=p[ijk][ps*l+1]-y2;
-				z1=p[ijk][ps*l+2]-z2;
-				rs=con.r_scale(x1*x1+y1*y1+z1*z1,ijk,l);
-				if(!c.nplane(x1,y1,z1,rs,id[ijk][l])) return false;
-				l++;
-			} while (l<co[ijk]);
+			block_vectors(ijk,x-qx,y-qy,z-qz);
+			for(l=0;l<co[ijk];l++) bvr[l]=con.r_scale(bvr[l],ijk,l,rsc);
+			if(!cut_block(c,ijk)) return false;
 		}
 
 		// If there's not much memory on the block list then add more
@@ -629,16 +706,16 @@ bool voro_compute<c_class>::compute_cell(v_cell &c,int ijk,int s,int ci,int cj,i
  * \param[in] (xh,yh,zh) the relative coordinates of the corner of the block
  *                       furthest away from the cell center.
  * \return False if the block may intersect, true if does not. */
-template<class c_class>
+template<class c_class,class p_class,class m_class>
 template<class v_cell>
-bool voro_compute<c_class>::corner_test(v_cell &c,double xl,double yl,double zl,double xh,double yh,double zh) {
-	con.r_prime(xl*xl+yl*yl+zl*zl);
-	if(c.plane_intersects_guess(xh,yl,zl,con.r_cutoff(xl*xh+yl*yl+zl*zl))) return false;
-	if(c.plane_intersects(xh,yh,zl,con.r_cutoff(xl*xh+yl*yh+zl*zl))) return false;
-	if(c.plane_intersects(xl,yh,zl,con.r_cutoff(xl*xl+yl*yh+zl*zl))) return false;
-	if(c.plane_intersects(xl,yh,zh,con.r_cutoff(xl*xl+yl*yh+zl*zh))) return false;
-	if(c.plane_intersects(xl,yl,zh,con.r_cutoff(xl*xl+yl*yl+zl*zh))) return false;
-	if(c.plane_intersects(xh,yl,zh,con.r_cutoff(xl*xh+yl*yl+zl*zh))) return false;
+bool voro_compute<c_class,p_class,m_class>::corner_test(v_cell &c,double xl,double yl,double zl,double xh,double yh,double zh) {
+	con.r_prime(xl*xl+yl*yl+zl*zl,rsc);
+	if(c.plane_intersects_guess(xh,yl,zl,con.r_cutoff(xl*xh+yl*yl+zl*zl,rsc))) return false;
+	if(c.plane_intersects(xh,yh,zl,con.r_cutoff(xl*xh+yl*yh+zl*zl,rsc))) return false;
+	if(c.plane_intersects(xl,yh,zl,con.r_cutoff(xl*xl+yl*yh+zl*zl,rsc))) return false;
+	if(c.plane_intersects(xl,yh,zh,con.r_cutoff(xl*xl+yl*yh+zl*zh,rsc))) return false;
+	if(c.plane_intersects(xl,yl,zh,con.r_cutoff(xl*xl+yl*yl+zl*zh,rsc))) return false;
+	if(c.plane_intersects(xh,yl,zh,con.r_cutoff(xl*xh+yl*yl+zl*zh,rsc))) return false;
 	return true;
 }
 
@@ -654,16 +731,16 @@ bool voro_compute<c_class>::corner_test(v_cell &c,double xl,double yl,double zl,
  * \param[in] (yh,zh) the relative y and z coordinates of the corner of the
  *                    block furthest away from the cell center.
  * \return False if the block may intersect, true if does not. */
-template<class c_class>
+template<class c_class,class p_class,class m_class>
 template<class v_cell>
-inline bool voro_compute<c_class>::edge_x_test(v_cell &c,double x0,double yl,double zl,double x1,double yh,double zh) {
-	con.r_prime(yl*yl+zl*zl);
-	if(c.plane_intersects_guess(x0,yl,zh,con.r_cutoff(yl*yl+zl*zh))) return false;
-	if(c.plane_intersects(x1,yl,zh,con.r_cutoff(yl*yl+zl*zh))) return false;
-	if(c.plane_intersects(x1,yl,zl,con.r_cutoff(yl*yl+zl*zl))) return false;
-	if(c.plane_intersects(x0,yl,zl,con.r_cutoff(yl*yl+zl*zl))) return false;
-	if(c.plane_intersects(x0,yh,zl,con.r_cutoff(yl*yh+zl*zl))) return false;
-	if(c.plane_intersects(x1,yh,zl,con.r_cutoff(yl*yh+zl*zl))) return false;
+inline bool voro_compute<c_class,p_class,m_class>::edge_x_test(v_cell &c,double x0,double yl,double zl,double x1,double yh,double zh) {
+	con.r_prime(yl*yl+zl*zl,rsc);
+	if(c.plane_intersects_guess(x0,yl,zh,con.r_cutoff(yl*yl+zl*zh,rsc))) return false;
+	if(c.plane_intersects(x1,yl,zh,con.r_cutoff(yl*yl+zl*zh,rsc))) return false;
+	if(c.plane_intersects(x1,yl,zl,con.r_cutoff(yl*yl+zl*zl,rsc))) return false;
+	if(c.plane_intersects(x0,yl,zl,con.r_cutoff(yl*yl+zl*zl,rsc))) return false;
+	if(c.plane_intersects(x0,yh,zl,con.r_cutoff(yl*yh+zl*zl,rsc))) return false;
+	if(c.plane_intersects(x1,yh,zl,con.r_cutoff(yl*yh+zl*zl,rsc))) return false;
 	return true;
 }
 
@@ -679,16 +756,16 @@ inline bool voro_compute<c_class>::edge_x_test(v_cell &c,double x0,double yl,dou
  * \param[in] (xh,zh) the relative x and z coordinates of the corner of the
  *                    block furthest away from the cell center.
  * \return False if the block may intersect, true if does not. */
-template<class c_class>
+template<class c_class,class p_class,class m_class>
 template<class v_cell>
-inline bool voro_compute<c_class>::edge_y_test(v_cell &c,double xl,double y0,double zl,double xh,double y1,double zh) {
-	con.r_prime(xl*xl+zl*zl);
-	if(c.plane_intersects_guess(xl,y0,zh,con.r_cutoff(xl*xl+zl*zh))) return false;
-	if(c.plane_intersects(xl,y1,zh,con.r_cutoff(xl*xl+zl*zh))) return false;
-	if(c.plane_intersects(xl,y1,zl,con.r_cutoff(xl*xl+zl*zl))) return false;
-	if(c.plane_intersects(xl,y0,zl,con.r_cutoff(xl*xl+zl*zl))) return false;
-	if(c.plane_intersects(xh,y0,zl,con.r_cutoff(xl*xh+zl*zl))) return false;
-	if(c.plane_intersects(xh,y1,zl,con.r_cutoff(xl*xh+zl*zl))) return false;
+inline bool voro_compute<c_class,p_class,m_class>::edge_y_test(v_cell &c,double xl,double y0,double zl,double xh,double y1,double zh) {
+	con.r_prime(xl*xl+zl*zl,rsc);
+	if(c.plane_intersects_guess(xl,y0,zh,con.r_cutoff(xl*xl+zl*zh,rsc))) return false;
+	if(c.plane_intersects(xl,y1,zh,con.r_cutoff(xl*xl+zl*zh,rsc))) return false;
+	if(c.plane_intersects(xl,y1,zl,con.r_cutoff(xl*xl+zl*zl,rsc))) return false;
+	if(c.plane_intersects(xl,y0,zl,con.r_cutoff(xl*xl+zl*zl,rsc))) return false;
+	if(c.plane_intersects(xh,y0,zl,con.r_cutoff(xl*xh+zl*zl,rsc))) return false;
+	if(c.plane_intersects(xh,y1,zl,con.r_cutoff(xl*xh+zl*zl,rsc))) return false;
 	return true;
 }
 
@@ -703,16 +780,16 @@ inline bool voro_compute<c_class>::edge_y_test(v_cell &c,double xl,double y0,dou
  * \param[in] (xh,yh) the relative x and y coordinates of the corner of the
  *                    block furthest away from the cell center.
  * \return False if the block may intersect, true if does not. */
-template<class c_class>
+template<class c_class,class p_class,class m_class>
 template<class v_cell>
-inline bool voro_compute<c_class>::edge_z_test(v_cell &c,double xl,double yl,double z0,double xh,double yh,double z1) {
-	con.r_prime(xl*xl+yl*yl);
-	if(c.plane_intersects_guess(xl,yh,z0,con.r_cutoff(xl*xl+yl*yh))) return false;
-	if(c.plane_intersects(xl,yh,z1,con.r_cutoff(xl*xl+yl*yh))) return false;
-	if(c.plane_intersects(xl,yl,z1,con.r_cutoff(xl*xl+yl*yl))) return false;
-	if(c.plane_intersects(xl,yl,z0,con.r_cutoff(xl*xl+yl*yl))) return false;
-	if(c.plane_intersects(xh,yl,z0,con.r_cutoff(xl*xh+yl*yl))) return false;
-	if(c.plane_intersects(xh,yl,z1,con.r_cutoff(xl*xh+yl*yl))) return false;
+inline bool voro_compute<c_class,p_class,m_class>::edge_z_test(v_cell &c,double xl,double yl,double z0,double xh,double yh,double z1) {
+	con.r_prime(xl*xl+yl*yl,rsc);
+	if(c.plane_intersects_guess(xl,yh,z0,con.r_cutoff(xl*xl+yl*yh,rsc))) return false;
+	if(c.plane_intersects(xl,yh,z1,con.r_cutoff(xl*xl+yl*yh,rsc))) return false;
+	if(c.plane_intersects(xl,yl,z1,con.r_cutoff(xl*xl+yl*yl,rsc))) return false;
+	if(c.plane_intersects(xl,yl,z0,con.r_cutoff(xl*xl+yl*yl,rsc))) return false;
+	if(c.plane_intersects(xh,yl,z0,con.r_cutoff(xl*xh+yl*yl,rsc))) return false;
+	if(c.plane_intersects(xh,yl,z1,con.r_cutoff(xl*xh+yl*yl,rsc))) return false;
 	return true;
 }
 
@@ -726,14 +803,14 @@ inline bool voro_compute<c_class>::edge_z_test(v_cell &c,double xl,double yl,dou
  * \param[in] (z0,z1) the minimum and maximum relative z coordinates of the
  *                    block.
  * \return False if the block may intersect, true if does not. */
-template<class c_class>
+template<class c_class,class p_class,class m_class>
 template<class v_cell>
-inline bool voro_compute<c_class>::face_x_test(v_cell &c,double xl,double y0,double z0,double y1,double z1) {
-	con.r_prime(xl*xl);
-	if(c.plane_intersects_guess(xl,y0,z0,con.r_cutoff(xl*xl))) return false;
-	if(c.plane_intersects(xl,y0,z1,con.r_cutoff(xl*xl))) return false;
-	if(c.plane_intersects(xl,y1,z1,con.r_cutoff(xl*xl))) return false;
-	if(c.plane_intersects(xl,y1,z0,con.r_cutoff(xl*xl))) return false;
+inline bool voro_compute<c_class,p_class,m_class>::face_x_test(v_cell &c,double xl,double y0,double z0,double y1,double z1) {
+	con.r_prime(xl*xl,rsc);
+	if(c.plane_intersects_guess(xl,y0,z0,con.r_cutoff(xl*xl,rsc))) return false;
+	if(c.plane_intersects(xl,y0,z1,con.r_cutoff(xl*xl,rsc))) return false;
+	if(c.plane_intersects(xl,y1,z1,con.r_cutoff(xl*xl,rsc))) return false;
+	if(c.plane_intersects(xl,y1,z0,con.r_cutoff(xl*xl,rsc))) return false;
 	return true;
 }
 
@@ -747,14 +824,14 @@ inline bool voro_compute<c_class>::face_x_test(v_cell &c,double xl,double y0,dou
  * \param[in] (z0,z1) the minimum and maximum relative z coordinates of the
  *                    block.
  * \return False if the block may intersect, true if does not. */
-template<class c_class>
+template<class c_class,class p_class,class m_class>
 template<class v_cell>
-inline bool voro_compute<c_class>::face_y_test(v_cell &c,double x0,double yl,double z0,double x1,double z1) {
-	con.r_prime(yl*yl);
-	if(c.plane_intersects_guess(x0,yl,z0,con.r_cutoff(yl*yl))) return false;
-	if(c.plane_intersects(x0,yl,z1,con.r_cutoff(yl*yl))) return false;
-	if(c.plane_intersects(x1,yl,z1,con.r_cutoff(yl*yl))) return false;
-	if(c.plane_intersects(x1,yl,z0,con.r_cutoff(yl*yl))) return false;
+inline bool voro_compute<c_class,p_class,m_class>::face_y_test(v_cell &c,double x0,double yl,double z0,double x1,double z1) {
+	con.r_prime(yl*yl,rsc);
+	if(c.plane_intersects_guess(x0,yl,z0,con.r_cutoff(yl*yl,rsc))) return false;
+	if(c.plane_intersects(x0,yl,z1,con.r_cutoff(yl*yl,rsc))) return false;
+	if(c.plane_intersects(x1,yl,z1,con.r_cutoff(yl*yl,rsc))) return false;
+	if(c.plane_intersects(x1,yl,z0,con.r_cutoff(yl*yl,rsc))) return false;
 	return true;
 }
 
@@ -768,14 +845,14 @@ inline bool voro_compute<c_class>::face_y_test(v_cell &c,double x0,double yl,dou
  * \param[in] (y0,y1) the minimum and maximum relative y coordinates of the
  *                    block.
  * \return False if the block may intersect, true if does not. */
-template<class c_class>
+template<class c_class,class p_class,class m_class>
 template<class v_cell>
-inline bool voro_compute<c_class>::face_z_test(v_cell &c,double x0,double y0,double zl,double x1,double y1) {
-	con.r_prime(zl*zl);
-	if(c.plane_intersects_guess(x0,y0,zl,con.r_cutoff(zl*zl))) return false;
-	if(c.plane_intersects(x0,y1,zl,con.r_cutoff(zl*zl))) return false;
-	if(c.plane_intersects(x1,y1,zl,con.r_cutoff(zl*zl))) return false;
-	if(c.plane_intersects(x1,y0,zl,con.r_cutoff(zl*zl))) return false;
+inline bool voro_compute<c_class,p_class,m_class>::face_z_test(v_cell &c,double x0,double y0,double zl,double x1,double y1) {
+	con.r_prime(zl*zl,rsc);
+	if(c.plane_intersects_guess(x0,y0,zl,con.r_cutoff(zl*zl,rsc))) return false;
+	if(c.plane_intersects(x0,y1,zl,con.r_cutoff(zl*zl,rsc))) return false;
+	if(c.plane_intersects(x1,y1,zl,con.r_cutoff(zl*zl,rsc))) return false;
+	if(c.plane_intersects(x1,y0,zl,con.r_cutoff(zl*zl,rsc))) return false;
 	return true;
 }
 
@@ -793,8 +870,8 @@ inline bool voro_compute<c_class>::face_z_test(v_cell &c,double x0,double y0,dou
  * \param[in] mrs the distance to be tested.
  * \return True if the region is further away than mrs, false if the region in
  *         within mrs. */
-template<class c_class>
-bool voro_compute<c_class>::compute_min_max_radius(int di,int dj,int dk,double fx,double fy,double fz,double gxs,double gys,double gzs,double &crs,double mrs) {
+template<class c_class,class p_class,class m_class>
+bool voro_compute<c_class,p_class,m_class>::compute_min_max_radius(int di,int dj,int dk,double fx,double fy,double fz,double gxs,double gys,double gzs,double &crs,double mrs) {
 	double xlo,ylo,zlo;
 	if(di>0) {
 		xlo=di*boxx-fx;
@@ -804,14 +881,14 @@ bool voro_compute<c_class>::compute_min_max_radius(int di,int dj,int dk,double f
 			crs+=ylo*ylo;
 			if(dk>0) {
 				zlo=dk*boxz-fz;
-				crs+=zlo*zlo;if(con.r_ctest(crs,mrs)) return true;
+				crs+=zlo*zlo;if(con.r_ctest(crs,mrs,rsc)) return true;
 				crs+=bxsq+2*(boxx*xlo+boxy*ylo+boxz*zlo);
 			} else if(dk<0) {
 				zlo=(dk+1)*boxz-fz;
-				crs+=zlo*zlo;if(con.r_ctest(crs,mrs)) return true;
+				crs+=zlo*zlo;if(con.r_ctest(crs,mrs,rsc)) return true;
 				crs+=bxsq+2*(boxx*xlo+boxy*ylo-boxz*zlo);
 			} else {
-				if(con.r_ctest(crs,mrs)) return true;
+				if(con.r_ctest(crs,mrs,rsc)) return true;
 				crs+=boxx*(2*xlo+boxx)+boxy*(2*ylo+boxy)+gzs;
 			}
 		} else if(dj<0) {
@@ -819,27 +896,27 @@ bool voro_compute<c_class>::compute_min_max_radius(int di,int dj,int dk,double f
 			crs+=ylo*ylo;
 			if(dk>0) {
 				zlo=dk*boxz-fz;
-				crs+=zlo*zlo;if(con.r_ctest(crs,mrs)) return true;
+				crs+=zlo*zlo;if(con.r_ctest(crs,mrs,rsc)) return true;
 				crs+=bxsq+2*(boxx*xlo-boxy*ylo+boxz*zlo);
 			} else if(dk<0) {
 				zlo=(dk+1)*boxz-fz;
-				crs+=zlo*zlo;if(con.r_ctest(crs,mrs)) return true;
+				crs+=zlo*zlo;if(con.r_ctest(crs,mrs,rsc)) return true;
 				crs+=bxsq+2*(boxx*xlo-boxy*ylo-boxz*zlo);
 			} else {
-				if(con.r_ctest(crs,mrs)) return true;
+				if(con.r_ctest(crs,mrs,rsc)) return true;
 				crs+=boxx*(2*xlo+boxx)+boxy*(-2*ylo+boxy)+gzs;
 			}
 		} else {
 			if(dk>0) {
 				zlo=dk*boxz-fz;
-				crs+=zlo*zlo;if(con.r_ctest(crs,mrs)) return true;
+				crs+=zlo*zlo;if(con.r_ctest(crs,mrs,rsc)) return true;
 				crs+=boxz*(2*zlo+boxz);
 			} else if(dk<0) {
 				zlo=(dk+1)*boxz-fz;
-				crs+=zlo*zlo;if(con.r_ctest(crs,mrs)) return true;
+				crs+=zlo*zlo;if(con.r_ctest(crs,mrs,rsc)) return true;
 				crs+=boxz*(-2*zlo+boxz);
 			} else {
-				if(con.r_ctest(crs,mrs)) return true;
+				if(con.r_ctest(crs,mrs,rsc)) return true;
 				crs+=gzs;
 			}
 			crs+=gys+boxx*(2*xlo+boxx);
@@ -852,14 +929,14 @@ bool voro_compute<c_class>::compute_min_max_radius(int di,int dj,int dk,double f
 			crs+=ylo*ylo;
 			if(dk>0) {
 				zlo=dk*boxz-fz;
-				crs+=zlo*zlo;if(con.r_ctest(crs,mrs)) return true;
+				crs+=zlo*zlo;if(con.r_ctest(crs,mrs,rsc)) return true;
 				crs+=bxsq+2*(-boxx*xlo+boxy*ylo+boxz*zlo);
 			} else if(dk<0) {
 				zlo=(dk+1)*boxz-fz;
-				crs+=zlo*zlo;if(con.r_ctest(crs,mrs)) return true;
+				crs+=zlo*zlo;if(con.r_ctest(crs,mrs,rsc)) return true;
 				crs+=bxsq+2*(-boxx*xlo+boxy*ylo-boxz*zlo);
 			} else {
-				if(con.r_ctest(crs,mrs)) return true;
+				if(con.r_ctest(crs,mrs,rsc)) return true;
 				crs+=boxx*(-2*xlo+boxx)+boxy*(2*ylo+boxy)+gzs;
 			}
 		} else if(dj<0) {
@@ -867,27 +944,27 @@ bool voro_compute<c_class>::compute_min_max_radius(int di,int dj,int dk,double f
 			crs+=ylo*ylo;
 			if(dk>0) {
 				zlo=dk*boxz-fz;
-				crs+=zlo*zlo;if(con.r_ctest(crs,mrs)) return true;
+				crs+=zlo*zlo;if(con.r_ctest(crs,mrs,rsc)) return true;
 				crs+=bxsq+2*(-boxx*xlo-boxy*ylo+boxz*zlo);
 			} else if(dk<0) {
 				zlo=(dk+1)*boxz-fz;
-				crs+=zlo*zlo;if(con.r_ctest(crs,mrs)) return true;
+				crs+=zlo*zlo;if(con.r_ctest(crs,mrs,rsc)) return true;
 				crs+=bxsq+2*(-boxx*xlo-boxy*ylo-boxz*zlo);
 			} else {
-				if(con.r_ctest(crs,mrs)) return true;
+				if(con.r_ctest(crs,mrs,rsc)) return true;
 				crs+=boxx*(-2*xlo+boxx)+boxy*(-2*ylo+boxy)+gzs;
 			}
 		} else {
 			if(dk>0) {
 				zlo=dk*boxz-fz;
-				crs+=zlo*zlo;if(con.r_ctest(crs,mrs)) return true;
+				crs+=zlo*zlo;if(con.r_ctest(crs,mrs,rsc)) return true;
 				crs+=boxz*(2*zlo+boxz);
 			} else if(dk<0) {
 				zlo=(dk+1)*boxz-fz;
-				crs+=zlo*zlo;if(con.r_ctest(crs,mrs)) return true;
+				crs+=zlo*zlo;if(con.r_ctest(crs,mrs,rsc)) return true;
 				crs+=boxz*(-2*zlo+boxz);
 			} else {
-				if(con.r_ctest(crs,mrs)) return true;
+				if(con.r_ctest(crs,mrs,rsc)) return true;
 				crs+=gzs;
 			}
 			crs+=gys+boxx*(-2*xlo+boxx);
@@ -898,14 +975,14 @@ bool voro_compute<c_class>::compute_min_max_radius(int di,int dj,int dk,double f
 			crs=ylo*ylo;
 			if(dk>0) {
 				zlo=dk*boxz-fz;
-				crs+=zlo*zlo;if(con.r_ctest(crs,mrs)) return true;
+				crs+=zlo*zlo;if(con.r_ctest(crs,mrs,rsc)) return true;
 				crs+=boxz*(2*zlo+boxz);
 			} else if(dk<0) {
 				zlo=(dk+1)*boxz-fz;
-				crs+=zlo*zlo;if(con.r_ctest(crs,mrs)) return true;
+				crs+=zlo*zlo;if(con.r_ctest(crs,mrs,rsc)) return true;
 				crs+=boxz*(-2*zlo+boxz);
 			} else {
-				if(con.r_ctest(crs,mrs)) return true;
+				if(con.r_ctest(crs,mrs,rsc)) return true;
 				crs+=gzs;
 			}
 			crs+=boxy*(2*ylo+boxy);
@@ -914,23 +991,23 @@ bool voro_compute<c_class>::compute_min_max_radius(int di,int dj,int dk,double f
 			crs=ylo*ylo;
 			if(dk>0) {
 				zlo=dk*boxz-fz;
-				crs+=zlo*zlo;if(con.r_ctest(crs,mrs)) return true;
+				crs+=zlo*zlo;if(con.r_ctest(crs,mrs,rsc)) return true;
 				crs+=boxz*(2*zlo+boxz);
 			} else if(dk<0) {
 				zlo=(dk+1)*boxz-fz;
-				crs+=zlo*zlo;if(con.r_ctest(crs,mrs)) return true;
+				crs+=zlo*zlo;if(con.r_ctest(crs,mrs,rsc)) return true;
 				crs+=boxz*(-2*zlo+boxz);
 			} else {
-				if(con.r_ctest(crs,mrs)) return true;
+				if(con.r_ctest(crs,mrs,rsc)) return true;
 				crs+=gzs;
 			}
 			crs+=boxy*(-2*ylo+boxy);
 		} else {
 			if(dk>0) {
-				zlo=dk*boxz-fz;crs=zlo*zlo;if(con.r_ctest(crs,mrs)) return true;
+				zlo=dk*boxz-fz;crs=zlo*zlo;if(con.r_ctest(crs,mrs,rsc)) return true;
 				crs+=boxz*(2*zlo+boxz);
 			} else if(dk<0) {
-				zlo=(dk+1)*boxz-fz;crs=zlo*zlo;if(con.r_ctest(crs,mrs)) return true;
+				zlo=(dk+1)*boxz-fz;crs=zlo*zlo;if(con.r_ctest(crs,mrs,rsc)) return true;
 				crs+=boxz*(-2*zlo+boxz);
 			} else {
 				crs=0;
@@ -943,8 +1020,8 @@ bool voro_compute<c_class>::compute_min_max_radius(int di,int dj,int dk,double f
 	return false;
 }
 
-template<class c_class>
-bool voro_compute<c_class>::compute_min_radius(int di,int dj,int dk,double fx,double fy,double fz,double mrs) {
+template<class c_class,class p_class,class m_class>
+bool voro_compute<c_class,p_class,m_class>::compute_min_radius(int di,int dj,int dk,double fx,double fy,double fz,double mrs) {
 	double t,crs;
 
 	if(di>0) {t=di*boxx-fx;crs=t*t;}
@@ -963,8 +1040,8 @@ bool voro_compute<c_class>::compute_min_radius(int di,int dj,int dk,double fx,do
 /** Adds memory to the queue.
  * \param[in,out] qu_s a reference to the queue start pointer.
  * \param[in,out] qu_e a reference to the queue end pointer. */
-template<class c_class>
-inline void voro_compute<c_class>::add_list_memory(int*& qu_s,int*& qu_e) {
+template<class c_class,class p_class,class m_class>
+inline void voro_compute<c_class,p_class,m_class>::add_list_memory(int*& qu_s,int*& qu_e) {
 	qu_size<<=1;
 	int *qu_n=new int[qu_size],*qu_c=qu_n;
 #if VOROPP_VERBOSE >=2
@@ -984,17 +1061,33 @@ inline void voro_compute<c_class>::add_list_memory(int*& qu_s,int*& qu_e) {
 
 // Explicit template instantiation
 template voro_compute<container>::voro_compute(container&,int,int,int);
+template voro_compute<container>::voro_compute(container&);
 template voro_compute<container_poly>::voro_compute(container_poly&,int,int,int);
+template voro_compute<container_poly>::voro_compute(container_poly&);
 template bool voro_compute<container>::compute_cell(voronoicell&,int,int,int,int,int);
 template bool voro_compute<container>::compute_cell(voronoicell_neighbor&,int,int,int,int,int);
 template void voro_compute<container>::find_voronoi_cell(double,double,double,int,int,int,int,particle_record&,double&);
 template bool voro_compute<container_poly>::compute_cell(voronoicell&,int,int,int,int,int);
 template bool voro_compute<container_poly>::compute_cell(voronoicell_neighbor&,int,int,int,int,int);
 template void voro_compute<container_poly>::find_voronoi_cell(double,double,double,int,int,int,int,particle_record&,double&);
+template voro_compute<container,periodicity_none>::voro_compute(container&);
+template voro_compute<container,periodicity_all>::voro_compute(container&);
+template voro_compute<container_poly,periodicity_none>::voro_compute(container_poly&);
+template voro_compute<container_poly,periodicity_all>::voro_compute(container_poly&);
+template bool voro_compute<container,periodicity_none>::compute_cell(voronoicell&,int,int,int,int,int);
+template bool voro_compute<container,periodicity_none>::compute_cell(voronoicell_neighbor&,int,int,int,int,int);
+template bool voro_compute<container,periodicity_all>::compute_cell(voronoicell&,int,int,int,int,int);
+template bool voro_compute<container,periodicity_all>::compute_cell(voronoicell_neighbor&,int,int,int,int,int);
+template bool voro_compute<container_poly,periodicity_none>::compute_cell(voronoicell&,int,int,int,int,int);
+template bool voro_compute<container_poly,periodicity_none>::compute_cell(voronoicell_neighbor&,int,int,int,int,int);
+template bool voro_compute<container_poly,periodicity_all>::compute_cell(voronoicell&,int,int,int,int,int);
+template bool voro_compute<container_poly,periodicity_all>::compute_cell(voronoicell_neighbor&,int,int,int,int,int);
 
 // Explicit template instantiation
 template voro_compute<container_periodic>::voro_compute(container_periodic&,int,int,int);
+template voro_compute<container_periodic>::voro_compute(container_periodic&);
 template voro_compute<container_periodic_poly>::voro_compute(container_periodic_poly&,int,int,int);
+template voro_compute<container_periodic_poly>::voro_compute(container_periodic_poly&);
 template bool voro_compute<container_periodic>::compute_cell(voronoicell&,int,int,int,int,int);
 template bool voro_compute<container_periodic>::compute_cell(voronoicell_neighbor&,int,int,int,int,int);
 template void voro_compute<container_periodic>::find_voronoi_cell(double,double,double,int,int,int,int,particle_record&,double&);
@@ -1002,4 +1095,11 @@ template bool voro_compute<container_periodic_poly>::compute_cell(voronoicell&,i
 template bool voro_compute<container_periodic_poly>::compute_cell(voronoicell_neighbor&,int,int,int,int,int);
 template void voro_compute<container_periodic_poly>::find_voronoi_cell(double,double,double,int,int,int,int,particle_record&,double&);
 
+// Explicit template instantiation
+template voro_compute<container_sparse,periodicity_runtime,block_mask_hashed>::voro_compute(container_sparse&,int,int,int);
+template voro_compute<container_sparse,periodicity_runtime,block_mask_hashed>::voro_compute(container_sparse&);
+template bool voro_compute<container_sparse,periodicity_runtime,block_mask_hashed>::compute_cell(voronoicell&,int,int,int,int,int);
+template bool voro_compute<container_sparse,periodicity_runtime,block_mask_hashed>::compute_cell(voronoicell_neighbor&,int,int,int,int,int);
+template void voro_compute<container_sparse,periodicity_runtime,block_mask_hashed>::find_voronoi_cell(double,double,double,int,int,int,int,particle_record&,double&);
+
 }
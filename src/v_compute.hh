@@ -13,6 +13,7 @@
 #include "config.hh"
 #include "worklist.hh"
 #include "cell.hh"
+#include "rad_option.hh"
 
 namespace voro {
 
@@ -34,8 +35,257 @@ struct particle_record {
 	int dk;
 };
 
-/** \brief Template for carrying out Voronoi cell computations. */
-template <class c_class>
+/** \brief A class for handling the periodicity of a container at run time.
+ *
+ * This class is the default periodicity policy of the voro_compute template.
+ * It passes the periodicity-dependent parts of the cell computation on to the
+ * container class, which tests its periodic flags each time they are
+ * called. */
+class periodicity_runtime {
+	public:
+		/** Initializes the Voronoi cell prior to a compute_cell
+		 * operation, using the container's routine. The parameters
+		 * are described in container_base::initialize_voronoicell.
+		 * \return False if the cell was completely removed, true
+		 *         otherwise. */
+		template<class c_class,class v_cell>
+		static inline bool initialize_voronoicell(c_class &con,v_cell &c,int ijk,int q,int ci,int cj,int ck,
+				int &i,int &j,int &k,double &x,double &y,double &z,int &disp) {
+			return con.initialize_voronoicell(c,ijk,q,ci,cj,ck,i,j,k,x,y,z,disp);
+		}
+		/** Initializes parameters for a find_voronoi_cell call, using
+		 * the container's routine. The parameters are described in
+		 * container_base::initialize_search. */
+		template<class c_class>
+		static inline void initialize_search(c_class &con,int ci,int cj,int ck,int ijk,int &i,int &j,int &k,int &disp) {
+			con.initialize_search(ci,cj,ck,ijk,i,j,k,disp);
+		}
+		/** Calculates the index of a block, using the container's
+		 * routine. The parameters are described in
+		 * container_base::region_index.
+		 * \return The block index. */
+		template<class c_class>
+		static inline int region_index(c_class &con,int ci,int cj,int ck,int ei,int ej,int ek,double &qx,double &qy,double &qz,int &disp) {
+			return con.region_index(ci,cj,ck,ei,ej,ek,qx,qy,qz,disp);
+		}
+};
+
+/** \brief A class for handling a periodicity that is known at compile time.
+ *
+ * This class is a periodicity policy for the voro_compute template, for use
+ * with the container and container_poly classes. It carries out the
+ * periodicity-dependent parts of the cell computation with the periodicity in
+ * each direction given by a template parameter, so that when voro_compute is
+ * instantiated with it, the tests on the container's periodic flags for each
+ * particle and each block are removed. The template parameters must match the
+ * periodicity of the container. The containers only select this policy through
+ * the drive_cells_periodicity routine in c_drive.hh, so that the extra
+ * instantiations are confined to a single place. */
+template<bool xp,bool yp,bool zp>
+class periodicity_fixed {
+	public:
+		/** Initializes the Voronoi cell prior to a compute_cell
+		 * operation, in the same way as
+		 * container_base::initialize_voronoicell, whose parameters
+		 * are the same.
+		 * \return False if the cell was completely removed, true
+		 *         otherwise. */
+		template<class c_class,class v_cell>
+		static inline bool initialize_voronoicell(c_class &con,v_cell &c,int ijk,int q,int ci,int cj,int ck,
+				int &i,int &j,int &k,double &x,double &y,double &z,int &disp) {
+			double x1,x2,y1,y2,z1,z2;
+			particle_real *pp=con.p[ijk]+con.ps*q;
+			x=*(pp++);y=*(pp++);z=*pp;
+			if(xp) {x1=-(x2=0.5*(con.bx-con.ax));i=con.nx;} else {x1=con.ax-x;x2=con.bx-x;i=ci;}
+			if(yp) {y1=-(y2=0.5*(con.by-con.ay));j=con.ny;} else {y1=con.ay-y;y2=con.by-y;j=cj;}
+			if(zp) {z1=-(z2=0.5*(con.bz-con.az));k=con.nz;} else {z1=con.az-z;z2=con.bz-z;k=ck;}
+			c.init(x1,x2,y1,y2,z1,z2);
+			if(!con.apply_walls(c,x,y,z)) return false;
+			disp=ijk-i-con.nx*(j+con.ny*k);
+			return true;
+		}
+		/** Initializes parameters for a find_voronoi_cell call, in the
+		 * same way as container_base::initialize_search, whose
+		 * parameters are the same. */
+		template<class c_class>
+		static inline void initialize_search(c_class &con,int ci,int cj,int ck,int ijk,int &i,int &j,int &k,int &disp) {
+			i=xp?con.nx:ci;
+			j=yp?con.ny:cj;
+			k=zp?con.nz:ck;
+			disp=ijk-i-con.nx*(j+con.ny*k);
+		}
+		/** Calculates the index of a block, in the same way as
+		 * container_base::region_index, whose parameters are the
+		 * same.
+		 * \return The block index. */
+		template<class c_class>
+		static inline int region_index(c_class &con,int ci,int cj,int ck,int ei,int ej,int ek,double &qx,double &qy,double &qz,int &disp) {
+			const int nx=con.nx,ny=con.ny,nz=con.nz;
+			if(xp) {if(ci+ei<nx) {ei+=nx;qx=-(con.bx-con.ax);} else if(ci+ei>=(nx<<1)) {ei-=nx;qx=con.bx-con.ax;} else qx=0;}
+			if(yp) {if(cj+ej<ny) {ej+=ny;qy=-(con.by-con.ay);} else if(cj+ej>=(ny<<1)) {ej-=ny;qy=con.by-con.ay;} else qy=0;}
+			if(zp) {if(ck+ek<nz) {ek+=nz;qz=-(con.bz-con.az);} else if(ck+ek>=(nz<<1)) {ek-=nz;qz=con.bz-con.az;} else qz=0;}
+			return disp+ei+nx*(ej+ny*ek);
+		}
+};
+
+/** The periodicity policy for a container that is non-periodic in all three
+ * directions. */
+typedef periodicity_fixed<false,false,false> periodicity_none;
+
+/** The periodicity policy for a container that is periodic in all three
+ * directions. */
+typedef periodicity_fixed<true,true,true> periodicity_all;
+
+/** Scrambles the bits of a block index, for use in the hash tables that
+ * store blocks. Nearby blocks have indices that differ only in a few bits, so
+ * the bits are mixed so that they are spread evenly over the table.
+ * \param[in] l the index of the block.
+ * \return The hash value. */
+inline unsigned int block_hash(int l) {
+	unsigned int h=static_cast<unsigned int>(l);
+	h^=h>>16;h*=0x45d9f3bu;h^=h>>16;
+	return h;
+}
+
+/** \brief A class for recording which blocks have been tested during a cell
+ * computation, using an array with an entry for every block.
+ *
+ * This class is the default mask policy of the voro_compute template. Each
+ * entry of the array holds the value of a counter at the time that the block
+ * was last marked, so that the mask can be cleared for each computation by
+ * incrementing the counter. */
+class block_mask {
+	public:
+		/** The class constructor allocates the array and clears it.
+		 * \param[in] hxyz_ the number of blocks in the mask. */
+		block_mask(int hxyz_) : hxyz(hxyz_), mv(0), m(new unsigned int[hxyz_]) {
+			reset();
+		}
+		/** The class destructor frees the dynamically allocated
+		 * memory. */
+		~block_mask() {delete [] m;}
+		/** Clears the mask prior to a computation, by incrementing the
+		 * counter. If the counter wraps around, then the whole array
+		 * is reset, which only happens once every 2^32 calls. */
+		inline void advance() {
+			mv++;
+			if(mv==0) {reset();mv=1;}
+		}
+		/** Marks a block as tested.
+		 * \param[in] l the index of the block. */
+		inline void mark(int l) {m[l]=mv;}
+		/** Marks a block as tested, if it has not been already.
+		 * \param[in] l the index of the block.
+		 * \return True if the block was not previously marked, false
+		 *         otherwise. */
+		inline bool mark_new(int l) {
+			if(m[l]==mv) return false;
+			m[l]=mv;return true;
+		}
+		/** Returns the initial size of the block queue to use with
+		 * this mask, which is large enough to hold a layer of blocks
+		 * around the whole mask.
+		 * \param[in] (hx,hy,hz) the dimensions of the mask.
+		 * \return The queue size. */
+		static inline int queue_size(int hx,int hy,int hz) {
+			return 3*(3+hx*hy+hz*(hx+hy));
+		}
+	private:
+		/** The number of blocks in the mask. */
+		const int hxyz;
+		/** The current value being used to mark tested blocks. */
+		unsigned int mv;
+		/** The array holding the mark of each block. */
+		unsigned int *m;
+		/** Resets all entries of the array to zero. */
+		inline void reset() {
+			for(unsigned int *mp=m;mp<m+hxyz;mp++) *mp=0;
+		}
+};
+
+/** \brief A class for recording which blocks have been tested during a cell
+ * computation, using a hash table of the marked blocks.
+ *
+ * This class is a mask policy for the voro_compute template whose memory
+ * depends on the number of blocks tested during a single cell computation,
+ * rather than on the total number of blocks. It is used with the
+ * container_sparse class, whose block grid can be too large to hold a mask
+ * entry for every block. The table uses open addressing with linear probing.
+ * Each slot stores the counter value at the time it was filled, and slots
+ * from earlier computations are treated as empty, so that the table can be
+ * cleared by incrementing the counter. */
+class block_mask_hashed {
+	public:
+		block_mask_hashed(int hxyz_);
+		/** The class destructor frees the dynamically allocated
+		 * memory. */
+		~block_mask_hashed() {
+			delete [] mg;
+			delete [] mk;
+		}
+		/** Clears the mask prior to a computation, by incrementing the
+		 * counter. If the counter wraps around, then the whole table
+		 * is reset. */
+		inline void advance() {
+			mv++;n=0;
+			if(mv==0) {reset();mv=1;}
+		}
+		/** Marks a block as tested.
+		 * \param[in] l the index of the block. */
+		inline void mark(int l) {mark_new(l);}
+		/** Marks a block as tested, if it has not been already.
+		 * \param[in] l the index of the block.
+		 * \return True if the block was not previously marked, false
+		 *         otherwise. */
+		inline bool mark_new(int l) {
+			unsigned int h=hash(l);
+			while(mg[h]==mv) {
+				if(mk[h]==l) return false;
+				h=(h+1)&hm;
+			}
+			mg[h]=mv;mk[h]=l;
+			if(++n>(hmem>>1)) grow();
+			return true;
+		}
+		/** Returns the initial size of the block queue to use with
+		 * this mask, which is independent of the mask dimensions, since
+		 * the queue is extended as needed.
+		 * \return The queue size. */
+		static inline int queue_size(int,int,int) {
+			return 3*init_mask_hash_size;
+		}
+	private:
+		/** The number of slots in the table, which is a power of
+		 * two. */
+		int hmem;
+		/** A bit mask for reducing a hash value to a slot, set to
+		 * hmem-1. */
+		unsigned int hm;
+		/** The number of blocks marked in the current computation. */
+		int n;
+		/** The current value being used to mark tested blocks. */
+		unsigned int mv;
+		/** The block index stored in each slot. */
+		int *mk;
+		/** The counter value at the time that each slot was
+		 * filled. */
+		unsigned int *mg;
+		/** Computes the first slot to probe for a block.
+		 * \param[in] l the index of the block.
+		 * \return The slot. */
+		inline unsigned int hash(int l) {return block_hash(l)&hm;}
+		void grow();
+		void reset();
+};
+
+/** \brief Template for carrying out Voronoi cell computations.
+ *
+ * The first template parameter is the container class, and the second is a
+ * periodicity policy, either periodicity_runtime or periodicity_fixed, which
+ * carries out the parts of the computation that depend on the periodicity of
+ * the container. The third is a mask policy, either block_mask or
+ * block_mask_hashed, which records the blocks that have been tested. */
+template <class c_class,class p_class=periodicity_runtime,class m_class=block_mask>
 class voro_compute {
 	public:
 		/** A reference to the container class on which to carry out*/
@@ -80,16 +330,17 @@ class voro_compute {
 		/** A two dimensional array holding particle positions. For the
 		 * derived container_poly class, this also holds particle
 		 * radii. */
-		double **p;
+		particle_real **p;
 		/** An array holding the number of particles within each
 		 * computational box of the container. */
 		int *co;
 		voro_compute(c_class &con_,int hx_,int hy_,int hz_);
+		voro_compute(c_class &con_);
 		/** The class destructor frees the dynamically allocated memory
-		 * for the mask and queue. */
+		 * for the queue. */
 		~voro_compute() {
+			delete [] bv;
 			delete [] qu;
-			delete [] mask;
 		}
 		template<class v_cell>
 		bool compute_cell(v_cell &c,int ijk,int s,int ci,int cj,int ck);
@@ -98,9 +349,6 @@ class voro_compute {
 		/** A constant set to boxx*boxx+boxy*boxy+boxz*boxz, which is
 		 * frequently used in the computation. */
 		const double bxsq;
-		/** This sets the current value being used to mark tested blocks
-		 * in the mask. */
-		unsigned int mv;
 		/** The current size of the search list. */
 		int qu_size;
 		/** A pointer to the array of worklists. */
@@ -108,15 +356,40 @@ class voro_compute {
 		/** An pointer to the array holding the minimum distances
 		 * associated with the worklists. */
 		double *mrad;
-		/** This array is used during the cell computation to determine
+		/** The mask used during the cell computation to determine
 		 * which blocks have been considered. */
-		unsigned int *mask;
+		m_class mask;
 		/** An array is used to store the queue of blocks to test
 		 * during the Voronoi cell computation. */
 		int *qu;
 		/** A pointer to the end of the queue array, used to determine
 		 * when the queue is full. */
 		int *qu_l;
+		/** The constants used by the radius routines during the
+		 * current cell computation. */
+		radius_scratch rsc;
+		/** The current memory allocation for the block displacement
+		 * arrays, set to the number of particles they can hold. */
+		int bmem;
+		/** The memory holding the block displacement arrays. */
+		double *bv;
+		/** The x components of the displacement vectors to the
+		 * particles in the current block. */
+		double *bvx;
+		/** The y components of the displacement vectors to the
+		 * particles in the current block. */
+		double *bvy;
+		/** The z components of the displacement vectors to the
+		 * particles in the current block. */
+		double *bvz;
+		/** The squared lengths of the displacement vectors to the
+		 * particles in the current block, which are replaced by the
+		 * scaled plane displacements before the cutting. */
+		double *bvr;
+		/** The bounds on the scalar products of the displacement
+		 * vectors with the vertices of the cell, used to discard
+		 * planes that cannot cut the cell. */
+		double *bvm;
 		template<class v_cell>
 		bool corner_test(v_cell &c,double xl,double yl,double zl,double xh,double yh,double zh);
 		template<class v_cell>
@@ -134,14 +407,13 @@ class voro_compute {
 		bool compute_min_max_radius(int di,int dj,int dk,double fx,double fy,double fz,double gx,double gy,double gz,double& crs,double mrs);
 		bool compute_min_radius(int di,int dj,int dk,double fx,double fy,double fz,double mrs);
 		inline void add_to_mask(int ei,int ej,int ek,int *&qu_e);
-		inline void scan_bits_mask_add(unsigned int q,unsigned int *mijk,int ei,int ej,int ek,int *&qu_e);
+		inline void scan_bits_mask_add(unsigned int q,int mijk,int ei,int ej,int ek,int *&qu_e);
 		inline void scan_all(int ijk,double x,double y,double z,int di,int dj,int dk,particle_record &w,double &mrs);
 		void add_list_memory(int*& qu_s,int*& qu_e);
-		/** Resets the mask in cases where the mask counter wraps
-		 * around. */
-		inline void reset_mask() {
-			for(unsigned int *mp(mask);mp<mask+hxyz;mp++) *mp=0;
-		}
+		inline void block_vectors(int ijk,double x,double y,double z);
+		void add_block_memory(int n);
+		template<class v_cell>
+		inline bool cut_block(v_cell &c,int ijk);
 };
 
 }
@@ -17,3 +17,18 @@
 #include "v_compute.cc"
 #include "c_loops.cc"
 #include "wall.cc"
+#include "c_sched.cc"
+#include "p_soa.cc"
+#include "p_file.cc"
+#include "p_text.cc"
+#include "o_custom.cc"
+#include "o_columns.cc"
+#include "o_graph.cc"
+#include "o_mesh.cc"
+#include "o_laplace.cc"
+#include "o_tess.cc"
+#include "c_pool.cc"
+#include "c_drive.cc"
+#include "container_sparse.cc"
+#include "container_octree.cc"
+#include "p_index.cc"
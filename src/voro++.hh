@@ -133,7 +133,10 @@
  * at allocations within mep[][]. To the user, it appears as though each row of
  * ed[][] has a different number of elements. When vertices are added or
  * deleted, care must be taken to reorder and reassign elements in these
- * arrays.
+ * arrays. Since the vast majority of vertices have order 3, the mep[3] array
+ * is sized by the number of vertices, and an order 3 vertex i is always held
+ * at mep[3]+7*i, so that these entries do not need to be reordered when other
+ * vertices are deleted.
  *
  * During the plane() routine, the code traces around the vertices of the cell,
  * and adds new vertices along edges which intersect the cutting plane to
@@ -329,5 +332,21 @@
 #include "v_compute.hh"
 #include "c_loops.hh"
 #include "wall.hh"
+#include "c_track.hh"
+#include "p_index.hh"
+#include "container_octree.hh"
+#include "container_sparse.hh"
+#include "c_pool.hh"
+#include "c_drive.hh"
+#include "o_columns.hh"
+#include "o_graph.hh"
+#include "o_mesh.hh"
+#include "o_laplace.hh"
+#include "o_tess.hh"
+#include "o_custom.hh"
+#include "p_text.hh"
+#include "p_file.hh"
+#include "p_soa.hh"
+#include "c_sched.hh"
 
 #endif